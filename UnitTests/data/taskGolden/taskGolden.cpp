@@ -0,0 +1,113 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskGolden.cpp
+ *
+ * @brief Generates TaskXCSoar5.tsk and TaskLK8000.tsk golden files.
+ *
+ * Golden files are the memory images of imported XCSoar/LK8000 structures laid
+ * out by a 32-bit compiler in the same order baseline TaskDump() wrote them to
+ * the file (settings fields are written one by one so they are packed). The file
+ * is only compiled (no linking nor C++ library is needed) and images are
+ * extracted from the object file sections:
+ *
+ * g++ -m32 -malign-double -fshort-wchar -std=c++2a -D_WIN32 -I. -I../../../src -c taskGolden.cpp
+ * objcopy -O binary --only-section=.xcsoar5 taskGolden.o ../TaskXCSoar5.tsk
+ * objcopy -O binary --only-section=.lk8000 taskGolden.o ../TaskLK8000.tsk
+ */
+
+#include "imports/lk8000Types.h"
+
+using namespace xcsoar;
+
+namespace {
+
+  struct __attribute__((packed)) TSettings {
+    decltype(SETTINGS_TASK::AATEnabled) aatEnabled;
+    decltype(SETTINGS_TASK::AATTaskLength) aatTaskLength;
+    decltype(SETTINGS_TASK::FinishRadius) finishRadius;
+    decltype(SETTINGS_TASK::FinishType) finishType;
+    decltype(SETTINGS_TASK::StartRadius) startRadius;
+    decltype(SETTINGS_TASK::StartType) startType;
+    decltype(SETTINGS_TASK::SectorType) sectorType;
+    decltype(SETTINGS_TASK::SectorRadius) sectorRadius;
+    decltype(SETTINGS_TASK::AutoAdvance) autoAdvance;
+    decltype(SETTINGS_TASK::EnableMultipleStartPoints) enableMultipleStartPoints;
+  };
+
+  struct __attribute__((packed)) TXCSoar5 {
+    TASK_POINT taskPoints[xcsoar::MAXTASKPOINTS];
+    TSettings settings;
+    START_POINT startPoints[xcsoar::MAXSTARTPOINTS];
+    xcsoar::WAYPOINT taskWaypoints[xcsoar::MAXTASKPOINTS];
+    xcsoar::WAYPOINT startWaypoints[xcsoar::MAXSTARTPOINTS];
+  };
+
+  struct __attribute__((packed)) TLK8000 {
+    char version[50];
+    TASK_POINT taskPoints[lk8000::MAXTASKPOINTS];
+    TSettings settings;
+    START_POINT startPoints[lk8000::MAXSTARTPOINTS];
+    lk8000::WAYPOINT taskWaypoints[lk8000::MAXTASKPOINTS];
+    lk8000::WAYPOINT startWaypoints[lk8000::MAXSTARTPOINTS];
+  };
+
+  static_assert(sizeof(TXCSoar5) == 8761, "XCSoar 5 task file size mismatch");
+  static_assert(sizeof(TLK8000) == 15931, "LK8000 task file size mismatch");
+
+}
+
+// the same task as the one encoded by TestTaskImage::Image()
+#define TP_UNUSED { .Index = -1, .AATStartRadial = 0, .AATFinishRadial = 360 }
+#define TASK_POINTS \
+  { .Index = 100001, .AATType = WAYPOINT_AAT_CIRCLE, .AATCircleRadius = 500, .AATStartRadial = 0, .AATFinishRadial = 360 }, \
+  { .Index = 100002, .AATType = WAYPOINT_AAT_SECTOR, .AATSectorRadius = 3000, .AATStartRadial = 45, .AATFinishRadial = 135 }, \
+  { .Index = 100003, .AATType = WAYPOINT_AAT_CIRCLE, .AATCircleRadius = 1000, .AATStartRadial = 0, .AATFinishRadial = 360 }
+#define SETTINGS { true, 7200, 1000, FINISH_LINE, 2000, START_LINE, AST_DAE, 500, AUTOADVANCE_ARMSTART, false }
+#define SP_UNUSED { .Index = -1 }
+
+__attribute__((section(".xcsoar5"), used)) const TXCSoar5 xcsoar5 = {
+  { TASK_POINTS, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED },
+  SETTINGS,
+  { SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED },
+  {
+    { .Number = 100001, .Latitude = 46.35, .Longitude = 14.1733, .Altitude = 505, .Flags = WAYPOINT_AIRPORT | WAYPOINT_TURNPOINT, .Name = L"S:Lesce", .Comment = L"Lesce", .InTask = true },
+    { .Number = 100002, .Latitude = 46.2333, .Longitude = 15.2667, .Altitude = 244, .Flags = WAYPOINT_TURNPOINT, .Name = L"1:Celje", .Comment = L"Celje", .InTask = true },
+    { .Number = 100003, .Latitude = 46.35, .Longitude = 14.1733, .Altitude = 505, .Flags = WAYPOINT_AIRPORT | WAYPOINT_TURNPOINT, .Name = L"F:Lesce", .Comment = L"Lesce", .InTask = true }
+  },
+  {}
+};
+
+__attribute__((section(".lk8000"), used)) const TLK8000 lk8000Task = {
+  "LK32020",
+  { TASK_POINTS, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED,
+    TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED, TP_UNUSED },
+  SETTINGS,
+  { SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED,
+    SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED, SP_UNUSED },
+  {
+    { .Number = 100001, .Latitude = 46.35, .Longitude = 14.1733, .Altitude = 505, .Flags = WAYPOINT_AIRPORT | WAYPOINT_TURNPOINT, .Name = L"S:Lesce", .InTask = true, .Style = 1 },
+    { .Number = 100002, .Latitude = 46.2333, .Longitude = 15.2667, .Altitude = 244, .Flags = WAYPOINT_TURNPOINT, .Name = L"1:Celje", .InTask = true, .Style = 1 },
+    { .Number = 100003, .Latitude = 46.35, .Longitude = 14.1733, .Altitude = 505, .Flags = WAYPOINT_AIRPORT | WAYPOINT_TURNPOINT, .Name = L"F:Lesce", .InTask = true, .Style = 1 }
+  },
+  {}
+};
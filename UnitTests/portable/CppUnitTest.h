@@ -0,0 +1,238 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file CppUnitTest.h
+ *
+ * @brief Portable subset of Microsoft Native C++ Unit Test Framework.
+ *
+ * The header provides the part of Microsoft::VisualStudio::CppUnitTestFramework
+ * interface used by Condor2Nav unit tests so that they can be built and run with
+ * CMake/CTest on platforms without Visual Studio. Tests register themselves during
+ * static initialization and are run by the runner from main.cpp.
+ */
+
+#ifndef __CPPUNITTEST_H__
+#define __CPPUNITTEST_H__
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace Microsoft {
+  namespace VisualStudio {
+    namespace CppUnitTestFramework {
+
+      /**
+       * @brief Registered test method.
+       */
+      struct TTestMethod {
+        const char *className;
+        const char *methodName;
+        std::function<void()> run;
+      };
+
+      /**
+       * @brief Returns all registered test methods.
+       */
+      inline std::vector<TTestMethod> &TestMethods()
+      {
+        static std::vector<TTestMethod> methods;
+        return methods;
+      }
+
+      /**
+       * @brief Registers test method during static initialization.
+       */
+      template<typename Registrar>
+      struct TAutoRegister {
+        static Registrar instance;
+      };
+      template<typename Registrar>
+      Registrar TAutoRegister<Registrar>::instance;
+
+      /**
+       * @brief Test classes base class.
+       */
+      template<typename Class, typename Name>
+      class TestClass {
+      protected:
+        using ThisClass = Class;
+        using ThisClassName = Name;
+      };
+
+      /**
+       * @brief Exception thrown on assertion failure.
+       */
+      struct AssertFailedException : std::runtime_error {
+        explicit AssertFailedException(const std::string &message) : std::runtime_error{message} {}
+      };
+
+      namespace detail {
+
+        template<typename T>
+        auto Stream(std::wostream &stream, const T &value, int) -> decltype(stream << value, void())
+        {
+          stream << value;
+        }
+
+        inline void Stream(std::wostream &stream, const std::string &value, int)
+        {
+          stream << value.c_str();
+        }
+
+        template<typename T>
+        void Stream(std::wostream &stream, const T &, long)
+        {
+          stream << L"<" << typeid(T).name() << L">";
+        }
+
+        inline std::string Narrow(const std::wstring &str)
+        {
+          std::string result;
+          for(auto c : str)
+            result += c >= 0 && c < 0x80 ? static_cast<char>(c) : '?';
+          return result;
+        }
+
+      }
+
+      /**
+       * @brief Converts a value to a string used in assertion messages.
+       */
+      template<typename T>
+      std::wstring ToString(const T &value)
+      {
+        std::wstringstream stream;
+        detail::Stream(stream, value, 0);
+        return stream.str();
+      }
+
+      /**
+       * @brief Test assertions.
+       */
+      class Assert {
+        static void Fail(const std::wstring &expected, const std::wstring &actual, const wchar_t *message)
+        {
+          std::wstring error = L"Expected: <" + expected + L"> Actual: <" + actual + L">";
+          if(message)
+            error += std::wstring{L" - "} + message;
+          throw AssertFailedException{detail::Narrow(error)};
+        }
+
+      public:
+        template<typename T, typename U>
+        static void AreEqual(const T &expected, const U &actual, const wchar_t *message = nullptr)
+        {
+          if(!(expected == actual))
+            Fail(ToString(expected), ToString(actual), message);
+        }
+
+        static void AreEqual(const char *expected, const char *actual, const wchar_t *message = nullptr)
+        {
+          if(std::strcmp(expected, actual))
+            Fail(ToString(std::string{expected}), ToString(std::string{actual}), message);
+        }
+
+        static void AreEqual(double expected, double actual, double tolerance, const wchar_t *message = nullptr)
+        {
+          if(std::fabs(expected - actual) > tolerance)
+            Fail(ToString(expected), ToString(actual), message);
+        }
+
+        template<typename T, typename U>
+        static void AreNotEqual(const T &notExpected, const U &actual, const wchar_t *message = nullptr)
+        {
+          if(notExpected == actual)
+            Fail(L"not " + ToString(notExpected), ToString(actual), message);
+        }
+
+        static void IsTrue(bool condition, const wchar_t *message = nullptr)
+        {
+          if(!condition)
+            Fail(L"true", L"false", message);
+        }
+
+        static void IsFalse(bool condition, const wchar_t *message = nullptr)
+        {
+          if(condition)
+            Fail(L"false", L"true", message);
+        }
+
+        template<typename Exception, typename Functor>
+        static void ExpectException(Functor functor, const wchar_t *message = nullptr)
+        {
+          try {
+            functor();
+          }
+          catch(const Exception &) {
+            return;
+          }
+          catch(const AssertFailedException &) {
+            throw;
+          }
+          catch(...) {
+            Fail(L"expected exception", L"other exception", message);
+          }
+          Fail(L"expected exception", L"no exception", message);
+        }
+      };
+
+      /**
+       * @brief Test output logger.
+       */
+      class Logger {
+      public:
+        static void WriteMessage(const char *message) { std::cout << message << std::endl; }
+        static void WriteMessage(const wchar_t *message) { std::cout << detail::Narrow(message) << std::endl; }
+      };
+
+    }
+  }
+}
+
+#define TEST_CLASS(className)                                                                                    \
+  struct className##_ClassName { static const char *Get() { return #className; } };                             \
+  class className : public ::Microsoft::VisualStudio::CppUnitTestFramework::TestClass<className, className##_ClassName>
+
+#define TEST_METHOD(methodName)                                                                                  \
+  struct methodName##_Registrar {                                                                                \
+    methodName##_Registrar()                                                                                     \
+    {                                                                                                            \
+      ::Microsoft::VisualStudio::CppUnitTestFramework::TestMethods().push_back(                                  \
+        { ThisClassName::Get(), #methodName, []{ ThisClass test; test.methodName(); } });                        \
+    }                                                                                                            \
+  };                                                                                                             \
+  void methodName##_Register()                                                                                   \
+  {                                                                                                              \
+    (void)&::Microsoft::VisualStudio::CppUnitTestFramework::TAutoRegister<methodName##_Registrar>::instance;     \
+  }                                                                                                              \
+  public: void methodName()
+
+#endif /* __CPPUNITTEST_H__ */
@@ -0,0 +1,84 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file main.cpp
+ *
+ * @brief Runs unit tests registered with portable CppUnitTest.h.
+ */
+
+#include "CppUnitTest.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+
+/**
+ * @brief Main entry-point for unit tests runner.
+ *
+ * Runs all registered test methods or only the ones which class name
+ * or 'Class::Method' name is provided in the command line.
+ *
+ * @param argc Number of command-line arguments. 
+ * @param argv Array of command-line argument strings. 
+ *
+ * @return Exit-code for the process - 0 if all tests passed.
+ */
+int main(int argc, const char *argv[])
+{
+  using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+  using clock = std::chrono::steady_clock;
+
+  unsigned run = 0;
+  unsigned failed = 0;
+  for(const auto &method : TestMethods()) {
+    const auto name = std::string{method.className} + "::" + method.methodName;
+    bool selected = argc == 1;
+    for(int i = 1; i < argc && !selected; ++i)
+      selected = name == argv[i] || std::string{method.className} == argv[i];
+    if(!selected)
+      continue;
+
+    ++run;
+    const auto start = clock::now();
+    std::string error;
+    try {
+      method.run();
+    }
+    catch(const std::exception &ex) {
+      error = ex.what();
+    }
+    catch(...) {
+      error = "Unknown exception";
+    }
+    const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+    if(error.empty())
+      std::cout << "[  PASSED ] " << name << " (" << time << " ms)" << std::endl;
+    else {
+      ++failed;
+      std::cout << "[  FAILED ] " << name << " (" << time << " ms): " << error << std::endl;
+    }
+  }
+
+  std::cout << run - failed << " of " << run << " tests passed" << std::endl;
+  return failed || !run ? EXIT_FAILURE : EXIT_SUCCESS;
+}
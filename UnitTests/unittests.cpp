@@ -27,17 +27,50 @@
 
 #include "tools.h"
 #include "activeObject.h"
+#include "threadPool.h"
 #include "condor.h"
+#include "config.h"
+#include "coordConverterUTM.h"
+#include "deviceEmulator.h"
+#include "deviceSession.h"
+#include "directoryWatcher.h"
+#include "geodesy.h"
+#include "raceResultsIndex.h"
+#include "speedToFlyTable.h"
 #include "istream.h"
 #include "fileParserCSV.h"
 #include "fileParserINI.h"
+#include "resources.h"
+#include "ostream.h"
+#include "outputBuffer.h"
+#include "platform.h"
+#include "translationCache.h"
+#include "translator.h"
+#include "taskCorridor.h"
+#include "taskGeometry.h"
+#include "taskImage.h"
+#include "targetXCSoar6.h"
+#include "xmlWriter.h"
+#include "imports/lk8000Types.h"
+#include "traitsNoCase.h"
+#include "../tools/PolarOptimiser/src/batch.h"
+#include "../tools/PolarOptimiser/src/polarFit.h"
+#include "../tools/PolarOptimiser/src/polarSolver.h"
 #include "CppUnitTest.h"
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace condor2nav;
 
-template<> static std::wstring Microsoft::VisualStudio::CppUnitTestFramework::ToString<TPathType>(const TPathType& val)
+template<> std::wstring Microsoft::VisualStudio::CppUnitTestFramework::ToString<TPathType>(const TPathType& val)
 {
   return val == TPathType::LOCAL ? L"LOCAL" : L"ACTIVE_SYNC";
 }
@@ -143,10 +176,16 @@ namespace unitTests
 
     TEST_METHOD(FileExistsTest)
     {
+#if defined(_WIN32)
       Assert::IsTrue(FileExists("UnitTests.dll"));
       Assert::IsTrue(FileExists("unitTests.DLL"));
       Assert::IsTrue(FileExists("./UnitTests.dll"));
       Assert::IsTrue(FileExists(".\\UnitTests.dll"));
+#else
+      Assert::IsTrue(FileExists("unittests.cpp"));
+      Assert::IsTrue(FileExists("./unittests.cpp"));
+      Assert::IsTrue(FileExists(MAIN_SRC_DIR / "UnitTests/unittests.cpp"));
+#endif
       Assert::IsFalse(FileExists("nonexisting"));
     }
 
@@ -154,6 +193,122 @@ namespace unitTests
 
 
 
+  ////////////////////////   N O - C A S E   S T R I N G S   ////////////////////////
+
+  TEST_CLASS(TestTraitsNoCase) {
+    /**
+     * @brief Previous character by character implementation used as a reference.
+     */
+    struct CTraitsNoCaseScalar : std::char_traits<char> {
+      static bool lt(char c1, char c2) { return ToUpper(c1) < ToUpper(c2); }
+      static int compare(const char *s1, const char *s2, size_t N)
+      {
+        for(size_t i = 0; i < N; ++i) {
+          if(lt(s1[i], s2[i]))
+            return -1;
+          if(lt(s2[i], s1[i]))
+            return +1;
+        }
+        return 0;
+      }
+    };
+    using CStringNoCaseScalar = std::basic_string<char, CTraitsNoCaseScalar>;
+
+    static std::vector<std::string> Names(unsigned num)
+    {
+      const char *prefixes[] = { "Slovenia", "SLOVENIA", "AA3", "Alps_XL", "Colorado_C2", "Provence-Extended" };
+      std::vector<std::string> names;
+      names.reserve(num);
+      unsigned seed = 12345;
+      for(unsigned i = 0; i < num; ++i) {
+        seed = seed * 1103515245 + 12345;
+        names.emplace_back(std::string{prefixes[seed % 6]} + "_Landscape_" + Convert(seed % 100000));
+      }
+      return names;
+    }
+
+  public:
+    TEST_METHOD(Compare)
+    {
+      Assert::IsTrue(CStringNoCase{"Slovenia"} == "SLOVENIA");
+      Assert::IsTrue(CStringNoCase{"Provence-Extended_Landscape"} == "provence-extended_LANDSCAPE");
+      Assert::IsTrue(CStringNoCase{"Provence-Extended_Landscape_A"} < "provence-extended_LANDSCAPE_b");
+      Assert::IsTrue(CStringNoCase{"Provence-Extended_Landscape_["} > "provence-extended_LANDSCAPE_z");
+      Assert::IsTrue(CStringNoCase{"Provence-Extended_Landscape_1"} != "provence-extended_LANDSCAPE_");
+      Assert::IsTrue(CStringNoCase{"Provence_Extended_Landscape_1"} != "Provence-Extended_Landscape_1");
+      Assert::IsTrue(CStringNoCase{"Provence-Extended_Landscape_\xe9"} == "provence-extended_LANDSCAPE_\xe9");
+      Assert::IsTrue(CStringNoCase{"\xe9Provence-Extended_Landscape"} == "\xe9provence-extended_LANDSCAPE");
+    }
+
+    TEST_METHOD(Find)
+    {
+      const CStringNoCase str{"Provence-Extended_Landscape_Z.cup"};
+      Assert::AreEqual(28U, str.find('z'));
+      Assert::AreEqual(29U, str.find('.'));
+      Assert::AreEqual(30U, str.find("CUP"));
+      Assert::IsTrue(str.find('q') == CStringNoCase::npos);
+    }
+
+    TEST_METHOD(Hash)
+    {
+      const CHashNoCase hash;
+      Assert::IsTrue(hash(CStringNoCase{"Provence-Extended_Landscape"}) == hash(CStringNoCase{"PROVENCE-extended_landscape"}));
+      Assert::IsTrue(hash(CStringNoCase{"AA3"}) != hash(CStringNoCase{"AA4"}));
+      Assert::IsTrue(hash(CWStringNoCase{L"Slovenia"}) == hash(CWStringNoCase{L"sLOVENIA"}));
+
+      std::unordered_map<CStringNoCase, unsigned, CHashNoCase> map;
+      map["Slovenia"] = 1;
+      map["SLOVENIA"]++;
+      Assert::AreEqual(1U, map.size());
+      Assert::AreEqual(2U, map["slovenia"]);
+    }
+
+    TEST_METHOD(Benchmark100k)
+    {
+      using clock = std::chrono::steady_clock;
+      const auto names = Names(100000);
+
+      // reference implementation
+      std::vector<CStringNoCaseScalar> scalarNames;
+      for(const auto &name : names)
+        scalarNames.emplace_back(name.c_str());
+      auto start = clock::now();
+      std::sort(begin(scalarNames), end(scalarNames));
+      size_t scalarMatches = 0;
+      for(const auto &name : names)
+        scalarMatches += std::binary_search(begin(scalarNames), end(scalarNames), CStringNoCaseScalar{name.c_str()});
+      const auto scalarTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      std::vector<CStringNoCase> noCaseNames;
+      for(const auto &name : names)
+        noCaseNames.emplace_back(name.c_str());
+      start = clock::now();
+      std::sort(begin(noCaseNames), end(noCaseNames));
+      size_t matches = 0;
+      for(const auto &name : names)
+        matches += std::binary_search(begin(noCaseNames), end(noCaseNames), CStringNoCase{name.c_str()});
+      const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      std::unordered_set<CStringNoCase, CHashNoCase> set{begin(noCaseNames), end(noCaseNames)};
+      start = clock::now();
+      size_t hashMatches = 0;
+      for(const auto &name : names)
+        hashMatches += set.count(name.c_str());
+      const auto hashTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      Assert::AreEqual(names.size(), scalarMatches);
+      Assert::AreEqual(names.size(), matches);
+      Assert::AreEqual(names.size(), hashMatches);
+      for(size_t i = 0; i < names.size(); ++i)
+        Assert::AreEqual(0, CTraitsNoCaseScalar::compare(scalarNames[i].c_str(), noCaseNames[i].c_str(), noCaseNames[i].size()));
+
+      Logger::WriteMessage(("Sort and match of 100k names: character by character " + Convert(scalarTime) + " ms, SIMD " + Convert(time) +
+                            " ms, hash lookup " + Convert(hashTime) + " ms").c_str());
+    }
+  };
+
+
+
   ////////////////////////   A C T I V E   O B J E C T   ////////////////////////
 
   TEST_CLASS(TestActiveObject) {
@@ -171,6 +326,25 @@ namespace unitTests
 
 
 
+  ////////////////////////   T H R E A D   P O O L   ////////////////////////
+
+  TEST_CLASS(TestThreadPool) {
+  public:
+    TEST_METHOD(AllTasksRun)
+    {
+      std::vector<int> data(100);
+      {
+        CThreadPool pool(4);
+        for(size_t i = 0; i < data.size(); ++i)
+          pool.Send([&, i]{ data[i] = static_cast<int>(i); });
+      }
+      for(size_t i = 0; i < data.size(); ++i)
+        Assert::AreEqual(static_cast<int>(i), data[i]);
+    }
+  };
+
+
+
   ////////////////////////   I S T R E A M   ////////////////////////
 
   TEST_CLASS(TestIStream) {
@@ -188,7 +362,11 @@ namespace unitTests
       bfs::ifstream expected(MAIN_SRC_DIR / "README.txt");
       std::stringstream expectedStr;
       expectedStr << expected.rdbuf();
-      Assert::AreEqual(expectedStr.str(), actualStr.str());
+
+      // CRLF line endings are translated on every platform (not only in Windows text mode)
+      auto expectedData = expectedStr.str();
+      expectedData.erase(std::remove(expectedData.begin(), expectedData.end(), '\r'), expectedData.end());
+      Assert::AreEqual(expectedData, actualStr.str());
     }
 
     TEST_METHOD(GetLine)
@@ -204,6 +382,328 @@ namespace unitTests
       Assert::AreEqual(std::string(""), txt);
       Assert::IsFalse(static_cast<bool>(stream));
     }
+
+    TEST_METHOD(Chunked)
+    {
+      // CRLF split between chunks, lone CR kept and CR at the end of data kept
+      const size_t chunk = CReader::CHUNK_SIZE;
+      const std::string line1(chunk - 1, 'a'), line2(chunk, 'b');
+      const auto data = line1 + "\r\n" + line2 + "\rc\r\nd\r";
+
+      const auto device = std::make_shared<CDeviceEmulator>();
+      device->Write("\\My Documents\\data.txt", data);
+      CDeviceTransport::Select(device);
+      {
+        CIStream stream{"\\My Documents\\data.txt"};
+        std::string line;
+        stream.GetLine(line);
+        Assert::IsTrue(line == line1);
+        stream.GetLine(line);
+        Assert::IsTrue(line == line2 + "\rc");
+        stream.GetLine(line);
+        Assert::AreEqual(std::string{"d\r"}, line);
+        Assert::IsFalse(static_cast<bool>(stream.GetLine(line)));
+      }
+      CDeviceTransport::Select(nullptr);
+
+      // write, open, 3 chunks and close
+      const auto stats = device->Stats();
+      Assert::AreEqual(3U + 2U + 3U + 1U, stats.roundTrips);
+      Assert::AreEqual(data.size(), stats.bytesRead);
+
+      // the same hash as the one of translated data
+      CIStream::CBuffer buffer{std::make_unique<CReaderString>(data)};
+      std::stringstream out;
+      buffer.Copy([&](const char *ptr, std::streamsize size){ out.write(ptr, size); });
+      Assert::IsTrue(buffer.Eof());
+      Assert::AreEqual(line1 + "\n" + line2 + "\rc\nd\r", out.str());
+      Assert::IsTrue(CTranslationCache::Hash(out.str()) == buffer.Hash());
+    }
+  };
+
+
+
+  ////////////////////////   O S T R E A M   ////////////////////////
+
+  TEST_CLASS(TestOStream) {
+    static std::string FileRead(const bfs::path &path)
+    {
+      std::stringstream buffer;
+      buffer << bfs::ifstream{path, std::ios_base::in | std::ios_base::binary}.rdbuf();
+      return buffer.str();
+    }
+
+    /**
+     * @brief Previous COStream implementation (std::stringstream buffer).
+     */
+    static size_t LegacyWrite(const COStream::CPathList &pathList, const std::string &data)
+    {
+      std::stringstream buffer;
+      buffer.write(data.data(), data.size());
+      size_t copied = data.size();
+      if(buffer.str().size()) {
+        copied += data.size();
+        for(const auto &path : pathList) {
+          bfs::ofstream stream{path, std::ios_base::out | std::ios_base::binary};
+          stream << buffer.str();
+          const auto recorded = buffer.str();
+          copied += 2 * data.size();
+        }
+      }
+      return copied;
+    }
+
+  public:
+    TEST_METHOD(Segments)
+    {
+      const std::string binary(3 * COutputBuffer::BLOCK_SIZE / 2, 'b');
+      COutputBuffer buffer;
+      std::ostream stream{&buffer};
+      stream << "header " << 42 << "\n";
+      buffer.Attach(binary.data(), binary.size());
+      for(unsigned i = 0; i < 5000; ++i)
+        stream << i << ",";
+      buffer.sputn(binary.data(), binary.size());
+
+      std::stringstream expected;
+      expected << "header " << 42 << "\n" << binary;
+      for(unsigned i = 0; i < 5000; ++i)
+        expected << i << ",";
+      expected << binary;
+
+      Assert::AreEqual(expected.str().size(), buffer.Size());
+      Assert::AreEqual(buffer.Size() - binary.size(), buffer.Copied());
+      const auto &segments = buffer.Segments();
+      Assert::IsTrue(segments.size() >= 4);
+      Assert::IsTrue(segments[1].data == binary.data());
+      Assert::IsTrue(expected.str() == buffer.String());
+    }
+
+    TEST_METHOD(Write)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      const std::string binary(100000, '\x7f');
+      {
+        COStream stream{COStream::CPathList{dir / "a.txt", dir / "b.txt"}};
+        stream << "line " << 1 << std::endl;
+        stream.Attach(binary.data(), binary.size());
+        stream.Write("end", 3);
+      }
+      const auto expected = "line 1\n" + binary + "end";
+      Assert::IsTrue(expected == FileRead(dir / "a.txt"));
+      Assert::IsTrue(expected == FileRead(dir / "b.txt"));
+
+      // empty stream does not create a file
+      { COStream stream{dir / "c.txt"}; }
+      Assert::IsFalse(bfs::exists(dir / "c.txt"));
+      bfs::remove_all(dir);
+    }
+
+    TEST_METHOD(BenchmarkTaskFile)
+    {
+      using clock = std::chrono::steady_clock;
+      const unsigned loops = 500;
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+
+      // LK8000 task file written to condor2nav and default task file paths
+      CTaskImage image{CTaskImage::TFormat::LK8000_1_24};
+      const auto &data = image.Data();
+      const COStream::CPathList pathList{dir / "condor2nav.lkt", dir / "DEFAULT.lkt"};
+
+      auto start = clock::now();
+      size_t legacyCopied = 0;
+      for(unsigned i = 0; i < loops; ++i)
+        legacyCopied += LegacyWrite(pathList, data);
+      const auto legacyTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+      Assert::IsTrue(data == FileRead(pathList[1]));
+
+      start = clock::now();
+      for(unsigned i = 0; i < loops; ++i)
+        COStream{pathList}.Attach(data.data(), data.size());
+      const auto time = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+      Assert::IsTrue(data == FileRead(pathList[0]));
+      Assert::IsTrue(data == FileRead(pathList[1]));
+
+      COutputBuffer buffer;
+      buffer.Attach(data.data(), data.size());
+      const size_t copied = loops * buffer.Copied();
+      Assert::AreEqual(0U, copied);
+      bfs::remove_all(dir);
+
+      Logger::WriteMessage(("Writing " + Convert(loops) + " LK8000 task files (" + Convert(data.size()) + " bytes, 2 destinations): stringstream " +
+                            Convert(legacyTime / 1000.0) + " ms and " + Convert(legacyCopied / 1024) + " kB copied, segmented buffer " +
+                            Convert(time / 1000.0) + " ms and " + Convert(copied / 1024) + " kB copied").c_str());
+    }
+  };
+
+
+
+  ////////////////////////   D E V I C E   T R A N S P O R T   ////////////////////////
+
+  TEST_CLASS(TestDeviceTransport) {
+  public:
+    TEST_METHOD(Emulator)
+    {
+      CDeviceEmulator device;
+      Assert::ExpectException<EOperationFailed>([&]{ device.DirectoryCreate("\\My Documents\\XCSoarData\\Tasks"); });
+      Assert::ExpectException<EOperationFailed>([&]{ device.Write("\\My Documents\\XCSoarData\\a.txt", "data"); });
+      Assert::ExpectException<EOperationFailed>([&]{ device.Read("\\My Documents\\a.txt"); });
+      device.DirectoryCreate("\\My Documents\\XCSoarData");
+      device.DirectoryCreate("\\My Documents\\XCSoarData\\Tasks");
+      device.Write("\\My Documents\\XCSoarData\\a.txt", "data\r\n");
+      Assert::AreEqual(std::string{"data\r\n"}, device.Read("\\my documents\\xcsoardata\\A.TXT"));
+      Assert::IsTrue(device.FileExists("\\My Documents\\XCSoarData\\Tasks"));
+      Assert::IsFalse(device.FileExists("\\My Documents\\XCSoarData\\b.txt"));
+
+      // RAPI calls: 2 failed + 2 directories + 3 write + 4 read + 2 * 2 probes
+      const auto stats = device.Stats();
+      Assert::AreEqual(3U + 2U + 3U + 4U + 4U, stats.roundTrips);
+      Assert::AreEqual(size_t{6}, stats.bytesRead);
+      Assert::AreEqual(size_t{6}, stats.bytesWritten);
+      device.StatsReset();
+      Assert::AreEqual(0U, device.Stats().roundTrips);
+    }
+
+    TEST_METHOD(EmulatorCost)
+    {
+      using clock = std::chrono::steady_clock;
+      CDeviceEmulator device{std::chrono::milliseconds{2}, 1024 * 1024};
+      const auto start = clock::now();
+      for(unsigned i = 0; i < 5; i++)
+        device.FileExists("\\My Documents\\a.txt");
+      device.Write("\\My Documents\\a.txt", std::string(20 * 1024, 'x'));
+      const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      // 13 round trips and 20 KB with 1 MB/s
+      Assert::AreEqual(13U, device.Stats().roundTrips);
+      Assert::IsTrue(time >= 13 * 2 + 19);
+    }
+
+    TEST_METHOD(Routing)
+    {
+      const auto device = std::make_shared<CDeviceEmulator>();
+      CDeviceTransport::Select(device);
+      DirectoryCreate("\\My Documents\\XCSoarData\\Tasks");
+      Assert::IsTrue(FileExists("\\My Documents\\XCSoarData\\Tasks"));
+      {
+        COStream stream{"\\My Documents\\XCSoarData\\Tasks\\task.txt"};
+        stream << "line1\r\nline2\r\n";
+      }
+      CIStream stream{"\\My Documents\\XCSoarData\\Tasks\\task.txt"};
+      std::string line;
+      stream.GetLine(line);
+      Assert::AreEqual(std::string{"line1"}, line);
+      stream.GetLine(line);
+      Assert::AreEqual(std::string{"line2"}, line);
+      CDeviceTransport::Select(nullptr);
+      Assert::AreEqual(size_t{14}, device->Stats().bytesWritten);
+    }
+
+    TEST_METHOD(Local)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir / "My Documents");
+      {
+        CDeviceTransportLocal device{dir};
+        device.DirectoryCreate("\\My Documents\\LK8000");
+        device.Write("\\My Documents\\LK8000\\a.txt", "data");
+        Assert::IsTrue(bfs::exists(dir / "My Documents" / "LK8000" / "a.txt"));
+        Assert::AreEqual(std::string{"data"}, device.Read("\\My Documents\\LK8000\\a.txt"));
+        Assert::IsFalse(device.FileExists("\\My Documents\\b.txt"));
+      }
+      bfs::remove_all(dir);
+      Assert::ExpectException<EOperationFailed>([&]{ CDeviceTransportLocal device{dir}; });
+    }
+
+    TEST_METHOD(Session)
+    {
+      const auto device = std::make_shared<CDeviceEmulator>();
+      device->DirectoryCreate("\\My Documents\\XCSoarData");
+      device->Write("\\My Documents\\XCSoarData\\a.txt", "old");
+      device->StatsReset();
+      {
+        CDeviceSession session{device};
+        Assert::IsTrue(CDeviceTransport::Current().get() == &session);
+        Assert::IsTrue(FileExists("\\My Documents\\XCSoarData\\A.TXT"));
+        Assert::IsFalse(FileExists("\\My Documents\\XCSoarData\\b.txt"));
+        Assert::IsFalse(FileExists("\\My Documents\\XCSoarData\\Tasks\\task.tsk"));
+        DirectoryCreate("\\My Documents\\XCSoarData\\Tasks");
+        Assert::IsTrue(FileExists("\\My Documents\\XCSoarData\\Tasks"));
+        Assert::ExpectException<EOperationFailed>([&]{ session.Write("\\My Documents\\Missing\\a.txt", "data"); });
+        Assert::ExpectException<EOperationFailed>([&]{ session.Read("\\My Documents\\XCSoarData\\b.txt"); });
+        Assert::AreEqual(std::string{"old"}, session.Read("\\My Documents\\XCSoarData\\a.txt"));
+        session.Write("\\My Documents\\XCSoarData\\Tasks\\task.tsk", "1");
+        session.Write("\\My Documents\\XCSoarData\\Tasks\\task.tsk", "2");
+        Assert::AreEqual(std::string{"2"}, session.Read("\\My Documents\\XCSoarData\\Tasks\\task.tsk"));
+        CDeviceTransport::CEntriesList entries;
+        Assert::IsTrue(session.List("\\My Documents\\XCSoarData", entries));
+        Assert::AreEqual(size_t{2}, entries.size());
+
+        // nothing written to the device before commit
+        Assert::IsFalse(device->FileExists("\\My Documents\\XCSoarData\\Tasks"));
+        session.Commit();
+        Assert::AreEqual(2U, session.Stats().listings);         // "\\My Documents" and "\\My Documents\\XCSoarData"
+        Assert::AreEqual(1U, session.Stats().creates);
+        Assert::AreEqual(1U, session.Stats().writes);
+      }
+      Assert::AreEqual(std::string{"2"}, device->Read("\\My Documents\\XCSoarData\\Tasks\\task.tsk"));
+
+      // not committed changes are discarded
+      {
+        CDeviceSession session{device};
+        session.Write("\\My Documents\\XCSoarData\\c.txt", "data");
+      }
+      Assert::IsFalse(device->FileExists("\\My Documents\\XCSoarData\\c.txt"));
+    }
+
+    TEST_METHOD(SessionRoundTrips)
+    {
+      // device calls done by LK8000 target
+      const auto translation = []{
+        const bfs::path root{"\\My Documents\\LK8000"};
+        for(const auto dir : {"_Airspaces", "_Maps", "_Polars", "_Waypoints", "_Tasks", "_Configuration"})
+          DirectoryCreate(root / dir / "condor2nav");
+        const auto config = root / "_Configuration";
+        if(!FileExists(config / "condor2nav" / "Condor.prf"))
+          FileExists(config / "DEFAULT_PROFILE.prf");
+        if(!FileExists(config / "condor2nav" / "Condor.acf"))
+          FileExists(config / "DEFAULT_AIRCRAFT.acf");
+        for(const auto file : {"_Tasks/condor2nav/Condor.tsk", "_Tasks/Default.tsk", "_Polars/condor2nav/Condor.plr",
+                               "_Configuration/condor2nav/Condor.prf", "_Configuration/condor2nav/Condor.acf"}) {
+          COStream stream{root / file};
+          stream << "data\r\n";
+        }
+      };
+
+      unsigned roundTrips[2][2];
+      for(unsigned batched = 0; batched < 2; ++batched) {
+        const auto device = std::make_shared<CDeviceEmulator>();
+        CDeviceTransport::Select(device);
+        for(unsigned run = 0; run < 2; ++run) {
+          device->StatsReset();
+          if(batched) {
+            CDeviceSession session;
+            translation();
+            session.Commit();
+          }
+          else {
+            translation();
+          }
+          roundTrips[batched][run] = device->Stats().roundTrips;
+        }
+        CDeviceTransport::Select(nullptr);
+        Assert::AreEqual(size_t{0}, device->Stats().bytesRead);
+      }
+
+      Logger::WriteMessage(("LK8000 round trips (first/next translation): " + Convert(roundTrips[0][0]) + "/" + Convert(roundTrips[0][1]) +
+                            " direct, " + Convert(roundTrips[1][0]) + "/" + Convert(roundTrips[1][1]) + " batched").c_str());
+      Assert::AreEqual(46U, roundTrips[0][0]);
+      Assert::AreEqual(55U, roundTrips[0][1]);
+      Assert::IsTrue(roundTrips[1][0] < roundTrips[0][0]);
+      Assert::IsTrue(roundTrips[1][1] * 2 < roundTrips[0][1]);
+    }
   };
 
 
@@ -263,6 +763,166 @@ namespace unitTests
       Assert::ExpectException<EOperationFailed>([&]{ parser.Value("", "", "Fail"); });
       Assert::ExpectException<EOperationFailed>([&]{ parser.Value("", {}, "Fail"); });
     }
+
+    TEST_METHOD(TryValue)
+    {
+      CFileParserINI parser(MAIN_SRC_DIR / "data/condor2nav.ini");
+      const auto target = parser.TryValue("Condor2Nav", "Target");
+      Assert::IsTrue(target.is_initialized());
+      Assert::IsTrue(&*target == &parser.Value("Condor2Nav", "Target"));
+      Assert::IsFalse(parser.TryValue("Condor2Nav", "DefaultTaskOverwrite").is_initialized());
+      Assert::IsFalse(parser.TryValue("", "DefaultTaskOverwrite").is_initialized());
+      Assert::IsFalse(parser.TryValue("NonExisting", "DefaultTaskOverwrite").is_initialized());
+      Assert::IsFalse(parser.TryValue("", "").is_initialized());
+      parser.Value("", "NonExisting", "Test");
+      Assert::AreEqual(std::string("Test"), *parser.TryValue("", "NonExisting"));
+    }
+
+    TEST_METHOD(TryValueBenchmark)
+    {
+      using clock = std::chrono::steady_clock;
+      const unsigned loops = 20000;
+
+      // condor-club entries are not present in a plain Condor task
+      const auto path = bfs::temp_directory_path() / bfs::unique_path();
+      {
+        bfs::ofstream stream{path};
+        stream << "[Version]\nCondor version=1150\n[Task]\nLandscape=Slovenia\nCount=4\n";
+        for(unsigned i=0; i<4; i++)
+          stream << "TPName" << i << "=TP" << i << "\nTPPosX" << i << "=" << 10000 * (i + 1) << "\nTPRadius" << i << "=3000\n";
+        stream << "[Weather]\nWindDir=270\nWindSpeed=5\n";
+      }
+      const CFileParserINI parser{path};
+      bfs::remove(path);
+
+      auto start = clock::now();
+      unsigned found = 0;
+      for(unsigned i=0; i<loops; i++) {
+        try {
+          parser.Value("Task", "AAT");
+          found++;
+        }
+        catch(const EOperationFailed &) {
+        }
+        try {
+          parser.Value("Task", "DesignatedTime");
+          found++;
+        }
+        catch(const EOperationFailed &) {
+        }
+      }
+      const auto exceptionTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      start = clock::now();
+      unsigned tryFound = 0;
+      for(unsigned i=0; i<loops; i++) {
+        if(parser.TryValue("Task", "AAT"))
+          tryFound++;
+        if(parser.TryValue("Task", "DesignatedTime"))
+          tryFound++;
+      }
+      const auto tryTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      Assert::AreEqual(0U, found);
+      Assert::AreEqual(0U, tryFound);
+      Logger::WriteMessage(("Probing " + Convert(2 * loops) + " missing FPL entries: exceptions " + Convert(exceptionTime) +
+                            " us, TryValue " + Convert(tryTime) + " us").c_str());
+    }
+
+    TEST_METHOD(Patch)
+    {
+      const auto read = [](const bfs::path &path) {
+        std::ostringstream buffer;
+        buffer << bfs::ifstream{path, std::ios_base::in | std::ios_base::binary}.rdbuf();
+        return buffer.str();
+      };
+
+      const auto path = bfs::temp_directory_path() / bfs::unique_path();
+      const auto output = bfs::temp_directory_path() / bfs::unique_path();
+      const std::string source = "; profile\r\nZulu = 1 \r\nAlpha=2\r\n\r\n[Chapter]\r\n# comment\r\nKey=old\r\n\r\n[Empty]\r\n[Last]\r\nName=x";
+      {
+        bfs::ofstream stream{path, std::ios_base::out | std::ios_base::binary};
+        stream << source;
+      }
+      CFileParserINI parser{path};
+      bfs::remove(path);
+
+      // not modified file is recreated byte by byte
+      auto stats = parser.Patch(output);
+      Assert::AreEqual(source, read(output));
+      Assert::AreEqual(source.size(), stats.size);
+
+      // the same value does not modify the file
+      parser.Value("", "Zulu", "1");
+      parser.Patch(output);
+      Assert::AreEqual(source, read(output));
+
+      parser.Value("", "Zulu", "100");
+      parser.Value("", "Beta", "3");
+      parser.Value("Chapter", "Key", "new");
+      parser.Value("Chapter", "Added", "a");
+      parser.Value("Empty", "Added", "b");
+      parser.Value("Last", "Added", "c");
+      stats = parser.Patch(output);
+      const std::string expected = "; profile\r\nZulu = 100 \r\nAlpha=2\r\nBeta=3\r\n\r\n[Chapter]\r\n# comment\r\nKey=new\r\nAdded=a\r\n\r\n"
+                                   "[Empty]\r\nAdded=b\r\n[Last]\r\nName=x\r\nAdded=c\r\n";
+      Assert::AreEqual(expected, read(output));
+      Assert::AreEqual(expected.size(), stats.size);
+      Assert::AreEqual(expected.size(), stats.written);
+
+      // patched file is parsed the same way
+      CFileParserINI patched{output};
+      Assert::AreEqual(std::string{"100"}, patched.Value("", "Zulu"));
+      Assert::AreEqual(std::string{"a"}, patched.Value("Chapter", "Added"));
+      Assert::AreEqual(std::string{"c"}, patched.Value("Last", "Added"));
+      bfs::remove(output);
+    }
+
+    TEST_METHOD(PatchDevice)
+    {
+      // profile similar to LK8000 one (about 300 entries in one chapter)
+      const bfs::path path{"\\My Documents\\LK8000\\_Configuration\\DEFAULT_PROFILE.prf"};
+      std::string source;
+      for(unsigned i=0; i<300; i++)
+        source += "Setting" + Convert(i) + "=" + Convert(i * 37) + "\r\n";
+
+      const auto device = std::make_shared<CDeviceEmulator>();
+      device->DirectoryCreate("\\My Documents\\LK8000");
+      device->DirectoryCreate("\\My Documents\\LK8000\\_Configuration");
+      device->Write(path, source);
+
+      // the value of the same size changes only its bytes
+      {
+        CDeviceSession session{device};
+        CFileParserINI parser{path};
+        parser.Value("", "Setting150", "4321");
+        parser.Value("", "Setting151", "5587");           // the same value
+        const auto stats = parser.Patch();
+        session.Commit();
+
+        source.replace(source.find("Setting150=5550") + 11, 4, "4321");
+        Assert::AreEqual(source, device->Read(path));
+        Assert::AreEqual(source.size(), stats.size);
+        Assert::AreEqual(size_t{4}, stats.written);
+        Assert::AreEqual(0U, session.Stats().writes);
+        Assert::AreEqual(1U, session.Stats().patches);
+        Assert::AreEqual(size_t{4}, session.Stats().bytes);
+      }
+
+      // new value at the end of the file changes the size of the file
+      {
+        CDeviceSession session{device};
+        CFileParserINI parser{path};
+        parser.Value("", "Setting299", "1");
+        parser.Value("", "Setting300", "2");
+        const auto stats = parser.Patch();
+        session.Commit();
+        Logger::WriteMessage(("Profile patch on the device: " + Convert(stats.written) + " of " + Convert(stats.size) + " bytes sent").c_str());
+        Assert::AreEqual(std::string{"Setting299=1\r\nSetting300=2\r\n"}, device->Read(path).substr(source.find("Setting299=")));
+        Assert::IsTrue(stats.written < 32);
+        Assert::AreEqual(stats.written, session.Stats().bytes);
+      }
+    }
   };
 
 
@@ -298,6 +958,49 @@ namespace unitTests
       Assert::ExpectException<EOperationFailed>([&]{ parser.Row("asw28")[1]; });
       Assert::ExpectException<EOperationFailed>([&]{ parser.Row("123", 1)[0]; });
     }
+
+    TEST_METHOD(TryRow)
+    {
+      CFileParserCSV parser(MAIN_SRC_DIR / "data/GliderData.csv");
+      Assert::AreEqual(std::string("285"), parser.TryRow("ASW28")->at(1));
+      Assert::AreEqual(std::string("285"), parser.TryRow("asw28", 0, true)->at(1));
+      Assert::IsFalse(parser.TryRow("asw28").is_initialized());
+      Assert::IsFalse(parser.TryRow("123", 1).is_initialized());
+
+      auto row = parser.TryRow("ASW22");
+      (*row)[1] = "999";
+      const auto &constParser = parser;
+      Assert::AreEqual(std::string("999"), constParser.TryRow("ASW22")->at(1));
+    }
+
+    TEST_METHOD(LineParse)
+    {
+      const auto values = CFileParserCSV::LineParse("\"Aosta, Italy\",,IT,4544.268N,00722.188E,540.0m,5");
+      Assert::AreEqual(7U, values.size());
+      Assert::AreEqual(std::string("Aosta, Italy"), values[0]);
+      Assert::AreEqual(std::string(""), values[1]);
+      Assert::AreEqual(std::string("00722.188E"), values[4]);
+      Assert::AreEqual(std::string("5"), values[6]);
+    }
+
+    TEST_METHOD(Dump)
+    {
+      const auto path = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::ofstream{path} << "Name,Flaps,Comment" << std::endl
+                          << "ASW27,\"317,6,0,5\",\"Called \"\"Diana\"\", \"\"Diana, 2\"\"\"" << std::endl;
+      CFileParserCSV parser{path};
+      Assert::AreEqual(std::string("Called \"Diana\", \"Diana, 2\""), parser.Row("ASW27").at(2));
+      parser.Rows()[1][0] = "ASW \"27\"";
+      parser.Dump();
+      const CFileParserCSV dumped{path};
+      bfs::remove(path);
+      Assert::IsTrue(parser.Rows() == dumped.Rows());
+      Assert::AreEqual(std::string("317,6,0,5"), dumped.Rows()[1].at(1));
+
+      bfs::ofstream{path};
+      Assert::ExpectException<EOperationFailed>([&]{ CFileParserCSV{path}; });
+      bfs::remove(path);
+    }
   };
 
 
@@ -308,7 +1011,111 @@ namespace unitTests
   public:
     TEST_METHOD(InstallPath)
     {
+#if defined(_WIN32)
       Assert::AreEqual("C:\\Program Files (x86)\\Condor", condor::InstallPath().string().c_str());
+#else
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      const auto wine = dir / "wine";
+      bfs::create_directories(wine / "dosdevices" / "c:" / "Condor");
+      bfs::ofstream{wine / "user.reg"} << "WINE REGISTRY Version 2\n\n"
+                                        << "[Software\\\\Condor] 1311111111\n"
+                                        << "\"InstallDir\"=\"C:\\\\Condor\"\n";
+      const auto installDir = platform::Environment("CONDOR_INSTALL_DIR");
+      const auto winePrefix = platform::Environment("WINEPREFIX");
+      setenv("WINEPREFIX", wine.string().c_str(), 1);
+      unsetenv("CONDOR_INSTALL_DIR");
+      const auto winePath = condor::InstallPath();
+      setenv("CONDOR_INSTALL_DIR", dir.string().c_str(), 1);
+      const auto envPath = condor::InstallPath();
+
+      // restore environment
+      if(installDir.empty()) unsetenv("CONDOR_INSTALL_DIR"); else setenv("CONDOR_INSTALL_DIR", installDir.c_str(), 1);
+      if(winePrefix.empty()) unsetenv("WINEPREFIX"); else setenv("WINEPREFIX", winePrefix.c_str(), 1);
+      bfs::remove_all(dir);
+
+      Assert::AreEqual((wine / "dosdevices" / "c:" / "Condor").string(), winePath.string());
+      Assert::AreEqual(dir.string(), envPath.string());
+#endif
+    }
+
+    TEST_METHOD(CoordConverterUTM)
+    {
+      // zone boundary on the equator
+      auto lonLat = CCoordConverterUTM::UTMToLonLat(31, true, 166021.4431, 0);
+      Assert::AreEqual(0.0, lonLat.first, 1e-6);
+      Assert::AreEqual(0.0, lonLat.second, 1e-6);
+
+      // zone central meridian
+      lonLat = CCoordConverterUTM::UTMToLonLat(33, true, 500000, 5000000);
+      Assert::AreEqual(15.0, lonLat.first, 1e-9);
+      Assert::AreEqual(45.1535, lonLat.second, 1e-4);
+
+      // Southern hemisphere false northing
+      lonLat = CCoordConverterUTM::UTMToLonLat(56, false, 500000, 10000000);
+      Assert::AreEqual(153.0, lonLat.first, 1e-9);
+      Assert::AreEqual(0.0, lonLat.second, 1e-9);
+
+      // Condor map origin in the bottom-right corner with X axis pointing West
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      const auto trn = dir / "Landscapes" / "Test" / "Test.trn";
+      bfs::create_directories(trn.parent_path());
+      {
+        bfs::ofstream stream{trn, std::ios::binary};
+        const std::int32_t size[] = { 1024, 1024 };
+        const float geometry[] = { 90, 90, 510000, 4990000 };
+        const std::int32_t zone = 33;
+        stream.write(reinterpret_cast<const char *>(size), sizeof(size));
+        stream.write(reinterpret_cast<const char *>(geometry), sizeof(geometry));
+        stream.write(reinterpret_cast<const char *>(&zone), sizeof(zone));
+        stream.write("N", 1);
+      }
+#if !defined(_WIN32)
+      // landscape terrain file projection is used only on request
+      const auto coordConverter = platform::Environment("CONDOR2NAV_COORD_CONVERTER");
+      unsetenv("CONDOR2NAV_COORD_CONVERTER");
+      Assert::ExpectException<EOperationFailed>([&]{ CCondor::CCoordConverter::Create(dir, "Test"); });
+      setenv("CONDOR2NAV_COORD_CONVERTER", "UTM", 1);
+      const auto converter = CCondor::CCoordConverter::Create(dir, "Test");
+      if(coordConverter.empty()) unsetenv("CONDOR2NAV_COORD_CONVERTER"); else setenv("CONDOR2NAV_COORD_CONVERTER", coordConverter.c_str(), 1);
+#else
+      const auto converter = CCoordConverterUTM::FromTRN(trn);
+#endif
+
+      // unexpected header layout
+      {
+        bfs::ofstream stream{trn, std::ios::binary};
+        const std::int32_t size[] = { 1024, 1024 };
+        const float geometry[] = { 90, 90, 4990000, 510000 };
+        stream.write(reinterpret_cast<const char *>(size), sizeof(size));
+        stream.write(reinterpret_cast<const char *>(geometry), sizeof(geometry));
+        stream.write("\x21\0\0\0N", 5);
+      }
+      Assert::ExpectException<EOperationFailed>([&]{ CCoordConverterUTM::FromTRN(trn); });
+      bfs::remove_all(dir);
+      Assert::AreEqual(Coord2DDMMFF(TLongitude{15.0}), Coord2DDMMFF(converter->Longitude("10000", "10000")));
+      Assert::AreEqual(Coord2DDMMFF(TLatitude{45.1534772}), Coord2DDMMFF(converter->Latitude("10000", "10000")));
+    }
+
+    TEST_METHOD(CoordConverterPoints)
+    {
+      class CCountingConverter : public CCondor::CCoordConverter {
+        CPoint XYToLonLat(float x, float y) const override { calls++; return CPoint{x, y}; }
+      public:
+        mutable unsigned calls = 0;
+      };
+
+      // the same point is converted only once
+      CCountingConverter converter;
+      converter.Longitude("100", "200");
+      converter.Latitude("100", "200");
+      Assert::AreEqual(1U, converter.calls);
+
+      // remembered points are bounded
+      for(unsigned i = 0; i < 5000; i++)
+        Assert::AreEqual(static_cast<double>(i), converter.Longitude(Convert(i), "0").value, 1e-9);
+      Assert::AreEqual(5001U, converter.calls);
+      converter.Longitude("0", "0");
+      Assert::AreEqual(5002U, converter.calls);
     }
 
     //TEST_METHOD(FPLPath)
@@ -328,4 +1135,1714 @@ namespace unitTests
 
   };
 
+
+
+  ////////////////////////   T A S K   C O R R I D O R   ////////////////////////
+
+  TEST_CLASS(TestTaskCorridor) {
+  public:
+    TEST_METHOD(SinglePoint)
+    {
+      CTaskCorridor corridor(10);
+      corridor.PointAdd(TLongitude{15}, TLatitude{50});
+      Assert::IsTrue(corridor.Inside(TLongitude{15}, TLatitude{50}));
+      Assert::IsTrue(corridor.Inside(TLongitude{15}, TLatitude{50.08}));    // ~8.9km
+      Assert::IsFalse(corridor.Inside(TLongitude{15}, TLatitude{50.1}));    // ~11.1km
+      Assert::IsTrue(corridor.Inside(TLongitude{15.13}, TLatitude{50}));    // ~9.3km
+      Assert::IsFalse(corridor.Inside(TLongitude{15.15}, TLatitude{50}));   // ~10.7km
+    }
+
+    TEST_METHOD(Legs)
+    {
+      CTaskCorridor corridor(5);
+      corridor.PointAdd(TLongitude{15}, TLatitude{50});
+      corridor.PointAdd(TLongitude{16}, TLatitude{50});
+      corridor.PointAdd(TLongitude{16}, TLatitude{51});
+
+      // along the legs
+      Assert::IsTrue(corridor.Inside(TLongitude{15.5}, TLatitude{50.04}));
+      Assert::IsTrue(corridor.Inside(TLongitude{15.5}, TLatitude{49.96}));
+      Assert::IsTrue(corridor.Inside(TLongitude{16.06}, TLatitude{50.5}));
+      Assert::IsTrue(corridor.Inside(TLongitude{15.94}, TLatitude{50.5}));
+
+      // outside of the legs
+      Assert::IsFalse(corridor.Inside(TLongitude{15.5}, TLatitude{50.06}));
+      Assert::IsFalse(corridor.Inside(TLongitude{15.5}, TLatitude{50.5}));
+      Assert::IsFalse(corridor.Inside(TLongitude{16.08}, TLatitude{50.5}));
+      Assert::IsFalse(corridor.Inside(TLongitude{14.9}, TLatitude{50}));
+      Assert::IsFalse(corridor.Inside(TLongitude{16}, TLatitude{51.06}));
+    }
+  };
+
+
+  TEST_CLASS(TestTaskGeometry) {
+    typedef CTaskGeometry::TPoint TPoint;
+
+    static double Distance(const TPoint &p1, const TPoint &p2)
+    {
+      double distance, bearing;
+      CTaskGeometry::DistanceBearing(p1, p2, distance, bearing);
+      return distance;
+    }
+
+    static double Bearing(const TPoint &p1, const TPoint &p2)
+    {
+      double distance, bearing;
+      CTaskGeometry::DistanceBearing(p1, p2, distance, bearing);
+      return bearing;
+    }
+
+    static double AngleDiff(double angle1, double angle2)
+    {
+      return std::fmod(angle1 - angle2 + 540, 360.0) - 180;
+    }
+
+  public:
+    TEST_METHOD(DistanceBearing)
+    {
+      double distance, bearing;
+      CTaskGeometry::DistanceBearing(TPoint{0, 0}, TPoint{0, 1}, distance, bearing);
+      Assert::AreEqual(111194.93, distance, 0.01);
+      Assert::AreEqual(90.0, bearing, 1e-9);
+      CTaskGeometry::DistanceBearing(TPoint{0, 1}, TPoint{0, 0}, distance, bearing);
+      Assert::AreEqual(270.0, bearing, 1e-9);
+      CTaskGeometry::DistanceBearing(TPoint{46, 14}, TPoint{47, 14}, distance, bearing);
+      Assert::AreEqual(0.0, bearing, 1e-9);
+
+      // Land's End to John o' Groats
+      CTaskGeometry::DistanceBearing(TPoint{50.06639, -5.71472}, TPoint{58.64389, -3.07}, distance, bearing);
+      Assert::AreEqual(968900.0, distance, 100.0);
+      Assert::AreEqual(9.1198, bearing, 1e-3);
+    }
+
+    TEST_METHOD(Destination)
+    {
+      const auto point = CTaskGeometry::Destination(TPoint{53.3206, -1.7297}, 96.0217, 124800);
+      Assert::AreEqual(53.1883, point.latitude, 1e-3);
+      Assert::AreEqual(0.1333, point.longitude, 1e-3);
+
+      const TPoint start{46.3, 14.2};
+      for(unsigned bearing=0; bearing<360; bearing+=15) {
+        const auto end = CTaskGeometry::Destination(start, bearing, 25000);
+        Assert::AreEqual(25000.0, Distance(start, end), 1e-3);
+        Assert::AreEqual(0.0, AngleDiff(Bearing(start, end), bearing), 1e-6);
+      }
+    }
+
+    TEST_METHOD(BiSector)
+    {
+      Assert::AreEqual(315.0, CTaskGeometry::BiSector(90, 0), 1e-9);     // east then north
+      Assert::AreEqual(45.0, CTaskGeometry::BiSector(270, 0), 1e-9);     // west then north
+      Assert::AreEqual(270.0, CTaskGeometry::BiSector(180, 180), 1e-9);  // straight south
+      Assert::AreEqual(180.0, CTaskGeometry::BiSector(350, 190), 1e-9);  // turn back
+    }
+
+    TEST_METHOD(Fill)
+    {
+      const CTaskGeometry::CPointArray points{ TPoint{46.0, 14.0}, TPoint{46.0, 14.5}, TPoint{46.4, 14.5}, TPoint{46.0, 14.0} };
+      xcsoar::SETTINGS_TASK settings{};
+      settings.StartRadius = 3000;
+      settings.SectorRadius = 500;
+      settings.FinishRadius = 1000;
+      xcsoar::TASK_POINT tps[xcsoar::MAXTASKPOINTS] = {};
+      CTaskGeometry{points}.Fill(settings, tps);
+
+      Assert::AreEqual(0.0, tps[0].Leg);
+      for(unsigned i=1; i<points.size(); i++) {
+        Assert::AreEqual(Distance(points[i - 1], points[i]), tps[i].Leg, 1e-6);
+        Assert::AreEqual(Bearing(points[i - 1], points[i]), tps[i].InBound, 1e-9);
+        Assert::AreEqual(tps[i].InBound, tps[i - 1].OutBound, 1e-9);
+      }
+      Assert::AreEqual(90.0, tps[1].InBound, 0.5);
+      Assert::AreEqual(0.0, tps[1].OutBound, 1e-9);
+      Assert::AreEqual(315.0, tps[1].Bisector, 0.5);
+
+      const double radius[] = { 3000, 500, 500, 1000 };
+      for(unsigned i=0; i<points.size(); i++) {
+        const TPoint start{tps[i].SectorStartLat, tps[i].SectorStartLon};
+        const TPoint end{tps[i].SectorEndLat, tps[i].SectorEndLon};
+        Assert::AreEqual(radius[i], Distance(points[i], start), 1e-3);
+        Assert::AreEqual(radius[i], Distance(points[i], end), 1e-3);
+        Assert::AreEqual(points[i].latitude, tps[i].AATTargetLat);
+        Assert::AreEqual(points[i].longitude, tps[i].AATTargetLon);
+      }
+
+      // start line perpendicular to the first leg
+      Assert::AreEqual(0.0, AngleDiff(Bearing(points[0], TPoint{tps[0].SectorEndLat, tps[0].SectorEndLon}), 0), 0.5);
+      Assert::AreEqual(0.0, AngleDiff(Bearing(points[0], TPoint{tps[0].SectorStartLat, tps[0].SectorStartLon}), 180), 0.5);
+
+      // FAI sector of the first TP spans from east to south
+      Assert::AreEqual(90.0, Bearing(points[1], TPoint{tps[1].SectorStartLat, tps[1].SectorStartLon}), 0.5);
+      Assert::AreEqual(180.0, Bearing(points[1], TPoint{tps[1].SectorEndLat, tps[1].SectorEndLon}), 0.5);
+
+      // DAe sector radius does not depend on the configured one
+      settings.SectorType = xcsoar::AST_DAE;
+      CTaskGeometry{points}.Fill(settings, tps);
+      const double radiusDAe[] = { 3000, 10000, 10000, 1000 };
+      for(unsigned i=0; i<points.size(); i++) {
+        Assert::AreEqual(radiusDAe[i], Distance(points[i], TPoint{tps[i].SectorStartLat, tps[i].SectorStartLon}), 1e-3);
+        Assert::AreEqual(radiusDAe[i], Distance(points[i], TPoint{tps[i].SectorEndLat, tps[i].SectorEndLon}), 1e-3);
+      }
+    }
+
+    TEST_METHOD(AATDistances)
+    {
+      // start, AAT circle and finish on the equator
+      const double radius = 20000;
+      const CTaskGeometry::CPointArray points{ TPoint{0, 0}, TPoint{0, 1}, TPoint{0, 2} };
+      xcsoar::SETTINGS_TASK settings{};
+      settings.AATEnabled = true;
+      xcsoar::TASK_POINT tps[xcsoar::MAXTASKPOINTS] = {};
+      tps[1].AATType = xcsoar::WAYPOINT_AAT_CIRCLE;
+      tps[1].AATCircleRadius = radius;
+      const CTaskGeometry geometry{points};
+      geometry.Fill(settings, tps);
+      auto distances = geometry.AATDistances(tps);
+      const double leg = Distance(points[0], points[1]);
+      Assert::AreEqual(2 * leg, distances.nominal, 1e-6);
+      Assert::AreEqual(2 * leg, distances.min, 1e-6);
+      Assert::AreEqual(2 * std::sqrt(leg * leg + radius * radius), distances.max, 50.0);
+      Assert::AreEqual(radius, Distance(points[1], TPoint{tps[1].AATStartLat, tps[1].AATStartLon}), 1e-3);
+
+      // AAT sector pointing away from the finish
+      tps[1].AATType = xcsoar::WAYPOINT_AAT_SECTOR;
+      tps[1].AATSectorRadius = radius;
+      tps[1].AATStartRadial = 225;
+      tps[1].AATFinishRadial = 315;
+      geometry.Fill(settings, tps);
+      distances = geometry.AATDistances(tps);
+      Assert::AreEqual(2 * leg, distances.min, 1e-6);
+      Assert::IsTrue(distances.max > 2 * leg && distances.max < 2 * std::sqrt(leg * leg + radius * radius));
+      Assert::AreEqual(225.0, Bearing(points[1], TPoint{tps[1].AATStartLat, tps[1].AATStartLon}), 1e-6);
+      Assert::AreEqual(315.0, Bearing(points[1], TPoint{tps[1].AATFinishLat, tps[1].AATFinishLon}), 1e-6);
+
+      // AAT circle away from the course line
+      tps[1].AATType = xcsoar::WAYPOINT_AAT_CIRCLE;
+      const TPoint center{0.5, 1};
+      const CTaskGeometry offset{CTaskGeometry::CPointArray{ points[0], center, points[2] }};
+      distances = offset.AATDistances(tps);
+      Assert::AreEqual(2 * Distance(points[0], CTaskGeometry::Destination(center, 180, radius)), distances.min, 1.0);
+    }
+  };
+
+  TEST_CLASS(TestGeodesy) {
+    typedef CGeodesy::TPoint TPoint;
+
+    static CGeodesy::CPointArray Points(unsigned num, double latMin, double latMax, double lonMin, double lonMax, unsigned seed)
+    {
+      std::mt19937 gen{seed};
+      std::uniform_real_distribution<double> lat{latMin, latMax}, lon{lonMin, lonMax};
+      CGeodesy::CPointArray points;
+      for(unsigned i=0; i<num; i++)
+        points.push_back(TPoint{lat(gen), lon(gen)});
+      return points;
+    }
+
+    static double AngleDiff(double angle1, double angle2)
+    {
+      return std::fmod(angle1 - angle2 + 540, 360.0) - 180;
+    }
+
+  public:
+    TEST_METHOD(SinCos)
+    {
+      const double PI = 3.14159265358979323846;
+      std::mt19937 gen{1};
+      std::uniform_real_distribution<double> dist{-2 * PI, 2 * PI};
+      std::vector<double> angle(10001), sin(angle.size()), cos(angle.size());
+      for(auto &a : angle)
+        a = dist(gen);
+      angle[0] = 0;
+      angle[1] = PI / 4;
+      angle[2] = -PI / 2;
+      angle[3] = PI;
+      CGeodesy::SinCos(angle.data(), sin.data(), cos.data(), angle.size());
+      for(size_t i=0; i<angle.size(); i++) {
+        Assert::AreEqual(std::sin(angle[i]), sin[i], CGeodesy::MAX_ERROR);
+        Assert::AreEqual(std::cos(angle[i]), cos[i], CGeodesy::MAX_ERROR);
+      }
+    }
+
+    TEST_METHOD(Atan2)
+    {
+      std::mt19937 gen{2};
+      std::uniform_real_distribution<double> dist{-1, 1};
+      std::vector<double> y(10001), x(y.size()), angle(y.size());
+      for(size_t i=0; i<y.size(); i++) {
+        y[i] = dist(gen);
+        x[i] = dist(gen);
+      }
+      const double special[][2] = { {0, 0}, {0, 1}, {1, 0}, {0, -1}, {-1, 0}, {1, 1}, {-1, -1}, {1e-300, 1}, {1, 1e-300}, {0.66, 1}, {1, -0.66} };
+      for(size_t i=0; i<sizeof(special) / sizeof(*special); i++) {
+        y[i] = special[i][0];
+        x[i] = special[i][1];
+      }
+      CGeodesy::Atan2(y.data(), x.data(), angle.data(), y.size());
+      for(size_t i=0; i<y.size(); i++)
+        Assert::AreEqual(std::atan2(y[i], x[i]), angle[i], CGeodesy::MAX_ERROR);
+    }
+
+    TEST_METHOD(Bearings)
+    {
+      for(auto &points : { Points(101, 44, 48, 12, 16, 3), Points(101, -80, 80, -180, 180, 4) }) {
+        const CGeodesy geodesy{points};
+        Assert::AreEqual(points.size(), geodesy.Size());
+        CGeodesy::CPairArray pairs;
+        for(unsigned i=0; i<points.size(); i++)
+          for(unsigned j=0; j<points.size(); j+=7)
+            pairs.push_back(CGeodesy::TPair{i, j});
+        std::vector<double> bearing(pairs.size()), angle(pairs.size());
+        geodesy.Bearings(pairs.data(), pairs.size(), bearing.data(), angle.data());
+        for(size_t i=0; i<pairs.size(); i++) {
+          double distance, refBearing;
+          CTaskGeometry::DistanceBearing(points[pairs[i].from], points[pairs[i].to], distance, refBearing);
+          Assert::AreEqual(distance, angle[i] * CTaskGeometry::EARTH_RADIUS, 1e-4);
+          Assert::IsTrue(bearing[i] >= 0 && bearing[i] < 360);
+          if(pairs[i].from != pairs[i].to)
+            Assert::AreEqual(0.0, AngleDiff(bearing[i], refBearing), 1e-9);
+        }
+      }
+    }
+
+    TEST_METHOD(Legs)
+    {
+      const auto points = Points(11, 45, 47, 13, 15, 5);
+      std::vector<double> bearing(points.size() - 1), angle(points.size() - 1);
+      CGeodesy{points}.Legs(bearing.data(), angle.data());
+      for(size_t i=1; i<points.size(); i++) {
+        double distance, refBearing;
+        CTaskGeometry::DistanceBearing(points[i - 1], points[i], distance, refBearing);
+        Assert::AreEqual(distance, angle[i - 1] * CTaskGeometry::EARTH_RADIUS, 1e-4);
+        Assert::AreEqual(0.0, AngleDiff(bearing[i - 1], refBearing), 1e-9);
+      }
+    }
+
+    TEST_METHOD(Benchmark)
+    {
+      // a corpus of 2000 tasks with 10 waypoints, bearings and distances between all waypoints of a task
+      typedef std::chrono::high_resolution_clock clock;
+      const unsigned TASKS_NUM = 2000;
+      const unsigned TASK_SIZE = 10;
+      const auto points = Points(TASKS_NUM * TASK_SIZE, 44, 48, 12, 16, 6);
+      CGeodesy::CPairArray pairs;
+      for(unsigned t=0; t<TASKS_NUM; t++)
+        for(unsigned i=0; i<TASK_SIZE; i++)
+          for(unsigned j=0; j<TASK_SIZE; j++)
+            if(i != j)
+              pairs.push_back(CGeodesy::TPair{t * TASK_SIZE + i, t * TASK_SIZE + j});
+
+      std::vector<double> bearing(pairs.size()), angle(pairs.size());
+      double sum = 0;
+      auto start = clock::now();
+      for(size_t i=0; i<pairs.size(); i++) {
+        double distance;
+        CTaskGeometry::DistanceBearing(points[pairs[i].from], points[pairs[i].to], distance, bearing[i]);
+        sum += distance + bearing[i];
+      }
+      const auto scalarTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      start = clock::now();
+      CGeodesy{points}.Bearings(pairs.data(), pairs.size(), bearing.data(), angle.data());
+      const auto batchTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+      for(size_t i=0; i<pairs.size(); i++)
+        sum -= angle[i] * CTaskGeometry::EARTH_RADIUS + bearing[i];
+
+      Logger::WriteMessage(("Bearings and distances of " + Convert(pairs.size()) + " waypoints pairs: scalar " + Convert(scalarTime) +
+                            " us, batch " + Convert(batchTime) + " us").c_str());
+      Assert::AreEqual(0.0, sum, 1.0);
+    }
+  };
+
+  ////////////////////////   T A S K   I M A G E   ////////////////////////
+
+  TEST_CLASS(TestTaskImage) {
+    static std::string Image(CTaskImage::TFormat format, unsigned taskPointsNum, unsigned startPointsNum)
+    {
+      using namespace xcsoar;
+
+      std::vector<TASK_POINT> taskPointArray(taskPointsNum);
+      memset(taskPointArray.data(), 0, taskPointsNum * sizeof(TASK_POINT));
+      for(auto &tp : taskPointArray) {
+        tp.Index = -1;
+        tp.AATStartRadial = 0;
+        tp.AATFinishRadial = 360;
+      }
+      taskPointArray[0].Index = 100001;
+      taskPointArray[0].AATType = WAYPOINT_AAT_CIRCLE;
+      taskPointArray[0].AATCircleRadius = 500;
+      taskPointArray[1].Index = 100002;
+      taskPointArray[1].AATType = WAYPOINT_AAT_SECTOR;
+      taskPointArray[1].AATSectorRadius = 3000;
+      taskPointArray[1].AATStartRadial = 45;
+      taskPointArray[1].AATFinishRadial = 135;
+      taskPointArray[2].Index = 100003;
+      taskPointArray[2].AATType = WAYPOINT_AAT_CIRCLE;
+      taskPointArray[2].AATCircleRadius = 1000;
+
+      std::vector<START_POINT> startPointArray(startPointsNum);
+      memset(startPointArray.data(), 0, startPointsNum * sizeof(START_POINT));
+      for(auto &sp : startPointArray)
+        sp.Index = -1;
+
+      SETTINGS_TASK settingsTask{};
+      settingsTask.AATEnabled = true;
+      settingsTask.AATTaskLength = 7200;
+      settingsTask.FinishRadius = 1000;
+      settingsTask.FinishType = FINISH_LINE;
+      settingsTask.StartRadius = 2000;
+      settingsTask.StartType = START_LINE;
+      settingsTask.SectorType = AST_DAE;
+      settingsTask.SectorRadius = 500;
+      settingsTask.AutoAdvance = AUTOADVANCE_ARMSTART;
+      settingsTask.EnableMultipleStartPoints = false;
+
+      const CTaskImage::CWaypointArray waypointArray{
+        { 100001, 46.35,   14.1733, 505, WAYPOINT_AIRPORT | WAYPOINT_TURNPOINT, "S:Lesce", "Lesce", true },
+        { 100002, 46.2333, 15.2667, 244, WAYPOINT_TURNPOINT,                    "1:Celje", "Celje", true },
+        { 100003, 46.35,   14.1733, 505, WAYPOINT_AIRPORT | WAYPOINT_TURNPOINT, "F:Lesce", "Lesce", true }
+      };
+
+      CTaskImage image{format};
+      image.TaskPoints(taskPointArray.data());
+      image.Settings(settingsTask);
+      image.StartPoints(startPointArray.data());
+      image.Waypoints(waypointArray);
+      return image.Data();
+    }
+
+    static int ReadInt(const std::string &image, size_t offset)
+    {
+      return static_cast<unsigned char>(image[offset]) | static_cast<unsigned char>(image[offset + 1]) << 8 |
+             static_cast<unsigned char>(image[offset + 2]) << 16 | static_cast<unsigned char>(image[offset + 3]) << 24;
+    }
+
+    static std::string Golden(const bfs::path &fileName)
+    {
+      bfs::ifstream stream{MAIN_SRC_DIR / "UnitTests/data" / fileName, std::ios_base::in | std::ios_base::binary};
+      std::stringstream buffer;
+      buffer << stream.rdbuf();
+      return buffer.str();
+    }
+
+    // field (size, alignment)
+    using TField = std::pair<size_t, size_t>;
+
+    // returns offsets of all fields followed by the size of the record
+    static std::vector<size_t> Layout(const std::vector<TField> &fields, bool packed = false)
+    {
+      std::vector<size_t> offsets;
+      size_t offset = 0, align = 1;
+      for(const auto &f : fields) {
+        const auto a = packed ? 1 : f.second;
+        offset = (offset + a - 1) / a * a;
+        offsets.push_back(offset);
+        offset += f.first;
+        align = (std::max)(align, a);
+      }
+      offsets.push_back((offset + align - 1) / align * align);
+      return offsets;
+    }
+
+  public:
+    TEST_METHOD(XCSoar5)
+    {
+      const auto image = Image(CTaskImage::TFormat::XCSOAR_5, xcsoar::MAXTASKPOINTS, xcsoar::MAXSTARTPOINTS);
+      Assert::AreEqual(CTaskImage::Size(CTaskImage::TFormat::XCSOAR_5), image.size());
+      Assert::AreEqual(8761U, image.size());
+      Assert::IsTrue(Golden("TaskXCSoar5.tsk") == image);
+
+      // read back (little-endian, UTF-16)
+      const size_t waypoints = xcsoar::MAXTASKPOINTS * CTaskImage::TASK_POINT_SIZE + CTaskImage::SETTINGS_SIZE + xcsoar::MAXSTARTPOINTS * CTaskImage::START_POINT_SIZE;
+      Assert::AreEqual(100002, ReadInt(image, CTaskImage::TASK_POINT_SIZE + CTaskImage::TASK_POINT_INDEX));
+      Assert::AreEqual(100002, ReadInt(image, waypoints + CTaskImage::XCSOAR_WAYPOINT_SIZE + CTaskImage::XCSOAR_WAYPOINT_NUMBER));
+      Assert::AreEqual(std::string{"1\0:\0C\0", 6}, image.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_SIZE + CTaskImage::XCSOAR_WAYPOINT_NAME, 6));
+    }
+
+    TEST_METHOD(LK8000)
+    {
+      const auto image = Image(CTaskImage::TFormat::LK8000_1_24, lk8000::MAXTASKPOINTS, lk8000::MAXSTARTPOINTS);
+      Assert::AreEqual(CTaskImage::Size(CTaskImage::TFormat::LK8000_1_24), image.size());
+      Assert::AreEqual(15931U, image.size());
+      Assert::AreEqual(std::string{"LK32020"}, std::string{image.c_str()});
+      Assert::IsTrue(Golden("TaskLK8000.tsk") == image);
+    }
+
+    TEST_METHOD(Layout)
+    {
+      // 32-bit device ABI (8-byte aligned doubles, 16-bit wchar_t) independent of the host one
+      const TField INT{4, 4}, DOUBLE{8, 8}, POINT{8, 4}, BOOL{1, 1}, PTR{4, 4}, SHORT{2, 2};
+      const auto WSTR = [](unsigned size) { return TField{2 * (size + 1), 2}; };
+
+      const auto tp = Layout({ INT, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, POINT, POINT, INT,
+                               DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, POINT, POINT,
+                               DOUBLE, DOUBLE, DOUBLE, DOUBLE, POINT, BOOL });
+      const std::vector<size_t> tpLayout{
+        CTaskImage::TASK_POINT_INDEX, CTaskImage::TASK_POINT_IN_BOUND, CTaskImage::TASK_POINT_OUT_BOUND, CTaskImage::TASK_POINT_BISECTOR,
+        CTaskImage::TASK_POINT_LEG, CTaskImage::TASK_POINT_SECTOR_START_LAT, CTaskImage::TASK_POINT_SECTOR_START_LON,
+        CTaskImage::TASK_POINT_SECTOR_END_LAT, CTaskImage::TASK_POINT_SECTOR_END_LON, CTaskImage::TASK_POINT_START, CTaskImage::TASK_POINT_END,
+        CTaskImage::TASK_POINT_AAT_TYPE, CTaskImage::TASK_POINT_AAT_CIRCLE_RADIUS, CTaskImage::TASK_POINT_AAT_SECTOR_RADIUS,
+        CTaskImage::TASK_POINT_AAT_START_RADIAL, CTaskImage::TASK_POINT_AAT_FINISH_RADIAL, CTaskImage::TASK_POINT_AAT_START_LAT,
+        CTaskImage::TASK_POINT_AAT_START_LON, CTaskImage::TASK_POINT_AAT_FINISH_LAT, CTaskImage::TASK_POINT_AAT_FINISH_LON,
+        CTaskImage::TASK_POINT_AAT_START, CTaskImage::TASK_POINT_AAT_FINISH, CTaskImage::TASK_POINT_AAT_TARGET_OFFSET_RADIUS,
+        CTaskImage::TASK_POINT_AAT_TARGET_OFFSET_RADIAL, CTaskImage::TASK_POINT_AAT_TARGET_LAT, CTaskImage::TASK_POINT_AAT_TARGET_LON,
+        CTaskImage::TASK_POINT_TARGET, CTaskImage::TASK_POINT_AAT_TARGET_LOCKED, CTaskImage::TASK_POINT_SIZE
+      };
+      Assert::IsTrue(tpLayout == tp);
+
+      const auto sp = Layout({ INT, DOUBLE, DOUBLE, DOUBLE, DOUBLE, DOUBLE, POINT, POINT, BOOL, BOOL });
+      const std::vector<size_t> spLayout{
+        CTaskImage::START_POINT_INDEX, CTaskImage::START_POINT_OUT_BOUND, CTaskImage::START_POINT_SECTOR_START_LAT,
+        CTaskImage::START_POINT_SECTOR_START_LON, CTaskImage::START_POINT_SECTOR_END_LAT, CTaskImage::START_POINT_SECTOR_END_LON,
+        CTaskImage::START_POINT_START, CTaskImage::START_POINT_END, CTaskImage::START_POINT_ACTIVE, CTaskImage::START_POINT_IN_SECTOR,
+        CTaskImage::START_POINT_SIZE
+      };
+      Assert::IsTrue(spLayout == sp);
+
+      // BOOL, double, DWORD, 5 x enum, DWORD, enum, bool written one by one
+      const auto settings = Layout({ INT, DOUBLE, INT, INT, INT, INT, INT, INT, INT, BOOL }, true);
+      const std::vector<size_t> settingsLayout{
+        CTaskImage::SETTINGS_AAT_ENABLED, CTaskImage::SETTINGS_AAT_TASK_LENGTH, CTaskImage::SETTINGS_FINISH_RADIUS,
+        CTaskImage::SETTINGS_FINISH_TYPE, CTaskImage::SETTINGS_START_RADIUS, CTaskImage::SETTINGS_START_TYPE,
+        CTaskImage::SETTINGS_SECTOR_TYPE, CTaskImage::SETTINGS_SECTOR_RADIUS, CTaskImage::SETTINGS_AUTO_ADVANCE,
+        CTaskImage::SETTINGS_ENABLE_MULTIPLE_START, CTaskImage::SETTINGS_SIZE
+      };
+      Assert::IsTrue(settingsLayout == settings);
+
+      const auto xcsoarWp = Layout({ INT, DOUBLE, DOUBLE, DOUBLE, INT, WSTR(xcsoar::NAME_SIZE), WSTR(xcsoar::COMMENT_SIZE),
+                                     POINT, INT, INT, DOUBLE, INT, BOOL, PTR, BOOL, INT });
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_NUMBER), xcsoarWp[0]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_LATITUDE), xcsoarWp[1]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_LONGITUDE), xcsoarWp[2]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_ALTITUDE), xcsoarWp[3]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_FLAGS), xcsoarWp[4]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_NAME), xcsoarWp[5]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_COMMENT), xcsoarWp[6]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_IN_TASK), xcsoarWp[12]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::XCSOAR_WAYPOINT_SIZE), xcsoarWp.back());
+
+      // LK8000 1.24 stores comment as a pointer
+      const auto lk8000Wp = Layout({ INT, DOUBLE, DOUBLE, DOUBLE, INT, WSTR(lk8000::NAME_SIZE), PTR,
+                                     POINT, INT, INT, DOUBLE, INT, BOOL, PTR, BOOL, INT,
+                                     SHORT, WSTR(lk8000::CUPSIZE_CODE), WSTR(lk8000::CUPSIZE_FREQ), INT, INT,
+                                     WSTR(lk8000::CUPSIZE_COUNTRY), SHORT });
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_NUMBER), lk8000Wp[0]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_LATITUDE), lk8000Wp[1]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_LONGITUDE), lk8000Wp[2]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_ALTITUDE), lk8000Wp[3]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_FLAGS), lk8000Wp[4]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_NAME), lk8000Wp[5]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_COMMENT), lk8000Wp[6]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_IN_TASK), lk8000Wp[12]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_STYLE), lk8000Wp[22]);
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_WAYPOINT_SIZE), lk8000Wp.back());
+
+      Assert::AreEqual(static_cast<size_t>(CTaskImage::LK8000_VERSION_SIZE + lk8000::MAXTASKPOINTS * tp.back() + settings.back() +
+                                           lk8000::MAXSTARTPOINTS * sp.back() + (lk8000::MAXTASKPOINTS + lk8000::MAXSTARTPOINTS) * lk8000Wp.back()),
+                       CTaskImage::Size(CTaskImage::TFormat::LK8000_1_24));
+      Assert::AreEqual(static_cast<size_t>(xcsoar::MAXTASKPOINTS * tp.back() + settings.back() +
+                                           xcsoar::MAXSTARTPOINTS * sp.back() + (xcsoar::MAXTASKPOINTS + xcsoar::MAXSTARTPOINTS) * xcsoarWp.back()),
+                       CTaskImage::Size(CTaskImage::TFormat::XCSOAR_5));
+    }
+
+    TEST_METHOD(PortableEncoding)
+    {
+      CTaskImage image{CTaskImage::TFormat::XCSOAR_5};
+      const size_t waypoints = xcsoar::MAXTASKPOINTS * CTaskImage::TASK_POINT_SIZE + CTaskImage::SETTINGS_SIZE + xcsoar::MAXSTARTPOINTS * CTaskImage::START_POINT_SIZE;
+      image.Waypoints({ { -2, 1.0, -1.5, 100, xcsoar::WAYPOINT_TURNPOINT, "Pr\xe9", std::string(60, 'c'), true } });
+      const auto &data = image.Data();
+
+      Assert::AreEqual(std::string{"\xfe\xff\xff\xff", 4}, data.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_NUMBER, 4));
+      Assert::AreEqual(std::string{"\0\0\0\0\0\0\xf0\x3f", 8}, data.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_LATITUDE, 8));
+      Assert::AreEqual(std::string{"\0\0\0\0\0\0\xf8\xbf", 8}, data.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_LONGITUDE, 8));
+      Assert::AreEqual(std::string{"P\0r\0\xe9\0\0\0", 8}, data.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_NAME, 8));
+
+      // too long comment is truncated and terminated
+      Assert::AreEqual(std::string{"c\0", 2}, data.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_COMMENT + 2 * (xcsoar::COMMENT_SIZE - 1), 2));
+      Assert::AreEqual(std::string{"\0\0", 2}, data.substr(waypoints + CTaskImage::XCSOAR_WAYPOINT_COMMENT + 2 * xcsoar::COMMENT_SIZE, 2));
+      Assert::AreEqual('\1', data[waypoints + CTaskImage::XCSOAR_WAYPOINT_IN_TASK]);
+    }
+  };
+
+
+  ////////////////////////   X M L   W R I T E R   ////////////////////////
+
+  TEST_CLASS(TestXMLWriter) {
+    using TZone = CTargetXCSoar6::TObservationZone;
+
+    template<typename Func>
+    static std::string Write(Func func)
+    {
+      const auto path = bfs::temp_directory_path() / bfs::unique_path();
+      {
+        COStream stream{path};
+        func(stream);
+      }
+      std::stringstream buffer;
+      buffer << bfs::ifstream{path, std::ios_base::in | std::ios_base::binary}.rdbuf();
+      bfs::remove(path);
+      return buffer.str();
+    }
+
+    static void Task(unsigned idx, xcsoar::SETTINGS_TASK &settingsTask, CTaskImage::CWaypointArray &waypointArray, CTargetXCSoar6::CObservationZoneArray &zoneArray)
+    {
+      settingsTask = xcsoar::SETTINGS_TASK{};
+      settingsTask.AATEnabled = idx % 2 == 0;
+      settingsTask.AATTaskLength = 120 + idx % 60;
+      settingsTask.StartMaxHeight = 1500 + idx % 1000;
+      waypointArray.clear();
+      zoneArray.clear();
+      const unsigned points = 3 + idx % 6;
+      for(unsigned i = 0; i < points; i++) {
+        const auto name = "TP" + Convert(i) + " \"Lesce & Bled\" <" + Convert(idx) + ">";
+        waypointArray.push_back(CTaskImage::TWaypoint{ static_cast<int>(i), 46.35 + i * 0.0123, 14.1733 + idx * 0.0001, 505.0 + i, 0, name, "Comment " + Convert(idx), true });
+        zoneArray.push_back(TZone{ i % 3 == 0 ? TZone::TType::CYLINDER : i % 3 == 1 ? TZone::TType::LINE : TZone::TType::SECTOR, 500 * (i + 1), 45, 135 });
+      }
+    }
+
+    // previous XCSoar 6 task implementation
+    static void TaskWriteStream(COStream &tskFile, const xcsoar::SETTINGS_TASK &settingsTask, const CTaskImage::CWaypointArray &waypointArray, const CTargetXCSoar6::CObservationZoneArray &zoneArray)
+    {
+      if(settingsTask.AATEnabled) {
+        tskFile << "<Task type=\"AAT\" task_scored=\"1\" aat_min_time=\""
+          << (settingsTask.AATTaskLength * 60) << "\"";
+      }
+      else {
+        tskFile << "<Task type=\"RT\" task_scored=\"1\" aat_min_time=\"0\"";
+      }
+      tskFile << " start_max_speed=\"0\" start_max_height=\"" << settingsTask.StartMaxHeight
+        << "\" start_max_height_ref=\"1\" finish_min_height=\"" << settingsTask.FinishMinHeight
+        << "\" fai_finish=\"0\" min_points=\"" << waypointArray.size() - 1
+        << "\" max_points=\"10\" homogeneous_tps=\"0\" is_closed=\"0\">" << std::endl;
+
+      for(size_t i=0; i<waypointArray.size(); i++) {
+        tskFile << "\t<Point type=\"";
+        if(i==0)
+          tskFile << "Start";
+        else if(i==(waypointArray.size()-1))
+          tskFile << "Finish";
+        else if(settingsTask.AATEnabled)
+          tskFile << "Area";
+        else
+          tskFile << "Turn";
+        tskFile << "\">" << std::endl;
+
+        tskFile << "\t\t<Waypoint name=\"" << waypointArray[i].name << "\" id=\"0\" comment=\"" << waypointArray[i].comment <<
+          "\" altitude=\"" << waypointArray[i].altitude << "\">" << std::endl;
+        tskFile << "\t\t\t<Location longitude=\"" << waypointArray[i].longitude << "\" latitude=\""<< waypointArray[i].latitude << "\"/>" << std::endl;
+        tskFile << "\t\t</Waypoint>" << std::endl;
+
+        const auto &zone = zoneArray[i];
+        if(zone.type == TZone::TType::CYLINDER)
+          tskFile << "\t\t<ObservationZone type=\"Cylinder\" radius=\"" << zone.size <<"\"/>" << std::endl;
+        else if(zone.type == TZone::TType::LINE)
+          tskFile << "\t\t<ObservationZone type=\"Line\" length=\"" << zone.size <<"\"/>" << std::endl;
+        else
+          tskFile << "<ObservationZone type=\"Sector\" radius=\"" << zone.size << "\" start_radial=\""<< static_cast<double>(zone.startRadial) <<"\" end_radial=\""<< static_cast<double>(zone.endRadial) <<"\" />\r\n";
+        tskFile << "\t</Point>" << std::endl;
+      }
+      tskFile << "</Task>" << std::endl;
+    }
+
+  public:
+    TEST_METHOD(Elements)
+    {
+      const auto xml = Write([](COStream &stream){
+          CXMLWriter writer{stream};
+          writer.Start("a").Attribute("x", 1);
+          writer.Start("b").Text("text").End();
+          writer.Start("c").End();
+          Assert::AreEqual(1U, writer.Depth());
+          writer.End();
+          Assert::ExpectException<EOperationFailed>([&]{ writer.End(); });
+          Assert::ExpectException<EOperationFailed>([&]{ writer.Attribute("y", 2); });
+        });
+      Assert::AreEqual(std::string{"<a x=\"1\">\r\n\t<b>text</b>\r\n\t<c/>\r\n</a>\r\n"}, xml);
+    }
+
+    TEST_METHOD(Escaping)
+    {
+      const auto xml = Write([](COStream &stream){
+          CXMLWriter writer{stream};
+          writer.Start("a").Attribute("v", std::string{"<\"Tom\" & 'Jerry'>\t\n\x01!"}).Text("1 < 2 && 3 > 2").End();
+        });
+      Assert::AreEqual(std::string{"<a v=\"&lt;&quot;Tom&quot; &amp; &apos;Jerry&apos;&gt;&#9;&#10;!\">1 &lt; 2 &amp;&amp; 3 &gt; 2</a>\r\n"}, xml);
+    }
+
+    TEST_METHOD(Numbers)
+    {
+      const auto xml = Write([](COStream &stream){
+          CXMLWriter writer{stream};
+          writer.Start("n").Attribute("a", 0).Attribute("b", -2147483647 - 1).Attribute("c", 4294967295U)
+            .Attribute("d", 14.1733, 6).Attribute("e", -0.0000004, 6).Attribute("f", -46.35, 1).Attribute("g", 2.5, 0)
+            .Attribute("h", 0.125, 2).End();
+          Assert::ExpectException<EOperationFailed>([&]{ writer.Start("x").Attribute("a", 1e300, 6); });
+          Assert::ExpectException<EOperationFailed>([&]{ writer.Attribute("a", 1.0, CXMLWriter::PRECISION_MAX + 1); });
+        });
+      Assert::AreEqual(0U, xml.find("<n a=\"0\" b=\"-2147483648\" c=\"4294967295\" d=\"14.173300\" e=\"0.000000\" f=\"-46.4\" g=\"3\" h=\"0.13\"/>\r\n"));
+    }
+
+    TEST_METHOD(XCSoar6Task)
+    {
+      xcsoar::SETTINGS_TASK settingsTask;
+      CTaskImage::CWaypointArray waypointArray;
+      CTargetXCSoar6::CObservationZoneArray zoneArray;
+      Task(1, settingsTask, waypointArray, zoneArray);
+      waypointArray[1].altitude = 512.75;
+      const auto xml = Write([&](COStream &stream){
+          CXMLWriter writer{stream};
+          CTargetXCSoar6::TaskWrite(writer, settingsTask, waypointArray, zoneArray);
+        });
+      Assert::AreEqual(0U, xml.find("<Task type=\"RT\" task_scored=\"1\" aat_min_time=\"0\" start_max_speed=\"0\" start_max_height=\"1501\""));
+      Assert::AreNotEqual(std::string::npos, xml.find("\t<Point type=\"Start\">\r\n\t\t<Waypoint name=\"TP0 &quot;Lesce &amp; Bled&quot; &lt;1&gt;\" id=\"0\" comment=\"Comment 1\" altitude=\"505\">\r\n"
+                                                      "\t\t\t<Location longitude=\"14.173400\" latitude=\"46.350000\"/>\r\n\t\t</Waypoint>\r\n"
+                                                      "\t\t<ObservationZone type=\"Cylinder\" radius=\"500\"/>\r\n\t</Point>\r\n"));
+      Assert::AreNotEqual(std::string::npos, xml.find("comment=\"Comment 1\" altitude=\"512.75\">"));
+      Assert::AreNotEqual(std::string::npos, xml.find("\t\t<ObservationZone type=\"Sector\" radius=\"1500\" start_radial=\"45\" end_radial=\"135\"/>\r\n"));
+      Assert::AreEqual(xml.size() - 9, xml.rfind("</Task>\r\n"));
+      for(size_t pos = xml.find('\n'); pos != std::string::npos; pos = xml.find('\n', pos + 1))
+        Assert::AreEqual('\r', xml[pos - 1]);
+    }
+
+    TEST_METHOD(Benchmark1000)
+    {
+      using clock = std::chrono::steady_clock;
+      const unsigned TASKS_NUM = 1000;
+      std::vector<xcsoar::SETTINGS_TASK> settingsTasks(TASKS_NUM);
+      std::vector<CTaskImage::CWaypointArray> waypointArrays(TASKS_NUM);
+      std::vector<CTargetXCSoar6::CObservationZoneArray> zoneArrays(TASKS_NUM);
+      for(unsigned i = 0; i < TASKS_NUM; i++)
+        Task(i, settingsTasks[i], waypointArrays[i], zoneArrays[i]);
+
+      // previous implementation
+      auto start = clock::now();
+      for(unsigned i = 0; i < TASKS_NUM; i++) {
+        COStream stream{COStream::CPathList{}};
+        TaskWriteStream(stream, settingsTasks[i], waypointArrays[i], zoneArrays[i]);
+      }
+      const auto streamTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      // XML writer
+      start = clock::now();
+      for(unsigned i = 0; i < TASKS_NUM; i++) {
+        COStream stream{COStream::CPathList{}};
+        CXMLWriter writer{stream};
+        CTargetXCSoar6::TaskWrite(writer, settingsTasks[i], waypointArrays[i], zoneArrays[i]);
+      }
+      const auto writerTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      Logger::WriteMessage(("XCSoar 6 tasks (" + Convert(TASKS_NUM) + "): stream: " + Convert(streamTime) +
+                            " us, XML writer: " + Convert(writerTime) + " us").c_str());
+    }
+  };
+
+
+  ////////////////////////   R E S O U R C E S   ////////////////////////
+
+  TEST_CLASS(TestResources) {
+  public:
+    TEST_METHOD(CSVParserCached)
+    {
+      CResources resources;
+      auto parser1 = resources.CSVParser(MAIN_SRC_DIR / "data/GliderData.csv");
+      auto parser2 = resources.CSVParser(MAIN_SRC_DIR / "data/GliderData.csv");
+      Assert::IsTrue(parser1 == parser2);
+      Assert::AreEqual(std::string("285"), parser2->Row("ASW28")[1]);
+      Assert::ExpectException<EOperationFailed>([&]{ resources.CSVParser("nonexisting.some_file"); });
+    }
+
+    TEST_METHOD(INIParserCopy)
+    {
+      CResources resources;
+      auto parser1 = resources.INIParser(MAIN_SRC_DIR / "data/condor2nav.ini");
+      parser1->Value("Condor2Nav", "Target", "UnitTest");
+      auto parser2 = resources.INIParser(MAIN_SRC_DIR / "data/condor2nav.ini");
+      Assert::AreEqual(std::string("UnitTest"), parser1->Value("Condor2Nav", "Target"));
+      Assert::AreEqual(std::string("LK8000"), parser2->Value("Condor2Nav", "Target"));
+    }
+  };
+
+
+  ////////////////////////   T R A N S L A T I O N   C A C H E   ////////////////////////
+
+  TEST_CLASS(TestTranslationCache) {
+    static void Translate(CTranslationCache &cache, CTranslationCache::THash key, const bfs::path &input, const bfs::path &output, bool dryRun = false)
+    {
+      CTranslationCache::CRecorder recorder{cache, key, dryRun};
+      {
+        DirectoryCreate(output.parent_path());
+        FileExists(output);
+        CIStream in{input};
+        COStream out{output};
+        out << in << "translated";
+      }
+      recorder.Commit();
+    }
+
+  public:
+    TEST_METHOD(Hash)
+    {
+      Assert::IsTrue(CTranslationCache::Hash("") == 0xcbf29ce484222325ULL);
+      Assert::IsTrue(CTranslationCache::Hash("a") == 0xaf63dc4c8601ec8cULL);
+      Assert::IsTrue(CTranslationCache::Hash("b", CTranslationCache::Hash("a")) == CTranslationCache::Hash("ab"));
+    }
+
+    TEST_METHOD(Replay)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      const auto input = dir / "input.txt";
+      const auto output = dir / "out" / "output.txt";
+      bfs::ofstream{input} << "data ";
+      bfs::create_directories(output.parent_path());
+
+      CTranslationCache cache{1024};
+      Assert::AreEqual(0U, cache.Replay(1));
+      Translate(cache, 1, input, output);
+      Assert::AreEqual(1U, cache.Stats().entries);
+
+      // output removed
+      bfs::remove_all(output.parent_path());
+      Assert::AreEqual(1U, cache.Replay(1));
+      CIStream in{output};
+      std::stringstream data;
+      data << in;
+      Assert::AreEqual(std::string{"data translated"}, data.str());
+
+      // output exists now with the translated contents
+      Assert::AreEqual(1U, cache.Replay(1));
+
+      // output modified
+      bfs::ofstream{output} << "modified";
+      Assert::AreEqual(0U, cache.Replay(1));
+      Translate(cache, 1, input, output);
+      Assert::AreEqual(1U, cache.Replay(1));
+
+      // the same translation done again
+      Translate(cache, 1, input, output);
+      Assert::AreEqual(1U, cache.Replay(1));
+
+      // input changed
+      bfs::ofstream{input} << "new data ";
+      Assert::AreEqual(0U, cache.Replay(1));
+
+      const auto stats = cache.Stats();
+      Assert::AreEqual(4U, stats.hits);
+      Assert::AreEqual(3U, stats.misses);
+      bfs::remove_all(dir);
+    }
+
+    TEST_METHOD(PreviousOutput)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      const auto input = dir / "template.prf";
+      const auto output = dir / "output.prf";
+      bfs::ofstream{input} << "Value=0\r\n";
+
+      // profile like translation that updates previous output if it exists
+      CTranslationCache cache{1024};
+      const auto translate = [&]{
+        CTranslationCache::CRecorder recorder{cache, 1};
+        {
+          CIStream in{FileExists(output) ? output : input};
+          std::stringstream data;
+          data << in;
+          COStream out{output};
+          out << "Value=1\r\nName=Test\r\n";
+        }
+        recorder.Commit();
+      };
+
+      translate();
+      Assert::AreEqual(1U, cache.Replay(1));
+
+      // output modified by the user
+      bfs::ofstream{output} << "Value=2\r\n";
+      Assert::AreEqual(0U, cache.Replay(1));
+      translate();
+      Assert::AreEqual(1U, cache.Replay(1));
+      bfs::remove_all(dir);
+    }
+
+    TEST_METHOD(Eviction)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      const auto input = dir / "input.txt";
+      bfs::ofstream{input} << std::string(100, 'x');
+
+      // place for 2 entries only
+      CTranslationCache cache{2 * (100 + 10 + (dir / "output1.txt").string().size()) + 10};
+      Translate(cache, 1, input, dir / "output1.txt");
+      Translate(cache, 2, input, dir / "output2.txt");
+      Assert::AreEqual(1U, cache.Replay(1));           // 1 is the most recently used now
+      Translate(cache, 3, input, dir / "output3.txt");
+
+      const auto stats = cache.Stats();
+      Assert::AreEqual(1U, stats.evictions);
+      Assert::AreEqual(2U, stats.entries);
+      Assert::AreEqual(0U, cache.Replay(2));
+      Assert::AreEqual(1U, cache.Replay(1));
+      Assert::AreEqual(1U, cache.Replay(3));
+      bfs::remove_all(dir);
+    }
+
+    TEST_METHOD(DryRun)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      const auto input = dir / "input.txt";
+      const auto output = dir / "out" / "output.txt";
+      bfs::ofstream{input} << "data ";
+
+      CTranslationCache cache{1024};
+      Assert::IsFalse(cache.Contains(1));
+      Assert::IsFalse(CTranslationCache::CRecorder::DryRun());
+      Translate(cache, 1, input, output, true);
+      Assert::IsFalse(bfs::exists(output.parent_path()));
+      Assert::IsTrue(cache.Contains(1));
+      Assert::AreEqual(0U, cache.Stats().hits);
+
+      // prepared translation is written by replay
+      Assert::AreEqual(1U, cache.Replay(1));
+      CIStream in{output};
+      std::stringstream data;
+      data << in;
+      Assert::AreEqual(std::string{"data translated"}, data.str());
+
+      // output exists now with the prepared contents
+      Assert::IsTrue(cache.Contains(1));
+
+      // input changed
+      bfs::remove_all(output.parent_path());
+      bfs::ofstream{input} << "new data ";
+      Assert::IsFalse(cache.Contains(1));
+      bfs::remove_all(dir);
+    }
+
+    TEST_METHOD(PreparedTranslationRepeated)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      const auto input = dir / "input.txt";
+      const auto output = dir / "out" / "output.txt";
+      bfs::ofstream{input} << "data ";
+
+      // GUI prepares the translation in the background without touching the output
+      CTranslationCache cache{1024};
+      Translate(cache, 1, input, output, true);
+      Assert::IsFalse(bfs::exists(output));
+      Assert::IsFalse(bfs::exists(output.parent_path()));
+
+      // the user clicks Translate twice and the prepared translation is replayed each time
+      for(unsigned i=0; i<2; i++) {
+        Assert::IsTrue(cache.Contains(1));
+        Assert::AreEqual(1U, cache.Replay(1));
+      }
+      CIStream in{output};
+      std::stringstream data;
+      data << in;
+      Assert::AreEqual(std::string{"data translated"}, data.str());
+
+      // prepared translation is still available
+      Assert::IsTrue(cache.Contains(1));
+      const auto stats = cache.Stats();
+      Assert::AreEqual(2U, stats.hits);
+      Assert::AreEqual(0U, stats.misses);
+      bfs::remove_all(dir);
+    }
+  };
+
+
+  ////////////////////////   T R A N S L A T O R   ////////////////////////
+
+  TEST_CLASS(TestTranslator) {
+  public:
+    TEST_METHOD(Targets)
+    {
+      CFileParserINI configParser{MAIN_SRC_DIR / "data/condor2nav.ini"};
+      configParser.Value("Condor2Nav", "Target", "LK8000");
+      auto targets = CTranslator::Targets(*TConfig::Parse(configParser.Clone()), "out");
+      Assert::AreEqual(1U, targets.size());
+      Assert::AreEqual(std::string{"LK8000"}, targets[0].chapter);
+      Assert::AreEqual(std::string{"out"}, targets[0].outputPath.string());
+
+      configParser.Value("Condor2Nav", "Target", "XCSoar5, XCSoar6,LK8000");
+      targets = CTranslator::Targets(*TConfig::Parse(configParser.Clone()), "out");
+      Assert::AreEqual(3U, targets.size());
+      Assert::AreEqual(std::string{"XCSoar"}, targets[0].chapter);
+      Assert::AreEqual(std::string{"5"}, targets[0].version);
+      Assert::AreEqual(std::string{"6"}, targets[1].version);
+      Assert::AreEqual((bfs::path{"out"} / "XCSoar6").string(), targets[1].outputPath.string());
+      Assert::AreEqual((bfs::path{"out"} / "LK8000").string(), targets[2].outputPath.string());
+
+      configParser.Value("Condor2Nav", "Target", "XCSoar,Unknown");
+      Assert::ExpectException<EOperationFailed>([&]{ TConfig::Parse(configParser.Clone()); });
+      configParser.Value("Condor2Nav", "Target", "LK8000,LK8000");
+      Assert::ExpectException<EOperationFailed>([&]{ TConfig::Parse(configParser.Clone()); });
+    }
+  };
+
+
+  ////////////////////////   C O N F I G   ////////////////////////
+
+  TEST_CLASS(TestConfig) {
+  public:
+    TEST_METHOD(Parse)
+    {
+      const auto config = TConfig::Parse(std::make_shared<const CFileParserINI>(MAIN_SRC_DIR / "data/condor2nav.ini"));
+      Assert::AreEqual(1U, config->general.targets.size());
+      Assert::AreEqual(std::string{"LK8000"}, config->general.targets[0]);
+      Assert::AreEqual(std::string{"G:"}, config->general.outputPath.string());
+      Assert::IsTrue(config->general.setGPS && config->general.setTask && !config->general.speedToFlyTable);
+      Assert::AreEqual(16U, config->general.translationCacheSize);
+      Assert::AreEqual(std::string{"A"}, config->condor.defaultTaskName);
+      Assert::IsTrue(config->condor.flightPlansPath.empty());
+      Assert::AreEqual(std::string{"6"}, config->xcsoar.version);
+      Assert::AreEqual(std::string{"data\\condor2nav"}, config->xcsoar.condor2navDataSubDir.string());
+      Assert::IsTrue(config->xcsoar.defaultTaskOverwrite);
+      Assert::IsFalse(config->xcsoar.taskWPFileGenerate);
+      Assert::AreEqual(0.0, config->lk8000.wpFileCorridorWidth);
+      Assert::IsFalse(config->lk8000.defaultProfilesOverwrite);
+      Assert::IsTrue(config->lk8000.checkForMapUpdates);
+      Assert::AreEqual(std::string{"LK8000"}, config->parser->Value("Condor2Nav", "Target"));
+    }
+
+    TEST_METHOD(Defaults)
+    {
+      // entries added in later versions are optional
+      const auto path = bfs::temp_directory_path() / bfs::unique_path();
+      {
+        CFileParserINI parser{MAIN_SRC_DIR / "data/condor2nav.ini"};
+        parser.Dump(path);
+        std::stringstream buffer;
+        buffer << bfs::ifstream{path}.rdbuf();
+        std::string str, line;
+        while(std::getline(buffer, line))
+          if(line.find("SpeedToFlyTable") == std::string::npos && line.find("TranslationCacheSize") == std::string::npos &&
+             line.find("WPFileCorridorWidth") == std::string::npos)
+            str += line + "\n";
+        bfs::ofstream{path} << str;
+      }
+      const auto config = TConfig::Parse(std::make_shared<const CFileParserINI>(path));
+      bfs::remove(path);
+      Assert::IsFalse(config->general.speedToFlyTable);
+      Assert::AreEqual(16U, config->general.translationCacheSize);
+      Assert::AreEqual(0.0, config->xcsoar.wpFileCorridorWidth);
+    }
+
+    TEST_METHOD(Validation)
+    {
+      const auto invalid = [](const char *chapter, const char *key, const char *value) {
+        CFileParserINI parser{MAIN_SRC_DIR / "data/condor2nav.ini"};
+        parser.Value(chapter, key, value);
+        Assert::ExpectException<EOperationFailed>([&]{ TConfig::Parse(parser.Clone()); });
+      };
+      invalid("Condor2Nav", "SetGPS", "yes");
+      invalid("Condor2Nav", "SetTask", "2");
+      invalid("Condor2Nav", "Target", "");
+      invalid("Condor2Nav", "TranslationCacheSize", "-1");
+      invalid("Condor2Nav", "TranslationCacheSize", "16MB");
+      invalid("XCSoar", "Version", "7");
+      invalid("LK8000", "WPFileCorridorWidth", "wide");
+
+      CFileParserINI parser{MAIN_SRC_DIR / "data/condor2nav.ini"};
+      parser.Value("LK8000", "WPFileCorridorWidth", "12.5");
+      Assert::AreEqual(12.5, TConfig::Parse(parser.Clone())->lk8000.wpFileCorridorWidth);
+    }
+  };
+
+
+  ////////////////////////   D I R E C T O R Y   W A T C H E R   ////////////////////////
+
+  TEST_CLASS(TestDirectoryWatcher) {
+  public:
+    TEST_METHOD(NewFileReported)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+      bfs::ofstream{dir / "existing.fpl"} << "[Task]";
+
+      std::vector<bfs::path> reported;
+      {
+        CDirectoryWatcher watcher({dir}, ".fpl", 10);
+        std::atomic<bool> done{false};
+        std::thread thread{[&]{
+            watcher.Run([&](const bfs::path &path){ reported.push_back(path); done = true; },
+                        [&]{ return done.load(); });
+          }};
+        bfs::ofstream{dir / "ignored.txt"} << "Text";
+        bfs::ofstream{dir / "new.fpl"} << "[Task]";
+
+        // directories polling may need more time
+        for(int i = 0; i < 50 && !done; ++i)
+          std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        done = true;
+        thread.join();
+      }
+      bfs::remove_all(dir);
+
+      Assert::AreEqual(1U, reported.size());
+      Assert::AreEqual((dir / "new.fpl").string(), reported[0].string());
+    }
+
+    TEST_METHOD(SeveralExtensions)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir);
+
+      std::vector<bfs::path> reported;
+      {
+        CDirectoryWatcher watcher({dir}, CDirectoryWatcher::CExtensionList{".fpl", ".ini"}, 10);
+        std::atomic<bool> done{false};
+        std::thread thread{[&]{
+            watcher.Run([&](const bfs::path &path){ reported.push_back(path); done = reported.size() == 2; },
+                        [&]{ return done.load(); });
+          }};
+        bfs::ofstream{dir / "ignored.txt"} << "Text";
+        bfs::ofstream{dir / "condor2nav.INI"} << "[Condor2Nav]";
+        bfs::ofstream{dir / "new.fpl"} << "[Task]";
+
+        // directories polling may need more time
+        for(int i = 0; i < 50 && !done; ++i)
+          std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        done = true;
+        thread.join();
+      }
+      bfs::remove_all(dir);
+
+      std::sort(begin(reported), end(reported));
+      Assert::AreEqual(2U, reported.size());
+      Assert::AreEqual((dir / "condor2nav.INI").string(), reported[0].string());
+      Assert::AreEqual((dir / "new.fpl").string(), reported[1].string());
+    }
+  };
+
+
+  ////////////////////////   R A C E   R E S U L T S   I N D E X   ////////////////////////
+
+  TEST_CLASS(TestRaceResultsIndex) {
+    static void FileCreate(const bfs::path &path, std::time_t time)
+    {
+      bfs::ofstream{path} << "[Task]";
+      bfs::last_write_time(path, time);
+    }
+
+  public:
+    TEST_METHOD(LastResults)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      const auto indexPath = dir.string() + ".idx";
+      bfs::create_directories(dir);
+      const auto now = std::time(nullptr);
+      FileCreate(dir / "a.fpl", now - 300);
+      FileCreate(dir / "b.FPL", now - 200);
+      FileCreate(dir / "c.txt", now - 100);
+      {
+        CRaceResultsIndex index{dir, indexPath};
+        Assert::AreEqual(2U, index.Size());
+        const auto last = index.Last(5);
+        Assert::AreEqual(2U, last.size());
+        Assert::AreEqual((dir / "b.FPL").string(), last[0].string());
+        Assert::AreEqual((dir / "a.fpl").string(), last[1].string());
+
+        FileCreate(dir / "d.fpl", now - 250);
+        bfs::remove(dir / "b.FPL");
+        index.Update();
+        Assert::AreEqual(2U, index.Size());
+        Assert::AreEqual((dir / "d.fpl").string(), index.Last(1).front().string());
+      }
+      {
+        // persisted index
+        CRaceResultsIndex index{dir, indexPath};
+        Assert::AreEqual(2U, index.Size());
+        Assert::AreEqual((dir / "d.fpl").string(), index.Last(1).front().string());
+      }
+      {
+        // file renamed
+        bfs::rename(dir / "d.fpl", dir / "e.fpl");
+        CRaceResultsIndex index{dir, indexPath};
+        Assert::AreEqual(2U, index.Size());
+        Assert::AreEqual((dir / "e.fpl").string(), index.Last(1).front().string());
+      }
+      bfs::remove_all(dir);
+      bfs::remove(indexPath);
+    }
+
+    TEST_METHOD(Benchmark50k)
+    {
+      using clock = std::chrono::steady_clock;
+      const unsigned FILES_NUM = 50000;
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      const auto indexPath = dir.string() + ".idx";
+      bfs::create_directories(dir);
+      const auto now = std::time(nullptr) - FILES_NUM;
+      for(unsigned i = 0; i < FILES_NUM; ++i)
+        FileCreate(dir / ("race" + Convert(i) + ".fpl"), now + i);
+
+      // previous implementation
+      auto start = clock::now();
+      std::vector<bfs::path> results;
+      std::copy_if(bfs::directory_iterator(dir), bfs::directory_iterator(), std::back_inserter(results),
+                   [](const bfs::path &f){ return CStringNoCase{f.extension().string().c_str()} == ".fpl"; });
+      const auto result = std::max_element(begin(results), end(results),
+                                           [](const bfs::path &f1, const bfs::path &f2)
+      { return bfs::last_write_time(f1) < bfs::last_write_time(f2); });
+      const auto scanTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      // index build
+      start = clock::now();
+      {
+        CRaceResultsIndex index{dir, indexPath};
+        Assert::AreEqual(result->string(), index.Last(1).front().string());
+      }
+      const auto buildTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      // persisted index with one new result
+      FileCreate(dir / "new.fpl", now + FILES_NUM);
+      start = clock::now();
+      {
+        CRaceResultsIndex index{dir, indexPath};
+        Assert::AreEqual((dir / "new.fpl").string(), index.Last(1).front().string());
+      }
+      const auto updateTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      // persisted index with no changes
+      start = clock::now();
+      {
+        CRaceResultsIndex index{dir, indexPath};
+        Assert::AreEqual(5U, index.Last(5).size());
+      }
+      const auto queryTime = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count();
+
+      bfs::remove_all(dir);
+      bfs::remove(indexPath);
+
+      Logger::WriteMessage(("Directory scan: " + Convert(scanTime) + " ms, index build: " + Convert(buildTime) +
+                            " ms, index update: " + Convert(updateTime) + " ms, index query: " + Convert(queryTime) + " ms").c_str());
+    }
+  };
+
+  ////////////////////////   P O L A R   O P T I M I S E R   ////////////////////////
+
+  TEST_CLASS(TestPolarOptimiser) {
+    typedef polarOptimiser::CPolarFit CPolarFit;
+
+    static CPolarFit::CPointsArray PolarPoints(unsigned num, unsigned seed)
+    {
+      // ASW-20 like polar with measurement noise
+      std::mt19937 gen{seed};
+      std::normal_distribution<double> noise{0, 0.03};
+      CPolarFit::CPointsArray points;
+      for(unsigned i=0; i<num; i++) {
+        const double speed = 70 + 180.0 * i / (num - 1);
+        const double sink = -0.00019 * speed * speed + 0.0325 * speed - 1.95;
+        points.push_back(CPolarFit::TPoint{speed, sink + noise(gen)});
+      }
+      return points;
+    }
+
+    // the old PolarOptimiser search for the best 3 of measured points
+    static double BruteForce(const CPolarFit::CPointsArray &points, bool squared)
+    {
+      double bestError = std::numeric_limits<double>::max();
+      for(unsigned i=0; i<points.size(); i++) {
+        for(unsigned j=i + 1; j<points.size(); j++) {
+          for(unsigned k=j + 1; k<points.size(); k++) {
+            const double speed[3] = { points[i].speed, points[j].speed, points[k].speed };
+            const double sink[3] = { points[i].sink, points[j].sink, points[k].sink };
+            polarOptimiser::CPolarXCSoar polar{speed, sink};
+            double error = 0;
+            for(auto &p : points) {
+              const double diff = polar.Sink(p.speed, 400, 0) - p.sink;
+              error += squared ? diff * diff : std::fabs(diff);
+            }
+            bestError = (std::min)(bestError, error);
+          }
+        }
+      }
+      return bestError;
+    }
+
+    struct TGliderPolar {
+      std::string name;
+      std::unique_ptr<polarOptimiser::CPolarXCSoar> polar;
+      double mass;
+      double ballast;
+    };
+
+    static std::vector<TGliderPolar> GliderPolars()
+    {
+      std::vector<TGliderPolar> gliders;
+      CFileParserCSV csv{MAIN_SRC_DIR / "data" / "GliderData.csv"};
+      for(size_t i=1; i<csv.Rows().size(); i++) {
+        const auto &row = csv.Rows()[i];
+        double speed[3], sink[3];
+        for(unsigned j=0; j<3; j++) {
+          speed[j] = Convert<double>(row.at(7 + j * 2));
+          sink[j] = Convert<double>(row.at(8 + j * 2));
+        }
+        gliders.push_back(TGliderPolar{row.at(0), std::unique_ptr<polarOptimiser::CPolarXCSoar>{new polarOptimiser::CPolarXCSoar{speed, sink}},
+                                       Convert<double>(row.at(5)), Convert<double>(row.at(6))});
+      }
+      return gliders;
+    }
+
+    // the old PolarOptimiser best LD search
+    static unsigned SteppingBestLDSpeed(const polarOptimiser::CPolar &polar, double weight, double ballast)
+    {
+      double ld = 0;
+      unsigned ldSpeed;
+      for(ldSpeed=50; ldSpeed<=300; ldSpeed+=1) {
+        double ldLast = ld;
+        ld = ldSpeed / 3.6 / (-polar.Sink(ldSpeed, weight, ballast));
+        if(ld < ldLast) {
+          ldSpeed--;
+          break;
+        }
+      }
+      return ldSpeed;
+    }
+
+    // the old PolarOptimiser best MassDryGross search
+    static unsigned SteppingBestWeight(const polarOptimiser::CPolar &polar, double ballast, const double (&speed)[3], const double (&sink)[3], double &error)
+    {
+      unsigned weight;
+      error = 0xFFFF;
+      for(weight=10; weight<500; weight++) {
+        double errorLast = error;
+        error = 0;
+        for(unsigned i=0; i<3; i++)
+          error += std::fabs(polar.Sink(speed[i], weight, ballast) - sink[i]);
+        if(error > errorLast) {
+          error = errorLast;
+          weight--;
+          break;
+        }
+      }
+      return weight;
+    }
+
+  public:
+    TEST_METHOD(ExactPolar)
+    {
+      CPolarFit::CPointsArray points;
+      for(double speed=70; speed<=250; speed+=20)
+        points.push_back(CPolarFit::TPoint{speed, -0.0002 * speed * speed + 0.03 * speed - 1.8});
+
+      for(auto mode : { CPolarFit::MODE_LEAST_SQUARES, CPolarFit::MODE_L1 }) {
+        CPolarFit fit{points, mode};
+        Assert::IsTrue(fit.Error(points) < 1e-9);
+        const double speed[3] = { 80, 150, 220 };
+        const auto polar = fit.Polar(speed);
+        for(auto &p : points)
+          Assert::AreEqual(p.sink, polar.Sink(p.speed, 400, 0), 1e-9);
+      }
+    }
+
+    TEST_METHOD(Weights)
+    {
+      auto points = PolarPoints(20, 1);
+      points.push_back(CPolarFit::TPoint{150, 1.0});
+      CPolarFit::CWeightsArray weights(points.size(), 1.0);
+      weights.back() = 0;
+
+      // outlier with zero weight does not change the fit
+      points.pop_back();
+      CPolarFit weighted{points, CPolarFit::CWeightsArray(weights.begin(), weights.end() - 1)};
+      points.push_back(CPolarFit::TPoint{150, 1.0});
+      CPolarFit outlier{points, weights};
+      Assert::AreEqual(weighted.Sink(150), outlier.Sink(150), 1e-9);
+    }
+
+    TEST_METHOD(NotWorseThanBruteForce)
+    {
+      for(unsigned seed=0; seed<10; seed++) {
+        const auto points = PolarPoints(8 + seed * 4, seed);
+        Assert::IsTrue(CPolarFit(points).ErrorSquared(points) <= BruteForce(points, true));
+        Assert::IsTrue(CPolarFit(points, CPolarFit::MODE_L1).Error(points) <= BruteForce(points, false) + 1e-9);
+      }
+    }
+
+    TEST_METHOD(L1EqualsBruteForce)
+    {
+      // random speeds with heavy tailed noise and outliers
+      for(unsigned seed=0; seed<50; seed++) {
+        std::mt19937 gen{seed};
+        std::uniform_real_distribution<double> speeds{60, 260};
+        std::cauchy_distribution<double> noise{0, 0.05 + 0.01 * (seed % 10)};
+        CPolarFit::CPointsArray points;
+        const unsigned num = 5 + seed % 30;
+        for(unsigned i=0; i<num; i++) {
+          const double speed = speeds(gen);
+          points.push_back(CPolarFit::TPoint{speed, -0.00019 * speed * speed + 0.0325 * speed - 1.95 + noise(gen)});
+        }
+        const double bruteForce = BruteForce(points, false);
+        Assert::AreEqual(bruteForce, CPolarFit(points, CPolarFit::MODE_L1).Error(points), 1e-9 * (1 + bruteForce));
+      }
+    }
+
+    TEST_METHOD(Batch)
+    {
+      const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+      bfs::create_directories(dir / "polars");
+
+      // measured polar and full water ballast points for 400kg
+      CPolarFit::CPointsArray points;
+      for(double speed=70; speed<=250; speed+=20)
+        points.push_back(CPolarFit::TPoint{speed, -0.0002 * speed * speed + 0.03 * speed - 1.8});
+      {
+        bfs::ofstream polar{dir / "polars" / "ASW27.plr"};
+        polar << "* ASW27 measured polar" << std::endl;
+        polar << "317,190" << std::endl;
+        for(auto &p : points)
+          polar << p.speed << "," << p.sink << std::endl;
+      }
+      const auto polar = CPolarFit{points}.Polar(points);
+      const double speedFull[] = { 90, 150, 210 };
+      std::string fullBallast;
+      for(auto speed : speedFull)
+        fullBallast += (fullBallast.empty() ? "" : ",") + Convert(speed) + "," + Convert(polar.Sink(speed, 400, 190));
+
+      const std::string header = "CondorName,SpeedMax[km/h],DAeCIndex,WaterBalastEmptyTime[s],WingArea [m2],MassDryGross[kg],MaxWaterBallast[liters],"
+                                 "Speed1[km/h],Sink1[m/s],Speed2,Sink2,Speed3,Sink3,Flaps";
+      const std::string ask13 = "ASK13,200,78,0,17.5,380,0,64,-0.726,100,-1.17,130,-2.22,";
+      {
+        bfs::ofstream csv{dir / "GliderData.csv"};
+        csv << header << std::endl;
+        csv << "ASW27,285,114,190,9,317,190,75,-0.54,181,-1.82,222,-3.14,\"317,6,0,5,74,4,82,3B,104,3A,126,2,170,1\"" << std::endl;
+        csv << ask13 << std::endl;
+        csv << "LS4,280,106,170,10.5,327,170,96,-0.66,120,-0.9,145,-1.36,\"327,2,0,L\"" << std::endl;
+      }
+      {
+        bfs::ofstream ini{dir / "batch.ini"};
+        ini << "[PolarOptimiser]" << std::endl;
+        ini << "GliderData=GliderData.csv" << std::endl;
+        ini << "PolarsDir=" << (dir / "polars").string() << std::endl;
+        ini << "OutputGliderData=out/GliderData.csv" << std::endl;
+        ini << "Report=out/report.txt" << std::endl;
+        ini << "Threads=2" << std::endl;
+        ini << "[ASW27]" << std::endl;
+        ini << "FullBallast=" << fullBallast << std::endl;
+      }
+
+      const auto results = polarOptimiser::CBatch{dir / "batch.ini"}.Run();
+      Assert::AreEqual(3U, results.size());
+
+      // fitted polar with new MassDryGross
+      Assert::AreEqual(std::string{"ASW27"}, results[0].glider);
+      Assert::AreEqual(10U, results[0].points);
+      Assert::IsTrue(results[0].errorNew < 0.01 && results[0].errorNew < results[0].errorOld);
+      Assert::IsTrue(results[0].massNew >= 398 && results[0].massNew <= 402);
+      Assert::IsTrue(results[0].message.empty());
+
+      // no measured points
+      Assert::AreEqual(0U, results[1].points);
+      Assert::IsTrue(results[1].message.empty());
+
+      // invalid flaps
+      Assert::IsFalse(results[2].message.empty());
+
+      CFileParserCSV output{dir / "out" / "GliderData.csv"};
+      Assert::AreEqual(4U, output.Rows().size());
+      const auto &asw27 = output.Row("ASW27");
+      Assert::AreEqual(Convert(results[0].massNew), asw27.at(5));
+      Assert::AreEqual(std::string{"70"}, asw27.at(7));
+      Assert::AreEqual(std::string{"250"}, asw27.at(11));
+      Assert::AreEqual(Convert(results[0].massNew) + ",6,0,5,74,4,82,3B,104,3A,126,2,170,1", asw27.at(13));
+      Assert::IsTrue(CFileParserCSV::LineParse(ask13) == output.Row("ASK13"));
+      Assert::AreEqual(std::string{"327,2,0,L"}, output.Row("LS4").at(13));
+      Assert::IsTrue(bfs::exists(dir / "out" / "report.txt"));
+
+      bfs::remove_all(dir);
+    }
+
+    TEST_METHOD(SolverSink)
+    {
+      const auto gliders = GliderPolars();
+      std::vector<double> speed, sink(101);
+      for(unsigned i=0; i<sink.size(); i++)
+        speed.push_back(60 + 2 * i);
+      for(auto &g : gliders) {
+        polarOptimiser::CPolarSolver{*g.polar}.Sink(speed.data(), sink.data(), static_cast<unsigned>(speed.size()), g.mass, g.ballast);
+        for(unsigned i=0; i<speed.size(); i++)
+          Assert::AreEqual(g.polar->Sink(speed[i], g.mass, g.ballast), sink[i], 1e-12);
+      }
+    }
+
+    TEST_METHOD(SolverBestLD)
+    {
+      for(auto &g : GliderPolars()) {
+        for(auto ballast : { 0.0, g.ballast }) {
+          const auto speed = polarOptimiser::CPolarSolver{*g.polar}.BestLDSpeed(g.mass, ballast);
+          const auto stepping = SteppingBestLDSpeed(*g.polar, g.mass, ballast);
+          Assert::AreEqual(static_cast<double>(stepping), speed, 1.0);
+          Assert::IsTrue(speed / -g.polar->Sink(speed, g.mass, ballast) >= stepping / -g.polar->Sink(stepping, g.mass, ballast));
+        }
+      }
+    }
+
+    TEST_METHOD(SolverBestWeight)
+    {
+      for(auto &g : GliderPolars()) {
+        if(g.ballast == 0)
+          continue;
+
+        // full water ballast polar of the glider 37.3kg lighter
+        const double speed[3] = { 90, 140, 190 };
+        double sink[3];
+        for(unsigned i=0; i<3; i++)
+          sink[i] = g.polar->Sink(speed[i], g.mass - 37.3, g.ballast);
+
+        double error, steppingError;
+        const auto weight = polarOptimiser::CPolarSolver{*g.polar}.BestWeight(g.ballast, speed, sink, 3, error);
+        const auto stepping = SteppingBestWeight(*g.polar, g.ballast, speed, sink, steppingError);
+        Assert::AreEqual(g.mass - 37.3, weight, 0.01);
+        Assert::AreEqual(static_cast<double>(stepping), weight, 1.0);
+        Assert::IsTrue(error <= steppingError);
+      }
+    }
+
+    TEST_METHOD(SolverBenchmark)
+    {
+      typedef std::chrono::high_resolution_clock clock;
+      const unsigned ITERATIONS = 200;
+      const auto gliders = GliderPolars();
+      const double speedFull[3] = { 90, 140, 190 };
+      double sinkFull[3];
+      for(unsigned i=0; i<3; i++)
+        sinkFull[i] = gliders.front().polar->Sink(speedFull[i], gliders.front().mass - 37.3, gliders.front().ballast);
+
+      double sum = 0;
+      auto start = clock::now();
+      for(unsigned i=0; i<ITERATIONS; i++)
+        for(auto &g : gliders)
+          sum += SteppingBestLDSpeed(*g.polar, g.mass, g.ballast);
+      const auto steppingLDTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      start = clock::now();
+      for(unsigned i=0; i<ITERATIONS; i++)
+        for(auto &g : gliders)
+          sum += polarOptimiser::CPolarSolver{*g.polar}.BestLDSpeed(g.mass, g.ballast);
+      const auto solverLDTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      double error;
+      start = clock::now();
+      for(unsigned i=0; i<ITERATIONS; i++)
+        sum += SteppingBestWeight(*gliders.front().polar, gliders.front().ballast, speedFull, sinkFull, error);
+      const auto steppingWeightTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      start = clock::now();
+      for(unsigned i=0; i<ITERATIONS; i++)
+        sum += polarOptimiser::CPolarSolver{*gliders.front().polar}.BestWeight(gliders.front().ballast, speedFull, sinkFull, 3, error);
+      const auto solverWeightTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      // sink polar curve
+      std::vector<double> speed, sink(100000);
+      for(unsigned i=0; i<sink.size(); i++)
+        speed.push_back(60 + 0.002 * i);
+      const auto &polar = *gliders.front().polar;
+      start = clock::now();
+      for(unsigned i=0; i<speed.size(); i++)
+        sink[i] = polar.Sink(speed[i], gliders.front().mass, 0);
+      const auto scalarSinkTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+      sum += sink.back();
+
+      start = clock::now();
+      polarOptimiser::CPolarSolver{polar}.Sink(speed.data(), sink.data(), static_cast<unsigned>(speed.size()), gliders.front().mass, 0);
+      const auto solverSinkTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+      sum += sink.back();
+
+      Logger::WriteMessage(("Best LD speed: stepping " + Convert(steppingLDTime) + " us, closed form " + Convert(solverLDTime) + " us (" +
+                            Convert(ITERATIONS * gliders.size()) + " polars)").c_str());
+      Logger::WriteMessage(("Best weight: stepping " + Convert(steppingWeightTime) + " us, golden-section " + Convert(solverWeightTime) + " us (" +
+                            Convert(ITERATIONS) + " searches)").c_str());
+      Logger::WriteMessage(("Sink of " + Convert(speed.size()) + " speeds: scalar " + Convert(scalarSinkTime) + " us, vectorised " +
+                            Convert(solverSinkTime) + " us").c_str());
+      Assert::IsTrue(sum != 0);
+    }
+
+    TEST_METHOD(Benchmark)
+    {
+      typedef std::chrono::high_resolution_clock clock;
+      const unsigned POINTS_NUM = 200;
+      const auto points = PolarPoints(POINTS_NUM, 42);
+
+      auto start = clock::now();
+      CPolarFit leastSquares{points};
+      const auto lsTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      start = clock::now();
+      CPolarFit l1{points, CPolarFit::MODE_L1};
+      const auto l1Time = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      start = clock::now();
+      const auto bruteForceError = BruteForce(points, false);
+      const auto bruteForceTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      Logger::WriteMessage(("Polar fit of " + Convert(POINTS_NUM) + " points: least squares " + Convert(lsTime) +
+                            " us, L1 " + Convert(l1Time) + " us, brute force " + Convert(bruteForceTime) + " us").c_str());
+      Logger::WriteMessage(("Gross sink error: least squares " + Convert(leastSquares.Error(points)) +
+                            " m/s, L1 " + Convert(l1.Error(points)) + " m/s, brute force " + Convert(bruteForceError) + " m/s").c_str());
+      Assert::IsTrue(l1.Error(points) <= bruteForceError + 1e-9);
+    }
+  };
+
+  TEST_CLASS(TestSpeedToFlyTable) {
+    struct TGlider {
+      double speed[3];
+      double sink[3];
+      std::unique_ptr<polarOptimiser::CPolarXCSoar> polar;
+      unsigned mass;
+      unsigned ballast;
+    };
+
+    static std::vector<TGlider> Gliders()
+    {
+      std::vector<TGlider> gliders;
+      CFileParserCSV csv{MAIN_SRC_DIR / "data" / "GliderData.csv"};
+      for(size_t i=1; i<csv.Rows().size(); i++) {
+        const auto &row = csv.Rows()[i];
+        TGlider g;
+        for(unsigned j=0; j<3; j++) {
+          g.speed[j] = Convert<double>(row.at(7 + j * 2));
+          g.sink[j] = Convert<double>(row.at(8 + j * 2));
+        }
+        g.polar.reset(new polarOptimiser::CPolarXCSoar{g.speed, g.sink});
+        g.mass = Convert<unsigned>(row.at(5));
+        g.ballast = Convert<unsigned>(row.at(6));
+        gliders.push_back(std::move(g));
+      }
+      return gliders;
+    }
+
+    // speed to fly search stepping the airspeed by 0.1 km/h
+    static double SteppingSpeedToFly(const double (&coeffs)[3], double headWind, double mc)
+    {
+      double bestSpeed = 0, best = 0;
+      for(unsigned i=0; i<=3000; i++) {
+        const double speed = (50 + 0.1 * i) / 3.6;
+        const double ground = speed - headWind;
+        const double value = ground / -CSpeedToFlyTable::SinkRate(coeffs[0], coeffs[1], coeffs[2], mc, headWind, ground);
+        if(value > best) {
+          best = value;
+          bestSpeed = speed * 3.6;
+        }
+      }
+      return bestSpeed;
+    }
+
+  public:
+    TEST_METHOD(Coefficients)
+    {
+      // the same polar as the one of PolarOptimiser
+      for(auto &g : Gliders()) {
+        for(auto ballast : { 0u, g.ballast / 2, g.ballast }) {
+          double coeffs[3], expected[3];
+          CSpeedToFlyTable::Coefficients(g.speed, g.sink, g.mass, ballast, coeffs);
+          g.polar->Coefficients(g.mass, ballast, expected);
+          for(unsigned i=0; i<3; i++)
+            Assert::AreEqual(expected[i], coeffs[i], 1e-12 * std::abs(expected[i]));
+        }
+      }
+    }
+
+    TEST_METHOD(SolveMatchesSearch)
+    {
+      const double mc[] = { 0, 0.5, 1, 1.5, 2, 3, 4, 5 };
+      const unsigned MC_NUM = sizeof(mc) / sizeof(*mc);
+      for(auto &g : Gliders()) {
+        for(auto ballast : { 0u, g.ballast }) {
+          double coeffs[3];
+          g.polar->Coefficients(g.mass, ballast, coeffs);
+          for(auto headWind : { -10.0, 0.0, 10.0 }) {
+            CSpeedToFlyTable::TCell cells[MC_NUM];
+            CSpeedToFlyTable::Solve(coeffs, headWind, mc, cells, MC_NUM);
+            for(unsigned i=0; i<MC_NUM; i++) {
+              const double speed = SteppingSpeedToFly(coeffs, headWind, mc[i]);
+              if(speed > 50.05 && speed < 349.95)
+                Assert::AreEqual(speed, cells[i].speed, 0.1);
+              Assert::AreEqual(g.polar->Sink(cells[i].speed, g.mass, ballast), cells[i].sink, 1e-9);
+              Assert::AreEqual((cells[i].speed / 3.6 - headWind) / -cells[i].sink, cells[i].groundLD, 1e-9);
+            }
+          }
+        }
+      }
+    }
+
+    TEST_METHOD(BestLD)
+    {
+      const double mc[] = { 0, 0, 0 };
+      for(auto &g : Gliders()) {
+        double coeffs[3];
+        g.polar->Coefficients(g.mass, 0, coeffs);
+        CSpeedToFlyTable::TCell cells[3];
+        CSpeedToFlyTable::Solve(coeffs, 0, mc, cells, 3);
+        for(auto &cell : cells) {
+          Assert::AreEqual(polarOptimiser::CPolarSolver{*g.polar}.BestLDSpeed(g.mass, 0), cell.speed, 1e-9);
+          Assert::AreEqual(0.0, cell.xcSpeed, 1e-9);
+        }
+      }
+    }
+
+    TEST_METHOD(Encoding)
+    {
+      const auto gliders = Gliders();
+      const auto &g = gliders.front();
+      const CSpeedToFlyTable table{g.speed, g.sink, g.mass, g.ballast};
+      const auto &data = table.Data();
+      Assert::AreEqual(CSpeedToFlyTable::Size(), data.size());
+      Assert::AreEqual(std::string{"C2NS"}, data.substr(0, 4));
+      Assert::AreEqual(static_cast<unsigned>(CSpeedToFlyTable::MC_NUM), static_cast<unsigned>(static_cast<unsigned char>(data[CSpeedToFlyTable::HEADER_MC_NUM])));
+
+      double mc[CSpeedToFlyTable::MC_NUM];
+      for(unsigned i=0; i<CSpeedToFlyTable::MC_NUM; i++)
+        mc[i] = i * CSpeedToFlyTable::MC_STEP / 1000.0;
+      CSpeedToFlyTable::TCell cells[CSpeedToFlyTable::MC_NUM];
+      for(unsigned ballast=0; ballast<CSpeedToFlyTable::BALLAST_NUM; ballast+=5) {
+        double coeffs[3];
+        g.polar->Coefficients(g.mass, static_cast<double>(g.ballast) * ballast / (CSpeedToFlyTable::BALLAST_NUM - 1), coeffs);
+        for(unsigned wind=0; wind<CSpeedToFlyTable::WIND_NUM; wind+=4) {
+          CSpeedToFlyTable::Solve(coeffs, (CSpeedToFlyTable::WIND_MIN + static_cast<int>(wind * CSpeedToFlyTable::WIND_STEP)) / 1000.0, mc, cells, CSpeedToFlyTable::MC_NUM);
+          for(unsigned i=0; i<CSpeedToFlyTable::MC_NUM; i++) {
+            const auto cell = table.Cell(ballast, wind, i);
+            Assert::AreEqual(cells[i].speed, cell.speed, 0.05 + 1e-9);
+            Assert::AreEqual(cells[i].sink, cell.sink, 0.0005 + 1e-9);
+            Assert::AreEqual(cells[i].groundLD, cell.groundLD, 0.005 + 1e-9);
+            Assert::AreEqual(cells[i].xcSpeed, cell.xcSpeed, 0.05 + 1e-9);
+          }
+        }
+      }
+    }
+
+    TEST_METHOD(Benchmark)
+    {
+      typedef std::chrono::high_resolution_clock clock;
+      const auto gliders = Gliders();
+
+      auto start = clock::now();
+      size_t size = 0;
+      for(auto &g : gliders)
+        size += CSpeedToFlyTable{g.speed, g.sink, g.mass, g.ballast}.Data().size();
+      const auto tableTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      // the same grid for one glider with stepping search
+      const auto &g = gliders.front();
+      double sum = 0;
+      start = clock::now();
+      for(unsigned ballast=0; ballast<CSpeedToFlyTable::BALLAST_NUM; ballast++) {
+        double coeffs[3];
+        g.polar->Coefficients(g.mass, static_cast<double>(g.ballast) * ballast / (CSpeedToFlyTable::BALLAST_NUM - 1), coeffs);
+        for(unsigned wind=0; wind<CSpeedToFlyTable::WIND_NUM; wind++)
+          for(unsigned mc=0; mc<CSpeedToFlyTable::MC_NUM; mc++)
+            sum += SteppingSpeedToFly(coeffs, (CSpeedToFlyTable::WIND_MIN + static_cast<int>(wind * CSpeedToFlyTable::WIND_STEP)) / 1000.0,
+                                      mc * CSpeedToFlyTable::MC_STEP / 1000.0);
+      }
+      const auto steppingTime = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start).count();
+
+      Logger::WriteMessage(("Speed to fly tables of " + Convert(gliders.size()) + " gliders (" + Convert(size) + " bytes): " +
+                            Convert(tableTime) + " us, stepping search for 1 glider " + Convert(steppingTime) + " us").c_str());
+      Assert::IsTrue(sum > 0);
+    }
+  };
 }
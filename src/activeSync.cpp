@@ -26,10 +26,14 @@
  */
 
 #include "activeSync.h"
-#include <memory>
+#include "platform.h"
+#include "exception.h"
+#include <boost/filesystem.hpp>
 #include <algorithm>
+#include <functional>
+#include <windows.h>
 #include <rapi.h>
-#include <boost/filesystem.hpp>
+
 
 namespace {
 
@@ -57,17 +61,26 @@ namespace {
                                      DWORD nNumberOfBytesToWrite,
                                      LPDWORD lpNumberOfBytesWritten,
                                      LPOVERLAPPED lpOverlapped);
+  using FCeSetFilePointer = DWORD(WINAPI*)(HANDLE hFile,
+                                           LONG lDistanceToMove,
+                                           PLONG lpDistanceToMoveHigh,
+                                           DWORD dwMoveMethod);
+  using FCeSetEndOfFile = BOOL(WINAPI*)(HANDLE hFile);
   using FCeCloseHandle = BOOL(WINAPI*)(HANDLE hObject);
   using FCeCreateDirectory = BOOL(WINAPI*)(LPCWSTR lpPathName,
                                            LPSECURITY_ATTRIBUTES lpSecurityAttributes);
+  using FCeGetFileAttributes = DWORD(WINAPI*)(LPCWSTR lpFileName);
+  using FCeFindAllFiles = BOOL(WINAPI*)(LPCWSTR szPath,
+                                        DWORD dwFlags,
+                                        LPDWORD lpdwFoundCount,
+                                        LPLPCE_FIND_DATA ppFindDataArray);
+  using FCeRapiFreeBuffer = HRESULT(WINAPI*)(LPVOID Buffer);
 
   template<typename SYMBOL_TYPE>
-  inline void Symbol(const HMODULE &module, const std::string &name, SYMBOL_TYPE &out)
+  inline void Symbol(const condor2nav::platform::CLibrary &lib, const std::string &name, SYMBOL_TYPE &out)
   {
-    auto sym = reinterpret_cast<SYMBOL_TYPE>(GetProcAddress(module, name.c_str()));
-    if(!sym)
+    if(!lib.Symbol(name, out))
       throw condor2nav::EOperationFailed{"ERROR: Couldn't map " + name + "() from 'rapi.dll'!!!"};
-    out = sym;
   }
 
 }
@@ -78,7 +91,7 @@ namespace condor2nav {
   /**
    * @brief rapi.dll interface.
    */
-  struct CActiveSync::TDLLIface {
+  struct TDLLIface {
     FCeRapiInitEx      ceRapiInitEx;
     FCeRapiUninit      ceRapiUninit;
     FCeGetLastError    ceGetLastError;
@@ -86,64 +99,89 @@ namespace condor2nav {
     FCeGetFileSize     ceGetFileSize;
     FCeReadFile        ceReadFile;
     FCeWriteFile       ceWriteFile;
+    FCeSetFilePointer  ceSetFilePointer;
+    FCeSetEndOfFile    ceSetEndOfFile;
     FCeCloseHandle     ceCloseHandle;
     FCeCreateDirectory ceCreateDirectory;
+    FCeGetFileAttributes ceGetFileAttributes;
+    FCeFindAllFiles    ceFindAllFiles;
+    FCeRapiFreeBuffer  ceRapiFreeBuffer;
   };
 
-  class CActiveSync::CRapiHandleDeleter {
-    const TDLLIface &_iface;
+  /**
+   * @brief ActiveSync RAPI implementation.
+   */
+  class CActiveSync::CImpl : CNonCopyable {
+    class CRapiHandleDeleter {
+      const TDLLIface &_iface;
+    public:
+      using pointer = HANDLE;
+      CRapiHandleDeleter(const TDLLIface &iface) : _iface{iface} {}
+      CRapiHandleDeleter &operator =(const CRapiHandleDeleter &) = delete;
+      void operator ()(pointer handle) const { _iface.ceCloseHandle(handle); }
+    };
+    using CRapiHandle = std::unique_ptr<HANDLE, CRapiHandleDeleter>;
+    class CFileReader;
+
+    class CRapiDeleter {
+      const TDLLIface &_iface;
+    public:
+      using pointer = bool;
+      CRapiDeleter(const TDLLIface &iface) : _iface{iface} {}
+      CRapiDeleter &operator =(const CRapiDeleter &) = delete;
+      void operator ()(pointer status) const { _iface.ceRapiUninit(); }
+    };
+    using CRapiRes = std::unique_ptr<bool, CRapiDeleter>;
+
+    static const unsigned TIMEOUT = 5000;             ///< @brief Timeout in ms for ActiveSync initialization. 
+
+    platform::CLibrary _lib;                          ///< @brief DLL instance. 
+    TDLLIface _iface;	                                ///< @brief DLL interface.
+    CRapiRes _rapi;                                   ///< @brief RAPI RAII wrapper. 
+
   public:
-    using pointer = HANDLE;
-    CRapiHandleDeleter(const TDLLIface &iface) : _iface{iface} {}
-    CRapiHandleDeleter &operator =(const CRapiHandleDeleter &) = delete;
-    void operator ()(pointer handle) const { _iface.ceCloseHandle(handle); }
+    CImpl();
+    std::unique_ptr<CReader> Open(const bfs::path &src) const;
+    void Write(const bfs::path &dest, const std::string &buffer) const;
+    void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const;
+    void DirectoryCreate(const bfs::path &path) const;
+    bool FileExists(const bfs::path &path) const;
+    bool List(const bfs::path &dir, CDeviceTransport::CEntriesList &entries) const;
   };
 
-  void CActiveSync::CRapiDeleter::operator()(pointer status) const { _iface.ceRapiUninit(); }
-
-}
-
-
-
-/**
- * @brief Returns singleton instance.
- *
- * Method returns singleton instance.
- *
- * @return Singleton instance.
- */
-condor2nav::CActiveSync &condor2nav::CActiveSync::Instance()
-{
-  static CActiveSync instance;
-  return instance;
 }
 
 
 /**
  * @brief Class constructor.
  *
- * condor2nav::CActiveSync class constructor.
+ * condor2nav::CActiveSync::CImpl class constructor that initializes RAPI connection.
  */
-condor2nav::CActiveSync::CActiveSync() :
-  _lib{::LoadLibrary("rapi.dll")}, _iface{std::make_unique<TDLLIface>()}, _rapi{false, CRapiDeleter(*_iface)}
+condor2nav::CActiveSync::CImpl::CImpl() :
+  _lib{"rapi.dll"}, _rapi{false, CRapiDeleter(_iface)}
 {
-  if(!_lib.get())
+  if(!_lib.Loaded())
     throw EOperationFailed{"ERROR: Couldn't open 'rapi.dll' library!!! Please check that ActiveSync is installed correctly."};
-  Symbol(_lib.get(), "CeRapiInitEx",      _iface->ceRapiInitEx);
-  Symbol(_lib.get(), "CeRapiUninit",      _iface->ceRapiUninit);
-  Symbol(_lib.get(), "CeGetLastError",    _iface->ceGetLastError);
-  Symbol(_lib.get(), "CeCreateFile",      _iface->ceCreateFile);
-  Symbol(_lib.get(), "CeGetFileSize",     _iface->ceGetFileSize);
-  Symbol(_lib.get(), "CeReadFile",        _iface->ceReadFile);
-  Symbol(_lib.get(), "CeWriteFile",       _iface->ceWriteFile);
-  Symbol(_lib.get(), "CeCloseHandle",     _iface->ceCloseHandle);
-  Symbol(_lib.get(), "CeCreateDirectory", _iface->ceCreateDirectory);
+  Symbol(_lib, "CeRapiInitEx",      _iface.ceRapiInitEx);
+  Symbol(_lib, "CeRapiUninit",      _iface.ceRapiUninit);
+  Symbol(_lib, "CeGetLastError",    _iface.ceGetLastError);
+  Symbol(_lib, "CeCreateFile",      _iface.ceCreateFile);
+  Symbol(_lib, "CeGetFileSize",     _iface.ceGetFileSize);
+  Symbol(_lib, "CeReadFile",        _iface.ceReadFile);
+  Symbol(_lib, "CeWriteFile",       _iface.ceWriteFile);
+  Symbol(_lib, "CeSetFilePointer",  _iface.ceSetFilePointer);
+  Symbol(_lib, "CeSetEndOfFile",    _iface.ceSetEndOfFile);
+  Symbol(_lib, "CeCloseHandle",     _iface.ceCloseHandle);
+  Symbol(_lib, "CeCreateDirectory", _iface.ceCreateDirectory);
+  Symbol(_lib, "CeGetFileAttributes", _iface.ceGetFileAttributes);
+  Symbol(_lib, "CeFindAllFiles",    _iface.ceFindAllFiles);
+  Symbol(_lib, "CeRapiFreeBuffer",  _iface.ceRapiFreeBuffer);
 
   // init RAPI
   RAPIINIT initData{};
   initData.cbSize = sizeof(initData);
 
-  _rapi.reset(!FAILED(_iface->ceRapiInitEx(&initData)));
+  _rapi.reset(!FAILED(_iface.ceRapiInitEx(&initData)));
   if(!_rapi.get())
     throw EOperationFailed{"Cannot initialize ActiveSync connection!!!"};
 
@@ -170,39 +208,62 @@ condor2nav::CActiveSync::CActiveSync() :
 }
 
 
+namespace condor2nav {
+
+  /**
+   * @brief ActiveSync file reader.
+   *
+   * Each chunk is read with one RAPI call.
+   */
+  class CActiveSync::CImpl::CFileReader : public CReader {
+    const TDLLIface &_iface;                          ///< @brief DLL interface.
+    const std::string _path;                          ///< @brief Target file path (for errors reporting).
+    CRapiHandle _handle;                              ///< @brief Target file handle.
+    DWORD _left;                                      ///< @brief The number of bytes left to read.
+  public:
+    CFileReader(const TDLLIface &iface, const bfs::path &path, CRapiHandle handle, DWORD size) :
+      _iface(iface), _path{path.string()}, _handle{std::move(handle)}, _left{size} {}
+
+    size_t Read(char *buffer, size_t size) override
+    {
+      if(!_left)
+        return 0;
+      DWORD numBytes = 0;
+      if(!_iface.ceReadFile(_handle.get(), buffer, (std::min)(static_cast<DWORD>(size), _left), &numBytes, nullptr))
+        throw EOperationFailed{"ERROR: Reading ActiveSync file '" + _path + "'!!!"};
+      _left = numBytes ? _left - numBytes : 0;
+      return numBytes;
+    }
+  };
+
+}
+
+
 /**
- * @brief Reads whole file to a string.
+ * @brief Opens a file on the target device for reading.
  *
- * Method reads whole file to a string.
+ * Method opens the file and returns the reader that transfers its content
+ * in chunks.
  *
  * @param src Target file path. 
  * 
- * @return String with file content. 
+ * @return File reader. 
  */
-std::string condor2nav::CActiveSync::Read(const bfs::path &src) const
+std::unique_ptr<condor2nav::CReader> condor2nav::CActiveSync::CImpl::Open(const bfs::path &src) const
 {
-  std::unique_ptr<HANDLE, CRapiHandleDeleter> hSrc{_iface->ceCreateFile(src.wstring().c_str(),
-                                                                        GENERIC_READ,
-                                                                        FILE_SHARE_READ,
-                                                                        nullptr,
-                                                                        OPEN_EXISTING,
-                                                                        FILE_ATTRIBUTE_NORMAL,
-                                                                        nullptr),
-                                                   CRapiHandleDeleter{*_iface}};
+  CRapiHandle hSrc{_iface.ceCreateFile(src.wstring().c_str(),
+                                       GENERIC_READ,
+                                       FILE_SHARE_READ,
+                                       nullptr,
+                                       OPEN_EXISTING,
+                                       FILE_ATTRIBUTE_NORMAL,
+                                       nullptr),
+                   CRapiHandleDeleter{_iface}};
   if(hSrc.get() == INVALID_HANDLE_VALUE)
     throw EOperationFailed{"ERROR: Unable to open ActiveSync file '" + src.string() + "'!!!"};
 
-  auto numBytes = _iface->ceGetFileSize(hSrc.get(), nullptr);
-  std::vector<char> buffer;
-  buffer.resize(numBytes);
-
-  if(!_iface->ceReadFile(hSrc.get(), buffer.data(), numBytes, &numBytes, nullptr))
-    throw EOperationFailed{"ERROR: Reading ActiveSync file '" + src.string() + "'!!!"};
-
-  // remove all returns from a file
-  buffer.erase(std::remove_if(begin(buffer), end(buffer), [](char c){ return c == '\r'; }), end(buffer));
-
-  return buffer.data();
+  const auto numBytes = _iface.ceGetFileSize(hSrc.get(), nullptr);
+  return std::make_unique<CFileReader>(_iface, src, std::move(hSrc), numBytes);
 }
 
 
@@ -214,21 +275,55 @@ std::string condor2nav::CActiveSync::Read(const bfs::path &src) const
  * @param dest Target file path. 
  * @param buffer Buffer with file content. 
  */
-void condor2nav::CActiveSync::Write(const bfs::path &dest, const std::string &buffer) const
+void condor2nav::CActiveSync::CImpl::Write(const bfs::path &dest, const std::string &buffer) const
 {
-  std::unique_ptr<HANDLE, CRapiHandleDeleter> hDest{_iface->ceCreateFile(dest.wstring().c_str(),
+  std::unique_ptr<HANDLE, CRapiHandleDeleter> hDest{_iface.ceCreateFile(dest.wstring().c_str(),
                                                                          GENERIC_WRITE,
                                                                          FILE_SHARE_READ,
                                                                          nullptr,
                                                                          CREATE_ALWAYS,
                                                                          FILE_ATTRIBUTE_NORMAL,
                                                                          nullptr),
-                                                    CRapiHandleDeleter{*_iface}};
+                                                    CRapiHandleDeleter{_iface}};
+  if(hDest.get() == INVALID_HANDLE_VALUE)
+    throw EOperationFailed{"ERROR: Unable to open ActiveSync file '" + dest.string() + "'!!!"};
+
+  DWORD numBytes;
+  if(!_iface.ceWriteFile(hDest.get(), buffer.c_str(), buffer.size(), &numBytes, nullptr))
+    throw EOperationFailed{"ERROR: Writing ActiveSync file '" + dest.string() + "'!!!"};
+}
+
+
+/**
+ * @brief Overwrites a part of a file on the target device.
+ *
+ * Method writes the buffer at provided offset of existing file on the target
+ * device and sets the size of the file. Only the buffer is transferred.
+ *
+ * @param dest   Target file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::CActiveSync::CImpl::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  CRapiHandle hDest{_iface.ceCreateFile(dest.wstring().c_str(),
+                                        GENERIC_WRITE,
+                                        FILE_SHARE_READ,
+                                        nullptr,
+                                        OPEN_EXISTING,
+                                        FILE_ATTRIBUTE_NORMAL,
+                                        nullptr),
+                    CRapiHandleDeleter{_iface}};
   if(hDest.get() == INVALID_HANDLE_VALUE)
     throw EOperationFailed{"ERROR: Unable to open ActiveSync file '" + dest.string() + "'!!!"};
 
   DWORD numBytes;
-  if(!_iface->ceWriteFile(hDest.get(), buffer.c_str(), buffer.size(), &numBytes, nullptr))
+  if(_iface.ceSetFilePointer(hDest.get(), static_cast<LONG>(offset), nullptr, FILE_BEGIN) == 0xFFFFFFFF ||
+     !_iface.ceWriteFile(hDest.get(), buffer.c_str(), buffer.size(), &numBytes, nullptr) || numBytes != buffer.size())
+    throw EOperationFailed{"ERROR: Writing ActiveSync file '" + dest.string() + "'!!!"};
+  if((size != offset + buffer.size() && _iface.ceSetFilePointer(hDest.get(), static_cast<LONG>(size), nullptr, FILE_BEGIN) == 0xFFFFFFFF) ||
+     !_iface.ceSetEndOfFile(hDest.get()))
     throw EOperationFailed{"ERROR: Writing ActiveSync file '" + dest.string() + "'!!!"};
 }
 
@@ -240,9 +335,9 @@ void condor2nav::CActiveSync::Write(const bfs::path &dest, const std::string &bu
  *
  * @param path Target directory path. 
  */
-void condor2nav::CActiveSync::DirectoryCreate(const bfs::path &path) const
+void condor2nav::CActiveSync::CImpl::DirectoryCreate(const bfs::path &path) const
 {
-  if(!_iface->ceCreateDirectory(path.wstring().c_str(), nullptr) && _iface->ceGetLastError() != ERROR_ALREADY_EXISTS)
+  if(!_iface.ceCreateDirectory(path.wstring().c_str(), nullptr) && _iface.ceGetLastError() != ERROR_ALREADY_EXISTS)
     throw EOperationFailed{"ERROR: Creating ActiveSync directory '" + path.string() + "'!!!"};
 }
 
@@ -256,21 +351,171 @@ void condor2nav::CActiveSync::DirectoryCreate(const bfs::path &path) const
  *
  * @return @p true if file exists.
  */
-bool condor2nav::CActiveSync::FileExists(const bfs::path &path) const
+bool condor2nav::CActiveSync::CImpl::FileExists(const bfs::path &path) const
 {
-  std::unique_ptr<HANDLE, CRapiHandleDeleter> hDest{_iface->ceCreateFile(path.wstring().c_str(),
+  std::unique_ptr<HANDLE, CRapiHandleDeleter> hDest{_iface.ceCreateFile(path.wstring().c_str(),
                                                                          GENERIC_READ,
                                                                          FILE_SHARE_READ,
                                                                          nullptr,
                                                                          OPEN_EXISTING,
                                                                          FILE_ATTRIBUTE_NORMAL,
                                                                          nullptr),
-                                                    CRapiHandleDeleter{*_iface}};
+                                                    CRapiHandleDeleter{_iface}};
   if(hDest.get() == INVALID_HANDLE_VALUE) {
-    if(_iface->ceGetLastError() == ERROR_FILE_NOT_FOUND)
+    if(_iface.ceGetLastError() == ERROR_FILE_NOT_FOUND)
       return false;
     throw EOperationFailed{"ERROR: Unable to check if file '" + path.string() + "' exists!!!"};
   }
   else
     return true;
 }
+
+
+/**
+ * @brief Lists directory content on the target device.
+ *
+ * Method lists names, attributes and sizes of all entries of the directory
+ * with one RAPI call.
+ *
+ * @param dir     Target directory path.
+ * @param entries Directory entries.
+ *
+ * @return @p false if the directory does not exist.
+ */
+bool condor2nav::CActiveSync::CImpl::List(const bfs::path &dir, CDeviceTransport::CEntriesList &entries) const
+{
+  DWORD count = 0;
+  LPCE_FIND_DATA data = nullptr;
+  if(!_iface.ceFindAllFiles((dir / "*").wstring().c_str(), FAF_ATTRIBUTES | FAF_SIZE_LOW | FAF_NAME, &count, &data)) {
+    const auto error = _iface.ceGetLastError();
+    if(error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)
+      return false;
+    throw EOperationFailed{"ERROR: Unable to list ActiveSync directory '" + dir.string() + "'!!!"};
+  }
+
+  std::unique_ptr<CE_FIND_DATA, std::function<void(LPCE_FIND_DATA)>> buffer{data, [this](LPCE_FIND_DATA ptr){ if(ptr) _iface.ceRapiFreeBuffer(ptr); }};
+  if(!count) {
+    // empty result is returned for not existing directory too
+    const auto attributes = _iface.ceGetFileAttributes(dir.wstring().c_str());
+    return attributes != 0xFFFFFFFF && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+  }
+  for(DWORD i = 0; i < count; ++i) {
+    const bool directory = (data[i].dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    entries.push_back(CDeviceTransport::TEntry{bfs::path{data[i].cFileName}.string(), directory, directory ? 0 : data[i].nFileSizeLow});
+  }
+  return true;
+}
+
+
+
+
+/**
+ * @brief Returns singleton instance.
+ *
+ * Method returns singleton instance.
+ *
+ * @return Singleton instance.
+ */
+condor2nav::CActiveSync &condor2nav::CActiveSync::Instance()
+{
+  static CActiveSync instance;
+  return instance;
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CActiveSync class constructor.
+ */
+condor2nav::CActiveSync::CActiveSync() :
+  _impl{std::make_unique<CImpl>()}
+{
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * NOTE: Destructor definition is needed here to make sure that CImpl is defined.
+ */
+condor2nav::CActiveSync::~CActiveSync()
+{
+}
+
+
+/**
+ * @brief Opens a file on the target device for reading.
+ *
+ * @param src Target file path. 
+ * 
+ * @return File reader. 
+ */
+std::unique_ptr<condor2nav::CReader> condor2nav::CActiveSync::Open(const bfs::path &src) const
+{
+  return _impl->Open(src);
+}
+
+
+/**
+ * @brief Writes buffer to a file on the target device.
+ *
+ * @param dest Target file path. 
+ * @param buffer Buffer with file content. 
+ */
+void condor2nav::CActiveSync::Write(const bfs::path &dest, const std::string &buffer) const
+{
+  _impl->Write(dest, buffer);
+}
+
+
+/**
+ * @brief Overwrites a part of a file on the target device.
+ *
+ * @param dest   Target file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::CActiveSync::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  _impl->Patch(dest, offset, buffer, size);
+}
+
+
+/**
+ * @brief Creates directory on the target device.
+ *
+ * @param path Target directory path. 
+ */
+void condor2nav::CActiveSync::DirectoryCreate(const bfs::path &path) const
+{
+  _impl->DirectoryCreate(path);
+}
+
+
+/**
+ * @brief Checks if a file exists on the target device.
+ *
+ * @param path Target file path.
+ *
+ * @return @p true if file exists.
+ */
+bool condor2nav::CActiveSync::FileExists(const bfs::path &path) const
+{
+  return _impl->FileExists(path);
+}
+
+
+/**
+ * @brief Lists directory content on the target device.
+ *
+ * @param dir     Target directory path.
+ * @param entries Directory entries.
+ *
+ * @return @p false if the directory does not exist.
+ */
+bool condor2nav::CActiveSync::List(const bfs::path &dir, CDeviceTransport::CEntriesList &entries) const
+{
+  return _impl->List(dir, entries);
+}
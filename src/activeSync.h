@@ -29,9 +29,9 @@
 #define __ACTIVESYNC_H__
 
 #include "nonCopyable.h"
-#include "tools.h"
-#include "boostfwd.h"
-#include <functional>
+#include "deviceTransport.h"
+#include <memory>
+#include <string>
 
 
 namespace condor2nav {
@@ -40,37 +40,24 @@ namespace condor2nav {
    * @brief ActiveSync interface wrapper
    *
    * condor2nav::CActiveSync class is a wrapper around ActiveSync interface.
-   * It uses RAPI interface to communicate with remote device.
+   * It uses RAPI interface to communicate with remote device (Windows only).
    *
    * @note Singleton design pattern
    */
   class CActiveSync : CNonCopyable {
-    struct TDLLIface;
-    class CRapiHandleDeleter;
-
-    class CRapiDeleter {
-      const TDLLIface &_iface;
-    public:
-      using pointer = bool;
-      CRapiDeleter(const TDLLIface &iface) : _iface{iface} {}
-      CRapiDeleter &operator =(const CRapiDeleter &) = delete;
-      void operator ()(pointer status) const;
-    };
-    using CRapiRes = std::unique_ptr<bool, CRapiDeleter>;
-
-    static const unsigned TIMEOUT = 5000;             ///< @brief Timeout in ms for ActiveSync initialization. 
-
-    CLibraryRes _lib;                                 ///< @brief DLL instance. 
-    std::unique_ptr<TDLLIface> _iface;	              ///< @brief DLL interface.
-    CRapiRes _rapi;                                   ///< @brief RAPI RAII wrapper. 
+    class CImpl;
+    std::unique_ptr<CImpl> _impl;                     ///< @brief RAPI implementation.
 
     CActiveSync();
   public:
     static CActiveSync &Instance();
-    std::string Read(const bfs::path &src) const;
+    ~CActiveSync();
+    std::unique_ptr<CReader> Open(const bfs::path &src) const;
     void Write(const bfs::path &dest, const std::string &buffer) const;
+    void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const;
     void DirectoryCreate(const bfs::path &path) const;
     bool FileExists(const bfs::path &path) const;
+    bool List(const bfs::path &dir, CDeviceTransport::CEntriesList &entries) const;
   };
 
 }
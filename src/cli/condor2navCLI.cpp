@@ -28,16 +28,46 @@
 #include "condor2navCLI.h"
 #include "translator.h"
 #include "condor.h"
+#include "directoryWatcher.h"
+#include "istream.h"
+#include "threadPool.h"
+#include "traitsNoCase.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+
+namespace {
+
+  // traces are collected per thread and printed in whole lines only
+  std::mutex traceMutex;
+  std::map<std::pair<const void *, std::thread::id>, std::string> traceLines;
+
+  // set by Ctrl+C in watch mode
+  volatile std::sig_atomic_t watchAbort = 0;
+
+  void WatchAbortHandler(int)
+  {
+    watchAbort = 1;
+  }
+
+}
 
 
 /**
  * @brief Class constructor. 
  *
- * @param type The logger type. 
+ * @param type  The logger type. 
+ * @param quiet Specifies if traces should be dropped. 
  */
-condor2nav::cli::CCondor2NavCLI::CLogger::CLogger(TType type) :
-  CCondor2Nav::CLogger{type}
+condor2nav::cli::CCondor2NavCLI::CLogger::CLogger(TType type, bool quiet /* = false */) :
+  CCondor2Nav::CLogger{type}, _quiet{quiet}
 {
 
 }
@@ -46,22 +76,39 @@ condor2nav::cli::CCondor2NavCLI::CLogger::CLogger(TType type) :
 /**
  * @brief Dumps the text to the console output. 
  *
+ * Text is dumped in whole lines so that traces from different threads
+ * are not mixed.
+ *
  * @param str The string to dump. 
  *
  * @exception EOperationFailed Thrown when operation failed to execute. 
  */
 void condor2nav::cli::CCondor2NavCLI::CLogger::Trace(const std::string &str) const
 {
+  if(_quiet)
+    return;
+
+  std::lock_guard<std::mutex> lock{traceMutex};
+  const auto key = std::make_pair(static_cast<const void *>(this), std::this_thread::get_id());
+  auto &line = traceLines[key];
+  line += str;
+  const auto pos = line.find_last_of('\n');
+  if(pos == std::string::npos)
+    return;
+
   switch(Type()) {
   case TType::LOG_NORMAL:
   case TType::LOG_HIGH:
-    std::cout << str;
+    std::cout << line.substr(0, pos + 1) << std::flush;
     break;
   case TType::WARNING:
   case TType::ERROR:
-    std::cerr << str;
+    std::cerr << line.substr(0, pos + 1) << std::flush;
     break;
   }
+  line.erase(0, pos + 1);
+  if(line.empty())
+    traceLines.erase(key);
 }
 
 
@@ -72,7 +119,9 @@ condor2nav::cli::CCondor2NavCLI::CCondor2NavCLI() :
   _normal{CLogger::TType::LOG_NORMAL},
   _high{CLogger::TType::LOG_HIGH},
   _warning{CLogger::TType::WARNING},
-  _error{CLogger::TType::ERROR}
+  _error{CLogger::TType::ERROR},
+  _quiet{CLogger::TType::LOG_NORMAL, true},
+  _batch{false}
 {
 }
 
@@ -90,7 +139,8 @@ void condor2nav::cli::CCondor2NavCLI::Usage() const
   Log() << "and you are welcome to redistribute it under GNU GPL conditions." << std::endl;
   Log() << std::endl;
   Log() << "Usage:" << std::endl;
-  Log() << "  condor2nav.exe [-h|--aat <TASK_MIN_TIME>][--default|--last-race|<FPL_PATH>]" << std::endl;
+  Log() << "  condor2nav.exe [-h|--aat <TASK_MIN_TIME>][--default|--last-race|<FPL_PATH>|" << std::endl;
+  Log() << "                  --batch <FPL_DIR|FPL_LIST> [--jobs <NUM>]|--watch]" << std::endl;
   Log() << std::endl;
   Log() << "  -h                    - that help message" << std::endl;
   Log() << "  --aat <TASK_MIN_TIME> - convert a task as AAT with provided Task Minimum Time" << std::endl;
@@ -107,6 +157,16 @@ void condor2nav::cli::CCondor2NavCLI::Usage() const
   Log() << "  <FPL_PATH>            - full path to Condor FPL file" << std::endl;
   Log() << "                          (The same result can be achieved i.e. by drag-and-drop" << std::endl;
   Log() << "                           of FPL file in Windows Explorer onto condor2nav.exe icon)" << std::endl;
+  Log() << "  --batch <FPL_DIR|FPL_LIST>" << std::endl;
+  Log() << "                        - convert all FPL files from provided directory or listed" << std::endl;
+  Log() << "                          in provided text file (one path per line). Results of" << std::endl;
+  Log() << "                          each FPL are stored in a separate subdirectory of" << std::endl;
+  Log() << "                          OutputPath named after FPL file" << std::endl;
+  Log() << "  --jobs <NUM>          - number of FPL files converted in parallel in batch mode" << std::endl;
+  Log() << "                          (the number of CPU cores by default)" << std::endl;
+  Log() << "  --watch               - wait for new FPL files in Condor flight plans and race" << std::endl;
+  Log() << "                          results directories and convert them as soon as they" << std::endl;
+  Log() << "                          are saved (finish with Ctrl+C)" << std::endl;
 }
 
 
@@ -148,6 +208,23 @@ auto condor2nav::cli::CCondor2NavCLI::CLIParse(int argc, const char *argv[]) con
     else if(arg == "--last-race") {
       opt.fplType = TFPLType::RESULT;
     }
+    else if(arg == "--batch") {
+      if(i + 1 == argc)
+        throw EOperationFailed{"ERROR: Batch FPL_DIR or FPL_LIST not provided!!!"};
+      opt.batchPath = argv[++i];
+    }
+    else if(arg == "--watch") {
+      opt.watch = true;
+    }
+    else if(arg == "--jobs") {
+      if(i + 1 == argc)
+        throw EOperationFailed{"ERROR: Number of jobs not provided!!!"};
+
+      std::stringstream stream{argv[++i]};
+      stream >> opt.jobs;
+      if(stream.fail() || opt.jobs == 0)
+        throw EOperationFailed{"ERROR: Invalid number of jobs!!!"};
+    }
     else if(arg[0] == '-') {
       throw EOperationFailed{"ERROR: Unkown option '" + arg + "' provided!!!"};
     }
@@ -174,29 +251,35 @@ auto condor2nav::cli::CCondor2NavCLI::CLIParse(int argc, const char *argv[]) con
  */
 bool condor2nav::cli::CCondor2NavCLI::AATCheck(const CCondor &condor, unsigned &aatTime) const
 {
-  try {
-    const auto &taskParser = condor.TaskParser();
-    if(taskParser.Value("Task", "AAT") == "Distance") {
-      Error() << "ERROR: AAT/D tasks are not supported!!!" << std::endl;
+  const auto &taskParser = condor.TaskParser();
+  const auto aat = taskParser.TryValue("Task", "AAT");
+  if(!aat)
+    return true;
+
+  if(*aat == "Distance") {
+    Error() << "ERROR: AAT/D tasks are not supported!!!" << std::endl;
+  }
+  else if(*aat == "Speed") {
+    const auto designatedTime = taskParser.TryValue("Task", "DesignatedTime");
+    if(!designatedTime) {
+      Error() << "ERROR: Corrupted condor-club task file!!!" << std::endl;
+      return false;
     }
-    else if(taskParser.Value("Task", "AAT") == "Speed") {
-      try {
-        const auto time = Convert<unsigned>(taskParser.Value("Task", "DesignatedTime"));
-        if(aatTime > 0 && aatTime != time) {
-          Warning() << "WARNING: Provided AAT time (" << aatTime << ") is different than condor-club time (" << time << ")!" << std::endl;
-        }
-        else if(aatTime == 0) {
-          aatTime = time;
-          Log() << "Autodetected AAT time: " << aatTime << " minutes." << std::endl;
-        }
-      }
-      catch(EOperationFailed &) {
-        Error() << "ERROR: Corrupted condor-club task file!!!" << std::endl;
-        return false;
-      }
+    unsigned time;
+    try {
+      time = Convert<unsigned>(*designatedTime);
+    }
+    catch(EOperationFailed &) {
+      Error() << "ERROR: Corrupted condor-club task file!!!" << std::endl;
+      return false;
+    }
+    if(aatTime > 0 && aatTime != time) {
+      Warning() << "WARNING: Provided AAT time (" << aatTime << ") is different than condor-club time (" << time << ")!" << std::endl;
+    }
+    else if(aatTime == 0) {
+      aatTime = time;
+      Log() << "Autodetected AAT time: " << aatTime << " minutes." << std::endl;
     }
-  }
-  catch(EOperationFailed &) {
   }
 
   return true;
@@ -217,22 +300,242 @@ int condor2nav::cli::CCondor2NavCLI::Run(int argc, const char *argv[]) const
 {
   // parse CLI options
   auto options = CLIParse(argc, argv);
+  if(!options.batchPath.empty())
+    return BatchRun(options);
+  if(options.watch)
+    return WatchRun(options);
   
   // obtain Condor installation path
   auto condorPath = condor::InstallPath();
   
   // create Condor FPL file path
   if(options.fplType != TFPLType::USER)
-    options.fplPath = condor::FPLPath(ConfigParser(), options.fplType, condorPath);
+    options.fplPath = condor::FPLPath(*Config(), options.fplType, condorPath);
+
+  // run translation
+  return Translate(condorPath, options.fplPath, options.aatTime) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 
+/**
+ * @brief Translates one FPL file.
+ *
+ * @param condorPath Full pathname of the Condor directory. 
+ * @param fplPath    Condor FPL file to convert path.
+ * @param aatTime    AAT time provided from command line. 
+ * @param outputPath Translation output directory (empty means the one from configuration file).
+ * 
+ * @return @p false if the FPL file cannot be translated.
+ */
+bool condor2nav::cli::CCondor2NavCLI::Translate(const bfs::path &condorPath, const bfs::path &fplPath, unsigned aatTime,
+                                                const bfs::path &outputPath /* = bfs::path{} */) const
+{
   // create Condor wrapper
-  CCondor condor{condorPath, options.fplPath};
-  if(!AATCheck(condor, options.aatTime))
-    return EXIT_FAILURE;
+  CCondor condor{Resources(), condorPath, fplPath};
+  if(!AATCheck(condor, aatTime))
+    return false;
 
   // run translation
-  CTranslator translator{*this, ConfigParser(), condor, options.aatTime};
+  CTranslator translator{*this, Config(), condor, aatTime, outputPath};
   translator.Run();
-  
+  return true;
+}
+
+
+/**
+ * @brief Runs batch translation.
+ *
+ * Method translates several FPL files in one process. Configuration, data files,
+ * profile templates and coordinates converters are loaded only once and shared
+ * by all translations that are run in parallel on a pool of worker threads.
+ * Each FPL file is translated to its own subdirectory of the output path.
+ *
+ * @param options Parsed CLI options. 
+ * 
+ * @return Application execution result.
+ */
+int condor2nav::cli::CCondor2NavCLI::BatchRun(const TOptions &options) const
+{
+  using clock = std::chrono::steady_clock;
+  using milliseconds = std::chrono::milliseconds;
+
+  /**
+   * @brief Single FPL file translation result.
+   */
+  struct TResult {
+    bfs::path fplPath;
+    bfs::path outputPath;
+    bool success;
+    std::string error;
+    milliseconds::rep time;
+  };
+
+  // find FPL files to translate
+  std::vector<bfs::path> fplList;
+  if(bfs::is_directory(options.batchPath)) {
+    for(bfs::directory_iterator it{options.batchPath}, end; it != end; ++it)
+      if(CStringNoCase{it->path().extension().string().c_str()} == ".fpl")
+        fplList.emplace_back(it->path());
+    std::sort(begin(fplList), end(fplList));
+  }
+  else {
+    CIStream listStream{options.batchPath};
+    std::string line;
+    while(listStream.GetLine(line)) {
+      Trim(line);
+      if(line.empty() || line[0] == ';' || line[0] == '#')
+        continue;
+      bfs::path fplPath{line};
+      if(fplPath.is_relative())
+        fplPath = options.batchPath.parent_path() / fplPath;
+      fplList.emplace_back(std::move(fplPath));
+    }
+  }
+  if(fplList.empty())
+    throw EOperationFailed{"ERROR: No FPL files found in '" + options.batchPath.string() + "'!!!"};
+
+  // every FPL file gets its own output directory
+  const auto config = Config();
+  const auto &outputPath = config->general.outputPath;
+  std::vector<TResult> results(fplList.size());
+  {
+    std::unordered_map<CStringNoCase, unsigned, CHashNoCase> names;
+    for(size_t i = 0; i < fplList.size(); ++i) {
+      auto name = fplList[i].stem().string();
+      const auto count = names[name.c_str()]++;
+      if(count)
+        name += "_" + Convert(count);
+      results[i].fplPath = fplList[i];
+      results[i].outputPath = outputPath / name;
+      results[i].success = false;
+      results[i].time = 0;
+    }
+  }
+
+  unsigned jobs = options.jobs ? options.jobs : (std::max)(std::thread::hardware_concurrency(), 1U);
+  if(PathType(outputPath) == TPathType::ACTIVE_SYNC)
+    // one connection to the device
+    jobs = 1;
+  jobs = (std::min)(jobs, static_cast<unsigned>(fplList.size()));
+
+  // obtain Condor installation path
+  const auto condorPath = condor::InstallPath();
+
+  _normal << "Batch translation of " << fplList.size() << " FPL files with " << jobs << " jobs START" << std::endl;
+  _batch = true;
+  const auto start = clock::now();
+  {
+    CThreadPool pool{jobs};
+    for(auto &result : results) {
+      pool.Send([&]{
+        const auto fileStart = clock::now();
+        try {
+          result.success = Translate(condorPath, result.fplPath, options.aatTime, result.outputPath);
+          if(!result.success)
+            result.error = "Invalid AAT task";
+        }
+        catch(const std::exception &ex) {
+          result.error = ex.what();
+        }
+        result.time = std::chrono::duration_cast<milliseconds>(clock::now() - fileStart).count();
+      });
+    }
+  }
+  const auto total = std::chrono::duration_cast<milliseconds>(clock::now() - start).count();
+  _batch = false;
+
+  // print summary
+  unsigned failed = 0;
+  milliseconds::rep sum = 0;
+  for(const auto &result : results) {
+    sum += result.time;
+    std::stringstream line;
+    line << std::setw(7) << result.time << " ms  " << result.fplPath.string();
+    if(result.success)
+      _normal << "  OK     " << line.str() << " -> " << result.outputPath.string() << std::endl;
+    else {
+      ++failed;
+      _error << "  FAILED " << line.str() << ": " << result.error << std::endl;
+    }
+  }
+  const auto seconds = total / 1000.0;
+  _normal << "Batch translation FINISH: " << results.size() - failed << " translated, " << failed << " failed in " << seconds << " s" << std::endl;
+  _normal << "Throughput: " << (seconds > 0 ? results.size() / seconds : 0.0) << " FPL/s, "
+          << sum / static_cast<double>(results.size()) << " ms per FPL on average" << std::endl;
+  const auto stats = TranslationCache().Stats();
+  _normal << "Translation cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions, "
+          << stats.entries << " entries (" << stats.size / 1024 << " kB)" << std::endl;
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/**
+ * @brief Runs watch mode.
+ *
+ * Method waits for new FPL files saved by Condor in user flight plans and race results
+ * directories and translates each of them as soon as it is written. All the data loaded
+ * for the first translation is reused by the following ones. Configuration file changes
+ * are applied to the following translations (watched directories are not changed).
+ *
+ * @param options Parsed CLI options. 
+ * 
+ * @return Application execution result.
+ */
+int condor2nav::cli::CCondor2NavCLI::WatchRun(const TOptions &options) const
+{
+  using clock = std::chrono::steady_clock;
+
+  // obtain Condor installation path
+  const auto condorPath = condor::InstallPath();
+
+  const auto config = Config();
+  CDirectoryWatcher::CPathList dirList;
+  for(const auto &dir : {condor::FlightPlansPath(*config, condorPath), condor::RaceResultsPath(*config, condorPath)}) {
+    if(bfs::is_directory(dir))
+      dirList.emplace_back(dir);
+    else
+      Warning() << "WARNING: Directory '" << dir.string() << "' not found and will not be watched!" << std::endl;
+  }
+  if(dirList.empty())
+    throw EOperationFailed{"ERROR: No Condor directories to watch!!!"};
+
+  const auto fplDirNum = dirList.size();
+
+  // configuration file is reloaded when modified
+  const auto configPath = bfs::absolute(CONFIG_FILE_NAME);
+  if(std::none_of(begin(dirList), end(dirList), [&](const bfs::path &dir){ return bfs::equivalent(dir, configPath.parent_path()); }))
+    dirList.emplace_back(configPath.parent_path());
+
+  CDirectoryWatcher watcher{dirList, CDirectoryWatcher::CExtensionList{".fpl", configPath.extension().string()}, WATCH_DEBOUNCE_TIME};
+  LogHigh() << "Watching for new FPL files (" << (watcher.Native() ? "system notifications" : "directories polling") << "). Press Ctrl+C to finish." << std::endl;
+  for(size_t i = 0; i < fplDirNum; ++i)
+    Log() << "  " << dirList[i].string() << std::endl;
+
+  watchAbort = 0;
+  std::signal(SIGINT, WatchAbortHandler);
+  watcher.Run([&](const bfs::path &fplPath) {
+      if(CStringNoCase{fplPath.extension().string().c_str()} != ".fpl") {
+        boost::system::error_code ec;
+        if(bfs::equivalent(fplPath, configPath, ec) && ConfigReload())
+          LogHigh() << std::endl << "Configuration file '" << configPath.string() << "' reloaded" << std::endl;
+        return;
+      }
+
+      Log() << std::endl << "New FPL file '" << fplPath.string() << "' found" << std::endl;
+      const auto start = clock::now();
+      try {
+        if(Translate(condorPath, fplPath, options.aatTime))
+          LogHigh() << "Translation of '" << fplPath.filename().string() << "' took "
+                    << std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - start).count() << " ms" << std::endl;
+      }
+      catch(const std::exception &ex) {
+        Error() << ex.what() << std::endl;
+      }
+    },
+    []{ return watchAbort != 0; });
+  std::signal(SIGINT, SIG_DFL);
+
+  LogHigh() << "Watching finished" << std::endl;
   return EXIT_SUCCESS;
 }
@@ -57,9 +57,10 @@ namespace condor2nav {
        * Class is responsible for logging Condor2Nav traces on the console output
        */
       class CLogger : public CCondor2Nav::CLogger {
+        const bool _quiet;          ///< @brief Specifies if traces should be dropped
         void Trace(const std::string &str) const override;
       public:
-        explicit CLogger(TType type);
+        explicit CLogger(TType type, bool quiet = false);
       };
 
     private:
@@ -67,22 +68,32 @@ namespace condor2nav {
         TFPLType fplType;
         bfs::path fplPath;
         unsigned aatTime;
+        bfs::path batchPath;
+        unsigned jobs;
+        bool watch;
       };
 
+      static const unsigned WATCH_DEBOUNCE_TIME = 50;  ///< @brief Time (in ms) with no changes to the FPL file before it is translated in watch mode
+
       CLogger _normal;              ///< @brief Normal logging level logger
       CLogger _high;                ///< @brief Important logging level logger
       CLogger _warning;             ///< @brief Warning logging level logger
       CLogger _error;               ///< @brief Error logging level logger
+      CLogger _quiet;               ///< @brief Logger that drops all traces
+      mutable bool _batch;          ///< @brief Batch mode (single translation logs are not printed)
 
       void Usage() const;
       TOptions CLIParse(int argc, const char *argv[]) const;
       bool AATCheck(const CCondor &condor, unsigned &aatTime) const;
+      bool Translate(const bfs::path &condorPath, const bfs::path &fplPath, unsigned aatTime, const bfs::path &outputPath = bfs::path{}) const;
+      int BatchRun(const TOptions &options) const;
+      int WatchRun(const TOptions &options) const;
 
     public:
       CCondor2NavCLI();
 
-      const CLogger &Log() const override     { return _normal; }
-      const CLogger &LogHigh() const override { return _high; }
+      const CLogger &Log() const override     { return _batch ? _quiet : _normal; }
+      const CLogger &LogHigh() const override { return _batch ? _quiet : _high; }
       const CLogger &Warning() const override { return _warning; }
       const CLogger &Error() const override   { return _error; }
 
@@ -26,16 +26,33 @@
  */
 
 #include "condor.h"
+#include "coordConverterUTM.h"
+#include "platform.h"
+#include "raceResultsIndex.h"
+#include "resources.h"
 #include "traitsNoCase.h"
 #include "tools.h"
+#include <boost/filesystem.hpp>
 #include <iomanip>
 #include <algorithm>
 #include <cmath>
+#include <mutex>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
 
 namespace {
 
-  const bfs::path FLIGHT_PLANS_PATH = "FlightPlans\\User";
+  const bfs::path FLIGHT_PLANS_PATH = bfs::path{"FlightPlans"} / "User";
   const bfs::path RACE_RESULTS_PATH = "RaceResults";
+  const bfs::path RACE_RESULTS_INDEX_FILE_NAME = "RaceResults.idx";
+
+  // coordinates converters factory
+  std::mutex factoryMutex;
+  condor2nav::CCondor::CCoordConverter::CFactory factory;
+
+#if defined(_WIN32)
 
   // NaviCon.dll interface
   using FNaviConInit = int(WINAPI*)(const char *trnFile);
@@ -45,68 +62,192 @@ namespace {
   using FGetMaxY = float(WINAPI*)();
 
 
+  /**
+   * @brief NaviCon.dll coordinates converter.
+   *
+   * CNaviConConverter uses NaviCon.dll library provided with every Condor release.
+   */
+  class CNaviConConverter : public condor2nav::CCondor::CCoordConverter {
+    condor2nav::platform::CLibrary _lib;         ///< @brief DLL instance. 
+    FNaviConInit _naviConInit;
+    FGetMaxX     _getMaxX;
+    FGetMaxY     _getMaxY;
+    FXYToLon     _xyToLon;
+    FXYToLat     _xyToLat;
+    const std::string _trnPath;                  ///< @brief The path of the landscape terrain file.
+
+    void Activate() const;
+    CPoint XYToLonLat(float x, float y) const override;
+
+  public:
+    CNaviConConverter(const bfs::path &condorPath, const std::string &trnName);
+    ~CNaviConConverter();
+  };
+
+
+  // NaviCon.dll keeps initialized landscape in a global state shared by all converters
+  std::mutex naviConMutex;
+  const CNaviConConverter *naviConActive = nullptr;
+
+
   template<typename SYMBOL_TYPE>
-  inline void Symbol(const HMODULE &module, const std::string &name, SYMBOL_TYPE &out)
+  inline void Symbol(const condor2nav::platform::CLibrary &lib, const std::string &name, SYMBOL_TYPE &out)
   {
-    SYMBOL_TYPE sym = reinterpret_cast<SYMBOL_TYPE>(GetProcAddress(module, name.c_str()));
-    if(!sym)
+    if(!lib.Symbol(name, out))
       throw condor2nav::EOperationFailed{"ERROR: Couldn't map " + name + "() from 'NaviCon.dll'!!!"};
-    out = sym;
   }
 
-}
 
-namespace condor2nav {
+  /**
+   * @brief Class constructor
+   *
+   * CNaviConConverter class constructor that connects to NaviCon.dll library
+   * interface and initializes it with current terrain file.
+   *
+   * @param condorPath The path to Condor directory
+   * @param trnName The name of the terrain used in task
+   */
+  CNaviConConverter::CNaviConConverter(const bfs::path &condorPath, const std::string &trnName) :
+    _lib{condorPath / "NaviCon.dll"},
+    _trnPath{(condorPath / "Landscapes" / trnName / (trnName + ".trn")).string()}
+  {
+    if(!_lib.Loaded())
+      throw condor2nav::EOperationFailed{"ERROR: Couldn't open 'NaviCon.dll' from Condor directory '" + condorPath.string() + "'!!!"};
+
+    Symbol(_lib, "NaviConInit", _naviConInit);
+    Symbol(_lib, "GetMaxX",     _getMaxX);
+    Symbol(_lib, "GetMaxY",     _getMaxY);
+    Symbol(_lib, "XYToLon",     _xyToLon);
+    Symbol(_lib, "XYToLat",     _xyToLat);
+
+    // init coordinates
+    std::lock_guard<std::mutex> lock{naviConMutex};
+    Activate();
+  }
+
 
   /**
-  * @brief NaviCon.dll interface.
-  */
-  struct CCondor::CCoordConverter::TDLLIface {
-    FNaviConInit naviConInit;
-    FGetMaxX     getMaxX;
-    FGetMaxY     getMaxY;
-    FXYToLon     xyToLon;
-    FXYToLat     xyToLat;
-  };
+   * @brief Class destructor
+   */
+  CNaviConConverter::~CNaviConConverter()
+  {
+    std::lock_guard<std::mutex> lock{naviConMutex};
+    if(naviConActive == this)
+      naviConActive = nullptr;
+  }
+
+
+  /**
+   * @brief Initializes NaviCon.dll with converter landscape.
+   *
+   * NaviCon.dll supports only one landscape at a time. Method reinitializes
+   * the library if it was last used by a converter of other landscape.
+   *
+   * @note Should be called with NaviCon.dll mutex locked.
+   */
+  void CNaviConConverter::Activate() const
+  {
+    if(naviConActive != this) {
+      _naviConInit(_trnPath.c_str());
+      naviConActive = this;
+    }
+  }
+
+
+  /**
+   * @brief Converts Condor coordinates.
+   *
+   * @param x The x coordinate.
+   * @param y The y coordinate. 
+   *
+   * @return Longitude and latitude of the point.
+   */
+  auto CNaviConConverter::XYToLonLat(float x, float y) const -> CPoint
+  {
+    std::lock_guard<std::mutex> lock{naviConMutex};
+    Activate();
+    return CPoint{_xyToLon(x, y), _xyToLat(x, y)};
+  }
+
+#endif
 
 }
 
+
 /* ******************** C O N D O R   -   C O O R D   C O N V E R T E R ********************* */
 
 /**
- * @brief Class constructor
+ * @brief Sets coordinates converters factory.
+ *
+ * Function replaces the default coordinates converter (NaviCon.dll on Windows,
+ * none on other platforms) with a custom one.
  *
- * condor2nav::CCondor::CCoordConverter class constructor that connects to 
- * NaviCon.dll library interface and initializes it with current terrain file.
+ * @param factory Function creating coordinates converter for a landscape (empty
+ *                function restores the default converter).
+ */
+void condor2nav::CCondor::CCoordConverter::Factory(CFactory factory)
+{
+  std::lock_guard<std::mutex> lock{factoryMutex};
+  ::factory = std::move(factory);
+}
+
+
+/**
+ * @brief Creates coordinates converter.
+ *
+ * Function creates coordinates converter for a landscape. NaviCon.dll is used
+ * on Windows. Other platforms have no default converter. Projection read from
+ * the landscape terrain file header (experimental, the header layout is not
+ * documented by Condor) is used there only if CONDOR2NAV_COORD_CONVERTER
+ * environment variable is set to "UTM".
  *
  * @param condorPath The path to Condor directory
  * @param trnName The name of the terrain used in task
+ *
+ * @return Coordinates converter.
  */
-condor2nav::CCondor::CCoordConverter::CCoordConverter(const bfs::path &condorPath, const std::string &trnName) :
-  _iface{std::make_unique<TDLLIface>()}, _lib{::LoadLibrary((condorPath / "NaviCon.dll").string().c_str())}
+std::unique_ptr<condor2nav::CCondor::CCoordConverter> condor2nav::CCondor::CCoordConverter::Create(const bfs::path &condorPath, const std::string &trnName)
 {
-  if(!_lib.get())
-    throw EOperationFailed{"ERROR: Couldn't open 'NaviCon.dll' from Condor directory '" + condorPath.string() + "'!!!"};
-  
-  Symbol(_lib.get(), "NaviConInit", _iface->naviConInit);
-  Symbol(_lib.get(), "GetMaxX",     _iface->getMaxX);
-  Symbol(_lib.get(), "GetMaxY",     _iface->getMaxY);
-  Symbol(_lib.get(), "XYToLon",     _iface->xyToLon);
-  Symbol(_lib.get(), "XYToLat",     _iface->xyToLat);
-
-  // init coordinates
-  auto trnPath = condorPath / "Landscapes" / trnName / (trnName + ".trn");
-  _iface->naviConInit(trnPath.string().c_str());
+  CFactory custom;
+  {
+    std::lock_guard<std::mutex> lock{factoryMutex};
+    custom = ::factory;
+  }
+  if(custom)
+    return custom(condorPath, trnName);
+#if defined(_WIN32)
+  return std::make_unique<CNaviConConverter>(condorPath, trnName);
+#else
+  if(platform::Environment("CONDOR2NAV_COORD_CONVERTER") != "UTM")
+    throw EOperationFailed{"ERROR: NaviCon.dll not available on this platform (please set CONDOR2NAV_COORD_CONVERTER to 'UTM' to use experimental landscape terrain file projection)!!!"};
+  return CCoordConverterUTM::FromTRN(condorPath / "Landscapes" / trnName / (trnName + ".trn"));
+#endif
 }
 
 
 /**
-* @brief Class constructor
-*
-* NOTE: Destructor definition is needed here to make sure that TDLLIface is defined.
-*/
-condor2nav::CCondor::CCoordConverter::~CCoordConverter()
+ * @brief Converts Condor coordinates.
+ *
+ * Method converts Condor coordinates to longitude and latitude. Each point
+ * is converted only once and remembered for next requests. Remembered
+ * points are forgotten when POINTS_MAX of them is reached.
+ * 
+ * @param x The x coordinate.
+ * @param y The y coordinate. 
+ *
+ * @return Longitude and latitude of the point.
+ */
+auto condor2nav::CCondor::CCoordConverter::Point(const std::string &x, const std::string &y) const -> CPoint
 {
+  const CPoint xy{Convert<float>(x), Convert<float>(y)};
+  std::lock_guard<std::mutex> lock{_mutex};
+  auto it = _points.find(xy);
+  if(it == _points.end()) {
+    if(_points.size() >= POINTS_MAX)
+      _points.clear();
+    it = _points.emplace(xy, XYToLonLat(xy.first, xy.second)).first;
+  }
+  return it->second;
 }
 
 
@@ -122,9 +263,7 @@ condor2nav::CCondor::CCoordConverter::~CCoordConverter()
  */
 condor2nav::TLongitude condor2nav::CCondor::CCoordConverter::Longitude(const std::string &x, const std::string &y) const
 {
-  auto xVal = Convert<float>(x);
-  auto yVal = Convert<float>(y);
-  auto lon = _iface->xyToLon(xVal, yVal);
+  const auto lon = Point(x, y).first;
   auto deg = static_cast<int>(lon);
   auto min = static_cast<int>(floor((lon - deg) * 60.0 * 1000 + 0.5)) / static_cast<double>(1000.0);
   return TLongitude{deg + min / 60};
@@ -143,9 +282,7 @@ condor2nav::TLongitude condor2nav::CCondor::CCoordConverter::Longitude(const std
  */
 condor2nav::TLatitude condor2nav::CCondor::CCoordConverter::Latitude(const std::string &x, const std::string &y) const
 {
-  auto xVal = Convert<float>(x);
-  auto yVal = Convert<float>(y);
-  auto lat = _iface->xyToLat(xVal, yVal);
+  const auto lat = Point(x, y).second;
   auto deg = static_cast<int>(lat);
   auto min = static_cast<int>(floor((lat - deg) * 60.0 * 1000 + 0.5)) / static_cast<double>(1000.0);
   return TLatitude{deg + min / 60};
@@ -169,7 +306,40 @@ condor2nav::TLatitude condor2nav::CCondor::CCoordConverter::Latitude(const std::
  */
 condor2nav::CCondor::CCondor(const bfs::path &condorPath, const bfs::path &fplPath):
 _taskParser{fplPath},
-_coordConverter{condorPath, _taskParser.Value("Task", "Landscape")}
+_coordConverter{CCoordConverter::Create(condorPath, _taskParser.Value("Task", "Landscape"))}
+{
+  VersionCheck();
+}
+
+
+/**
+ * @brief Class constructor. 
+ *
+ * condor2nav::CCondor class constructor that reuses coordinates converter
+ * cached for the task landscape.
+ * 
+ * @param resources  Translation resources cache. 
+ * @param condorPath Full pathname of the Condor directory. 
+ * @param fplPath    Condor FPL file to convert path
+ *
+ * @exception std Thrown when not supported Condor version.
+ */
+condor2nav::CCondor::CCondor(const CResources &resources, const bfs::path &condorPath, const bfs::path &fplPath):
+_taskParser{fplPath},
+_coordConverter{resources.CoordConverter(condorPath, _taskParser.Value("Task", "Landscape"))}
+{
+  VersionCheck();
+}
+
+
+/**
+ * @brief Verifies Condor version. 
+ *
+ * Method verifies if the task file was created with supported Condor version.
+ *
+ * @exception std Thrown when not supported Condor version.
+ */
+void condor2nav::CCondor::VersionCheck() const
 {
   if(Convert<unsigned>(_taskParser.Value("Version", "Condor version")) < CONDOR_VERSION_SUPPORTED)
     throw EOperationFailed{"Condor vesion '" + _taskParser.Value("Version", "Condor version") + "' not supported!!!"};
@@ -186,18 +356,41 @@ _coordConverter{condorPath, _taskParser.Value("Task", "Landscape")}
 */
 bfs::path condor2nav::condor::InstallPath()
 {
-  HKEY hTestKey;
-  if((RegOpenKeyEx(HKEY_CURRENT_USER, "Software\\Condor", 0, KEY_READ, &hTestKey)) == ERROR_SUCCESS) {
-    DWORD bufferSize = 0;
-    RegQueryValueEx(hTestKey, "InstallDir", nullptr, nullptr, nullptr, &bufferSize);
-    auto buffer = std::make_unique<char[]>(bufferSize);
-    RegQueryValueEx(hTestKey, "InstallDir", nullptr, nullptr, reinterpret_cast<BYTE *>(buffer.get()), &bufferSize);
-    bfs::path condorPath{buffer.get()};
-    RegCloseKey(hTestKey);
-    return condorPath;
-  }
-  else
-    throw EOperationFailed{"ERROR: Condor installation not found!!!"};
+  return platform::CondorInstallPath();
+}
+
+
+/**
+* @brief Returns Condor user flight plans directory.
+*
+* Method returns Condor user flight plans directory.
+*
+* @param config           Configuration.
+* @param condorPath       Full pathname of the Condor: The Competition Soaring Simulator.
+*
+* @return Full pathname of the user flight plans directory.
+*/
+bfs::path condor2nav::condor::FlightPlansPath(const TConfig &config, const bfs::path &condorPath)
+{
+  const auto &path = config.condor.flightPlansPath;
+  return path.empty() ? condorPath / FLIGHT_PLANS_PATH : path;
+}
+
+
+/**
+* @brief Returns Condor race results directory.
+*
+* Method returns Condor race results directory.
+*
+* @param config           Configuration.
+* @param condorPath       Full pathname of the Condor: The Competition Soaring Simulator.
+*
+* @return Full pathname of the race results directory.
+*/
+bfs::path condor2nav::condor::RaceResultsPath(const TConfig &config, const bfs::path &condorPath)
+{
+  const auto &path = config.condor.raceResultsPath;
+  return path.empty() ? condorPath / RACE_RESULTS_PATH : path;
 }
 
 
@@ -206,7 +399,7 @@ bfs::path condor2nav::condor::InstallPath()
 *
 * Method returns FPL file path.
 *
-* @param configParser     The INI file configuration parser.
+* @param config           Configuration.
 * @param fplType          Type of the FPL file.
 * @param condorPath       Full pathname of the Condor: The Competition Soaring Simulator.
 *
@@ -214,34 +407,24 @@ bfs::path condor2nav::condor::InstallPath()
 *
 * @return Full pathname of the FPL file.
 */
-bfs::path condor2nav::condor::FPLPath(const CFileParserINI &configParser,
+bfs::path condor2nav::condor::FPLPath(const TConfig &config,
                                        CCondor2Nav::TFPLType fplType,
                                        const bfs::path &condorPath)
 {
   bfs::path fplPath;
   if(fplType == CCondor2Nav::TFPLType::DEFAULT) {
-    auto fplPathUser = bfs::path{configParser.Value("Condor", "FlightPlansPath")};
-    if(fplPathUser.empty())
-      fplPath = condorPath / FLIGHT_PLANS_PATH / (configParser.Value("Condor", "DefaultTaskName") + ".fpl");
-    else
-      fplPath = fplPathUser / (configParser.Value("Condor", "DefaultTaskName") + ".fpl");
+    fplPath = FlightPlansPath(config, condorPath) / (config.condor.defaultTaskName + ".fpl");
   }
   else if(fplType == CCondor2Nav::TFPLType::RESULT) {
-    auto resultsPath = bfs::path{configParser.Value("Condor", "RaceResultsPath")};
-    if(resultsPath.empty())
-      resultsPath = condorPath / RACE_RESULTS_PATH;
+    const auto resultsPath = RaceResultsPath(config, condorPath);
 
     // find the latest race result
-    std::vector<bfs::path> results;
-    std::copy_if(bfs::directory_iterator(resultsPath), bfs::directory_iterator(), std::back_inserter(results),
-                 [](const bfs::path &f){ return CStringNoCase{f.extension().string().c_str()} == ".fpl"; });
-    auto result = std::max_element(cbegin(results), cend(results),
-                                   [](const bfs::path &f1, const bfs::path &f2)
-    { return bfs::last_write_time(f1) < bfs::last_write_time(f2); });
-    if(result != results.end())
-      fplPath = result->string();
+    const CRaceResultsIndex index{resultsPath, platform::UserDataPath() / RACE_RESULTS_INDEX_FILE_NAME};
+    const auto results = index.Last(1);
+    if(!results.empty())
+      fplPath = results.front();
     else
-      throw EOperationFailed{"ERROR: Cannot find last result FPL file in '" + fplPath.string() + "'(" + Convert(GetLastError()) + ")!!!"};
+      throw EOperationFailed{"ERROR: Cannot find last result FPL file in '" + resultsPath.string() + "'!!!"};
   }
   return fplPath;
 }
@@ -32,10 +32,17 @@
 #include "nonCopyable.h"
 #include "fileParserINI.h"
 #include "boostfwd.h"
-#include <windows.h>
+#include "tools.h"
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
 
 namespace condor2nav {
 
+  class CResources;
+
   /**
    * @brief Condor data class. 
    *
@@ -48,17 +55,44 @@ namespace condor2nav {
     /**
      * @brief Condor map coordinates converter.
      *
-     * condor2nav::CCondor::CCoordConverter is responsible for
-     * Condor map coordinates convertions. It uses NaviCon.dll library
-     * provided with every Condor release.
+     * condor2nav::CCondor::CCoordConverter is a base class for Condor map
+     * coordinates converters. NaviCon.dll library provided with every Condor
+     * release is used on Windows and the projection described by the landscape
+     * terrain file on other platforms. Other converters may be plugged in with
+     * Factory(). Up to POINTS_MAX converted points are remembered so every
+     * point is converted only once even if it is used by many translation
+     * targets.
      */
     class CCoordConverter : CNonCopyable {
-      struct TDLLIface;
-      std::unique_ptr<TDLLIface> _iface;	       ///< @brief DLL interface.
-      CLibraryRes _lib;                            ///< @brief DLL instance. 
     public:
-      CCoordConverter(const bfs::path &condorPath, const std::string &trnName);
-      ~CCoordConverter();
+      using CFactory = std::function<std::unique_ptr<CCoordConverter>(const bfs::path &condorPath, const std::string &trnName)>;
+
+    protected:
+      using CPoint = std::pair<float, float>;
+
+    private:
+      static const unsigned POINTS_MAX = 1024;     ///< @brief The maximum number of remembered points.
+      using CPointsMap = std::map<CPoint, CPoint>;
+      mutable std::mutex _mutex;                   ///< @brief Converted points access guard.
+      mutable CPointsMap _points;                  ///< @brief Longitude and latitude of already converted points.
+
+      CPoint Point(const std::string &x, const std::string &y) const;
+
+      /**
+       * @brief Converts Condor coordinates.
+       *
+       * @param x The x coordinate.
+       * @param y The y coordinate. 
+       *
+       * @return Longitude and latitude of the point.
+       */
+      virtual CPoint XYToLonLat(float x, float y) const = 0;
+
+    public:
+      static void Factory(CFactory factory);
+      static std::unique_ptr<CCoordConverter> Create(const bfs::path &condorPath, const std::string &trnName);
+
+      virtual ~CCoordConverter() {}
       TLongitude Longitude(const std::string &x, const std::string &y) const;
       TLatitude Latitude(const std::string &x, const std::string &y) const;
     };
@@ -66,12 +100,15 @@ namespace condor2nav {
   private:
     static const unsigned CONDOR_VERSION_SUPPORTED = 1120;	  ///< @brief Supported Condor version.
     const CFileParserINI _taskParser;	           ///< @brief Condor task file parser. 
-    const CCoordConverter _coordConverter;	       ///< @brief Condor map coordinates converter. 
+    const std::shared_ptr<const CCoordConverter> _coordConverter;	 ///< @brief Condor map coordinates converter. 
+
+    void VersionCheck() const;
 
   public:
     CCondor(const bfs::path &condorPath, const bfs::path &fplPath);
+    CCondor(const CResources &resources, const bfs::path &condorPath, const bfs::path &fplPath);
     const CFileParserINI &TaskParser() const      { return _taskParser; }
-    const CCoordConverter &CoordConverter() const { return _coordConverter; }
+    const CCoordConverter &CoordConverter() const { return *_coordConverter; }
   };
 
   namespace condor {
@@ -85,7 +122,9 @@ namespace condor2nav {
     };
 
     bfs::path InstallPath();
-    bfs::path FPLPath(const CFileParserINI &configParser,
+    bfs::path FlightPlansPath(const TConfig &config, const bfs::path &condorPath);
+    bfs::path RaceResultsPath(const TConfig &config, const bfs::path &condorPath);
+    bfs::path FPLPath(const TConfig &config,
                       CCondor2Nav::TFPLType fplType,
                       const bfs::path &condorPath);
 
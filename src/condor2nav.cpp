@@ -27,6 +27,9 @@
 
 #include "condor2nav.h"
 #include "lkMapsDB.h"
+#include "resources.h"
+#include "translationCache.h"
+#include "translator.h"
 
 const char *condor2nav::CCondor2Nav::CONFIG_FILE_NAME = "condor2nav.ini";
 
@@ -43,14 +46,54 @@ condor2nav::CCondor2Nav::CLogger::CLogger(TType type) :
 
 
 condor2nav::CCondor2Nav::CCondor2Nav() :
-  _configParser{CONFIG_FILE_NAME}
+  _config{TConfig::Parse(std::make_shared<const CFileParserINI>(CONFIG_FILE_NAME))}, _resources{std::make_unique<CResources>()},
+  _translationCache{std::make_unique<CTranslationCache>(static_cast<size_t>(_config->general.translationCacheSize) * 1024 * 1024)}
 {
 }
 
 
+/**
+* @brief Class destructor
+*
+* NOTE: Destructor definition is needed here to make sure that CResources and CTranslationCache are defined.
+*/
+condor2nav::CCondor2Nav::~CCondor2Nav()
+{
+}
+
+
+/**
+ * @brief Reloads configuration file.
+ *
+ * Method parses configuration INI file again and replaces current configuration
+ * snapshot. Translations that are already running continue with the snapshot
+ * they started with. Invalid configuration file is reported and ignored.
+ * Translation cache size is applied only on startup.
+ *
+ * @return @p true if new configuration is used.
+ */
+bool condor2nav::CCondor2Nav::ConfigReload() const
+{
+  try {
+    std::atomic_store(&_config, TConfig::Parse(std::make_shared<const CFileParserINI>(CONFIG_FILE_NAME)));
+    return true;
+  }
+  catch(const std::exception &ex) {
+    Error() << ex.what() << std::endl;
+    Warning() << "WARNING: Previous configuration will be used." << std::endl;
+    return false;
+  }
+}
+
+
 void condor2nav::CCondor2Nav::OnStart(std::function<bool()> abort)
 {
-  if(_configParser.Value("Condor2Nav", "Target") == "LK8000" && _configParser.Value("LK8000", "CheckForMapUpdates") == "1") {
+  const auto config = Config();
+  bool lk8000 = false;
+  for(const auto &target : CTranslator::Targets(*config, bfs::path{}))
+    lk8000 = lk8000 || target.chapter == "LK8000";
+
+  if(lk8000 && config->lk8000.checkForMapUpdates) {
     LogHigh() << "LK8000 maps synchronization START" << std::endl;
     try {
       CLKMapsDB db{*this};
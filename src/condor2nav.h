@@ -29,6 +29,7 @@
 #define __CONDOR2NAV_H__
 
 #include "nonCopyable.h"
+#include "config.h"
 #include "fileParserINI.h"
 #include <sstream>
 
@@ -40,6 +41,8 @@
 namespace condor2nav {
 
   class CFileParserINI;
+  class CResources;
+  class CTranslationCache;
 
   /**
    * @brief Main project class.
@@ -131,16 +134,21 @@ namespace condor2nav {
     };
 
   private:
-    const CFileParserINI _configParser;	          ///< @brief The INI file configuration parser
+    mutable CConfigPtr _config;                   ///< @brief Current configuration snapshot
+    std::unique_ptr<const CResources> _resources; ///< @brief Translation resources cache
+    std::unique_ptr<CTranslationCache> _translationCache; ///< @brief Translation results cache
 
   protected:
     static const char *CONFIG_FILE_NAME;          ///< @brief The name of the configuration INI file.
 
   public:
     CCondor2Nav();
-    virtual ~CCondor2Nav() {}
+    virtual ~CCondor2Nav();
 
-    const CFileParserINI &ConfigParser() const { return _configParser; }
+    CConfigPtr Config() const                  { return std::atomic_load(&_config); }
+    bool ConfigReload() const;
+    const CResources &Resources() const        { return *_resources; }
+    CTranslationCache &TranslationCache() const { return *_translationCache; }
 
     /**
      * @brief Handler triggered on application startup. 
@@ -0,0 +1,193 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file config.cpp
+ *
+ * @brief Implements the condor2nav::TConfig structure. 
+ */
+
+#include "config.h"
+#include "fileParserINI.h"
+#include <sstream>
+
+
+namespace {
+
+  using condor2nav::TConfig;
+  using condor2nav::EOperationFailed;
+
+  /**
+   * @brief Configuration schema entry.
+   */
+  struct TEntry {
+    const char *chapter;                                      ///< @brief Chapter of the entry.
+    const char *key;                                          ///< @brief Key of the entry.
+    const char *defaultValue;                                 ///< @brief Value used when entry is not provided (nullptr - entry required).
+    void (*set)(TConfig &config, const std::string &value);   ///< @brief Validates the value and stores it in the configuration.
+  };
+
+  /**
+   * @brief Converts on/off flag.
+   *
+   * @param value The value to convert.
+   *
+   * @exception EOperationFailed Thrown when neither "0" nor "1" is provided.
+   */
+  bool Flag(const std::string &value)
+  {
+    if(value != "0" && value != "1")
+      throw EOperationFailed{"0 or 1 expected"};
+    return value == "1";
+  }
+
+  /**
+   * @brief Converts a number.
+   *
+   * Contrary to condor2nav::Convert() the whole string has to be a valid number.
+   *
+   * @param value The value to convert.
+   *
+   * @exception EOperationFailed Thrown when the value is not a valid number.
+   */
+  template<class T>
+  T Number(const std::string &value)
+  {
+    std::stringstream stream{value};
+    T number;
+    if(value.empty() || value[0] == '-' || !(stream >> number) || !(stream >> std::ws).eof())
+      throw EOperationFailed{"non-negative number expected"};
+    return number;
+  }
+
+  /**
+   * @brief Converts translation targets list.
+   *
+   * @param value Comma separated list of translation targets.
+   *
+   * @exception EOperationFailed Thrown when unknown or repeated target is provided.
+   */
+  TConfig::CStringArray Targets(const std::string &value)
+  {
+    TConfig::CStringArray targets;
+    std::stringstream stream{value};
+    std::string name;
+    while(std::getline(stream, name, ',')) {
+      condor2nav::Trim(name);
+      if(name != "XCSoar" && name != "XCSoar5" && name != "XCSoar6" && name != "LK8000")
+        throw EOperationFailed{"unknown translation target '" + name + "'"};
+      for(const auto &target : targets)
+        if(target == name)
+          throw EOperationFailed{"translation target '" + name + "' provided more than once"};
+      targets.emplace_back(std::move(name));
+    }
+    if(targets.empty())
+      throw EOperationFailed{"no translation target provided"};
+    return targets;
+  }
+
+  /**
+   * @brief Converts XCSoar version.
+   *
+   * @param value The value to convert.
+   *
+   * @exception EOperationFailed Thrown when unknown version is provided.
+   */
+  std::string Version(const std::string &value)
+  {
+    if(value != "5" && value != "6")
+      throw EOperationFailed{"5 or 6 expected"};
+    return value;
+  }
+
+  /**
+   * @brief condor2nav.ini schema.
+   *
+   * Entries added in later versions have default values so older configuration
+   * files are still valid.
+   */
+  const TEntry SCHEMA[] = {
+    { "Condor2Nav", "Target",                   nullptr, [](TConfig &c, const std::string &v){ c.general.targets = Targets(v); } },
+    { "Condor2Nav", "OutputPath",               nullptr, [](TConfig &c, const std::string &v){ c.general.outputPath = v; } },
+    { "Condor2Nav", "SetGPS",                   nullptr, [](TConfig &c, const std::string &v){ c.general.setGPS = Flag(v); } },
+    { "Condor2Nav", "SetSceneryMap",            nullptr, [](TConfig &c, const std::string &v){ c.general.setSceneryMap = Flag(v); } },
+    { "Condor2Nav", "SetSceneryTime",           nullptr, [](TConfig &c, const std::string &v){ c.general.setSceneryTime = Flag(v); } },
+    { "Condor2Nav", "SetGlider",                nullptr, [](TConfig &c, const std::string &v){ c.general.setGlider = Flag(v); } },
+    { "Condor2Nav", "SetTask",                  nullptr, [](TConfig &c, const std::string &v){ c.general.setTask = Flag(v); } },
+    { "Condor2Nav", "SetPenaltyZones",          nullptr, [](TConfig &c, const std::string &v){ c.general.setPenaltyZones = Flag(v); } },
+    { "Condor2Nav", "SetWeather",               nullptr, [](TConfig &c, const std::string &v){ c.general.setWeather = Flag(v); } },
+    { "Condor2Nav", "SpeedToFlyTable",          "0",     [](TConfig &c, const std::string &v){ c.general.speedToFlyTable = Flag(v); } },
+    { "Condor2Nav", "TranslationCacheSize",     "16",    [](TConfig &c, const std::string &v){ c.general.translationCacheSize = Number<unsigned>(v); } },
+
+    { "Condor",     "DefaultTaskName",          nullptr, [](TConfig &c, const std::string &v){ c.condor.defaultTaskName = v; } },
+    { "Condor",     "FlightPlansPath",          "",      [](TConfig &c, const std::string &v){ c.condor.flightPlansPath = v; } },
+    { "Condor",     "RaceResultsPath",          "",      [](TConfig &c, const std::string &v){ c.condor.raceResultsPath = v; } },
+
+    { "XCSoar",     "Version",                  nullptr, [](TConfig &c, const std::string &v){ c.xcsoar.version = Version(v); } },
+    { "XCSoar",     "XCSoarDataPath",           nullptr, [](TConfig &c, const std::string &v){ c.xcsoar.xcsoarDataPath = v; } },
+    { "XCSoar",     "Condor2NavDataSubDir",     nullptr, [](TConfig &c, const std::string &v){ c.xcsoar.condor2navDataSubDir = v; } },
+    { "XCSoar",     "DefaultTaskOverwrite",     nullptr, [](TConfig &c, const std::string &v){ c.xcsoar.defaultTaskOverwrite = Flag(v); } },
+    { "XCSoar",     "TaskWPFileGenerate",       nullptr, [](TConfig &c, const std::string &v){ c.xcsoar.taskWPFileGenerate = Flag(v); } },
+    { "XCSoar",     "WPFileCorridorWidth",      "0",     [](TConfig &c, const std::string &v){ c.xcsoar.wpFileCorridorWidth = Number<double>(v); } },
+
+    { "LK8000",     "LK8000Path",               nullptr, [](TConfig &c, const std::string &v){ c.lk8000.lk8000Path = v; } },
+    { "LK8000",     "DefaultTaskOverwrite",     nullptr, [](TConfig &c, const std::string &v){ c.lk8000.defaultTaskOverwrite = Flag(v); } },
+    { "LK8000",     "DefaultProfilesOverwrite", nullptr, [](TConfig &c, const std::string &v){ c.lk8000.defaultProfilesOverwrite = Flag(v); } },
+    { "LK8000",     "TaskWPFileGenerate",       nullptr, [](TConfig &c, const std::string &v){ c.lk8000.taskWPFileGenerate = Flag(v); } },
+    { "LK8000",     "WPFileCorridorWidth",      "0",     [](TConfig &c, const std::string &v){ c.lk8000.wpFileCorridorWidth = Number<double>(v); } },
+    { "LK8000",     "CheckForMapUpdates",       nullptr, [](TConfig &c, const std::string &v){ c.lk8000.checkForMapUpdates = Flag(v); } }
+  };
+
+}
+
+
+/**
+ * @brief Creates typed configuration.
+ *
+ * Method converts and validates all the configuration entries described by the
+ * configuration schema. All the problems are reported here so the translation
+ * does not have to verify configuration values anymore.
+ *
+ * @param parser Configuration INI file parser.
+ *
+ * @exception EOperationFailed Thrown when required entry is missing or has invalid value.
+ *
+ * @return Immutable configuration snapshot.
+ */
+std::shared_ptr<const condor2nav::TConfig> condor2nav::TConfig::Parse(std::shared_ptr<const CFileParserINI> parser)
+{
+  auto config = std::make_shared<TConfig>();
+  for(const auto &entry : SCHEMA) {
+    const auto value = parser->TryValue(entry.chapter, entry.key);
+    if(!value && !entry.defaultValue)
+      throw EOperationFailed{"ERROR: Entry '" + std::string{entry.key} + "' not found in '[" + entry.chapter + "]' chapter of '" + parser->Path().string() + "' INI file!!!"};
+    const std::string &str = value ? *value : entry.defaultValue;
+    try {
+      entry.set(*config, str);
+    }
+    catch(const EOperationFailed &ex) {
+      throw EOperationFailed{"ERROR: Invalid value '" + str + "' of '" + entry.key + "' entry in '[" + entry.chapter + "]' chapter of '" +
+                             parser->Path().string() + "' INI file (" + ex.what() + ")!!!"};
+    }
+  }
+  config->parser = std::move(parser);
+  return config;
+}
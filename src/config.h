@@ -0,0 +1,119 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file config.h
+ *
+ * @brief Declares the condor2nav::TConfig structure. 
+ */
+
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include "boostfwd.h"
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace condor2nav {
+
+  class CFileParserINI;
+
+  /**
+   * @brief Typed Condor2Nav configuration.
+   *
+   * condor2nav::TConfig contains all the condor2nav.ini entries already converted to
+   * their types. It is created by condor2nav::TConfig::Parse() that validates all the
+   * entries up front against the configuration schema. Once created the configuration
+   * is never modified so one snapshot (condor2nav::CConfigPtr) may be shared by all
+   * translation threads. Reloaded configuration is a new snapshot.
+   */
+  struct TConfig {
+    using CStringArray = std::vector<std::string>;
+
+    /**
+     * @brief [Condor2Nav] chapter.
+     */
+    struct TGeneral {
+      CStringArray targets;               ///< @brief Translation target names (validated, no duplicates).
+      bfs::path outputPath;               ///< @brief Translation destination directory.
+      bool setGPS;                        ///< @brief Set Condor GPS data.
+      bool setSceneryMap;                 ///< @brief Set scenery map data.
+      bool setSceneryTime;                ///< @brief Set scenery time.
+      bool setGlider;                     ///< @brief Set glider data.
+      bool setTask;                       ///< @brief Set task data.
+      bool setPenaltyZones;               ///< @brief Set penalty zones.
+      bool setWeather;                    ///< @brief Set weather data.
+      bool speedToFlyTable;               ///< @brief Generate speed to fly table.
+      unsigned translationCacheSize;      ///< @brief Translation cache size limit (in MB).
+    };
+
+    /**
+     * @brief [Condor] chapter.
+     */
+    struct TCondor {
+      std::string defaultTaskName;        ///< @brief Default task name.
+      bfs::path flightPlansPath;          ///< @brief User flight plans directory (empty means Condor default).
+      bfs::path raceResultsPath;          ///< @brief Race results directory (empty means Condor default).
+    };
+
+    /**
+     * @brief Entries common for [XCSoar] and [LK8000] chapters.
+     */
+    struct TTarget {
+      bool defaultTaskOverwrite;          ///< @brief Overwrite default task file.
+      bool taskWPFileGenerate;            ///< @brief Generate task waypoints file.
+      double wpFileCorridorWidth;         ///< @brief Scenery waypoints corridor width in km (0 - disabled).
+    };
+
+    /**
+     * @brief [XCSoar] chapter.
+     */
+    struct TXCSoar : TTarget {
+      std::string version;                ///< @brief XCSoar version ("5" or "6").
+      std::string xcsoarDataPath;         ///< @brief XCSoarData directory path on the device.
+      bfs::path condor2navDataSubDir;     ///< @brief Condor2Nav data subdirectory.
+    };
+
+    /**
+     * @brief [LK8000] chapter.
+     */
+    struct TLK8000 : TTarget {
+      std::string lk8000Path;             ///< @brief LK8000 directory path on the device.
+      bool defaultProfilesOverwrite;      ///< @brief Overwrite default profile files.
+      bool checkForMapUpdates;            ///< @brief Check for new LK8000 maps on startup.
+    };
+
+    TGeneral general;
+    TCondor condor;
+    TXCSoar xcsoar;
+    TLK8000 lk8000;
+    std::shared_ptr<const CFileParserINI> parser;   ///< @brief Raw configuration entries (i.e. for translation cache keys).
+
+    static std::shared_ptr<const TConfig> Parse(std::shared_ptr<const CFileParserINI> parser);
+  };
+
+  using CConfigPtr = std::shared_ptr<const TConfig>;   ///< @brief Immutable configuration snapshot.
+
+}
+
+#endif /* __CONFIG_H__ */
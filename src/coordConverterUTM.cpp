@@ -0,0 +1,181 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file coordConverterUTM.cpp
+ *
+ * @brief Implements the condor2nav::CCoordConverterUTM class. 
+ */
+
+#include "coordConverterUTM.h"
+#include "exception.h"
+#include <boost/filesystem/fstream.hpp>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+  // WGS84 ellipsoid and UTM projection parameters
+  const double WGS84_A = 6378137.0;
+  const double WGS84_F = 1 / 298.257223563;
+  const double UTM_K0 = 0.9996;
+  const double UTM_E0 = 500000.0;
+  const double UTM_N0_SOUTH = 10000000.0;
+  const double UTM_E_MAX = 1000000.0;
+  const double PI = 3.14159265358979323846;
+
+  // Condor landscape terrain file header (little endian)
+  struct TTRNHeader {
+    std::int32_t width;
+    std::int32_t height;
+    float dx;
+    float dy;
+    float easting;
+    float northing;
+    std::int32_t zone;
+    char hemisphere;
+  };
+  const float DX_MAX = 1000;                       // terrain grid spacing sanity limit [m]
+
+
+  template<typename T>
+  void Read(std::istream &stream, T &value)
+  {
+    static_assert(sizeof(T) == sizeof(std::uint32_t), "Only 4 bytes long fields supported");
+    unsigned char buffer[sizeof(T)];
+    stream.read(reinterpret_cast<char *>(buffer), sizeof(T));
+    std::uint32_t raw = 0;
+    for(unsigned i = 0; i < sizeof(T); ++i)
+      raw |= static_cast<std::uint32_t>(buffer[i]) << (8 * i);
+    std::memcpy(&value, &raw, sizeof(T));
+  }
+
+}
+
+
+/**
+ * @brief Creates converter for a landscape.
+ *
+ * Method reads UTM projection of the landscape from the header of its terrain
+ * (*.trn) file. The header layout is not documented by Condor so every field
+ * is checked to be in a sane range and the file is rejected otherwise.
+ *
+ * @param trnPath The path to landscape terrain file.
+ *
+ * @return Coordinates converter.
+ */
+std::unique_ptr<condor2nav::CCoordConverterUTM> condor2nav::CCoordConverterUTM::FromTRN(const bfs::path &trnPath)
+{
+  bfs::ifstream stream{trnPath, std::ios::binary};
+  if(!stream)
+    throw EOperationFailed{"ERROR: Couldn't open landscape terrain file '" + trnPath.string() + "'!!!"};
+
+  TTRNHeader header;
+  Read(stream, header.width);
+  Read(stream, header.height);
+  Read(stream, header.dx);
+  Read(stream, header.dy);
+  Read(stream, header.easting);
+  Read(stream, header.northing);
+  Read(stream, header.zone);
+  stream.read(&header.hemisphere, 1);
+  if(!stream ||
+     header.width <= 0 || header.height <= 0 ||
+     !(header.dx > 0 && header.dx <= DX_MAX) || !(header.dy > 0 && header.dy <= DX_MAX) ||
+     !(header.easting > 0 && header.easting < UTM_E_MAX) || !(header.northing >= 0 && header.northing < UTM_N0_SOUTH) ||
+     header.zone < 1 || header.zone > 60 || (header.hemisphere != 'N' && header.hemisphere != 'S'))
+    throw EOperationFailed{"ERROR: Invalid landscape terrain file '" + trnPath.string() + "' header!!!"};
+
+  return std::make_unique<CCoordConverterUTM>(header.zone, header.hemisphere == 'N', header.easting, header.northing);
+}
+
+
+/**
+ * @brief Converts UTM coordinates.
+ *
+ * Method converts UTM coordinates to WGS84 longitude and latitude using
+ * Krueger series (accurate to less than a millimeter within the zone).
+ *
+ * @param zone     UTM zone number.
+ * @param north    @p true for Northern hemisphere.
+ * @param easting  UTM easting.
+ * @param northing UTM northing.
+ *
+ * @return Longitude and latitude in degrees.
+ */
+std::pair<double, double> condor2nav::CCoordConverterUTM::UTMToLonLat(int zone, bool north, double easting, double northing)
+{
+  const double n = WGS84_F / (2 - WGS84_F);
+  const double n2 = n * n;
+  const double n3 = n2 * n;
+  const double a = WGS84_A / (1 + n) * (1 + n2 / 4 + n2 * n2 / 64);
+  const double beta[] = { n / 2 - 2 * n2 / 3 + 37 * n3 / 96, n2 / 48 + n3 / 15, 17 * n3 / 480 };
+  const double delta[] = { 2 * n - 2 * n2 / 3 - 2 * n3, 7 * n2 / 3 - 8 * n3 / 5, 56 * n3 / 15 };
+
+  const double xi = (northing - (north ? 0 : UTM_N0_SOUTH)) / (UTM_K0 * a);
+  const double eta = (easting - UTM_E0) / (UTM_K0 * a);
+  double xiP = xi;
+  double etaP = eta;
+  for(int j = 1; j <= 3; ++j) {
+    xiP -= beta[j - 1] * sin(2 * j * xi) * cosh(2 * j * eta);
+    etaP -= beta[j - 1] * cos(2 * j * xi) * sinh(2 * j * eta);
+  }
+
+  const double chi = asin(sin(xiP) / cosh(etaP));
+  double lat = chi;
+  for(int j = 1; j <= 3; ++j)
+    lat += delta[j - 1] * sin(2 * j * chi);
+  const double lon0 = zone * 6.0 - 183.0;
+  const double lon = lon0 + atan2(sinh(etaP), cos(xiP)) * 180 / PI;
+  return std::make_pair(lon, lat * 180 / PI);
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CCoordConverterUTM class constructor.
+ *
+ * @param zone     UTM zone number.
+ * @param north    @p true for Northern hemisphere.
+ * @param easting  UTM easting of Condor map origin.
+ * @param northing UTM northing of Condor map origin.
+ */
+condor2nav::CCoordConverterUTM::CCoordConverterUTM(int zone, bool north, double easting, double northing) :
+  _zone{zone}, _north{north}, _easting{easting}, _northing{northing}
+{
+}
+
+
+/**
+ * @brief Converts Condor coordinates.
+ *
+ * @param x The x coordinate.
+ * @param y The y coordinate. 
+ *
+ * @return Longitude and latitude of the point.
+ */
+auto condor2nav::CCoordConverterUTM::XYToLonLat(float x, float y) const -> CPoint
+{
+  const auto lonLat = UTMToLonLat(_zone, _north, _easting - x, _northing + y);
+  return CPoint{static_cast<float>(lonLat.first), static_cast<float>(lonLat.second)};
+}
@@ -0,0 +1,64 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file coordConverterUTM.h
+ *
+ * @brief Declares the condor2nav::CCoordConverterUTM class. 
+ */
+
+#ifndef __COORDCONVERTERUTM_H__
+#define __COORDCONVERTERUTM_H__
+
+#include "condor.h"
+
+namespace condor2nav {
+
+  /**
+   * @brief UTM projection coordinates converter.
+   *
+   * condor2nav::CCoordConverterUTM class converts Condor map coordinates to
+   * longitude and latitude without NaviCon.dll. Condor landscapes are UTM
+   * projected with the origin in the bottom-right corner of the map, X axis
+   * pointing West and Y axis pointing North.
+   *
+   * @note The landscape terrain file header layout used by FromTRN() is not
+   *       documented by Condor and was not verified against NaviCon.dll, so
+   *       the converter is used only on explicit request.
+   */
+  class CCoordConverterUTM : public CCondor::CCoordConverter {
+    const int _zone;                              ///< @brief UTM zone number.
+    const bool _north;                            ///< @brief @p true for Northern hemisphere.
+    const double _easting;                        ///< @brief UTM easting of Condor map origin.
+    const double _northing;                       ///< @brief UTM northing of Condor map origin.
+
+    CPoint XYToLonLat(float x, float y) const override;
+
+  public:
+    static std::unique_ptr<CCoordConverterUTM> FromTRN(const bfs::path &trnPath);
+    static std::pair<double, double> UTMToLonLat(int zone, bool north, double easting, double northing);
+
+    CCoordConverterUTM(int zone, bool north, double easting, double northing);
+  };
+
+}
+
+#endif /* __COORDCONVERTERUTM_H__ */
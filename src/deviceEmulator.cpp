@@ -0,0 +1,299 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file deviceEmulator.cpp
+ *
+ * @brief Implements the condor2nav::CDeviceEmulator class. 
+ */
+
+#include "deviceEmulator.h"
+#include "exception.h"
+#include <boost/filesystem/path.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <thread>
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CDeviceEmulator class constructor.
+ *
+ * @param latency   Time of one RAPI call.
+ * @param bandwidth Transfer speed in bytes per second (0 means unlimited).
+ */
+condor2nav::CDeviceEmulator::CDeviceEmulator(std::chrono::microseconds latency /* = 0 */, unsigned bandwidth /* = 0 */) :
+  _latency{latency}, _bandwidth{bandwidth}, _stats()
+{
+}
+
+
+/**
+ * @brief Checks if directory exists.
+ *
+ * @note Should be called with device mutex locked.
+ *
+ * @param key Normalized directory path.
+ *
+ * @return @p true if directory exists.
+ */
+bool condor2nav::CDeviceEmulator::DirectoryExists(const std::string &key) const
+{
+  return key == "\\" || Parent(key) == "\\" || _dirs.count(key);
+}
+
+
+/**
+ * @brief Emulates RAPI call.
+ *
+ * Method waits for the time of one round trip with data transfer.
+ *
+ * @note Should be called with device mutex locked.
+ *
+ * @param bytes The number of bytes transferred.
+ */
+void condor2nav::CDeviceEmulator::RoundTrip(size_t bytes /* = 0 */) const
+{
+  ++_stats.roundTrips;
+  auto time = _latency;
+  if(_bandwidth)
+    time += std::chrono::microseconds{static_cast<long long>(bytes * 1000000ULL / _bandwidth)};
+  if(time.count())
+    std::this_thread::sleep_for(time);
+}
+
+
+namespace condor2nav {
+
+  /**
+   * @brief Emulated device file reader.
+   *
+   * Each chunk is read with CeReadFile() call and CeCloseHandle() is called
+   * when the reader is destroyed.
+   */
+  class CDeviceEmulator::CFileReader : public CReader {
+    const CDeviceEmulator &_device;                   ///< @brief Emulated device.
+    const std::string _data;                          ///< @brief File content at the time of opening.
+    size_t _pos;                                      ///< @brief Current position in the file.
+  public:
+    CFileReader(const CDeviceEmulator &device, std::string data) : _device(device), _data{std::move(data)}, _pos{0} {}
+
+    ~CFileReader()
+    {
+      std::lock_guard<std::mutex> lock{_device._mutex};
+      _device.RoundTrip();
+    }
+
+    size_t Read(char *buffer, size_t size) override
+    {
+      const auto count = (std::min)(size, _data.size() - _pos);
+      if(!count)
+        return 0;
+      std::lock_guard<std::mutex> lock{_device._mutex};
+      _device.RoundTrip(count);
+      _device._stats.bytesRead += count;
+      std::memcpy(buffer, _data.data() + _pos, count);
+      _pos += count;
+      return count;
+    }
+  };
+
+}
+
+
+/**
+ * @brief Opens file for reading.
+ *
+ * Emulates CeCreateFile() and CeGetFileSize() calls.
+ *
+ * @param src Device file path.
+ *
+ * @return File reader.
+ */
+std::unique_ptr<condor2nav::CReader> condor2nav::CDeviceEmulator::Open(const bfs::path &src) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  RoundTrip();
+  const auto it = _files.find(Key(src));
+  if(it == _files.end())
+    throw EOperationFailed{"ERROR: Unable to open device file '" + src.string() + "'!!!"};
+  RoundTrip();
+  return std::make_unique<CFileReader>(*this, it->second);
+}
+
+
+/**
+ * @brief Writes whole file.
+ *
+ * Emulates CeCreateFile(), CeWriteFile() and CeCloseHandle() calls.
+ *
+ * @param dest   Device file path.
+ * @param buffer File content.
+ */
+void condor2nav::CDeviceEmulator::Write(const bfs::path &dest, const std::string &buffer) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  RoundTrip();
+  const auto key = Key(dest);
+  if(!DirectoryExists(Parent(key)) || _dirs.count(key))
+    throw EOperationFailed{"ERROR: Unable to open device file '" + dest.string() + "'!!!"};
+  RoundTrip(buffer.size());
+  RoundTrip();
+  _files[key] = buffer;
+  _stats.bytesWritten += buffer.size();
+}
+
+
+/**
+ * @brief Overwrites a part of existing file.
+ *
+ * Emulates CeCreateFile(), CeSetFilePointer(), CeWriteFile(), CeSetEndOfFile() and
+ * CeCloseHandle() calls (and one more CeSetFilePointer() if the file ends after
+ * the written data).
+ *
+ * @param dest   Device file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::CDeviceEmulator::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  RoundTrip();
+  const auto it = _files.find(Key(dest));
+  if(it == _files.end())
+    throw EOperationFailed{"ERROR: Unable to open device file '" + dest.string() + "'!!!"};
+  RoundTrip();
+  RoundTrip(buffer.size());
+  if(size != offset + buffer.size())
+    RoundTrip();
+  RoundTrip();
+  RoundTrip();
+  it->second.resize((std::max)(it->second.size(), offset));
+  it->second.replace(offset, buffer.size(), buffer);
+  it->second.resize(size);
+  _stats.bytesWritten += buffer.size();
+}
+
+
+/**
+ * @brief Creates directory.
+ *
+ * Emulates CeCreateDirectory() call (and CeGetLastError() if the directory exists).
+ *
+ * @param path Device directory path.
+ */
+void condor2nav::CDeviceEmulator::DirectoryCreate(const bfs::path &path) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  RoundTrip();
+  const auto key = Key(path);
+  if(DirectoryExists(key)) {
+    RoundTrip();
+    return;
+  }
+  if(!DirectoryExists(Parent(key)) || _files.count(key))
+    throw EOperationFailed{"ERROR: Creating device directory '" + path.string() + "'!!!"};
+  _dirs.insert(key);
+}
+
+
+/**
+ * @brief Checks if a file or directory exists.
+ *
+ * Emulates CeCreateFile() and CeCloseHandle() or CeGetLastError() calls.
+ *
+ * @param path Device path.
+ *
+ * @return @p true if the path exists.
+ */
+bool condor2nav::CDeviceEmulator::FileExists(const bfs::path &path) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  RoundTrip();
+  RoundTrip();
+  const auto key = Key(path);
+  return _files.count(key) || _dirs.count(key);
+}
+
+
+/**
+ * @brief Lists directory content.
+ *
+ * Emulates CeFindAllFiles() call that transfers names, attributes and sizes of all
+ * the entries (and CeGetFileAttributes() to verify the directory if it is empty
+ * or CeGetLastError() if the call failed).
+ *
+ * @param dir     Device directory path.
+ * @param entries Directory entries.
+ *
+ * @return @p false if the directory does not exist.
+ */
+bool condor2nav::CDeviceEmulator::List(const bfs::path &dir, CEntriesList &entries) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  const auto key = Key(dir);
+  if(!DirectoryExists(key)) {
+    RoundTrip();
+    RoundTrip();
+    return false;
+  }
+
+  const auto name = [&](const std::string &path){ return path.substr(key.size() == 1 ? 1 : key.size() + 1); };
+  size_t bytes = 0;
+  const auto size = entries.size();
+  for(const auto &d : _dirs)
+    if(Parent(d) == key)
+      entries.push_back(TEntry{name(d), true, 0});
+  for(const auto &f : _files)
+    if(Parent(f.first) == key)
+      entries.push_back(TEntry{name(f.first), false, f.second.size()});
+  for(auto i = size; i < entries.size(); ++i)
+    bytes += entries[i].name.size() * 2 + 8;         // UTF-16 name, attributes and size
+  RoundTrip(bytes);
+  if(entries.size() == size)
+    RoundTrip();
+  return true;
+}
+
+
+/**
+ * @brief Returns transfers statistics.
+ *
+ * @return Transfers statistics since creation or the last reset.
+ */
+auto condor2nav::CDeviceEmulator::Stats() const -> TStats
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  return _stats;
+}
+
+
+/**
+ * @brief Resets transfers statistics.
+ */
+void condor2nav::CDeviceEmulator::StatsReset()
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  _stats = TStats();
+}
@@ -0,0 +1,89 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file deviceEmulator.h
+ *
+ * @brief Declares the condor2nav::CDeviceEmulator class. 
+ */
+
+#ifndef __DEVICEEMULATOR_H__
+#define __DEVICEEMULATOR_H__
+
+#include "deviceTransport.h"
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+
+namespace condor2nav {
+
+  /**
+   * @brief In-process ActiveSync emulator.
+   *
+   * condor2nav::CDeviceEmulator class keeps device storage in memory and
+   * emulates the cost of RAPI calls done by ActiveSync transport for every
+   * operation. Each RAPI call is one round trip that takes configured latency
+   * and the data is transferred with configured bandwidth. Device paths are
+   * case-insensitive and the directories in the root of the device (i.e.
+   * "\My Documents") always exist.
+   */
+  class CDeviceEmulator : public CDeviceTransport {
+  public:
+    /**
+     * @brief Emulated transfers statistics.
+     */
+    struct TStats {
+      unsigned roundTrips;                            ///< @brief Number of RAPI calls.
+      size_t bytesRead;                               ///< @brief Number of bytes read from the device.
+      size_t bytesWritten;                            ///< @brief Number of bytes written to the device.
+    };
+
+  private:
+    class CFileReader;
+
+    const std::chrono::microseconds _latency;         ///< @brief Round trip time.
+    const unsigned _bandwidth;                        ///< @brief Bytes per second (0 means unlimited).
+    mutable std::mutex _mutex;                        ///< @brief Device access guard (one RAPI connection).
+    mutable TStats _stats;                            ///< @brief Transfers statistics.
+    mutable std::set<std::string> _dirs;              ///< @brief Device directories.
+    mutable std::map<std::string, std::string> _files; ///< @brief Device files.
+
+    bool DirectoryExists(const std::string &key) const;
+    void RoundTrip(size_t bytes = 0) const;
+
+  public:
+    explicit CDeviceEmulator(std::chrono::microseconds latency = std::chrono::microseconds{0}, unsigned bandwidth = 0);
+
+    std::unique_ptr<CReader> Open(const bfs::path &src) const override;
+    void Write(const bfs::path &dest, const std::string &buffer) const override;
+    void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const override;
+    void DirectoryCreate(const bfs::path &path) const override;
+    bool FileExists(const bfs::path &path) const override;
+    bool List(const bfs::path &dir, CEntriesList &entries) const override;
+
+    TStats Stats() const;
+    void StatsReset();
+  };
+
+}
+
+#endif /* __DEVICEEMULATOR_H__ */
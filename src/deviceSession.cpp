@@ -0,0 +1,329 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file deviceSession.cpp
+ *
+ * @brief Implements the condor2nav::CDeviceSession class. 
+ */
+
+#include "deviceSession.h"
+#include "exception.h"
+#include <algorithm>
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CDeviceSession class constructor that attaches the session
+ * to the current thread.
+ *
+ * @param transport Underlying device transport.
+ */
+condor2nav::CDeviceSession::CDeviceSession(std::shared_ptr<CDeviceTransport> transport /* = Current() */) :
+  _transport{std::move(transport)}, _previous{SessionAttach(this)}, _stats()
+{
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::CDeviceSession class destructor that detaches the session from
+ * the current thread. Not committed changes are discarded.
+ */
+condor2nav::CDeviceSession::~CDeviceSession()
+{
+  SessionAttach(_previous);
+}
+
+
+/**
+ * @brief Returns device path with backslash separators.
+ *
+ * Returned path has the same length as its key so the keys of parent
+ * directories may be used to find parent paths.
+ *
+ * @param path Device path.
+ *
+ * @return Device path in original case.
+ */
+std::string condor2nav::CDeviceSession::Native(const bfs::path &path)
+{
+  auto native = path.string();
+  std::replace(native.begin(), native.end(), '/', '\\');
+  while(native.size() > 1 && native.back() == '\\')
+    native.pop_back();
+  return native;
+}
+
+
+/**
+ * @brief Lists device directory.
+ *
+ * Method adds the content of the directory to the manifest.
+ *
+ * @param dir Device directory path returned by Native().
+ */
+void condor2nav::CDeviceSession::Load(const std::string &dir) const
+{
+  const auto key = Key(dir);
+  CEntriesList entries;
+  ++_stats.listings;
+  if(_transport->List(dir, entries))
+    for(auto &entry : entries)
+      _entries[key + "\\" + Key(entry.name)] = std::move(entry);
+  _listed.insert(key);
+}
+
+
+/**
+ * @brief Returns manifest entry.
+ *
+ * Method finds the entry of a device path. Parent directory is listed if its
+ * content is not known yet.
+ *
+ * @param path Device path returned by Native().
+ *
+ * @return Entry or @p nullptr if the path does not exist.
+ */
+auto condor2nav::CDeviceSession::Entry(const std::string &path) const -> const TEntry *
+{
+  const auto key = Key(path);
+  auto it = _entries.find(key);
+  if(it != _entries.end())
+    return &it->second;
+
+  const auto parent = Parent(key);
+  if(parent == "\\")
+    // device root directories are expected to exist
+    return &(_entries[key] = TEntry{path.substr(1), true, 0});
+
+  if(!_listed.count(parent)) {
+    const auto dir = path.substr(0, parent.size());
+    const auto entry = Entry(dir);
+    if(entry && entry->directory)
+      Load(dir);
+    else
+      // content of not existing directory is known too
+      _listed.insert(parent);
+  }
+
+  it = _entries.find(key);
+  return it != _entries.end() ? &it->second : nullptr;
+}
+
+
+/**
+ * @brief Opens file for reading.
+ *
+ * Method returns the reader of planned content of the file or opens it on the device.
+ *
+ * @param src Device file path.
+ *
+ * @return File reader.
+ */
+std::unique_ptr<condor2nav::CReader> condor2nav::CDeviceSession::Open(const bfs::path &src) const
+{
+  const auto native = Native(src);
+  const auto key = Key(native);
+  const auto it = _writesMap.find(key);
+  if(it != _writesMap.end())
+    return std::make_unique<CReaderString>(_writes[it->second].second);
+
+  const auto entry = Entry(native);
+  if(!entry || entry->directory)
+    throw EOperationFailed{"ERROR: Unable to open device file '" + src.string() + "'!!!"};
+  ++_stats.reads;
+  const auto patched = [&](const TPatch &patch){ return Key(patch.path) == key; };
+  if(std::none_of(_patches.begin(), _patches.end(), patched))
+    return _transport->Open(src);
+
+  // apply planned patches to the content read from the device
+  auto data = _transport->Read(src);
+  for(const auto &patch : _patches) {
+    if(patched(patch)) {
+      data.resize((std::max)(data.size(), patch.offset));
+      data.replace(patch.offset, patch.buffer.size(), patch.buffer);
+      data.resize(patch.size);
+    }
+  }
+  return std::make_unique<CReaderString>(std::move(data));
+}
+
+
+/**
+ * @brief Plans file write.
+ *
+ * @param dest   Device file path (parent directory has to exist or be planned).
+ * @param buffer File content.
+ */
+void condor2nav::CDeviceSession::Write(const bfs::path &dest, const std::string &buffer) const
+{
+  const auto native = Native(dest);
+  const auto key = Key(native);
+  const auto entry = Entry(native);
+  const auto parent = Entry(native.substr(0, Parent(key).size()));
+  if((entry && entry->directory) || !parent || !parent->directory)
+    throw EOperationFailed{"ERROR: Unable to open device file '" + dest.string() + "'!!!"};
+
+  _entries[key] = TEntry{native.substr(Parent(key).size() + 1), false, buffer.size()};
+  _patches.erase(std::remove_if(_patches.begin(), _patches.end(), [&](const TPatch &patch){ return Key(patch.path) == key; }), _patches.end());
+  const auto it = _writesMap.find(key);
+  if(it != _writesMap.end()) {
+    _writes[it->second].second = buffer;
+  }
+  else {
+    _writesMap.emplace(key, _writes.size());
+    _writes.emplace_back(dest, buffer);
+  }
+}
+
+
+/**
+ * @brief Plans a patch of existing file.
+ *
+ * The patch is applied to the planned content if the file is written in the
+ * session. Otherwise only the patch is sent to the device.
+ *
+ * @param dest   Device file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::CDeviceSession::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  const auto native = Native(dest);
+  const auto key = Key(native);
+  const auto it = _writesMap.find(key);
+  if(it != _writesMap.end()) {
+    auto &data = _writes[it->second].second;
+    data.resize((std::max)(data.size(), offset));
+    data.replace(offset, buffer.size(), buffer);
+    data.resize(size);
+  }
+  else {
+    const auto entry = Entry(native);
+    if(!entry || entry->directory)
+      throw EOperationFailed{"ERROR: Unable to open device file '" + dest.string() + "'!!!"};
+    _patches.push_back(TPatch{dest, offset, buffer, size});
+  }
+  _entries[key].size = size;
+}
+
+
+/**
+ * @brief Plans directory creation.
+ *
+ * Nothing is planned if the directory already exists.
+ *
+ * @param path Device directory path (parent directory has to exist or be planned).
+ */
+void condor2nav::CDeviceSession::DirectoryCreate(const bfs::path &path) const
+{
+  const auto native = Native(path);
+  const auto key = Key(native);
+  if(const auto entry = Entry(native)) {
+    if(!entry->directory)
+      throw EOperationFailed{"ERROR: Creating device directory '" + path.string() + "'!!!"};
+    return;
+  }
+  const auto parent = Entry(native.substr(0, Parent(key).size()));
+  if(!parent || !parent->directory)
+    throw EOperationFailed{"ERROR: Creating device directory '" + path.string() + "'!!!"};
+
+  _entries[key] = TEntry{native.substr(Parent(key).size() + 1), true, 0};
+  _listed.insert(key);
+  _creates.push_back(path);
+}
+
+
+/**
+ * @brief Checks if a file or directory exists.
+ *
+ * Planned files and directories exist too.
+ *
+ * @param path Device path.
+ *
+ * @return @p true if the path exists.
+ */
+bool condor2nav::CDeviceSession::FileExists(const bfs::path &path) const
+{
+  return Entry(Native(path)) != nullptr;
+}
+
+
+/**
+ * @brief Lists directory content.
+ *
+ * Planned files and directories are listed too.
+ *
+ * @param dir     Device directory path.
+ * @param entries Directory entries.
+ *
+ * @return @p false if the directory does not exist.
+ */
+bool condor2nav::CDeviceSession::List(const bfs::path &dir, CEntriesList &entries) const
+{
+  const auto native = Native(dir);
+  const auto entry = Entry(native);
+  if(!entry || !entry->directory)
+    return false;
+  const auto key = Key(native);
+  if(!_listed.count(key))
+    Load(native);
+
+  const auto prefix = key.size() == 1 ? key : key + "\\";
+  for(auto it = _entries.lower_bound(prefix); it != _entries.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it)
+    if(Parent(it->first) == key)
+      entries.push_back(it->second);
+  return true;
+}
+
+
+/**
+ * @brief Sends planned changes to the device.
+ *
+ * Method creates all planned directories and then writes all planned files and patches.
+ */
+void condor2nav::CDeviceSession::Commit()
+{
+  for(const auto &dir : _creates) {
+    _transport->DirectoryCreate(dir);
+    ++_stats.creates;
+  }
+  _creates.clear();
+
+  for(const auto &write : _writes) {
+    _transport->Write(write.first, write.second);
+    ++_stats.writes;
+    _stats.bytes += write.second.size();
+  }
+  _writes.clear();
+  _writesMap.clear();
+
+  for(const auto &patch : _patches) {
+    _transport->Patch(patch.path, patch.offset, patch.buffer, patch.size);
+    ++_stats.patches;
+    _stats.bytes += patch.buffer.size();
+  }
+  _patches.clear();
+}
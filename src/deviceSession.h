@@ -0,0 +1,111 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file deviceSession.h
+ *
+ * @brief Declares the condor2nav::CDeviceSession class. 
+ */
+
+#ifndef __DEVICESESSION_H__
+#define __DEVICESESSION_H__
+
+#include "deviceTransport.h"
+#include <map>
+#include <set>
+#include <utility>
+
+namespace condor2nav {
+
+  /**
+   * @brief Batched device synchronization session.
+   *
+   * condor2nav::CDeviceSession class serves all device paths used by the current thread
+   * for the time of its life. It keeps a manifest of the device directories: each directory
+   * is listed with one call when its content is needed for the first time and all
+   * further existence checks are answered from the manifest. Directories creation and files
+   * writes are planned and sent to the device by Commit() as one batch (repeated writes
+   * of the same file are merged). Patches of existing files transfer only the changed part of
+   * the file. Planned changes are discarded if the session is not committed.
+   *
+   * @note Directories in the root of the device (i.e. "\My Documents") are expected to exist.
+   */
+  class CDeviceSession : public CDeviceTransport {
+  public:
+    /**
+     * @brief Session statistics.
+     */
+    struct TStats {
+      unsigned listings;                              ///< @brief Number of directories listed.
+      unsigned reads;                                 ///< @brief Number of files read from the device.
+      unsigned creates;                               ///< @brief Number of directories created.
+      unsigned writes;                                ///< @brief Number of files written.
+      unsigned patches;                               ///< @brief Number of file patches written.
+      size_t bytes;                                   ///< @brief Number of bytes written.
+    };
+
+  private:
+    /**
+     * @brief Planned patch of existing file.
+     */
+    struct TPatch {
+      bfs::path path;                                 ///< @brief Device file path.
+      size_t offset;                                  ///< @brief The offset of the data.
+      std::string buffer;                             ///< @brief The data to write.
+      size_t size;                                    ///< @brief New size of the file.
+    };
+
+    using CEntriesMap = std::map<std::string, TEntry>;
+    using CWritesList = std::vector<std::pair<bfs::path, std::string>>;
+    using CPatchesList = std::vector<TPatch>;
+
+    const std::shared_ptr<CDeviceTransport> _transport; ///< @brief Underlying device transport.
+    CDeviceTransport *const _previous;                ///< @brief Session attached to the thread before this one.
+    mutable TStats _stats;                            ///< @brief Session statistics.
+    mutable CEntriesMap _entries;                     ///< @brief Known device entries.
+    mutable std::set<std::string> _listed;            ///< @brief Directories with known content.
+    mutable std::vector<bfs::path> _creates;          ///< @brief Planned directories in creation order.
+    mutable CWritesList _writes;                      ///< @brief Planned writes in order.
+    mutable std::map<std::string, size_t> _writesMap; ///< @brief Planned writes by path.
+    mutable CPatchesList _patches;                    ///< @brief Planned patches of files not written in the session.
+
+    static std::string Native(const bfs::path &path);
+    void Load(const std::string &dir) const;
+    const TEntry *Entry(const std::string &path) const;
+
+  public:
+    explicit CDeviceSession(std::shared_ptr<CDeviceTransport> transport = Current());
+    ~CDeviceSession();
+
+    std::unique_ptr<CReader> Open(const bfs::path &src) const override;
+    void Write(const bfs::path &dest, const std::string &buffer) const override;
+    void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const override;
+    void DirectoryCreate(const bfs::path &path) const override;
+    bool FileExists(const bfs::path &path) const override;
+    bool List(const bfs::path &dir, CEntriesList &entries) const override;
+
+    void Commit();
+    const TStats &Stats() const { return _stats; }
+  };
+
+}
+
+#endif /* __DEVICESESSION_H__ */
@@ -0,0 +1,439 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file deviceTransport.cpp
+ *
+ * @brief Implements the condor2nav::CDeviceTransport class and its backends. 
+ */
+
+#include "deviceTransport.h"
+#include "deviceEmulator.h"
+#include "platform.h"
+#include "exception.h"
+#include "tools.h"
+#if defined(_WIN32)
+#include "activeSync.h"
+#endif
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+  std::mutex transportMutex;
+  std::shared_ptr<condor2nav::CDeviceTransport> transport;
+  std::map<std::thread::id, condor2nav::CDeviceTransport *> sessions;
+
+
+  /**
+   * @brief Creates default transport.
+   *
+   * Device emulator is used if CONDOR2NAV_DEVICE_EMULATOR environment variable is set
+   * to "<latency in ms>,<bandwidth in KB/s>". Otherwise local directory is used if
+   * CONDOR2NAV_DEVICE_ROOT environment variable is set. ActiveSync is used in any
+   * other case (Windows only).
+   *
+   * @return Default transport.
+   */
+  std::shared_ptr<condor2nav::CDeviceTransport> DefaultTransport()
+  {
+    using namespace condor2nav;
+
+    const auto emulator = platform::Environment("CONDOR2NAV_DEVICE_EMULATOR");
+    if(!emulator.empty()) {
+      const auto pos = emulator.find(',');
+      const auto latency = Convert<unsigned>(emulator.substr(0, pos));
+      const auto bandwidth = pos != std::string::npos ? Convert<unsigned>(emulator.substr(pos + 1)) : 0;
+      return std::make_shared<CDeviceEmulator>(std::chrono::milliseconds(latency), bandwidth * 1024);
+    }
+
+    const auto root = platform::Environment("CONDOR2NAV_DEVICE_ROOT");
+    if(!root.empty())
+      return std::make_shared<CDeviceTransportLocal>(root);
+
+#if defined(_WIN32)
+    return std::make_shared<CDeviceTransportActiveSync>();
+#else
+    throw EOperationFailed{"ERROR: ActiveSync not available on this platform (please set CONDOR2NAV_DEVICE_ROOT to device storage directory)!!!"};
+#endif
+  }
+
+}
+
+
+/* ******************** D E V I C E   T R A N S P O R T ******************** */
+
+/**
+ * @brief Returns current transport.
+ *
+ * Function returns the transport selected for device paths. The default one
+ * is created on the first use. Device session attached to the current thread
+ * takes precedence over the selected transport.
+ *
+ * @return Current transport.
+ */
+std::shared_ptr<condor2nav::CDeviceTransport> condor2nav::CDeviceTransport::Current()
+{
+  std::lock_guard<std::mutex> lock{transportMutex};
+  const auto it = sessions.find(std::this_thread::get_id());
+  if(it != sessions.end())
+    // session lifetime is controlled by its owner
+    return std::shared_ptr<CDeviceTransport>{std::shared_ptr<CDeviceTransport>{}, it->second};
+  if(!::transport)
+    ::transport = DefaultTransport();
+  return ::transport;
+}
+
+
+/**
+ * @brief Selects transport.
+ *
+ * Function selects the transport to use for device paths.
+ *
+ * @param transport Transport to use (empty pointer restores the default one).
+ */
+void condor2nav::CDeviceTransport::Select(std::shared_ptr<CDeviceTransport> transport)
+{
+  std::lock_guard<std::mutex> lock{transportMutex};
+  ::transport = std::move(transport);
+}
+
+
+/**
+ * @brief Attaches device session to the current thread.
+ *
+ * @param session Session to use for device paths in the current thread (@p nullptr detaches
+ *                the current one).
+ *
+ * @return Session attached previously (@p nullptr if none).
+ */
+condor2nav::CDeviceTransport *condor2nav::CDeviceTransport::SessionAttach(CDeviceTransport *session)
+{
+  std::lock_guard<std::mutex> lock{transportMutex};
+  const auto id = std::this_thread::get_id();
+  const auto it = sessions.find(id);
+  const auto previous = it != sessions.end() ? it->second : nullptr;
+  if(session)
+    sessions[id] = session;
+  else if(it != sessions.end())
+    sessions.erase(it);
+  return previous;
+}
+
+
+/**
+ * @brief Reads whole file.
+ *
+ * @param src Device file path.
+ *
+ * @return File content (line endings are not translated).
+ */
+std::string condor2nav::CDeviceTransport::Read(const bfs::path &src) const
+{
+  const auto reader = Open(src);
+  std::string data;
+  size_t size = 0;
+  do {
+    data.resize(data.size() + CReader::CHUNK_SIZE);
+    size = reader->Read(&data[data.size() - CReader::CHUNK_SIZE], CReader::CHUNK_SIZE);
+    data.resize(data.size() - CReader::CHUNK_SIZE + size);
+  } while(size);
+  return data;
+}
+
+
+/**
+ * @brief Overwrites a part of existing file.
+ *
+ * Method writes the buffer at provided offset of the existing file and sets the
+ * size of the file. Default implementation reads the whole file and writes it back
+ * so transports that can seek in remote files should override it.
+ *
+ * @param dest   Device file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file (not smaller than @p offset + @p buffer size).
+ */
+void condor2nav::CDeviceTransport::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  auto data = Read(dest);
+  data.resize(size);
+  data.replace(offset, buffer.size(), buffer);
+  Write(dest, data);
+}
+
+
+/**
+ * @brief Returns the key of device path.
+ *
+ * Device paths are case-insensitive and may use both slash and backslash separators.
+ *
+ * @param path Device path.
+ *
+ * @return Normalized path (lower case with backslash separators).
+ */
+std::string condor2nav::CDeviceTransport::Key(const bfs::path &path)
+{
+  auto key = path.string();
+  std::transform(key.begin(), key.end(), key.begin(), [](char c){ return c == '/' ? '\\' : static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+  while(key.size() > 1 && key.back() == '\\')
+    key.pop_back();
+  return key;
+}
+
+
+/**
+ * @brief Returns the key of parent directory.
+ *
+ * @param key Normalized path.
+ *
+ * @return Normalized parent directory path.
+ */
+std::string condor2nav::CDeviceTransport::Parent(const std::string &key)
+{
+  const auto pos = key.rfind('\\');
+  return pos == std::string::npos || pos == 0 ? std::string{"\\"} : key.substr(0, pos);
+}
+
+
+
+/* ******************** D E V I C E   T R A N S P O R T   -   L O C A L ******************** */
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CDeviceTransportLocal class constructor that verifies device storage.
+ *
+ * @param root Local directory with device storage.
+ */
+condor2nav::CDeviceTransportLocal::CDeviceTransportLocal(bfs::path root) :
+  _root{std::move(root)}
+{
+  if(!bfs::is_directory(_root))
+    throw EOperationFailed{"ERROR: Device storage directory '" + _root.string() + "' not found!!!"};
+}
+
+
+/**
+ * @brief Maps device path to a local one.
+ *
+ * @param path Device path.
+ *
+ * @return Local path.
+ */
+bfs::path condor2nav::CDeviceTransportLocal::Local(const bfs::path &path) const
+{
+  auto local = _root;
+  std::string::size_type pos = 0;
+  const auto &str = path.string();
+  while(pos < str.size()) {
+    const auto next = (std::min)(str.find_first_of("\\/", pos), str.size());
+    if(next > pos)
+      local /= str.substr(pos, next - pos);
+    pos = next + 1;
+  }
+  return local;
+}
+
+
+/**
+ * @brief Opens device file for reading.
+ *
+ * @param src Device file path.
+ *
+ * @return File reader.
+ */
+std::unique_ptr<condor2nav::CReader> condor2nav::CDeviceTransportLocal::Open(const bfs::path &src) const
+{
+  return std::make_unique<CReaderFile>(Local(src));
+}
+
+
+/**
+ * @brief Writes device file.
+ *
+ * @param dest   Device file path.
+ * @param buffer The data to write.
+ */
+void condor2nav::CDeviceTransportLocal::Write(const bfs::path &dest, const std::string &buffer) const
+{
+  bfs::ofstream stream{Local(dest), std::ios::binary};
+  if(!stream)
+    throw EOperationFailed{"ERROR: Unable to open device file '" + dest.string() + "'!!!"};
+  if(!stream.write(buffer.data(), buffer.size()))
+    throw EOperationFailed{"ERROR: Writing device file '" + dest.string() + "'!!!"};
+}
+
+
+/**
+ * @brief Overwrites a part of existing device file.
+ *
+ * Method writes the buffer at provided offset of the local file in place
+ * without reading the rest of it.
+ *
+ * @param dest   Device file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::CDeviceTransportLocal::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  platform::FilePatch(Local(dest), offset, platform::TBuffer{buffer.data(), buffer.size()}, size);
+}
+
+
+/**
+ * @brief Creates device directory.
+ *
+ * @param path Device directory path.
+ */
+void condor2nav::CDeviceTransportLocal::DirectoryCreate(const bfs::path &path) const
+{
+  boost::system::error_code ec;
+  bfs::create_directory(Local(path), ec);
+  if(ec)
+    throw EOperationFailed{"ERROR: Creating device directory '" + path.string() + "'!!!"};
+}
+
+
+/**
+ * @brief Checks if device file exists.
+ *
+ * @param path Device file path.
+ *
+ * @return @p true if the file exists.
+ */
+bool condor2nav::CDeviceTransportLocal::FileExists(const bfs::path &path) const
+{
+  return bfs::exists(Local(path));
+}
+
+
+/**
+ * @brief Lists device directory.
+ *
+ * @param dir     Device directory path.
+ * @param entries Directory entries found.
+ *
+ * @return @p false if the directory does not exist.
+ */
+bool condor2nav::CDeviceTransportLocal::List(const bfs::path &dir, CEntriesList &entries) const
+{
+  const auto local = Local(dir);
+  if(!bfs::is_directory(local))
+    return false;
+  for(bfs::directory_iterator it{local}, end; it != end; ++it) {
+    const bool directory = bfs::is_directory(it->status());
+    entries.push_back(TEntry{it->path().filename().string(), directory, directory ? 0 : static_cast<size_t>(bfs::file_size(it->path()))});
+  }
+  return true;
+}
+
+
+
+#if defined(_WIN32)
+
+/* ******************** D E V I C E   T R A N S P O R T   -   A C T I V E S Y N C ******************** */
+
+/**
+ * @brief Opens device file for reading.
+ *
+ * @param src Device file path.
+ *
+ * @return File reader.
+ */
+std::unique_ptr<condor2nav::CReader> condor2nav::CDeviceTransportActiveSync::Open(const bfs::path &src) const
+{
+  return CActiveSync::Instance().Open(src);
+}
+
+
+/**
+ * @brief Writes device file.
+ *
+ * @param dest   Device file path.
+ * @param buffer The data to write.
+ */
+void condor2nav::CDeviceTransportActiveSync::Write(const bfs::path &dest, const std::string &buffer) const
+{
+  CActiveSync::Instance().Write(dest, buffer);
+}
+
+
+/**
+ * @brief Overwrites a part of existing device file.
+ *
+ * Method transfers only the buffer to the file on the device.
+ *
+ * @param dest   Device file path.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::CDeviceTransportActiveSync::Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const
+{
+  CActiveSync::Instance().Patch(dest, offset, buffer, size);
+}
+
+
+/**
+ * @brief Creates device directory.
+ *
+ * @param path Device directory path.
+ */
+void condor2nav::CDeviceTransportActiveSync::DirectoryCreate(const bfs::path &path) const
+{
+  CActiveSync::Instance().DirectoryCreate(path);
+}
+
+
+/**
+ * @brief Checks if device file exists.
+ *
+ * @param path Device file path.
+ *
+ * @return @p true if the file exists.
+ */
+bool condor2nav::CDeviceTransportActiveSync::FileExists(const bfs::path &path) const
+{
+  return CActiveSync::Instance().FileExists(path);
+}
+
+
+/**
+ * @brief Lists device directory.
+ *
+ * @param dir     Device directory path.
+ * @param entries Directory entries found.
+ *
+ * @return @p false if the directory does not exist.
+ */
+bool condor2nav::CDeviceTransportActiveSync::List(const bfs::path &dir, CEntriesList &entries) const
+{
+  return CActiveSync::Instance().List(dir, entries);
+}
+
+#endif
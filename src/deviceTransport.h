@@ -0,0 +1,162 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file deviceTransport.h
+ *
+ * @brief Declares the condor2nav::CDeviceTransport class and its backends. 
+ */
+
+#ifndef __DEVICETRANSPORT_H__
+#define __DEVICETRANSPORT_H__
+
+#include "nonCopyable.h"
+#include "reader.h"
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Target device transport.
+   *
+   * condor2nav::CDeviceTransport is an interface to the storage of the target
+   * device. All the paths starting with a single backslash (i.e. "\My Documents\XCSoarData")
+   * are device paths and are served by the currently selected transport.
+   */
+  class CDeviceTransport : CNonCopyable {
+  public:
+    /**
+     * @brief Directory entry.
+     */
+    struct TEntry {
+      std::string name;                               ///< @brief File or directory name.
+      bool directory;                                 ///< @brief @p true for a directory.
+      size_t size;                                    ///< @brief File size in bytes.
+    };
+    using CEntriesList = std::vector<TEntry>;
+
+    static std::shared_ptr<CDeviceTransport> Current();
+    static void Select(std::shared_ptr<CDeviceTransport> transport);
+
+    static std::string Key(const bfs::path &path);
+    static std::string Parent(const std::string &key);
+
+    virtual ~CDeviceTransport() {}
+
+    /**
+     * @brief Opens file for reading.
+     *
+     * @param src Device file path.
+     *
+     * @return Reader of the file content (line endings are not translated).
+     */
+    virtual std::unique_ptr<CReader> Open(const bfs::path &src) const = 0;
+
+    std::string Read(const bfs::path &src) const;
+
+    /**
+     * @brief Writes whole file.
+     *
+     * @param dest   Device file path (parent directory has to exist).
+     * @param buffer File content.
+     */
+    virtual void Write(const bfs::path &dest, const std::string &buffer) const = 0;
+
+    virtual void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const;
+
+    /**
+     * @brief Creates directory.
+     *
+     * @param path Device directory path (parent directory has to exist).
+     */
+    virtual void DirectoryCreate(const bfs::path &path) const = 0;
+
+    /**
+     * @brief Checks if a file or directory exists.
+     *
+     * @param path Device path.
+     *
+     * @return @p true if the path exists.
+     */
+    virtual bool FileExists(const bfs::path &path) const = 0;
+
+    /**
+     * @brief Lists directory content.
+     *
+     * @param dir     Device directory path.
+     * @param entries Directory entries.
+     *
+     * @return @p false if the directory does not exist.
+     */
+    virtual bool List(const bfs::path &dir, CEntriesList &entries) const = 0;
+
+  protected:
+    static CDeviceTransport *SessionAttach(CDeviceTransport *session);
+  };
+
+
+  /**
+   * @brief Local filesystem transport.
+   *
+   * condor2nav::CDeviceTransportLocal class maps device paths to a local
+   * directory (i.e. mounted device storage card).
+   */
+  class CDeviceTransportLocal : public CDeviceTransport {
+    const bfs::path _root;                            ///< @brief Local directory with device storage.
+    bfs::path Local(const bfs::path &path) const;
+
+  public:
+    explicit CDeviceTransportLocal(bfs::path root);
+    std::unique_ptr<CReader> Open(const bfs::path &src) const override;
+    void Write(const bfs::path &dest, const std::string &buffer) const override;
+    void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const override;
+    void DirectoryCreate(const bfs::path &path) const override;
+    bool FileExists(const bfs::path &path) const override;
+    bool List(const bfs::path &dir, CEntriesList &entries) const override;
+  };
+
+
+#if defined(_WIN32)
+
+  /**
+   * @brief ActiveSync transport.
+   *
+   * condor2nav::CDeviceTransportActiveSync class uses RAPI interface to
+   * communicate with the device connected with ActiveSync.
+   */
+  class CDeviceTransportActiveSync : public CDeviceTransport {
+  public:
+    std::unique_ptr<CReader> Open(const bfs::path &src) const override;
+    void Write(const bfs::path &dest, const std::string &buffer) const override;
+    void Patch(const bfs::path &dest, size_t offset, const std::string &buffer, size_t size) const override;
+    void DirectoryCreate(const bfs::path &path) const override;
+    bool FileExists(const bfs::path &path) const override;
+    bool List(const bfs::path &dir, CEntriesList &entries) const override;
+  };
+
+#endif
+
+}
+
+#endif /* __DEVICETRANSPORT_H__ */
@@ -0,0 +1,405 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file directoryWatcher.cpp
+ *
+ * @brief Implements the condor2nav::CDirectoryWatcher class. 
+ */
+
+#include "directoryWatcher.h"
+#include "traitsNoCase.h"
+#include "tools.h"
+#include <boost/filesystem.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <thread>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+
+/**
+ * @brief Directory watcher implementation interface.
+ */
+class condor2nav::CDirectoryWatcher::CImpl : CNonCopyable {
+public:
+  virtual ~CImpl() {}
+
+  /**
+   * @brief Returns @p true if operating system notifications are used.
+   */
+  virtual bool Native() const = 0;
+
+  /**
+   * @brief Waits for directory changes.
+   *
+   * @param timeout Maximum time to wait (in ms).
+   *
+   * @return The list of created or modified files.
+   */
+  virtual CPathList Wait(unsigned timeout) = 0;
+};
+
+
+namespace {
+
+  using namespace condor2nav;
+
+  const unsigned IDLE_TIMEOUT = 250;              ///< @brief Maximum time (in ms) between abort checks.
+  const unsigned POLL_INTERVAL = 500;             ///< @brief Directories polling interval (in ms) if notifications are not available.
+
+  /**
+   * @brief Directory watcher based on periodic directory scans.
+   */
+  class CPollImpl : public CDirectoryWatcher::CImpl {
+    using clock = std::chrono::steady_clock;
+
+    /**
+     * @brief File state.
+     */
+    struct TFileInfo {
+      std::time_t time;
+      uintmax_t size;
+    };
+
+    const CDirectoryWatcher::CPathList _dirList;       ///< @brief Watched directories.
+    std::map<bfs::path, TFileInfo> _files;             ///< @brief Files found in the last scan.
+    clock::time_point _nextScan;                       ///< @brief Time of the next scan.
+
+    void Scan(CDirectoryWatcher::CPathList *changed)
+    {
+      boost::system::error_code ec;
+      for(const auto &dir : _dirList) {
+        for(bfs::directory_iterator it{dir, ec}, end; !ec && it != end; it.increment(ec)) {
+          const auto time = bfs::last_write_time(it->path(), ec);
+          const auto size = bfs::file_size(it->path(), ec);
+          if(ec) {
+            ec.clear();
+            continue;
+          }
+          auto &info = _files[it->path()];
+          if(info.time != time || info.size != size) {
+            info.time = time;
+            info.size = size;
+            if(changed)
+              changed->emplace_back(it->path());
+          }
+        }
+        ec.clear();
+      }
+      _nextScan = clock::now() + std::chrono::milliseconds{POLL_INTERVAL};
+    }
+
+  public:
+    explicit CPollImpl(CDirectoryWatcher::CPathList dirList) :
+      _dirList{std::move(dirList)}
+    {
+      // existing files are not reported
+      Scan(nullptr);
+    }
+
+    bool Native() const override { return false; }
+
+    CDirectoryWatcher::CPathList Wait(unsigned timeout) override
+    {
+      CDirectoryWatcher::CPathList changed;
+      const auto deadline = clock::now() + std::chrono::milliseconds{timeout};
+      if(deadline < _nextScan) {
+        std::this_thread::sleep_until(deadline);
+        return changed;
+      }
+      std::this_thread::sleep_until(_nextScan);
+      Scan(&changed);
+      return changed;
+    }
+  };
+
+
+#if defined(_WIN32)
+
+  /**
+   * @brief Directory watcher based on ReadDirectoryChangesW() notifications.
+   */
+  class CNativeImpl : public CDirectoryWatcher::CImpl {
+    static const size_t BUFFER_SIZE = 16 * 1024;       ///< @brief Notifications buffer size (in DWORDs).
+
+    /**
+     * @brief Watched directory.
+     */
+    struct TDir {
+      bfs::path path;
+      HANDLE handle;
+      OVERLAPPED overlapped;
+      std::vector<DWORD> buffer;
+    };
+
+    std::vector<std::unique_ptr<TDir>> _dirs;          ///< @brief Watched directories.
+    std::vector<HANDLE> _events;                       ///< @brief Notification events of watched directories.
+
+    static void Read(TDir &dir)
+    {
+      if(!::ReadDirectoryChangesW(dir.handle, dir.buffer.data(), static_cast<DWORD>(dir.buffer.size() * sizeof(DWORD)), FALSE,
+                                  FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE,
+                                  nullptr, &dir.overlapped, nullptr))
+        throw EOperationFailed{"ERROR: Couldn't watch directory '" + dir.path.string() + "' (" + Convert(GetLastError()) + ")!!!"};
+    }
+
+  public:
+    explicit CNativeImpl(const CDirectoryWatcher::CPathList &dirList)
+    {
+      try {
+        for(const auto &path : dirList) {
+          auto dir = std::make_unique<TDir>();
+          dir->path = path;
+          dir->handle = ::CreateFile(path.string().c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                     nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+          if(dir->handle == INVALID_HANDLE_VALUE)
+            throw EOperationFailed{"ERROR: Couldn't open directory '" + path.string() + "' (" + Convert(GetLastError()) + ")!!!"};
+          memset(&dir->overlapped, 0, sizeof(dir->overlapped));
+          dir->overlapped.hEvent = ::CreateEvent(nullptr, TRUE, FALSE, nullptr);
+          dir->buffer.resize(BUFFER_SIZE);
+          _events.push_back(dir->overlapped.hEvent);
+          _dirs.emplace_back(std::move(dir));
+          Read(*_dirs.back());
+        }
+      }
+      catch(...) {
+        Close();
+        throw;
+      }
+    }
+
+    ~CNativeImpl()
+    {
+      Close();
+    }
+
+    void Close()
+    {
+      for(auto &dir : _dirs) {
+        ::CancelIo(dir->handle);
+        ::CloseHandle(dir->handle);
+        ::CloseHandle(dir->overlapped.hEvent);
+      }
+      _dirs.clear();
+      _events.clear();
+    }
+
+    bool Native() const override { return true; }
+
+    CDirectoryWatcher::CPathList Wait(unsigned timeout) override
+    {
+      CDirectoryWatcher::CPathList changed;
+      const auto status = ::WaitForMultipleObjects(static_cast<DWORD>(_events.size()), _events.data(), FALSE, timeout);
+      if(status < WAIT_OBJECT_0 || status >= WAIT_OBJECT_0 + _events.size())
+        return changed;
+
+      auto &dir = *_dirs[status - WAIT_OBJECT_0];
+      DWORD bytes = 0;
+      if(::GetOverlappedResult(dir.handle, &dir.overlapped, &bytes, FALSE) && bytes) {
+        auto ptr = reinterpret_cast<const char *>(dir.buffer.data());
+        for(;;) {
+          const auto info = reinterpret_cast<const FILE_NOTIFY_INFORMATION *>(ptr);
+          if(info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+            changed.emplace_back(dir.path / std::wstring{info->FileName, info->FileNameLength / sizeof(WCHAR)});
+          if(!info->NextEntryOffset)
+            break;
+          ptr += info->NextEntryOffset;
+        }
+      }
+      Read(dir);
+      return changed;
+    }
+  };
+
+#elif defined(__linux__)
+
+  /**
+   * @brief Directory watcher based on inotify notifications.
+   */
+  class CNativeImpl : public CDirectoryWatcher::CImpl {
+    int _fd;                                           ///< @brief inotify instance.
+    std::map<int, bfs::path> _watches;                 ///< @brief Watched directories.
+
+  public:
+    explicit CNativeImpl(const CDirectoryWatcher::CPathList &dirList) :
+      _fd{inotify_init1(IN_NONBLOCK | IN_CLOEXEC)}
+    {
+      if(_fd < 0)
+        throw EOperationFailed{"ERROR: Couldn't initialize inotify!!!"};
+      for(const auto &dir : dirList) {
+        const auto wd = inotify_add_watch(_fd, dir.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+        if(wd < 0) {
+          close(_fd);
+          throw EOperationFailed{"ERROR: Couldn't watch directory '" + dir.string() + "'!!!"};
+        }
+        _watches[wd] = dir;
+      }
+    }
+
+    ~CNativeImpl()
+    {
+      close(_fd);
+    }
+
+    bool Native() const override { return true; }
+
+    CDirectoryWatcher::CPathList Wait(unsigned timeout) override
+    {
+      CDirectoryWatcher::CPathList changed;
+      pollfd fds{_fd, POLLIN, 0};
+      if(poll(&fds, 1, static_cast<int>(timeout)) <= 0)
+        return changed;
+
+      alignas(inotify_event) char buffer[16 * 1024];
+      ssize_t len;
+      while((len = read(_fd, buffer, sizeof(buffer))) > 0) {
+        for(auto ptr = buffer; ptr < buffer + len; ) {
+          const auto event = reinterpret_cast<const inotify_event *>(ptr);
+          const auto it = _watches.find(event->wd);
+          if(event->len && it != _watches.end())
+            changed.emplace_back(it->second / event->name);
+          ptr += sizeof(inotify_event) + event->len;
+        }
+      }
+      return changed;
+    }
+  };
+
+#endif
+
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CDirectoryWatcher class constructor. Operating system notifications
+ * are used if available. Otherwise watcher falls back to directories polling.
+ *
+ * @param dirList      The list of directories to watch.
+ * @param extension    Extension of the files to report (i.e. ".fpl").
+ * @param debounceTime Time (in ms) with no changes for a file to be reported.
+ */
+condor2nav::CDirectoryWatcher::CDirectoryWatcher(const CPathList &dirList, std::string extension, unsigned debounceTime) :
+  CDirectoryWatcher{dirList, CExtensionList{std::move(extension)}, debounceTime}
+{
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CDirectoryWatcher class constructor. Operating system notifications
+ * are used if available. Otherwise watcher falls back to directories polling.
+ *
+ * @param dirList      The list of directories to watch.
+ * @param extensions   Extensions of the files to report (i.e. ".fpl", ".ini").
+ * @param debounceTime Time (in ms) with no changes for a file to be reported.
+ */
+condor2nav::CDirectoryWatcher::CDirectoryWatcher(const CPathList &dirList, CExtensionList extensions, unsigned debounceTime) :
+  _extensions{std::move(extensions)}, _debounceTime{debounceTime}
+{
+#if defined(_WIN32) || defined(__linux__)
+  try {
+    _impl = std::make_unique<CNativeImpl>(dirList);
+  }
+  catch(const Exception &) {
+  }
+#endif
+  if(!_impl)
+    _impl = std::make_unique<CPollImpl>(dirList);
+}
+
+
+/**
+* @brief Class destructor
+*
+* NOTE: Destructor definition is needed here to make sure that CImpl is defined.
+*/
+condor2nav::CDirectoryWatcher::~CDirectoryWatcher()
+{
+}
+
+
+/**
+ * @brief Checks watcher type.
+ *
+ * @return @p true if operating system notifications are used or @p false if directories are polled.
+ */
+bool condor2nav::CDirectoryWatcher::Native() const
+{
+  return _impl->Native();
+}
+
+
+/**
+ * @brief Watches directories.
+ *
+ * Method waits for directories changes and calls provided callback for every file that was
+ * created or modified. The file is reported when it was not modified for a debounce time.
+ * Method returns when abort function returns @p true.
+ *
+ * @param callback Function to call for every created or modified file.
+ * @param abort    Function to call to check if watching should be finished.
+ */
+void condor2nav::CDirectoryWatcher::Run(const CCallback &callback, const std::function<bool()> &abort)
+{
+  using clock = std::chrono::steady_clock;
+  const std::chrono::milliseconds debounce{_debounceTime};
+  std::map<bfs::path, clock::time_point> pending;
+
+  while(!abort()) {
+    // wait until the next pending file is ready or at most until abort check
+    auto timeout = std::chrono::milliseconds{IDLE_TIMEOUT};
+    auto now = clock::now();
+    for(const auto &file : pending) {
+      const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(file.second + debounce - now);
+      timeout = (std::max)(std::chrono::milliseconds{0}, (std::min)(timeout, left));
+    }
+
+    for(const auto &path : _impl->Wait(static_cast<unsigned>(timeout.count()))) {
+      const CStringNoCase extension{path.extension().string().c_str()};
+      if(std::any_of(begin(_extensions), end(_extensions), [&](const std::string &ext){ return extension == ext.c_str(); }))
+        pending[path] = clock::now();
+    }
+
+    // report files that did not change for a debounce time
+    now = clock::now();
+    for(auto it = pending.begin(); it != pending.end(); ) {
+      if(now - it->second >= debounce) {
+        const auto path = it->first;
+        it = pending.erase(it);
+        boost::system::error_code ec;
+        if(bfs::is_regular_file(path, ec))
+          callback(path);
+      }
+      else
+        ++it;
+    }
+  }
+}
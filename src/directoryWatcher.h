@@ -0,0 +1,72 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file directoryWatcher.h
+ *
+ * @brief Declares the condor2nav::CDirectoryWatcher class. 
+ */
+
+#ifndef __DIRECTORYWATCHER_H__
+#define __DIRECTORYWATCHER_H__
+
+#include "nonCopyable.h"
+#include "boostfwd.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Directory watcher.
+   *
+   * condor2nav::CDirectoryWatcher class waits for files with specified extensions
+   * to be created or modified in a set of directories. Operating system change
+   * notifications are used when available (ReadDirectoryChangesW() on Windows,
+   * inotify on Linux) with periodic directory polling as a fallback. Bursts of
+   * changes are debounced so that each file is reported once after it was written.
+   */
+  class CDirectoryWatcher : CNonCopyable {
+  public:
+    using CPathList = std::vector<bfs::path>;
+    using CExtensionList = std::vector<std::string>;
+    using CCallback = std::function<void(const bfs::path &filePath)>;
+
+    class CImpl;
+
+  private:
+    const CExtensionList _extensions;             ///< @brief Extensions of watched files.
+    const unsigned _debounceTime;                 ///< @brief Time (in ms) with no changes for a file to be reported.
+    std::unique_ptr<CImpl> _impl;                 ///< @brief Platform specific implementation.
+
+  public:
+    CDirectoryWatcher(const CPathList &dirList, std::string extension, unsigned debounceTime);
+    CDirectoryWatcher(const CPathList &dirList, CExtensionList extensions, unsigned debounceTime);
+    ~CDirectoryWatcher();
+    bool Native() const;
+    void Run(const CCallback &callback, const std::function<bool()> &abort);
+  };
+
+}
+
+#endif /* __DIRECTORYWATCHER_H__ */
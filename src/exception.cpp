@@ -43,7 +43,7 @@ condor2nav::Exception::Exception(std::string error):
  *
  * @return Exception description. 
  */
-const char *condor2nav::Exception::what() const
+const char *condor2nav::Exception::what() const throw()
 {
   return _error.c_str();
 }
@@ -31,6 +31,18 @@
 #include <exception>
 #include <string>
 
+/**
+ * @brief Marks a destructor that may throw.
+ *
+ * Since C++11 destructors are implicitly non-throwing. Visual C++ 2013
+ * does not support noexcept specification (and does not need it).
+ */
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define CONDOR2NAV_DTOR_THROWS
+#else
+#define CONDOR2NAV_DTOR_THROWS noexcept(false)
+#endif
+
 namespace condor2nav {
 
   /**
@@ -41,7 +53,7 @@ namespace condor2nav {
   public:
     explicit Exception(std::string error);
     Exception &operator=(const Exception &) = delete;
-    const char *what() const override;
+    const char *what() const throw() override;
   };
 
 
@@ -33,56 +33,6 @@
 #include <string>
 
 
-namespace {
-
-  /**
-  * @brief Parses the line as CSV (Comma Separated Values).
-  *
-  * Method parses the line as CSV (Comma Separated Values).
-  *
-  * @param line            The line to parse.
-  *
-  * @return Parsed values.
-  */
-  std::vector<std::string> LineParseCSV(const std::string &line)
-  {
-    using namespace condor2nav;
-    std::vector<std::string> values;
-    bool insideQuote = false;
-    size_t pos = 0, newValuePos = 0;
-    do {
-      auto posOld = pos;
-      if(insideQuote) {
-        pos = line.find_first_of("\"", posOld);
-        insideQuote = false;
-      }
-      else {
-        pos = line.find_first_of(",\"", posOld);
-        if(pos != std::string::npos && line[pos] == '\"') {
-          insideQuote = true;
-        }
-        else {
-          auto len = (pos != std::string::npos) ? (pos - newValuePos) : pos;
-          auto value = line.substr(newValuePos, len);
-          Trim(value);
-          if(!value.empty() && value[0] == '\"')
-            // remove quotes
-            value = value.substr(1, value.size() - 2);
-          values.emplace_back(std::move(value));
-          if(pos != std::string::npos)
-            newValuePos = pos + 1;
-        }
-      }
-      if(pos != std::string::npos)
-        pos++;
-    }
-    while(pos != std::string::npos);
-
-    return values;
-  }
-
-}
-
 /**
  * @brief Class constructor.
  *
@@ -94,17 +44,66 @@ condor2nav::CFileParserCSV::CFileParserCSV(bfs::path filePath) :
   _filePath{std::move(filePath)}
 {
   // open CSV file
-  CIStream inputStream{filePath};
+  CIStream inputStream{_filePath};
 
   // parse all lines
   std::string line;
   while(inputStream.GetLine(line)) {
     if(line.empty())
       continue;
-    _rowsList.emplace_back(LineParseCSV(line));
+    _rowsList.emplace_back(LineParse(line));
   }
-  if(_rowsList.front().size() <= 1)
-    throw EOperationFailed{"ERROR: File '" + filePath.string() + "' does not look like a CSV File!!"};
+  if(_rowsList.empty() || _rowsList.front().size() <= 1)
+    throw EOperationFailed{"ERROR: File '" + _filePath.string() + "' does not look like a CSV File!!"};
+}
+
+
+/**
+ * @brief Parses the line as CSV (Comma Separated Values).
+ *
+ * Method parses the line as CSV (Comma Separated Values).
+ *
+ * @param line            The line to parse.
+ *
+ * @return Parsed values.
+ */
+auto condor2nav::CFileParserCSV::LineParse(const std::string &line) -> CStringArray
+{
+  CStringArray values;
+  bool insideQuote = false;
+  size_t pos = 0, newValuePos = 0;
+  do {
+    auto posOld = pos;
+    if(insideQuote) {
+      pos = line.find_first_of("\"", posOld);
+      insideQuote = false;
+    }
+    else {
+      pos = line.find_first_of(",\"", posOld);
+      if(pos != std::string::npos && line[pos] == '\"') {
+        insideQuote = true;
+      }
+      else {
+        auto len = (pos != std::string::npos) ? (pos - newValuePos) : pos;
+        auto value = line.substr(newValuePos, len);
+        Trim(value);
+        if(!value.empty() && value[0] == '\"') {
+          // remove quotes and unescape doubled quotes
+          value = value.substr(1, value.size() - 2);
+          for(auto quote = value.find("\"\""); quote != std::string::npos; quote = value.find("\"\"", quote + 1))
+            value.erase(quote, 1);
+        }
+        values.emplace_back(std::move(value));
+        if(pos != std::string::npos)
+          newValuePos = pos + 1;
+      }
+    }
+    if(pos != std::string::npos)
+      pos++;
+  }
+  while(pos != std::string::npos);
+
+  return values;
 }
 
 
@@ -142,11 +141,52 @@ auto condor2nav::CFileParserCSV::Row(const std::string &value, unsigned column /
  * @return Requested row.
  */
 auto condor2nav::CFileParserCSV::Row(const std::string &value, unsigned column /* = 0 */, bool nocase /* = false */) -> CStringArray &
+{
+  if(auto row = TryRow(value, column, nocase))
+    return *row;
+  throw EOperationFailed{"ERROR: Couldn't find value '" + value + "' in column '" + Convert(column) + "' of CSV file '" + Path().string() + "'!!!"};
+}
+
+
+/**
+ * @brief Returns requested row if present.
+ *
+ * Method returns the values from one row specified by the value in specified column.
+ * Contrary to Row() it does not throw when the row is missing.
+ *
+ * @param value  The value to use for searching.
+ * @param column The column index to be used for value comparison.
+ * @param nocase Specifies if a search should be case sensitive.
+ *
+ * @return Requested row or boost::none if not found.
+ */
+auto condor2nav::CFileParserCSV::TryRow(const std::string &value, unsigned column /* = 0 */, bool nocase /* = false */) const -> boost::optional<const CStringArray &>
+{
+  auto nonConst = const_cast<CFileParserCSV *>(this);
+  if(auto row = nonConst->TryRow(value, column, nocase))
+    return *row;
+  return boost::none;
+}
+
+
+/**
+ * @brief Returns requested row if present.
+ *
+ * Method returns the values from one row specified by the value in specified column.
+ * Contrary to Row() it does not throw when the row is missing.
+ *
+ * @param value  The value to use for searching.
+ * @param column The column index to be used for value comparison.
+ * @param nocase Specifies if a search should be case sensitive.
+ *
+ * @return Requested row or boost::none if not found.
+ */
+auto condor2nav::CFileParserCSV::TryRow(const std::string &value, unsigned column /* = 0 */, bool nocase /* = false */) -> boost::optional<CStringArray &>
 {
   for(auto &row : _rowsList)
     if(row.at(column) == value || (nocase && row[column].c_str() == CStringNoCase{value.c_str()}))
       return row;
-  throw EOperationFailed{"ERROR: Couldn't find value '" + value + "' in column '" + Convert(column) + "' of CSV file '" + Path().string() + "'!!!"};
+  return boost::none;
 }
 
 
@@ -190,7 +230,15 @@ void condor2nav::CFileParserCSV::Dump(const bfs::path &filePath /* = "" */) cons
     for(size_t i = 0; i < row.size(); ++i) {
       if(i)
         ostream << ",";
-      ostream << row[i];
+      if(row[i].find_first_of(",\"") != std::string::npos) {
+        // values with commas (i.e. glider flaps) are quoted in the input file
+        std::string value = row[i];
+        for(auto quote = value.find('\"'); quote != std::string::npos; quote = value.find('\"', quote + 2))
+          value.insert(quote, 1, '\"');
+        ostream << "\"" << value << "\"";
+      }
+      else
+        ostream << row[i];
     }
     ostream << std::endl;
   }
@@ -34,6 +34,7 @@
 #include <vector>
 #include <string>
 #include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
 
 namespace condor2nav {
 
@@ -54,10 +55,14 @@ namespace condor2nav {
     CRowsList _rowsList;	                       ///< @brief The list of file rows.
 
   public:
+    static CStringArray LineParse(const std::string &line);
+
     explicit CFileParserCSV(bfs::path filePath);
     const bfs::path &Path() const { return _filePath; }
     const CStringArray &Row(const std::string &value, unsigned column = 0, bool nocase = false) const;
     CStringArray &Row(const std::string &value, unsigned column = 0, bool nocase = false);
+    boost::optional<const CStringArray &> TryRow(const std::string &value, unsigned column = 0, bool nocase = false) const;
+    boost::optional<CStringArray &> TryRow(const std::string &value, unsigned column = 0, bool nocase = false);
     const CRowsList &Rows() const;
     CRowsList &Rows();
     void Dump(const bfs::path &filePath = "") const;
@@ -26,8 +26,12 @@
  */
 
 #include "fileParserINI.h"
+#include "deviceTransport.h"
 #include "istream.h"
 #include "ostream.h"
+#include "translationCache.h"
+#include <algorithm>
+#include <vector>
 
 
 namespace {
@@ -56,6 +60,26 @@ namespace {
     return ret;
   }
 
+
+  /**
+  * @brief Converts line endings to CRLF.
+  *
+  * @param text The text with LF line endings.
+  *
+  * @return The text with CRLF line endings.
+  */
+  std::string CrlfEndings(const std::string &text)
+  {
+    std::string ret;
+    ret.reserve(text.size() + std::count(text.begin(), text.end(), '\n'));
+    for(auto c : text) {
+      if(c == '\n')
+        ret += '\r';
+      ret += c;
+    }
+    return ret;
+  }
+
 }
 
 /**
@@ -66,10 +90,10 @@ namespace {
  * @param filePath The path of the INI file to parse.
  */
 condor2nav::CFileParserINI::CFileParserINI(bfs::path filePath) :
-  _filePath{std::move(filePath)}
+  _filePath{std::move(filePath)}, _global(), _crlf{false}, _exact{true}
 {
   // open input INI file
-  CIStream inputStream{filePath};
+  CIStream inputStream{_filePath};
   Parse(inputStream);
 }
 
@@ -83,17 +107,47 @@ condor2nav::CFileParserINI::CFileParserINI(bfs::path filePath) :
  * @param url The path on the server to the INI file.
  */
 condor2nav::CFileParserINI::CFileParserINI(const std::string &server, const bfs::path &url) :
-  _filePath{server + url.generic_string()}
+  _filePath{server + url.generic_string()}, _global(), _crlf{false}, _exact{true}
 {
   CIStream inputStream{server, url.generic_string()};
   Parse(inputStream);
 }
 
 
+/**
+ * @brief Class copy constructor.
+ *
+ * condor2nav::CFileParserINI class copy constructor. Private to make all copies
+ * explicit with Clone() method.
+ *
+ * @param parser The parser to copy.
+ */
+condor2nav::CFileParserINI::CFileParserINI(const CFileParserINI &parser) :
+  CNonCopyable{}, _filePath{parser._filePath}, _global(parser._global), _chaptersList{parser._chaptersList},
+  _source{parser._source}, _crlf{parser._crlf}, _exact{parser._exact}
+{
+}
+
+
+/**
+ * @brief Creates a copy of the parser.
+ *
+ * Method creates an independent copy of parsed data. It is used to modify
+ * cached templates without parsing the file again.
+ *
+ * @return Parser copy.
+ */
+std::unique_ptr<condor2nav::CFileParserINI> condor2nav::CFileParserINI::Clone() const
+{
+  return std::unique_ptr<CFileParserINI>{new CFileParserINI{*this}};
+}
+
+
 /**
  * @brief INI file parser.
  *
- * Parses INI file.
+ * Parses INI file. The content of the file and the positions of all the values
+ * are remembered for Patch().
  *
  * @param inputStream Input stream to use for reading.
  */
@@ -101,8 +155,13 @@ void condor2nav::CFileParserINI::Parse(CIStream &inputStream)
 {
   // parse all lines
   std::string line;
-  CValuesMap *currentMap = &_valuesMap;
+  TChapter *current = &_global;
   while(inputStream.GetLine(line)) {
+    const auto offset = _source.size();
+    _source += line;
+    if(!inputStream.Eof())
+      _source += '\n';
+
     if(line.empty())
       continue;
 
@@ -120,19 +179,68 @@ void condor2nav::CFileParserINI::Parse(CIStream &inputStream)
       if(pos2 == std::string::npos)
         throw EOperationFailed{"ERROR: ']' not found in file line '" + line + "' in '" + Path().string() + "' INI !!!"};
       
-      TChapter chapter;
+      TChapter chapter{};
       chapter.name = line.substr(1, pos2 - 1);
       Trim(chapter.name);
+      chapter.end = _source.size();
       _chaptersList.emplace_back(std::move(chapter));
-      currentMap = &_chaptersList.back().valuesMap;
+      current = &_chaptersList.back();
       continue;
     }
     
     // add new entry
-    auto ret = currentMap->insert(LineParseKeyValue(line));
+    auto ret = current->valuesMap.insert(LineParseKeyValue(line));
     if(!ret.second)
        throw EOperationFailed{"ERROR: Entry '" + ret.first->first + "' provided more than once in '" + Path().string() + "' INI file!!!"};
+
+    // remember where the value is
+    const auto &value = ret.first->second;
+    const auto valuePos = line.find_first_of("=") + 1;
+    const auto pos2 = value.empty() ? valuePos : line.find(value, valuePos);
+    current->spansMap[ret.first->first] = TSpan{offset + pos2, value.size()};
+    current->end = _source.size();
   }
+
+  // line endings are recreated only if all of them were the same
+  const auto lines = static_cast<size_t>(std::count(_source.begin(), _source.end(), '\n'));
+  _crlf = inputStream.Crlf() > 0;
+  _exact = !_crlf || inputStream.Crlf() == lines;
+}
+
+
+/**
+ * @brief Finds requested chapter.
+ *
+ * Method looks for the chapter specified by the @p chapter parameter.
+ * 
+ * @param chapter The chapter name to find ("" means global scope).
+ *
+ * @return Requested chapter or nullptr if not found.
+ */
+auto condor2nav::CFileParserINI::FindChapter(const std::string &chapter) -> TChapter *
+{
+  if(chapter == "")
+    return &_global;
+  for(auto &ch : _chaptersList)
+    if(ch.name == chapter)
+      return &ch;
+  return nullptr;
+}
+
+
+/**
+ * @brief Finds requested chapter.
+ *
+ * Method looks for the chapter specified by the @p chapter parameter.
+ * 
+ * @param chapter The chapter name to find.
+ *
+ * @return Requested chapter or nullptr if not found.
+ */
+auto condor2nav::CFileParserINI::FindChapter(const std::string &chapter) const -> const TChapter *
+{
+  auto nonConst = const_cast<CFileParserINI *>(this);
+  return nonConst->FindChapter(chapter);
 }
 
 
@@ -149,9 +257,8 @@ void condor2nav::CFileParserINI::Parse(CIStream &inputStream)
  */
 auto condor2nav::CFileParserINI::Chapter(const std::string &chapter) -> TChapter &
 {
-  for(auto &ch : _chaptersList)
-    if(ch.name == chapter)
-      return ch;
+  if(auto ch = FindChapter(chapter))
+    return *ch;
   throw EOperationFailed{"ERROR: Chapter '" + chapter + "' not found in '" + Path().string() + "' INI file!!!"};
 }
 
@@ -189,7 +296,7 @@ auto condor2nav::CFileParserINI::Chapter(const std::string &chapter) const -> co
  */
 const std::string &condor2nav::CFileParserINI::Value(const std::string &chapter, const std::string &key) const
 {
-  const CValuesMap &map = (chapter != "") ? Chapter(chapter).valuesMap : _valuesMap;
+  const CValuesMap &map = Chapter(chapter).valuesMap;
   auto it = map.find(key);
   if(it == map.end())
     throw EOperationFailed{"ERROR: Entry '" + key + "' not found in '" + Path().string() + "' INI file!!!"};
@@ -197,10 +304,36 @@ const std::string &condor2nav::CFileParserINI::Value(const std::string &chapter,
 }
 
 
+/**
+ * @brief Returns requested value if present. 
+ *
+ * Method returns the value specified by the chapter and key name. Contrary to Value()
+ * it does not throw when the chapter or key is missing so it should be used for
+ * optional entries. To search in global scope (no chapters) "" should be provided
+ * for @p chapter.
+ * 
+ * @param chapter The chapter name to find ("" means to look in global scope).
+ * @param key     The key name o find.
+ *
+ * @return Requested value or boost::none if not found.
+ */
+boost::optional<const std::string &> condor2nav::CFileParserINI::TryValue(const std::string &chapter, const std::string &key) const
+{
+  auto ch = FindChapter(chapter);
+  if(!ch)
+    return boost::none;
+  auto it = ch->valuesMap.find(key);
+  if(it == ch->valuesMap.end())
+    return boost::none;
+  return it->second;
+}
+
+
 /**
  * @brief Sets specified value.
  *
- * Method sets the value for the provided chapter and its key.
+ * Method sets the value for the provided chapter and its key. The key is marked
+ * as modified only if the value is different than the current one.
  *
  * @param chapter The chapter name of the value.
  * @param key     The key name. 
@@ -210,8 +343,30 @@ void condor2nav::CFileParserINI::Value(const std::string &chapter, const std::st
 {
   if(key == "")
     throw EOperationFailed{"ERROR: Cannot set value for empty key in INI file!!!"};
-  CValuesMap &map = (chapter != "") ? Chapter(chapter).valuesMap : _valuesMap;
-  map[key] = std::move(value);
+  auto &ch = Chapter(chapter);
+  auto &current = ch.valuesMap[key];
+  if(current != value || !ch.spansMap.count(key)) {
+    current = std::move(value);
+    ch.dirty.insert(key);
+  }
+}
+
+
+/**
+ * @brief Returns all values of a chapter.
+ *
+ * Method returns all key=value pairs of the chapter. To get global
+ * scope values (no chapters) "" should be provided for @p chapter.
+ *
+ * @param chapter The chapter name to find ("" means global scope).
+ *
+ * @exception std Thrown when chapter not found.
+ *
+ * @return Chapter values.
+ */
+auto condor2nav::CFileParserINI::Values(const std::string &chapter) const -> const CValuesMap &
+{
+  return Chapter(chapter).valuesMap;
 }
 
 
@@ -226,12 +381,12 @@ void condor2nav::CFileParserINI::Dump(const bfs::path &filePath /* = "" */) cons
 {
   COStream ostream{filePath.empty() ? Path() : filePath};
   // dump global scope
-  for(const auto &v : _valuesMap)
+  for(const auto &v : _global.valuesMap)
     ostream << v.first << "=" << v.second << std::endl;
 
   // dump chapters
   for(auto it=_chaptersList.begin(); it!=_chaptersList.end(); ++it) {
-    if(it != _chaptersList.begin() || _valuesMap.size())
+    if(it != _chaptersList.begin() || _global.valuesMap.size())
       ostream << std::endl;
 
     ostream << "[" << it->name << "]" << std::endl;
@@ -239,3 +394,82 @@ void condor2nav::CFileParserINI::Dump(const bfs::path &filePath /* = "" */) cons
       ostream << v.first << "=" << v.second << std::endl;
   }
 }
+
+
+/**
+* @brief Writes modified data to the file.
+*
+* Method writes the file with exactly the same layout as the input file has
+* (order of entries, comments, spacing and line endings). Only the values modified
+* with Value() are replaced and new entries are added at the end of their chapters.
+* If the input file on the device is overwritten only the part of the file
+* from the first to the last modified byte is sent.
+*
+* @param filePath Path of the file to create (empty means overwrite input file).
+*
+* @return Patch statistics.
+*/
+auto condor2nav::CFileParserINI::Patch(const bfs::path &filePath /* = "" */) const -> TPatchStats
+{
+  /**
+   * @brief Replacement of a part of input file.
+   */
+  struct TChange {
+    size_t offset;
+    size_t size;
+    std::string text;
+  };
+  std::vector<TChange> changes;
+
+  const auto collect = [&](const TChapter &chapter) {
+    std::string added;
+    for(const auto &key : chapter.dirty) {
+      const auto &value = chapter.valuesMap.at(key);
+      const auto it = chapter.spansMap.find(key);
+      if(it != chapter.spansMap.end())
+        changes.push_back(TChange{it->second.offset, it->second.size, value});
+      else
+        added += key + "=" + value + "\n";
+    }
+    if(!added.empty()) {
+      if(chapter.end && _source[chapter.end - 1] != '\n')
+        added.insert(0, "\n");
+      changes.push_back(TChange{chapter.end, 0, std::move(added)});
+    }
+  };
+  collect(_global);
+  for(const auto &chapter : _chaptersList)
+    collect(chapter);
+  std::stable_sort(changes.begin(), changes.end(), [](const TChange &l, const TChange &r){ return l.offset < r.offset; });
+
+  // copy not modified parts of input file
+  std::string data;
+  size_t pos = 0;
+  for(const auto &change : changes) {
+    data.append(_source, pos, change.offset - pos);
+    data += change.text;
+    pos = change.offset + change.size;
+  }
+  data.append(_source, pos, std::string::npos);
+  if(_crlf)
+    data = CrlfEndings(data);
+
+  const auto &path = filePath.empty() ? Path() : filePath;
+  if(path != Path() || !_exact || PathType(path) != TPathType::ACTIVE_SYNC) {
+    COStream{path}.Attach(data.data(), data.size());
+    return TPatchStats{data.size(), data.size()};
+  }
+
+  // input file on the device is not cached so its content is known
+  const auto source = _crlf ? CrlfEndings(_source) : _source;
+  const auto diff = std::mismatch(data.begin(), data.begin() + (std::min)(data.size(), source.size()), source.begin());
+  const auto begin = static_cast<size_t>(diff.first - data.begin());
+  auto end = data.size();
+  if(data.size() == source.size())
+    while(end > begin && data[end - 1] == source[end - 1])
+      --end;
+  if(end > begin || data.size() != source.size())
+    CDeviceTransport::Current()->Patch(path, begin, data.substr(begin, end - begin), data.size());
+  CTranslationCache::CRecorder::OnFileWrite(path, [&]() -> const std::string & { return data; });
+  return TPatchStats{data.size(), end - begin};
+}
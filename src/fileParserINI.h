@@ -33,7 +33,9 @@
 #include <memory>
 #include <deque>
 #include <map>
+#include <set>
 #include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
 
 namespace condor2nav {
 
@@ -46,34 +48,69 @@ namespace condor2nav {
    * provides key=value pairs can be processed with that class. Input file
    * may have those pairs grouped into chapters or provide one plain set
    * of pairs (set "" for chapter name in that case).
+   *
+   * The parser remembers the layout of the input file and the values modified
+   * with Value() so Patch() can write the file back with only modified lines changed.
    */
   class CFileParserINI : CNonCopyable {
+  public:
     using CValuesMap = std::map<std::string, std::string>;	///< @brief The map of key=value pairs. 
 
+    /**
+     * @brief File patch statistics.
+     */
+    struct TPatchStats {
+      size_t size;                                    ///< @brief File size.
+      size_t written;                                 ///< @brief Number of bytes written.
+    };
+
+  private:
+    /**
+     * @brief The position of a value in the input file.
+     */
+    struct TSpan {
+      size_t offset;
+      size_t size;
+    };
+    using CSpansMap = std::map<std::string, TSpan>;
+
     /**
      * @brief INI file chapter data.
      */
     struct TChapter {
       std::string name;
       CValuesMap valuesMap;
+      CSpansMap spansMap;                             ///< @brief Positions of values in the input file.
+      std::set<std::string> dirty;                    ///< @brief The keys of modified values.
+      size_t end;                                     ///< @brief Input file position for new entries.
     };
     using CChaptersList = std::deque<TChapter>;	      ///< @brief The list of INI file chapters.
 
     const bfs::path _filePath;                        ///< @brief Input file path.
-    CValuesMap _valuesMap;	                          ///< @brief The map of plain key=value pairs. 
+    TChapter _global;                                 ///< @brief Plain key=value pairs. 
     CChaptersList _chaptersList;                      ///< @brief The list of chapters and their data found in the file.
+    std::string _source;                              ///< @brief Input file content (with LF line endings).
+    bool _crlf;                                       ///< @brief Input file uses CRLF line endings.
+    bool _exact;                                      ///< @brief Input file content can be recreated byte by byte.
 
     void Parse(CIStream &inputStream);
+    TChapter *FindChapter(const std::string &chapter);
+    const TChapter *FindChapter(const std::string &chapter) const;
     TChapter &Chapter(const std::string &chapter);
     const TChapter &Chapter(const std::string &chapter) const;
+    CFileParserINI(const CFileParserINI &parser);
 
   public:
     explicit CFileParserINI(bfs::path filePath);
     CFileParserINI(const std::string &server, const bfs::path &url);
+    std::unique_ptr<CFileParserINI> Clone() const;
     const bfs::path &Path() const { return _filePath; }
     const std::string &Value(const std::string &chapter, const std::string &key) const;
+    boost::optional<const std::string &> TryValue(const std::string &chapter, const std::string &key) const;
     void Value(const std::string &chapter, const std::string &key, std::string value);
+    const CValuesMap &Values(const std::string &chapter) const;
     void Dump(const bfs::path &filePath = "") const;
+    TPatchStats Patch(const bfs::path &filePath = "") const;
   };
 
 }
@@ -0,0 +1,320 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file geodesy.cpp
+ *
+ * @brief Implements the condor2nav::CGeodesy class. 
+ */
+
+#include "geodesy.h"
+#include "tools.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CONDOR2NAV_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+  const double PI = 3.14159265358979323846;
+
+  // PI/2 split for exact range reduction (fdlibm)
+  const double PIO2_1  = 1.57079632673412561417e+00;
+  const double PIO2_2  = 6.07710050630396597660e-11;
+  const double PIO2_2T = 2.02226624879595063154e-21;
+
+  // sin() and cos() minimax polynomials on -PI/4..PI/4 (Cephes)
+  const double SIN_COEFFS[] = {
+    1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+    -1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1
+  };
+  const double COS_COEFFS[] = {
+    -1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+    2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2
+  };
+
+  // atan() rational approximation on 0..0.66 (Cephes)
+  const double ATAN_P[] = {
+    -8.750608600031904122785e-1, -1.615753718733365076637e1, -7.500855792314704667340e1,
+    -1.228866684490136173410e2, -6.485021904942025371773e1
+  };
+  const double ATAN_Q[] = {
+    2.485846490142306297962e1, 1.650270098316988542046e2, 4.328810604912902668951e2,
+    4.853903996359136964868e2, 1.945506571482613964425e2
+  };
+  const double ATAN_MOREBITS = 6.123233995736765886130e-17;
+
+#ifdef CONDOR2NAV_SSE2
+
+  /**
+   * @brief Selects values with a mask.
+   *
+   * @param mask  Selection mask.
+   * @param value1 Values selected for set mask bits.
+   * @param value2 Values selected for cleared mask bits.
+   *
+   * @return Selected values.
+   */
+  inline __m128d Select(__m128d mask, __m128d value1, __m128d value2)
+  {
+    return _mm_or_pd(_mm_and_pd(mask, value1), _mm_andnot_pd(mask, value2));
+  }
+
+  /**
+   * @brief Evaluates the polynomial with Horner's method.
+   *
+   * @param x      Polynomial argument.
+   * @param coeffs Polynomial coefficients (the highest power first).
+   * @param num    The number of coefficients.
+   *
+   * @return Polynomial value.
+   */
+  inline __m128d Polynomial(__m128d x, const double *coeffs, unsigned num)
+  {
+    auto result = _mm_set1_pd(coeffs[0]);
+    for(unsigned i=1; i<num; i++)
+      result = _mm_add_pd(_mm_mul_pd(result, x), _mm_set1_pd(coeffs[i]));
+    return result;
+  }
+
+#endif
+
+}
+
+
+const double condor2nav::CGeodesy::MAX_ERROR = 1e-14;
+
+
+/**
+ * @brief Calculates sine and cosine of angles.
+ *
+ * Method calculates sine and cosine of provided angles. Angles are reduced to
+ * -PI/4..PI/4 range and polynomial approximations are used.
+ *
+ * @param angle Angles (in radians).
+ * @param sin   Sine of angles.
+ * @param cos   Cosine of angles.
+ * @param num   The number of angles.
+ */
+void condor2nav::CGeodesy::SinCos(const double *angle, double *sin, double *cos, size_t num)
+{
+  size_t i = 0;
+
+#ifdef CONDOR2NAV_SSE2
+  const auto twoOverPi = _mm_set1_pd(2 / PI);
+  const auto signMask = _mm_set1_pd(-0.0);
+  const auto one = _mm_set1_pd(1.0);
+  const auto two = _mm_set1_pd(2.0);
+  const auto half = _mm_set1_pd(0.5);
+  const auto qMask1 = _mm_set1_epi32(1);
+  const auto qMask2 = _mm_set1_epi32(2);
+  for(; i + 2 <= num; i += 2) {
+    const auto x = _mm_loadu_pd(angle + i);
+
+    // quadrant and reduced angle
+    const auto q = _mm_cvtpd_epi32(_mm_mul_pd(x, twoOverPi));
+    const auto qd = _mm_cvtepi32_pd(q);
+    auto r = _mm_sub_pd(x, _mm_mul_pd(qd, _mm_set1_pd(PIO2_1)));
+    r = _mm_sub_pd(r, _mm_mul_pd(qd, _mm_set1_pd(PIO2_2)));
+    r = _mm_sub_pd(r, _mm_mul_pd(qd, _mm_set1_pd(PIO2_2T)));
+
+    const auto zz = _mm_mul_pd(r, r);
+    const auto sinR = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, zz), Polynomial(zz, SIN_COEFFS, 6)));
+    const auto cosR = _mm_add_pd(_mm_sub_pd(one, _mm_mul_pd(half, zz)), _mm_mul_pd(_mm_mul_pd(zz, zz), Polynomial(zz, COS_COEFFS, 6)));
+
+    const auto swap = _mm_cmpeq_pd(_mm_cvtepi32_pd(_mm_and_si128(q, qMask1)), one);
+    const auto sinNeg = _mm_cmpeq_pd(_mm_cvtepi32_pd(_mm_and_si128(q, qMask2)), two);
+    const auto cosNeg = _mm_cmpeq_pd(_mm_cvtepi32_pd(_mm_and_si128(_mm_add_epi32(q, qMask1), qMask2)), two);
+    _mm_storeu_pd(sin + i, _mm_xor_pd(Select(swap, cosR, sinR), _mm_and_pd(sinNeg, signMask)));
+    _mm_storeu_pd(cos + i, _mm_xor_pd(Select(swap, sinR, cosR), _mm_and_pd(cosNeg, signMask)));
+  }
+#endif
+
+  for(; i < num; i++) {
+    sin[i] = std::sin(angle[i]);
+    cos[i] = std::cos(angle[i]);
+  }
+}
+
+
+/**
+ * @brief Calculates arc tangent of y/x.
+ *
+ * Method calculates arc tangent of y/x using the signs of arguments to determine
+ * the quadrant of the result (as std::atan2() does). The ratio of arguments is
+ * reduced to 0..1 range and rational approximation is used.
+ *
+ * @param y     Y coordinates.
+ * @param x     X coordinates.
+ * @param angle Angles (in radians, -PI..PI range).
+ * @param num   The number of angles.
+ */
+void condor2nav::CGeodesy::Atan2(const double *y, const double *x, double *angle, size_t num)
+{
+  size_t i = 0;
+
+#ifdef CONDOR2NAV_SSE2
+  const auto signMask = _mm_set1_pd(-0.0);
+  const auto zero = _mm_setzero_pd();
+  const auto one = _mm_set1_pd(1.0);
+  const auto pio4 = _mm_set1_pd(PI / 4);
+  const auto pio2 = _mm_set1_pd(PI / 2);
+  const auto pi = _mm_set1_pd(PI);
+  for(; i + 2 <= num; i += 2) {
+    const auto vy = _mm_loadu_pd(y + i);
+    const auto vx = _mm_loadu_pd(x + i);
+    const auto ay = _mm_andnot_pd(signMask, vy);
+    const auto ax = _mm_andnot_pd(signMask, vx);
+
+    // ratio in 0..1 range (0 for both arguments equal to 0)
+    const auto mx = _mm_max_pd(ax, ay);
+    const auto a = _mm_and_pd(_mm_div_pd(_mm_min_pd(ax, ay), mx), _mm_cmpneq_pd(mx, zero));
+
+    // atan() of the ratio
+    const auto big = _mm_cmpgt_pd(a, _mm_set1_pd(0.66));
+    const auto t = Select(big, _mm_div_pd(_mm_sub_pd(a, one), _mm_add_pd(a, one)), a);
+    const auto z = _mm_mul_pd(t, t);
+    const auto p = Polynomial(z, ATAN_P, 5);
+    const auto q = _mm_add_pd(_mm_mul_pd(_mm_add_pd(z, _mm_set1_pd(ATAN_Q[0])), z), _mm_set1_pd(ATAN_Q[1]));
+    const auto q2 = _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(q, z), _mm_set1_pd(ATAN_Q[2])), z), _mm_set1_pd(ATAN_Q[3]));
+    const auto q3 = _mm_add_pd(_mm_mul_pd(q2, z), _mm_set1_pd(ATAN_Q[4]));
+    auto r = _mm_add_pd(_mm_mul_pd(_mm_mul_pd(t, z), _mm_div_pd(p, q3)), t);
+    r = _mm_add_pd(_mm_and_pd(big, pio4), _mm_add_pd(r, _mm_and_pd(big, _mm_set1_pd(0.5 * ATAN_MOREBITS))));
+
+    // quadrant
+    r = Select(_mm_cmpgt_pd(ay, ax), _mm_sub_pd(pio2, r), r);
+    r = Select(_mm_cmplt_pd(vx, zero), _mm_sub_pd(pi, r), r);
+    _mm_storeu_pd(angle + i, _mm_or_pd(r, _mm_and_pd(vy, signMask)));
+  }
+#endif
+
+  for(; i < num; i++)
+    angle[i] = std::atan2(y[i], x[i]);
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CGeodesy class constructor. Converts all locations to unit vectors.
+ *
+ * @param points Locations to convert.
+ */
+condor2nav::CGeodesy::CGeodesy(const CPointArray &points) :
+  _vectors(points.size())
+{
+  const auto num = points.size();
+  std::vector<double> buffer(6 * num);
+  const auto lat = buffer.data(), lon = lat + num;
+  const auto sinLat = lon + num, cosLat = sinLat + num, sinLon = cosLat + num, cosLon = sinLon + num;
+  for(size_t i=0; i<num; i++) {
+    lat[i] = Deg2Rad(points[i].latitude);
+    lon[i] = Deg2Rad(points[i].longitude);
+  }
+  SinCos(lat, sinLat, cosLat, num);
+  SinCos(lon, sinLon, cosLon, num);
+
+  for(size_t i=0; i<num; i++) {
+    auto &v = _vectors[i];
+    v.x = cosLat[i] * cosLon[i];
+    v.y = cosLat[i] * sinLon[i];
+    v.z = sinLat[i];
+    v.nx = -sinLat[i] * cosLon[i];
+    v.ny = -sinLat[i] * sinLon[i];
+    v.nz = cosLat[i];
+    v.ex = -sinLon[i];
+    v.ey = cosLon[i];
+  }
+}
+
+
+/**
+ * @brief Returns the number of locations.
+ *
+ * @return The number of locations.
+ */
+size_t condor2nav::CGeodesy::Size() const
+{
+  return _vectors.size();
+}
+
+
+/**
+ * @brief Calculates bearings and central angles.
+ *
+ * Method calculates the initial great-circle bearing and the central angle
+ * (distance on the unit sphere) for provided pairs of locations.
+ *
+ * @param pairs   Indexes of locations pairs.
+ * @param num     The number of pairs.
+ * @param bearing Initial bearings (in degrees, 0..360 range).
+ * @param angle   Central angles (in radians).
+ */
+void condor2nav::CGeodesy::Bearings(const TPair *pairs, size_t num, double *bearing, double *angle) const
+{
+  double east[CHUNK_SIZE], north[CHUNK_SIZE], cross[CHUNK_SIZE], dot[CHUNK_SIZE];
+  for(size_t begin=0; begin<num; begin+=CHUNK_SIZE) {
+    const auto size = (std::min)(num - begin, static_cast<size_t>(CHUNK_SIZE));
+    for(size_t i=0; i<size; i++) {
+      const auto &a = _vectors[pairs[begin + i].from];
+      const auto &b = _vectors[pairs[begin + i].to];
+      east[i] = b.x * a.ex + b.y * a.ey;
+      north[i] = b.x * a.nx + b.y * a.ny + b.z * a.nz;
+      const double cx = a.y * b.z - a.z * b.y;
+      const double cy = a.z * b.x - a.x * b.z;
+      const double cz = a.x * b.y - a.y * b.x;
+      cross[i] = std::sqrt(cx * cx + cy * cy + cz * cz);
+      dot[i] = a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    Atan2(east, north, bearing + begin, size);
+    Atan2(cross, dot, angle + begin, size);
+    for(size_t i=0; i<size; i++) {
+      auto &b = bearing[begin + i];
+      b = Rad2Deg(b);
+      if(b < 0)
+        b += 360;
+      if(b >= 360)
+        b -= 360;
+    }
+  }
+}
+
+
+/**
+ * @brief Calculates legs between consecutive locations.
+ *
+ * @param bearing Initial bearings of legs (Size() - 1 values in degrees).
+ * @param angle   Central angles of legs (Size() - 1 values in radians).
+ */
+void condor2nav::CGeodesy::Legs(double *bearing, double *angle) const
+{
+  if(_vectors.size() < 2)
+    return;
+  CPairArray pairs;
+  pairs.reserve(_vectors.size() - 1);
+  for(unsigned i=1; i<_vectors.size(); i++)
+    pairs.push_back(TPair{i - 1, i});
+  Bearings(pairs.data(), pairs.size(), bearing, angle);
+}
@@ -0,0 +1,97 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file geodesy.h
+ *
+ * @brief Declares the condor2nav::CGeodesy class. 
+ */
+
+#ifndef __GEODESY_H__
+#define __GEODESY_H__
+
+#include "nonCopyable.h"
+#include <cstddef>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Batch great-circle calculations.
+   *
+   * condor2nav::CGeodesy class converts a set of locations once to unit vectors on the sphere
+   * (together with local north and east directions) so bearings and central angles between
+   * any pairs of those locations are calculated with dot and cross products only. The remaining
+   * trigonometric functions are calculated in batches with polynomial approximations (SSE2 when
+   * available, 2 values at a time).
+   *
+   * The absolute error of SinCos() and Atan2() approximations is below MAX_ERROR radians
+   * for all the arguments used by the class (angles in -2*PI..2*PI range), so bearings are
+   * accurate to about 1e-12 degree compared to the scalar formulas.
+   */
+  class CGeodesy : CNonCopyable {
+  public:
+    /**
+     * @brief Geographic location (in degrees).
+     */
+    struct TPoint {
+      double latitude;
+      double longitude;
+    };
+    using CPointArray = std::vector<TPoint>;
+
+    /**
+     * @brief The pair of locations indexes.
+     */
+    struct TPair {
+      unsigned from;
+      unsigned to;
+    };
+    using CPairArray = std::vector<TPair>;
+
+    static const double MAX_ERROR;          ///< @brief Absolute error bound of trigonometric approximations (in radians)
+
+    static void SinCos(const double *angle, double *sin, double *cos, size_t num);
+    static void Atan2(const double *y, const double *x, double *angle, size_t num);
+
+  private:
+    static const unsigned CHUNK_SIZE = 64;  ///< @brief The number of pairs processed in one batch
+
+    /**
+     * @brief Location on the unit sphere with its local north and east directions.
+     */
+    struct TVector {
+      double x, y, z;                       ///< @brief Unit vector
+      double nx, ny, nz;                    ///< @brief North direction
+      double ex, ey;                        ///< @brief East direction (always horizontal)
+    };
+    std::vector<TVector> _vectors;          ///< @brief Converted locations
+
+  public:
+    explicit CGeodesy(const CPointArray &points);
+    size_t Size() const;
+    void Bearings(const TPair *pairs, size_t num, double *bearing, double *angle) const;
+    void Legs(double *bearing, double *angle) const;
+  };
+
+}
+
+#endif /* __GEODESY_H__ */
@@ -30,17 +30,19 @@
 #include "resource.h"
 #include "translator.h"
 #include "condor.h"
+#include <boost/filesystem/operations.hpp>
 #include <array>
+#include <chrono>
 
 
 /**
  * @brief Class constructor.
  *
  * @param type   The logger type.
- * @param hDlg   Main dialog window handle.
+ * @param gui    The application owning the logging window.
  */
-condor2nav::gui::CCondor2NavGUI::CLogger::CLogger(TType type, HWND hDlg) :
-  condor2nav::CCondor2Nav::CLogger{type}, _hDlg{hDlg}
+condor2nav::gui::CCondor2NavGUI::CLogger::CLogger(TType type, const CCondor2NavGUI &gui) :
+  condor2nav::CCondor2Nav::CLogger{type}, _gui(gui)
 {
 }
 
@@ -54,8 +56,7 @@ condor2nav::gui::CCondor2NavGUI::CLogger::CLogger(TType type, HWND hDlg) :
  */
 void condor2nav::gui::CCondor2NavGUI::CLogger::Trace(const std::string &str) const
 {
-  auto dup = std::make_unique<std::string>(str);
-  PostMessage(_hDlg, WM_LOG, static_cast<int>(Type()), reinterpret_cast<WPARAM>(dup.release()));
+  _gui.Trace(Type(), str);
 }
 
 
@@ -67,10 +68,10 @@ void condor2nav::gui::CCondor2NavGUI::CLogger::Trace(const std::string &str) con
  */
 condor2nav::gui::CCondor2NavGUI::CCondor2NavGUI(HINSTANCE hInst, HWND hDlg) :
   _condorPath{CCondor::InstallPath()},
-  _normal{CLogger::TType::LOG_NORMAL, hDlg},
-  _high{CLogger::TType::LOG_HIGH, hDlg},
-  _warning{CLogger::TType::WARNING, hDlg},
-  _error{CLogger::TType::ERROR, hDlg},
+  _normal{CLogger::TType::LOG_NORMAL, *this},
+  _high{CLogger::TType::LOG_HIGH, *this},
+  _warning{CLogger::TType::WARNING, *this},
+  _error{CLogger::TType::ERROR, *this},
   _hDlg{hDlg},
   _fplDefault{hDlg, IDC_FPL_DEFAULT_RADIO},
   _fplLastRace{hDlg, IDC_FPL_LAST_RACE_RADIO},
@@ -94,7 +95,7 @@ condor2nav::gui::CCondor2NavGUI::CCondor2NavGUI(HINSTANCE hInst, HWND hDlg) :
     _aatTime.Add(Convert(i * 15));
 
   // set default task
-  auto fplPath = condor::FPLPath(ConfigParser(), TFPLType::DEFAULT, _condorPath);
+  auto fplPath = condor::FPLPath(*Config(), TFPLType::DEFAULT, _condorPath);
 
   try {
     AATCheck(CCondor{_condorPath, fplPath});
@@ -109,7 +110,7 @@ condor2nav::gui::CCondor2NavGUI::CCondor2NavGUI(HINSTANCE hInst, HWND hDlg) :
 
   // check if last result is available
   try {
-    fplPath = condor::FPLPath(ConfigParser(), TFPLType::RESULT, _condorPath);
+    fplPath = condor::FPLPath(*Config(), TFPLType::RESULT, _condorPath);
   }
   catch(const Exception &) {
     _fplLastRace.Disable();
@@ -133,25 +134,34 @@ condor2nav::gui::CCondor2NavGUI::~CCondor2NavGUI()
  */
 void condor2nav::gui::CCondor2NavGUI::AATCheck(const CCondor &condor) const
 {
-  try {
-    const CFileParserINI &taskParser = condor.TaskParser();
-    if(taskParser.Value("Task", "AAT") == "Distance")
-      Error() << "ERROR: AAT/D tasks are not supported!!!" << std::endl;
-    else if(taskParser.Value("Task", "AAT") == "Speed") {
-      _aatOn.Click();
-      try {
-        _aatTime.String(taskParser.Value("Task", "DesignatedTime"));
-      }
-      catch(EOperationFailed &) {
-        Error() << "ERROR: Corrupted condor-club task file!!!" << std::endl;
-      }
-    }
-  }
-  catch(EOperationFailed &) {
+  const CFileParserINI &taskParser = condor.TaskParser();
+  const auto aat = taskParser.TryValue("Task", "AAT");
+  if(!aat)
+    return;
+
+  if(*aat == "Distance")
+    Error() << "ERROR: AAT/D tasks are not supported!!!" << std::endl;
+  else if(*aat == "Speed") {
+    _aatOn.Click();
+    if(const auto designatedTime = taskParser.TryValue("Task", "DesignatedTime"))
+      _aatTime.String(*designatedTime);
+    else
+      Error() << "ERROR: Corrupted condor-club task file!!!" << std::endl;
   }
 }
 
 
+/**
+ * @brief Checks if translation options are complete.
+ *
+ * @return true if it succeeds, false if it fails. 
+ */
+bool condor2nav::gui::CCondor2NavGUI::InputValid() const
+{
+  return (!_fplOther.Selected() || _fplPath.String() != "") && (!_aatOn.Selected() || _aatTime.Selection() != "" || _aatTime.ItemSelected());
+}
+
+
 /**
  * @brief Checks if translation is valid to execute.
  *
@@ -159,7 +169,95 @@ void condor2nav::gui::CCondor2NavGUI::AATCheck(const CCondor &condor) const
  */
 bool condor2nav::gui::CCondor2NavGUI::TranslateValid() const
 {
-  return !_running && (!_fplOther.Selected() || _fplPath.String() != "") && (!_aatOn.Selected() || _aatTime.Selection() != "" || _aatTime.ItemSelected());
+  return !_running && InputValid();
+}
+
+
+/**
+ * @brief Converts AAT task minimum time.
+ *
+ * Conversion is done by the active object thread so the text typed by the user
+ * is reported there as an error like the rest of translation problems.
+ *
+ * @param aatOn   Specifies if AAT task is selected.
+ * @param aatTime AAT task minimum time combo box text.
+ *
+ * @exception EOperationFailed Thrown when AAT time is not a number.
+ *
+ * @return AAT task minimum time or 0 if AAT task is not selected.
+ */
+unsigned condor2nav::gui::CCondor2NavGUI::AATTime(bool aatOn, const std::string &aatTime)
+{
+  return aatOn ? Convert<unsigned>(aatTime) : 0;
+}
+
+
+/**
+ * @brief Dumps the text to the logging window.
+ *
+ * Traces logged by the thread preparing the translation are captured
+ * and shown only if prepared translation is used.
+ *
+ * @param type The logger type.
+ * @param str  The string to dump.
+ */
+void condor2nav::gui::CCondor2NavGUI::Trace(CLogger::TType type, const std::string &str) const
+{
+  {
+    std::lock_guard<std::mutex> lock{_captureMutex};
+    if(_capture && _captureThread == std::this_thread::get_id()) {
+      _capture->emplace_back(type, str);
+      return;
+    }
+  }
+  auto dup = std::make_unique<std::string>(str);
+  PostMessage(_hDlg, WM_LOG, static_cast<int>(type), reinterpret_cast<WPARAM>(dup.release()));
+}
+
+
+/**
+ * @brief Prepares translation in the background.
+ *
+ * Method is called every time FPL file or AAT options change. Condor data is read
+ * from the FPL file and translation results are generated in the background and kept
+ * in the translation cache so the translation started by the user only writes them.
+ * Preparation is skipped if the options changed again before it started. Errors are
+ * ignored as they will be reported by the translation started by the user.
+ */
+void condor2nav::gui::CCondor2NavGUI::Prepare()
+{
+  if(!InputValid())
+    return;
+
+  const auto generation = ++_generation;
+  const bfs::path fplPath = _fplPath.String();
+  const bool aatOn = _aatOn.Selected();
+  const auto aatText = _aatTime.Selection();
+  _activeObject.Send([=]{
+    if(_abort || generation != _generation)
+      return;
+
+    auto preparation = std::make_unique<TPreparation>();
+    preparation->fplPath = fplPath;
+    {
+      std::lock_guard<std::mutex> lock{_captureMutex};
+      _captureThread = std::this_thread::get_id();
+      _capture = &preparation->logs;
+    }
+    try {
+      preparation->aatTime = AATTime(aatOn, aatText);
+      preparation->fplTime = bfs::last_write_time(fplPath);
+      preparation->condor = std::make_unique<const CCondor>(_condorPath, fplPath);
+      CTranslator{*this, Config(), *preparation->condor, preparation->aatTime}.Prepare();
+      _preparation = std::move(preparation);
+    }
+    catch(const std::exception &) {
+      _preparation.reset();
+    }
+
+    std::lock_guard<std::mutex> lock{_captureMutex};
+    _capture = nullptr;
+  });
 }
 
 
@@ -181,7 +279,7 @@ void condor2nav::gui::CCondor2NavGUI::Command(HWND hwnd, int controlID, int comm
       _fplSelect.Disable();
 
       // create Condor FPL file path
-      const auto fplPath = condor::FPLPath(ConfigParser(), CCondor2NavGUI::TFPLType::DEFAULT, _condorPath);
+      const auto fplPath = condor::FPLPath(*Config(), CCondor2NavGUI::TFPLType::DEFAULT, _condorPath);
       _fplPath.String(fplPath.string());
 
       fplChanged = true;
@@ -193,7 +291,7 @@ void condor2nav::gui::CCondor2NavGUI::Command(HWND hwnd, int controlID, int comm
       _fplSelect.Disable();
 
       // create Condor FPL file path
-      const auto fplPath = condor::FPLPath(ConfigParser(), CCondor2NavGUI::TFPLType::RESULT, _condorPath);
+      const auto fplPath = condor::FPLPath(*Config(), CCondor2NavGUI::TFPLType::RESULT, _condorPath);
       _fplPath.String(fplPath.string());
 
       fplChanged = true;
@@ -265,22 +363,44 @@ void condor2nav::gui::CCondor2NavGUI::Command(HWND hwnd, int controlID, int comm
   case IDC_TRANSLATE_BUTTON:
     if(command == BN_CLICKED) {
       _log.Clear();
-      _activeObject.Send([this]{
+      const auto start = std::chrono::steady_clock::now();
+      const bfs::path fplPath = _fplPath.String();
+      const bool aatOn = _aatOn.Selected();
+      const auto aatText = _aatTime.Selection();
+      _activeObject.Send([=]{
         try {
+          const auto aatTime = AATTime(aatOn, aatText);
           _running = true;
           _translate.Disable();
 
-          CTranslator translator{*this, ConfigParser(), CCondor{_condorPath, _fplPath.String()},
-                                 _aatOn.Selected() ? Convert<unsigned>(_aatTime.Selection()) : 0};
+          // use Condor data and translation results prepared in the background if options did not change
+          const auto preparation = std::move(_preparation);
+          boost::system::error_code ec;
+          const bool prepared = preparation && preparation->fplPath == fplPath && preparation->aatTime == aatTime &&
+                                preparation->fplTime == bfs::last_write_time(fplPath, ec) && !ec;
+          std::unique_ptr<const CCondor> condor;
+          if(prepared) {
+            for(const auto &log : preparation->logs)
+              Trace(log.first, log.second);
+            condor = std::move(preparation->condor);
+          }
+          else
+            condor = std::make_unique<const CCondor>(_condorPath, fplPath);
+
+          CTranslator translator{*this, Config(), *condor, aatTime};
           translator.Run();
 
-          _running = false;
-          if(TranslateValid())
-            _translate.Enable();
+          const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+          Log() << "Translation finished in " << time << " ms" << (prepared ? " (prepared in the background)" : "") << std::endl;
         }
         catch(const std::exception &ex) {
           Error() << ex.what() << std::endl;
         }
+
+        // allow next translation also after a failed one
+        _running = false;
+        if(TranslateValid())
+          _translate.Enable();
       });
     }
     break;
@@ -294,6 +414,7 @@ void condor2nav::gui::CCondor2NavGUI::Command(HWND hwnd, int controlID, int comm
       _translate.Enable();
     else
       _translate.Disable();
+    Prepare();
   }
 }
 
@@ -313,6 +434,7 @@ void condor2nav::gui::CCondor2NavGUI::OnStart(std::function<bool()> abort)
       Error() << ex.what() << std::endl;
     }
   });
+  Prepare();
 }
 
 
@@ -31,6 +31,11 @@
 #include "condor2nav.h"
 #include "widgets.h"
 #include "activeObject.h"
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 namespace condor2nav {
 
@@ -58,13 +63,26 @@ namespace condor2nav {
        * Class is responsible for logging Condor2Nav traces to the logging window
        */
       class CLogger : public CCondor2Nav::CLogger {
-        const HWND _hDlg;	                     ///< @brief The logging window widget
+        const CCondor2NavGUI &_gui;              ///< @brief The application owning the logging window
         void Trace(const std::string &str) const override;
       public:
-        CLogger(TType type, HWND hDlg);
+        CLogger(TType type, const CCondor2NavGUI &gui);
       };
 
     private:
+      using CLogsArray = std::vector<std::pair<CLogger::TType, std::string>>;
+
+      /**
+       * @brief Translation prepared in the background.
+       */
+      struct TPreparation {
+        bfs::path fplPath;                       ///< @brief FPL file path
+        std::time_t fplTime;                     ///< @brief FPL file modification time
+        unsigned aatTime;                        ///< @brief AAT task minimum time
+        std::unique_ptr<const CCondor> condor;   ///< @brief Condor data read from FPL file
+        CLogsArray logs;                         ///< @brief Traces logged during preparation
+      };
+
       const HWND _hDlg;	                         ///< @brief The dialog handle
       const bfs::path _condorPath;               ///< @brief Full pathname of the Condor directory
 
@@ -91,10 +109,20 @@ namespace condor2nav {
 
       CWidgetRichEdit _log;                      ///< @brief The Condor2Nav logging window
 
+      std::atomic<unsigned> _generation{0};      ///< @brief Incremented on every FPL or AAT change
+      std::unique_ptr<TPreparation> _preparation; ///< @brief Prepared translation (used only by the active object)
+      mutable std::mutex _captureMutex;          ///< @brief Traces capture guard
+      std::thread::id _captureThread;            ///< @brief The thread which traces are captured
+      CLogsArray *_capture = nullptr;            ///< @brief Captured traces
+
       CActiveObject _activeObject;               ///< @brief Active object
 
       void AATCheck(const CCondor &condor) const;
+      bool InputValid() const;
       bool TranslateValid() const;
+      static unsigned AATTime(bool aatOn, const std::string &aatTime);
+      void Prepare();
+      void Trace(CLogger::TType type, const std::string &str) const;
 
     public:
       CCondor2NavGUI(HINSTANCE hInst, HWND hDlg);
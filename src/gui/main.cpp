@@ -29,6 +29,7 @@
 #include "condor2navGUI.h"
 #include "widgets.h"
 #include "resource.h"
+#include "platform.h"
 #include <exception>
 
 static HINSTANCE hInst = nullptr;
@@ -144,7 +145,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInst, char *cmdParam, int
 {
   try {
     // init RichEdit controls
-    condor2nav::CLibraryRes _richEditLib{::LoadLibrary("RichEd20.dll")};
+    condor2nav::platform::CLibrary richEditLib{"RichEd20.dll"};
 
     // create MainDialog window
     HWND hDialog = CreateDialog(hInstance, MAKEINTRESOURCE(IDD_MAIN_DIALOG), nullptr, (DLGPROC)condor2nav::gui::MainDialogProc);
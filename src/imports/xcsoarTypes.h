@@ -48,7 +48,15 @@ Copyright_License {
 #ifndef __XCSOARTYPES_H__
 #define __XCSOARTYPES_H__
 
+#if defined(_WIN32)
 #include <windows.h>
+#else
+#include <cstdint>
+typedef std::int32_t BOOL;
+typedef std::uint32_t DWORD;
+typedef char TCHAR;
+struct POINT { std::int32_t x; std::int32_t y; };
+#endif
 
 /**
  * @brief Data imported from XCSoar project.
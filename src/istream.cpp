@@ -26,10 +26,178 @@
  */
 
 #include "istream.h"
-#include <algorithm>
 #include <boost/asio/ip/tcp.hpp>
-#include "activeSync.h"   // has to be included after boost/asio
-#include <boost/filesystem/fstream.hpp>
+#include "deviceTransport.h"
+#include "ostream.h"
+#include "tools.h"
+#include "translationCache.h"
+#include <boost/version.hpp>
+#include <chrono>
+
+
+namespace {
+
+  /**
+   * @brief HTTP download reader.
+   *
+   * Reader connects to the server, sends the request and checks the response
+   * headers. Response body is read in chunks straight from the socket.
+   */
+  class CReaderHTTP : public condor2nav::CReader {
+    boost::asio::ip::tcp::iostream _http;           ///< @brief Connection to the server.
+    const unsigned _timeout;                         ///< @brief Download timeout in seconds.
+  public:
+    CReaderHTTP(const std::string &server, const bfs::path &url, unsigned timeout);
+    size_t Read(char *buffer, size_t size) override;
+  };
+
+
+  CReaderHTTP::CReaderHTTP(const std::string &server, const bfs::path &url, unsigned timeout) :
+    _timeout{timeout}
+  {
+    using namespace condor2nav;
+
+#if BOOST_VERSION >= 106600
+    _http.expires_after(std::chrono::seconds(timeout));
+#else
+    _http.expires_from_now(boost::posix_time::seconds(timeout));
+#endif
+
+    // establish a connection to the server.
+    _http.connect(server, "http");
+    if(!_http)
+      throw EOperationFailed{"ERROR: Unable to connect to: '" + server + url.generic_string() + "', error: " + _http.error().message()};
+
+    // Send the request. We specify the "Connection: close" header so that the
+    // server will close the socket after transmitting the response. This will
+    // allow us to treat all data up until the EOF as the content.
+    _http << "GET " << url.generic_string() << " HTTP/1.0\r\n";
+    _http << "Host: " << server << "\r\n";
+    _http << "Accept: */*\r\n";
+    _http << "Connection: close\r\n\r\n";
+
+    // Check that response is OK.
+    std::string http_version;
+    _http >> http_version;
+    unsigned int status_code;
+    _http >> status_code;
+    std::string status_message;
+    std::getline(_http, status_message);
+    if(!_http || http_version.substr(0, 5) != "HTTP/")
+      throw EOperationFailed{"ERROR: Invalid response from: '" + server + url.generic_string() + "'"};
+    if(status_code != 200)
+      throw EOperationFailed{"ERROR: '" + server + url.generic_string() + "' returned a response with status code: " + Convert(status_code)};
+
+    // Process the response headers, which are terminated by a blank line.
+    std::string header;
+    while(std::getline(_http, header) && header != "\r")
+      ;
+  }
+
+
+  size_t CReaderHTTP::Read(char *buffer, size_t size)
+  {
+    _http.read(buffer, size);
+    const auto count = static_cast<size_t>(_http.gcount());
+    if(count < size && _http.error() == boost::asio::error::operation_aborted)
+      throw condor2nav::EOperationFailed{"ERROR: Download timeout (" + condor2nav::Convert(_timeout) + " seconds) exceeded!"};
+    return count;
+  }
+
+
+  /**
+   * @brief Opens file for reading.
+   *
+   * @param fileName The name of the file to read.
+   *
+   * @return File reader.
+   */
+  std::unique_ptr<condor2nav::CReader> Open(const bfs::path &fileName)
+  {
+    using namespace condor2nav;
+    if(PathType(fileName) == TPathType::ACTIVE_SYNC)
+      return CDeviceTransport::Current()->Open(fileName);
+    return std::make_unique<CReaderFile>(fileName);
+  }
+
+}
+
+
+/* ******************** C H U N K E D   B U F F E R ******************** */
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CIStream::CBuffer class constructor.
+ *
+ * @param reader Data source.
+ */
+condor2nav::CIStream::CBuffer::CBuffer(std::unique_ptr<CReader> reader) :
+  _reader{std::move(reader)}, _chunk(CReader::CHUNK_SIZE + 1), _cr{false}, _eof{false}, _crlf{0}, _hash{CTranslationCache::HASH_SEED}
+{
+  setg(_chunk.data(), _chunk.data(), _chunk.data());
+}
+
+
+/**
+ * @brief Reads next chunk of data.
+ *
+ * Method reads next chunk just after the first byte of the buffer and translates
+ * it in place. CR at the end of the chunk is held until the next one is read
+ * (the first byte is left for it).
+ *
+ * @return The first character of the chunk or EOF.
+ */
+auto condor2nav::CIStream::CBuffer::underflow() -> int_type
+{
+  if(gptr() < egptr())
+    return traits_type::to_int_type(*gptr());
+
+  const auto begin = _chunk.data();
+  auto out = begin;
+  while(out == begin && !_eof) {
+    const auto size = _reader->Read(begin + 1, CReader::CHUNK_SIZE);
+    if(!size) {
+      _eof = true;
+      if(_cr)
+        *out++ = '\r';
+      _cr = false;
+    }
+    for(auto in = begin + 1, end = begin + 1 + size; in != end; ++in) {
+      const auto c = *in;
+      if(_cr && c != '\n')
+        *out++ = '\r';
+      else if(_cr)
+        ++_crlf;
+      _cr = c == '\r';
+      if(!_cr)
+        *out++ = c;
+    }
+  }
+
+  _hash = CTranslationCache::Hash(begin, out - begin, _hash);
+  setg(begin, begin, out);
+  return out == begin ? traits_type::eof() : traits_type::to_int_type(*begin);
+}
+
+
+
+/* ******************** I N P U T   S T R E A M ******************** */
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CIStream class constructor.
+ *
+ * @param reader   Data source.
+ * @param fileName The name of the file (empty for downloads).
+ */
+condor2nav::CIStream::CIStream(std::unique_ptr<CReader> reader, bfs::path fileName) :
+  _fileName{std::move(fileName)}, _buffer{std::move(reader)}, _stream{&_buffer}
+{
+  // errors reported by readers are not hidden by the stream
+  _stream.exceptions(std::ios_base::badbit);
+}
 
 
 /**
@@ -39,63 +207,55 @@
  *
  * @param fileName The name of the file to read.
  */
-condor2nav::CIStream::CIStream(const bfs::path &fileName)
+condor2nav::CIStream::CIStream(const bfs::path &fileName) :
+  CIStream{Open(fileName), fileName}
 {
-  switch(PathType(fileName)) {
-  case TPathType::LOCAL:
-    {
-      bfs::fstream stream{fileName, std::ios_base::in};
-      if(!stream)
-        throw EOperationFailed{"ERROR: Couldn't open file '" + fileName.string() + "' for reading!!!"};
-      _buffer << stream.rdbuf();
-    }
-    break;
+}
 
-  case TPathType::ACTIVE_SYNC:
-    _buffer.str(CActiveSync::Instance().Read(fileName));
-    break;
-  }
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CIStream class constructor that downloads the file.
+ *
+ * @param server  Server name.
+ * @param url     File URL on the server.
+ * @param timeout Download timeout in seconds.
+ */
+condor2nav::CIStream::CIStream(const std::string &server, const bfs::path &url, unsigned timeout /* = 30 */) :
+  CIStream{std::make_unique<CReaderHTTP>(server, url, timeout), bfs::path{}}
+{
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::CIStream class destructor that reports the read of the file
+ * to the translation cache.
+ */
+condor2nav::CIStream::~CIStream()
+{
+  if(_fileName.empty())
+    return;
+  if(_buffer.Eof())
+    CTranslationCache::CRecorder::OnFileRead(_fileName, _buffer.Hash());
+  else
+    // file was not read till the end
+    CTranslationCache::CRecorder::OnFileRead(_fileName);
 }
 
 
-condor2nav::CIStream::CIStream(const std::string &server, const bfs::path &url, unsigned timeout /* = 30 */)
+/**
+ * @brief Writes the rest of input stream data to the output stream.
+ *
+ * @param out Output stream.
+ * @param in  Input stream.
+ *
+ * @return Output stream.
+ */
+condor2nav::COStream &condor2nav::operator<<(COStream &out, CIStream &in)
 {
-  boost::asio::ip::tcp::iostream http;
-  http.expires_from_now(boost::posix_time::seconds(timeout));
-
-  // establish a connection to the server.
-  http.connect(server, "http");
-  if(!http)
-    throw EOperationFailed{"ERROR: Unable to connect to: '" + server + url.generic_string() + "', error: " + http.error().message()};
-
-  // Send the request. We specify the "Connection: close" header so that the
-  // server will close the socket after transmitting the response. This will
-  // allow us to treat all data up until the EOF as the content.
-  http << "GET " << url.generic_string() << " HTTP/1.0\r\n";
-  http << "Host: " << server << "\r\n";
-  http << "Accept: */*\r\n";
-  http << "Connection: close\r\n\r\n";
-
-  // Check that response is OK.
-  std::string http_version;
-  http >> http_version;
-  unsigned int status_code;
-  http >> status_code;
-  std::string status_message;
-  std::getline(http, status_message);
-  if(!http || http_version.substr(0, 5) != "HTTP/")
-    throw EOperationFailed{"ERROR: Invalid response from: '" + server + url.generic_string() + "'"};
-  if(status_code != 200)
-    throw EOperationFailed{"ERROR: '" + server + url.generic_string() + "' returned a response with status code: " + Convert(status_code)};
-
-  // Process the response headers, which are terminated by a blank line.
-  std::string header;
-  while(std::getline(http, header) && header != "\r")
-    ;
-
-  // Write the remaining data to internal buffer
-  _buffer << http.rdbuf();
-
-  if(http.error() == boost::asio::error::operation_aborted)
-    throw EOperationFailed{"ERROR: Download timeout (" + Convert(timeout) + " seconds) exceeded!"};
+  in._buffer.Copy([&](const char *data, std::streamsize size){ out.Write(data, size); });
+  return out;
 }
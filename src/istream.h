@@ -29,32 +29,92 @@
 #define __ISTREAM_H__
 
 #include "nonCopyable.h"
-#include "boostfwd.h"
-#include <sstream>
+#include "reader.h"
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <vector>
 
 namespace condor2nav {
 
+  class COStream;
+
   /**
    * @brief Input stream wrapper
    *
-   * condor2nav::CIStream class is a wrapper for different stream types.
+   * condor2nav::CIStream class is a wrapper for different stream types. Data is
+   * read in chunks straight from the source (local file, device or network), so
+   * only one chunk is kept in memory no matter how big the file is.
    */
   class CIStream : CNonCopyable {
-    std::stringstream _buffer;            ///< @brief Buffer with file data. 
+  public:
+    /**
+     * @brief Chunked input buffer.
+     *
+     * condor2nav::CIStream::CBuffer class reads data from the reader one chunk at a time
+     * and translates CRLF line endings to LF on the fly (the same way on every platform
+     * and transport). The hash of translated data is calculated while reading.
+     */
+    class CBuffer : public std::streambuf {
+      std::unique_ptr<CReader> _reader;               ///< @brief Data source.
+      std::vector<char> _chunk;                       ///< @brief Current chunk (with the room for CR held from the previous one).
+      bool _cr;                                       ///< @brief CR read at the end of the previous chunk.
+      bool _eof;                                      ///< @brief End of data reached.
+      size_t _crlf;                                   ///< @brief The number of CRLF line endings translated so far.
+      std::uint64_t _hash;                            ///< @brief The hash of data read so far.
+
+    protected:
+      int_type underflow() override;
+
+    public:
+      explicit CBuffer(std::unique_ptr<CReader> reader);
+      bool Eof() const            { return _eof; }
+      size_t Crlf() const         { return _crlf; }
+      std::uint64_t Hash() const  { return _hash; }
+
+      /**
+       * @brief Passes the rest of data to the output chunk by chunk.
+       *
+       * @param write Functor called with each chunk (data pointer and size).
+       */
+      template<class Function>
+      void Copy(Function write)
+      {
+        while(sgetc() != traits_type::eof()) {
+          write(gptr(), static_cast<std::streamsize>(egptr() - gptr()));
+          setg(eback(), egptr(), egptr());
+        }
+      }
+    };
+
+  private:
+    const bfs::path _fileName;            ///< @brief The name of the file (empty for downloads).
+    CBuffer _buffer;                      ///< @brief Chunked buffer with file data.
+    std::istream _stream;                 ///< @brief Stream reading the buffer.
+
+    CIStream(std::unique_ptr<CReader> reader, bfs::path fileName);
+
   public:
     explicit CIStream(const bfs::path &fileName);
     CIStream(const std::string &server, const bfs::path &url, unsigned timeout = 30);
-    explicit operator bool() const           { return static_cast<bool>(_buffer); }
-    std::istream &GetLine(std::string &line) { return getline(_buffer, line); }
+    ~CIStream();
+    explicit operator bool() const           { return static_cast<bool>(_stream); }
+    std::istream &GetLine(std::string &line) { return getline(_stream, line); }
+    bool Eof() const                         { return _stream.eof(); }
+    size_t Crlf() const                      { return _buffer.Crlf(); }
 
     template<class Stream>
     friend Stream &operator<<(Stream &out, CIStream &in)
     {
-      out << in._buffer.rdbuf();
+      in._buffer.Copy([&](const char *data, std::streamsize size){ out.write(data, size); });
       return out;
     }
+
+    friend COStream &operator<<(COStream &out, CIStream &in);
   };
 
+  COStream &operator<<(COStream &out, CIStream &in);
+
 }
 
 #endif /* __ISTREAM_H__ */
@@ -32,7 +32,7 @@
 #include "istream.h"
 #include "tools.h"
 #include <algorithm>
-#include <boost\filesystem\fstream.hpp>
+#include <boost/filesystem/fstream.hpp>
 
 namespace condor2nav {
 
@@ -63,7 +63,7 @@ unsigned condor2nav::MapScale(const CFileParserINI &map)
 
 
 condor2nav::CLKMapsDB::CLKMapsDB(const CCondor2Nav &app) :
-  _app{app}, _sceneriesParser{CTranslator::DATA_PATH / _app.ConfigParser().Value("Condor2Nav", "Target") / CTranslator::SCENERIES_DATA_FILE_NAME}
+  _app{app}, _sceneriesParser{CTranslator::DATA_PATH / "LK8000" / CTranslator::SCENERIES_DATA_FILE_NAME}
 {
   // fill the list of Condor landscapes templates
   std::for_each(bfs::directory_iterator(CONDOR_TEMPLATES_DIR), bfs::directory_iterator(),
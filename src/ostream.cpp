@@ -26,9 +26,11 @@
  */
 
 #include "ostream.h"
-#include "activeSync.h"
-#include <algorithm>
-#include <boost/filesystem/fstream.hpp>
+#include "deviceTransport.h"
+#include "platform.h"
+#include "tools.h"
+#include "translationCache.h"
+#include <boost/filesystem/path.hpp>
 
 
 /**
@@ -39,7 +41,7 @@
  * @param fileName The name of the file to create.
  */
 condor2nav::COStream::COStream(bfs::path fileName) :
-  _pathList{{std::move(fileName)}}
+  _stream{&_buffer}, _pathList{{std::move(fileName)}}
 {
 }
 
@@ -52,7 +54,7 @@ condor2nav::COStream::COStream(bfs::path fileName) :
  * @param pathList The list of files to create.
  */
 condor2nav::COStream::COStream(CPathList pathList) :
-  _pathList{std::move(pathList)}
+  _stream{&_buffer}, _pathList{std::move(pathList)}
 {
 }
 
@@ -61,26 +63,36 @@ condor2nav::COStream::COStream(CPathList pathList) :
  * @brief Class destructor.
  *
  * condor2nav::COStream class destructor. Writes local buffer to
- * a file.
+ * a file. Local files are written directly from the buffer segments.
+ * One contiguous copy of the data is made only if needed by the device
+ * transport or the translation cache. Nothing is written during dry
+ * run translation (only the translation cache gets the data).
  */
-condor2nav::COStream::~COStream()
+condor2nav::COStream::~COStream() CONDOR2NAV_DTOR_THROWS
 {
-  if(_buffer.str().size()) {
+  if(_buffer.Size()) {
+    const auto &segments = _buffer.Segments();
+    std::string data;
+    const auto contiguous = [&]() -> const std::string & {
+      if(data.empty())
+        data = _buffer.String();
+      return data;
+    };
+
+    const bool dryRun = CTranslationCache::CRecorder::DryRun();
     for(auto &path : _pathList) {
-      switch(PathType(path)) {
-      case TPathType::LOCAL:
-        {
-          bfs::ofstream stream{path, std::ios_base::out | std::ios_base::binary};
-          if(!stream)
-            throw EOperationFailed{"ERROR: Couldn't open file '" + path.string() + "' for writing!!!"};
-          stream << _buffer.str();
-        }
-        break;
+      if(!dryRun) {
+        switch(PathType(path)) {
+        case TPathType::LOCAL:
+          platform::FileWrite(path, segments.data(), segments.size());
+          break;
 
-      case TPathType::ACTIVE_SYNC:
-        CActiveSync::Instance().Write(path, _buffer.str());
-        break;
+        case TPathType::ACTIVE_SYNC:
+          CDeviceTransport::Current()->Write(path, contiguous());
+          break;
+        }
       }
+      CTranslationCache::CRecorder::OnFileWrite(path, contiguous);
     }
   }
 }
@@ -98,6 +110,24 @@ condor2nav::COStream::~COStream()
 */
 condor2nav::COStream &condor2nav::COStream::Write(const char *buffer, std::streamsize num)
 {
-  _buffer.write(buffer, num);
+  _buffer.sputn(buffer, num);
+  return *this;
+}
+
+
+/**
+* @brief Attaches binary buffer to a stream.
+*
+* Method adds binary buffer to a stream without copying it. The buffer
+* has to stay valid and unchanged until the stream is destroyed.
+*
+* @param buffer Buffer data.
+* @param num Buffer size.
+*
+* @return Stream instance.
+*/
+condor2nav::COStream &condor2nav::COStream::Attach(const char *buffer, size_t num)
+{
+  _buffer.Attach(buffer, num);
   return *this;
 }
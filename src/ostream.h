@@ -28,9 +28,11 @@
 #ifndef __OSTREAM_H__
 #define __OSTREAM_H__
 
+#include "exception.h"
 #include "nonCopyable.h"
 #include "boostfwd.h"
-#include <sstream>
+#include "outputBuffer.h"
+#include <ostream>
 #include <vector>
 
 namespace condor2nav {
@@ -38,21 +40,25 @@ namespace condor2nav {
   /**
    * @brief Output stream wrapper
    *
-   * condor2nav::COStream class is a wrapper for different stream types.
+   * condor2nav::COStream class is a wrapper for different stream types. The data is
+   * collected in a segmented buffer and written to all the destinations when the stream
+   * is destroyed (with a gather write for local files).
    */
   class COStream : CNonCopyable {
   public:
     using CPathList = std::vector<bfs::path>;
 
   private:
-    std::stringstream _buffer;            ///< @brief Buffer with file data. 
+    COutputBuffer _buffer;                ///< @brief Buffer with file data. 
+    std::ostream _stream;                 ///< @brief Formatting stream writing to the buffer.
     CPathList _pathList;
 
   public:
     explicit COStream(bfs::path fileName);
     explicit COStream(CPathList pathList);
-    ~COStream();
+    ~COStream() CONDOR2NAV_DTOR_THROWS;
     COStream &Write(const char *buffer, std::streamsize num);
+    COStream &Attach(const char *buffer, size_t num);
 
     void Dump(const bfs::path &fileName);
 
@@ -69,7 +75,7 @@ namespace condor2nav {
     template<class T>
     friend COStream &operator<<(COStream &stream, const T &obj)
     {
-      stream._buffer << obj;
+      stream._stream << obj;
       return stream;
     }
 
@@ -85,7 +91,7 @@ namespace condor2nav {
      */
     friend COStream &operator<<(COStream &stream, std::ostream &(*f)(std::ostream &))
     {
-      stream._buffer << f;
+      stream._stream << f;
       return stream;
     }
   };
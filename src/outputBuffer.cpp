@@ -0,0 +1,181 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file outputBuffer.cpp
+ *
+ * @brief Implements the condor2nav::COutputBuffer class. 
+ */
+
+#include "outputBuffer.h"
+#include <algorithm>
+#include <cstring>
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::COutputBuffer class constructor. First block is allocated
+ * with the first write.
+ */
+condor2nav::COutputBuffer::COutputBuffer() :
+  _segmentStart{nullptr}, _size{0}, _copied{0}
+{
+}
+
+
+/**
+ * @brief Closes current segment.
+ *
+ * Method adds the data written to the current block since the last segment
+ * to the list of segments.
+ */
+void condor2nav::COutputBuffer::SegmentClose()
+{
+  if(pptr() != _segmentStart) {
+    const size_t size = pptr() - _segmentStart;
+    _segments.push_back(TSegment{_segmentStart, size});
+    _size += size;
+    _copied += size;
+  }
+  _segmentStart = pptr();
+}
+
+
+/**
+ * @brief Starts new block.
+ *
+ * Method is called by the stream when current block is full.
+ *
+ * @param ch Character to write.
+ *
+ * @return Written character or EOF.
+ */
+auto condor2nav::COutputBuffer::overflow(int_type ch) -> int_type
+{
+  SegmentClose();
+  _blocks.emplace_back(new char[BLOCK_SIZE]);
+  setp(_blocks.back().get(), _blocks.back().get() + BLOCK_SIZE);
+  _segmentStart = pptr();
+  if(traits_type::eq_int_type(ch, traits_type::eof()))
+    return traits_type::not_eof(ch);
+  *pptr() = traits_type::to_char_type(ch);
+  pbump(1);
+  return ch;
+}
+
+
+/**
+ * @brief Writes data.
+ *
+ * Method copies the data to the blocks.
+ *
+ * @param data Data to write.
+ * @param num  The size of the data.
+ *
+ * @return The number of written characters.
+ */
+std::streamsize condor2nav::COutputBuffer::xsputn(const char *data, std::streamsize num)
+{
+  std::streamsize left = num;
+  while(left > 0) {
+    if(pptr() == epptr())
+      overflow(traits_type::eof());
+    const auto size = (std::min)(left, static_cast<std::streamsize>(epptr() - pptr()));
+    std::memcpy(pptr(), data, static_cast<size_t>(size));
+    pbump(static_cast<int>(size));
+    data += size;
+    left -= size;
+  }
+  return num;
+}
+
+
+/**
+ * @brief Attaches binary buffer.
+ *
+ * Method adds the buffer to the chain without copying. The buffer has to stay
+ * valid and unchanged as long as the data is used.
+ *
+ * @param data Buffer data.
+ * @param size Buffer size.
+ */
+void condor2nav::COutputBuffer::Attach(const char *data, size_t size)
+{
+  if(!size)
+    return;
+  SegmentClose();
+  _segments.push_back(TSegment{data, size});
+  _size += size;
+}
+
+
+/**
+ * @brief Returns data segments.
+ *
+ * @return Data segments in file order.
+ */
+auto condor2nav::COutputBuffer::Segments() -> const CSegmentArray &
+{
+  SegmentClose();
+  return _segments;
+}
+
+
+/**
+ * @brief Returns data size.
+ *
+ * @return The size of the data in bytes.
+ */
+size_t condor2nav::COutputBuffer::Size() const
+{
+  return _size + (pptr() - _segmentStart);
+}
+
+
+/**
+ * @brief Returns the number of copied bytes.
+ *
+ * @return The number of bytes copied to the blocks or gathered with String().
+ */
+size_t condor2nav::COutputBuffer::Copied() const
+{
+  return _copied + (pptr() - _segmentStart);
+}
+
+
+/**
+ * @brief Gathers the data.
+ *
+ * Method copies all the segments to one contiguous string. It should be used
+ * only for consumers that need one memory block.
+ *
+ * @return Buffer data.
+ */
+std::string condor2nav::COutputBuffer::String()
+{
+  std::string str;
+  str.reserve(Size());
+  for(const auto &segment : Segments())
+    str.append(segment.data, segment.size);
+  _copied += str.size();
+  return str;
+}
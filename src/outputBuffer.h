@@ -0,0 +1,78 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file outputBuffer.h
+ *
+ * @brief Declares the condor2nav::COutputBuffer class. 
+ */
+
+#ifndef __OUTPUTBUFFER_H__
+#define __OUTPUTBUFFER_H__
+
+#include "nonCopyable.h"
+#include "platform.h"
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Segmented output buffer.
+   *
+   * condor2nav::COutputBuffer class collects output file data in a chain of fixed size
+   * blocks. Blocks are never reallocated so the data written once is never copied again.
+   * Large binary buffers may be attached to the chain without copying. The data is
+   * provided as the list of segments ready for a gather write. As a stream buffer it can
+   * be used by std::ostream to format the data directly into the blocks.
+   */
+  class COutputBuffer : public std::streambuf, CNonCopyable {
+  public:
+    using TSegment = platform::TBuffer;
+    using CSegmentArray = std::vector<TSegment>;
+
+    static const size_t BLOCK_SIZE = 16 * 1024;         ///< @brief The size of a data block.
+
+  private:
+    std::vector<std::unique_ptr<char[]>> _blocks;       ///< @brief Data blocks.
+    CSegmentArray _segments;                            ///< @brief Closed data segments in file order.
+    char *_segmentStart;                                ///< @brief Beginning of the segment being written in the current block.
+    size_t _size;                                       ///< @brief The size of closed segments.
+    size_t _copied;                                     ///< @brief The number of bytes copied to blocks.
+
+    void SegmentClose();
+    int_type overflow(int_type ch) override;
+    std::streamsize xsputn(const char *data, std::streamsize num) override;
+
+  public:
+    COutputBuffer();
+    void Attach(const char *data, size_t size);
+    const CSegmentArray &Segments();
+    size_t Size() const;
+    size_t Copied() const;
+    std::string String();
+  };
+
+}
+
+#endif /* __OUTPUTBUFFER_H__ */
@@ -0,0 +1,404 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file platform.cpp
+ *
+ * @brief Implements the operating system abstraction layer. 
+ */
+
+#include "platform.h"
+#include "exception.h"
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <algorithm>
+#include <cerrno>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <vector>
+#endif
+
+
+/**
+ * @brief Returns the value of environment variable.
+ *
+ * @param name The name of the variable.
+ *
+ * @return The value of the variable or empty string if it is not defined.
+ */
+std::string condor2nav::platform::Environment(const std::string &name)
+{
+#if defined(_MSC_VER)
+  char *buffer = nullptr;
+  size_t size = 0;
+  if(_dupenv_s(&buffer, &size, name.c_str()) || !buffer)
+    return std::string{};
+  const std::string value{buffer};
+  free(buffer);
+  return value;
+#else
+  const char *value = std::getenv(name.c_str());
+  return value ? std::string{value} : std::string{};
+#endif
+}
+
+
+/**
+ * @brief Returns per-user data directory.
+ *
+ * Function returns the directory where data kept between runs (e.g. indexes)
+ * should be stored. It is %LOCALAPPDATA%\Condor2Nav on Windows and
+ * $XDG_CACHE_HOME/condor2nav (~/.cache/condor2nav by default) elsewhere.
+ * System temporary directory is used if none of them is defined. The directory
+ * is created if it does not exist.
+ *
+ * @return Per-user data directory.
+ */
+bfs::path condor2nav::platform::UserDataPath()
+{
+  bfs::path path;
+#if defined(_WIN32)
+  auto base = Environment("LOCALAPPDATA");
+  if(base.empty())
+    base = Environment("APPDATA");
+  path = base.empty() ? bfs::temp_directory_path() / "Condor2Nav" : bfs::path{base} / "Condor2Nav";
+#else
+  if(!Environment("XDG_CACHE_HOME").empty())
+    path = bfs::path{Environment("XDG_CACHE_HOME")} / "condor2nav";
+  else if(!Environment("HOME").empty())
+    path = bfs::path{Environment("HOME")} / ".cache" / "condor2nav";
+  else
+    path = bfs::temp_directory_path() / "condor2nav";
+#endif
+  boost::system::error_code ec;
+  bfs::create_directories(path, ec);
+  return path;
+}
+
+
+
+#if defined(_WIN32)
+
+/* ***************************************** W I N 3 2 ************************************** */
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::platform::CLibrary class constructor that loads the library.
+ *
+ * @param path The path of the library.
+ */
+condor2nav::platform::CLibrary::CLibrary(const bfs::path &path) :
+  _handle{::LoadLibrary(path.string().c_str())}
+{
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::platform::CLibrary class destructor that unloads the library.
+ */
+condor2nav::platform::CLibrary::~CLibrary()
+{
+  if(_handle)
+    ::FreeLibrary(static_cast<HMODULE>(_handle));
+}
+
+
+/**
+ * @brief Returns the address of library symbol.
+ *
+ * @param name The name of the symbol.
+ *
+ * @return The address of the symbol or @p nullptr if not found.
+ */
+void *condor2nav::platform::CLibrary::Symbol(const std::string &name) const
+{
+  return _handle ? reinterpret_cast<void *>(::GetProcAddress(static_cast<HMODULE>(_handle), name.c_str())) : nullptr;
+}
+
+
+/**
+* @brief Returns a path to Condor: The Competition Soaring Simulator
+*
+* Function returns a path to Condor: The Competition Soaring Simulator
+* read from Windows registry.
+*
+* @return Path to Condor: The Competition Soaring Simulator
+*/
+bfs::path condor2nav::platform::CondorInstallPath()
+{
+  HKEY hTestKey;
+  if((RegOpenKeyEx(HKEY_CURRENT_USER, "Software\\Condor", 0, KEY_READ, &hTestKey)) == ERROR_SUCCESS) {
+    DWORD bufferSize = 0;
+    RegQueryValueEx(hTestKey, "InstallDir", nullptr, nullptr, nullptr, &bufferSize);
+    auto buffer = std::make_unique<char[]>(bufferSize);
+    RegQueryValueEx(hTestKey, "InstallDir", nullptr, nullptr, reinterpret_cast<BYTE *>(buffer.get()), &bufferSize);
+    bfs::path condorPath{buffer.get()};
+    RegCloseKey(hTestKey);
+    return condorPath;
+  }
+  else
+    throw EOperationFailed{"ERROR: Condor installation not found!!!"};
+}
+
+/**
+ * @brief Writes a file from several buffers.
+ *
+ * Function creates (or truncates) the file and writes all the buffers one after
+ * another without gathering them in one memory block first.
+ *
+ * @param path    The path of the file.
+ * @param buffers Buffers to write.
+ * @param num     The number of buffers.
+ */
+void condor2nav::platform::FileWrite(const bfs::path &path, const TBuffer buffers[], size_t num)
+{
+  const HANDLE file = ::CreateFileW(path.wstring().c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE)
+    throw EOperationFailed{"ERROR: Couldn't open file '" + path.string() + "' for writing!!!"};
+  std::unique_ptr<void, BOOL(WINAPI *)(HANDLE)> guard{file, ::CloseHandle};
+  for(size_t i = 0; i < num; ++i) {
+    DWORD written;
+    if(!::WriteFile(file, buffers[i].data, static_cast<DWORD>(buffers[i].size), &written, nullptr) || written != buffers[i].size)
+      throw EOperationFailed{"ERROR: Writing file '" + path.string() + "'!!!"};
+  }
+}
+
+
+/**
+ * @brief Overwrites a part of existing file.
+ *
+ * Function writes the buffer at provided offset of the existing file and sets
+ * the size of the file. The rest of the file content is not touched.
+ *
+ * @param path   The path of the file.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::platform::FilePatch(const bfs::path &path, size_t offset, const TBuffer &buffer, size_t size)
+{
+  const HANDLE file = ::CreateFileW(path.wstring().c_str(), GENERIC_WRITE, 0, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if(file == INVALID_HANDLE_VALUE)
+    throw EOperationFailed{"ERROR: Couldn't open file '" + path.string() + "' for writing!!!"};
+  std::unique_ptr<void, BOOL(WINAPI *)(HANDLE)> guard{file, ::CloseHandle};
+  LARGE_INTEGER pos;
+  pos.QuadPart = offset;
+  DWORD written;
+  if(!::SetFilePointerEx(file, pos, nullptr, FILE_BEGIN) ||
+     !::WriteFile(file, buffer.data, static_cast<DWORD>(buffer.size), &written, nullptr) || written != buffer.size)
+    throw EOperationFailed{"ERROR: Writing file '" + path.string() + "'!!!"};
+  pos.QuadPart = size;
+  if(!::SetFilePointerEx(file, pos, nullptr, FILE_BEGIN) || !::SetEndOfFile(file))
+    throw EOperationFailed{"ERROR: Writing file '" + path.string() + "'!!!"};
+}
+
+#else
+
+/* ***************************************** P O S I X ************************************** */
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::platform::CLibrary class constructor that loads the library.
+ *
+ * @param path The path of the library.
+ */
+condor2nav::platform::CLibrary::CLibrary(const bfs::path &path) :
+  _handle{::dlopen(path.string().c_str(), RTLD_NOW | RTLD_LOCAL)}
+{
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::platform::CLibrary class destructor that unloads the library.
+ */
+condor2nav::platform::CLibrary::~CLibrary()
+{
+  if(_handle)
+    ::dlclose(_handle);
+}
+
+
+/**
+ * @brief Returns the address of library symbol.
+ *
+ * @param name The name of the symbol.
+ *
+ * @return The address of the symbol or @p nullptr if not found.
+ */
+void *condor2nav::platform::CLibrary::Symbol(const std::string &name) const
+{
+  return _handle ? ::dlsym(_handle, name.c_str()) : nullptr;
+}
+
+
+/**
+* @brief Returns a path to Condor: The Competition Soaring Simulator
+*
+* Function returns a path to Condor: The Competition Soaring Simulator. The path
+* is taken from CONDOR_INSTALL_DIR environment variable or from the registry
+* of Wine prefix (WINEPREFIX or ~/.wine) where Condor was installed.
+*
+* @return Path to Condor: The Competition Soaring Simulator
+*/
+bfs::path condor2nav::platform::CondorInstallPath()
+{
+  const auto installDir = Environment("CONDOR_INSTALL_DIR");
+  if(!installDir.empty())
+    return bfs::path{installDir};
+
+  auto prefix = Environment("WINEPREFIX");
+  if(prefix.empty() && !Environment("HOME").empty())
+    prefix = Environment("HOME") + "/.wine";
+  if(!prefix.empty()) {
+    // [Software\\Condor] chapter of Wine user registry with "InstallDir"="C:\\Condor\\" value
+    const std::string CHAPTER{"[Software\\\\Condor]"};
+    const std::string VALUE{"\"InstallDir\"=\""};
+    bfs::ifstream reg{bfs::path{prefix} / "user.reg"};
+    std::string line;
+    bool chapter = false;
+    while(std::getline(reg, line)) {
+      if(!line.empty() && line.back() == '\r')
+        line.pop_back();
+      if(!line.empty() && line[0] == '[')
+        chapter = line.compare(0, CHAPTER.size(), CHAPTER) == 0 && (line.size() == CHAPTER.size() || line[CHAPTER.size()] == ' ');
+      else if(chapter && line.compare(0, VALUE.size(), VALUE) == 0 && line.size() > VALUE.size() + 2 && line[VALUE.size() + 1] == ':') {
+        // "C:\\Condor\\" -> <prefix>/dosdevices/c:/Condor
+        bfs::path path{bfs::path{prefix} / "dosdevices" / std::string{static_cast<char>(std::tolower(line[VALUE.size()])), ':'}};
+        std::string name;
+        for(size_t i = VALUE.size() + 2; i < line.size(); ++i) {
+          if(line[i] == '\\' || line[i] == '"') {
+            if(!name.empty())
+              path /= name;
+            name.clear();
+            if(line[i] == '"')
+              break;
+            ++i;
+          }
+          else
+            name += line[i];
+        }
+        return path;
+      }
+    }
+  }
+  throw EOperationFailed{"ERROR: Condor installation not found (please set CONDOR_INSTALL_DIR)!!!"};
+}
+
+
+/**
+ * @brief Writes a file from several buffers.
+ *
+ * Function creates (or truncates) the file and writes all the buffers with
+ * writev() calls without gathering them in one memory block first.
+ *
+ * @param path    The path of the file.
+ * @param buffers Buffers to write.
+ * @param num     The number of buffers.
+ */
+void condor2nav::platform::FileWrite(const bfs::path &path, const TBuffer buffers[], size_t num)
+{
+  const int fd = ::open(path.string().c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if(fd < 0)
+    throw EOperationFailed{"ERROR: Couldn't open file '" + path.string() + "' for writing!!!"};
+  struct TGuard {
+    const int fd;
+    ~TGuard() { ::close(fd); }
+  } guard{fd};
+
+  std::vector<iovec> iov;
+  iov.reserve(num);
+  for(size_t i = 0; i < num; ++i)
+    if(buffers[i].size)
+      iov.push_back(iovec{const_cast<char *>(buffers[i].data), buffers[i].size});
+
+  size_t first = 0;
+  while(first < iov.size()) {
+    const auto count = static_cast<int>((std::min)(iov.size() - first, static_cast<size_t>(IOV_MAX)));
+    auto written = ::writev(fd, &iov[first], count);
+    if(written < 0) {
+      if(errno == EINTR)
+        continue;
+      throw EOperationFailed{"ERROR: Writing file '" + path.string() + "'!!!"};
+    }
+    // skip written buffers and continue with the rest of a partially written one
+    while(first < iov.size() && static_cast<size_t>(written) >= iov[first].iov_len)
+      written -= iov[first++].iov_len;
+    if(written > 0) {
+      iov[first].iov_base = static_cast<char *>(iov[first].iov_base) + written;
+      iov[first].iov_len -= written;
+    }
+  }
+}
+
+
+
+/**
+ * @brief Overwrites a part of existing file.
+ *
+ * Function writes the buffer at provided offset of the existing file with pwrite()
+ * calls and sets the size of the file. The rest of the file content is not touched.
+ *
+ * @param path   The path of the file.
+ * @param offset The offset of the data to write.
+ * @param buffer The data to write.
+ * @param size   New size of the file.
+ */
+void condor2nav::platform::FilePatch(const bfs::path &path, size_t offset, const TBuffer &buffer, size_t size)
+{
+  const int fd = ::open(path.string().c_str(), O_WRONLY | O_CLOEXEC);
+  if(fd < 0)
+    throw EOperationFailed{"ERROR: Couldn't open file '" + path.string() + "' for writing!!!"};
+  struct TGuard {
+    const int fd;
+    ~TGuard() { ::close(fd); }
+  } guard{fd};
+
+  size_t done = 0;
+  while(done < buffer.size) {
+    const auto written = ::pwrite(fd, buffer.data + done, buffer.size - done, static_cast<off_t>(offset + done));
+    if(written < 0) {
+      if(errno == EINTR)
+        continue;
+      throw EOperationFailed{"ERROR: Writing file '" + path.string() + "'!!!"};
+    }
+    done += written;
+  }
+  if(::ftruncate(fd, static_cast<off_t>(size)) < 0)
+    throw EOperationFailed{"ERROR: Writing file '" + path.string() + "'!!!"};
+}
+
+#endif
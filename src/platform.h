@@ -0,0 +1,103 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file platform.h
+ *
+ * @brief Declares the operating system abstraction layer. 
+ */
+
+#ifndef __PLATFORM_H__
+#define __PLATFORM_H__
+
+#include "nonCopyable.h"
+#include "boostfwd.h"
+#include <cstddef>
+#include <string>
+
+namespace condor2nav {
+
+  /**
+   * @brief Operating system abstraction layer.
+   *
+   * Everything that depends on the operating system and is used by the translator
+   * core is provided here so that the rest of the code is portable.
+   */
+  namespace platform {
+
+    /**
+     * @brief Dynamic library.
+     *
+     * condor2nav::platform::CLibrary class loads a dynamic library (DLL on Windows,
+     * shared object elsewhere) for the time of its life.
+     */
+    class CLibrary : CNonCopyable {
+      void *_handle;                            ///< @brief Library handle.
+      void *Symbol(const std::string &name) const;
+
+    public:
+      explicit CLibrary(const bfs::path &path);
+      ~CLibrary();
+
+      /**
+       * @brief Checks if the library was loaded.
+       *
+       * @return @p true if the library was loaded.
+       */
+      bool Loaded() const { return _handle != nullptr; }
+
+      /**
+       * @brief Maps library symbol.
+       *
+       * Method maps the function exported by the library.
+       *
+       * @param name The name of the function.
+       * @param out  Function pointer to set.
+       *
+       * @return @p false if the function is not exported by the library.
+       */
+      template<typename T>
+      bool Symbol(const std::string &name, T &out) const
+      {
+        out = reinterpret_cast<T>(Symbol(name));
+        return out != nullptr;
+      }
+    };
+
+    /**
+     * @brief Data buffer of a gather write.
+     */
+    struct TBuffer {
+      const char *data;                         ///< @brief Buffer data.
+      size_t size;                              ///< @brief Buffer size in bytes.
+    };
+
+    bfs::path CondorInstallPath();
+    std::string Environment(const std::string &name);
+    bfs::path UserDataPath();
+    void FileWrite(const bfs::path &path, const TBuffer buffers[], size_t num);
+    void FilePatch(const bfs::path &path, size_t offset, const TBuffer &buffer, size_t size);
+
+  }
+
+}
+
+#endif /* __PLATFORM_H__ */
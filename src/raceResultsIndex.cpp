@@ -0,0 +1,227 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file raceResultsIndex.cpp
+ *
+ * @brief Implements the condor2nav::CRaceResultsIndex class. 
+ */
+
+#include "raceResultsIndex.h"
+#include "traitsNoCase.h"
+#include "tools.h"
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <set>
+#include <cstdlib>
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CRaceResultsIndex class constructor. Loads persisted index and
+ * updates it with the current directory content.
+ *
+ * @param dirPath   Race results directory.
+ * @param indexPath Index file path.
+ */
+condor2nav::CRaceResultsIndex::CRaceResultsIndex(bfs::path dirPath, bfs::path indexPath) :
+  _dirPath{std::move(dirPath)}, _indexPath{std::move(indexPath)}, _dirTime{0}, _scanTime{0}
+{
+  Load();
+  Update();
+}
+
+
+/**
+ * @brief Loads persisted index.
+ *
+ * Method loads the index from the file. Index stored for other directory
+ * or corrupted is ignored.
+ */
+void condor2nav::CRaceResultsIndex::Load()
+{
+  bfs::ifstream stream{_indexPath};
+  std::string line;
+  if(!std::getline(stream, line) || line != _dirPath.string())
+    return;
+
+  if(!(stream >> _dirTime >> _scanTime) || !std::getline(stream, line)) {
+    _dirTime = _scanTime = 0;
+    return;
+  }
+
+  while(std::getline(stream, line)) {
+    const auto pos = line.find(',');
+    if(pos == std::string::npos || pos == 0)
+      continue;
+    char *end;
+    const auto time = static_cast<std::time_t>(std::strtoll(line.c_str(), &end, 10));
+    if(end != line.c_str() + pos)
+      continue;
+    Add(line.substr(pos + 1), time);
+  }
+}
+
+
+/**
+ * @brief Persists the index.
+ *
+ * Method stores the index in the file. The index is only a cache so
+ * write errors are ignored.
+ */
+void condor2nav::CRaceResultsIndex::Save() const
+{
+  bfs::ofstream stream{_indexPath, std::ios_base::out | std::ios_base::binary};
+  stream << _dirPath.string() << "\n";
+  stream << _dirTime << " " << _scanTime << "\n";
+  for(const auto &file : _times)
+    stream << file.first << "," << file.second << "\n";
+}
+
+
+/**
+ * @brief Adds file to the index.
+ *
+ * @param name The name of the file.
+ * @param time File modification time.
+ */
+void condor2nav::CRaceResultsIndex::Add(const std::string &name, std::time_t time)
+{
+  const auto it = _files.find(name);
+  if(it != _files.end())
+    Remove(it);
+  _files.emplace(name, time);
+  _times.emplace_hint(_times.upper_bound(time), time, name);
+}
+
+
+/**
+ * @brief Removes file from the index.
+ *
+ * @param it Iterator to the file to remove.
+ */
+void condor2nav::CRaceResultsIndex::Remove(CFilesMap::iterator it)
+{
+  const auto range = _times.equal_range(it->second);
+  for(auto timeIt = range.first; timeIt != range.second; ++timeIt) {
+    if(timeIt->second == it->first) {
+      _times.erase(timeIt);
+      break;
+    }
+  }
+  _files.erase(it);
+}
+
+
+/**
+ * @brief Scans the directory.
+ *
+ * Method adds new FPL files to the index and removes the ones that do not exist
+ * anymore. Modification time is read only for files that are not indexed yet.
+ *
+ * @return @p true if the index was changed.
+ */
+bool condor2nav::CRaceResultsIndex::Scan()
+{
+  bool changed = false;
+  size_t found = 0;
+  boost::system::error_code ec;
+  for(bfs::directory_iterator it{_dirPath, ec}, end; !ec && it != end; it.increment(ec)) {
+    const auto &path = it->path();
+    if(CStringNoCase{path.extension().string().c_str()} != ".fpl")
+      continue;
+
+    auto name = path.filename().string();
+    if(!_files.count(name)) {
+      boost::system::error_code timeEc;
+      const auto time = bfs::last_write_time(path, timeEc);
+      if(timeEc)
+        continue;
+      Add(name, time);
+      changed = true;
+    }
+    ++found;
+  }
+  if(ec)
+    throw EOperationFailed{"ERROR: Cannot read race results directory '" + _dirPath.string() + "'!!!"};
+
+  // remove deleted files (rare so directory is listed again only when needed)
+  if(found != _files.size()) {
+    std::set<std::string> names;
+    for(bfs::directory_iterator it{_dirPath, ec}, end; !ec && it != end; it.increment(ec))
+      names.emplace(it->path().filename().string());
+    if(ec)
+      throw EOperationFailed{"ERROR: Cannot read race results directory '" + _dirPath.string() + "'!!!"};
+    for(auto it = _files.begin(); it != _files.end(); ) {
+      if(!names.count(it->first)) {
+        Remove(it++);
+        changed = true;
+      }
+      else
+        ++it;
+    }
+  }
+  return changed;
+}
+
+
+/**
+ * @brief Updates the index.
+ *
+ * Method verifies directory modification time and scans the directory only
+ * if it has changed since the last scan. If the directory was modified in the
+ * same second as the last scan was done it is always scanned again as some
+ * changes could have been missed because of time resolution.
+ */
+void condor2nav::CRaceResultsIndex::Update()
+{
+  boost::system::error_code ec;
+  const auto dirTime = bfs::last_write_time(_dirPath, ec);
+  if(ec)
+    throw EOperationFailed{"ERROR: Cannot find race results directory '" + _dirPath.string() + "'!!!"};
+  if(dirTime == _dirTime && dirTime < _scanTime)
+    return;
+
+  const auto scanTime = std::time(nullptr);
+  const bool changed = Scan();
+  if(changed || dirTime != _dirTime || scanTime != _scanTime) {
+    _dirTime = dirTime;
+    _scanTime = scanTime;
+    Save();
+  }
+}
+
+
+/**
+ * @brief Returns the latest results.
+ *
+ * @param num The number of results to return.
+ *
+ * @return The paths of up to @p num last modified FPL files (the latest first).
+ */
+auto condor2nav::CRaceResultsIndex::Last(size_t num) const -> CPathList
+{
+  CPathList results;
+  for(auto it = _times.rbegin(); it != _times.rend() && results.size() < num; ++it)
+    results.emplace_back(_dirPath / it->second);
+  return results;
+}
@@ -0,0 +1,84 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file raceResultsIndex.h
+ *
+ * @brief Declares the condor2nav::CRaceResultsIndex class. 
+ */
+
+#ifndef __RACERESULTSINDEX_H__
+#define __RACERESULTSINDEX_H__
+
+#include "nonCopyable.h"
+#include "boostfwd.h"
+#include <boost/filesystem/path.hpp>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Condor race results index.
+   *
+   * condor2nav::CRaceResultsIndex class keeps the list of FPL files from Condor race
+   * results directory sorted by their modification time. The index is persisted
+   * in a file and updated incrementally. Directory is scanned again only if its
+   * modification time changed and only new files are queried for their modification
+   * time.
+   *
+   * @note Directory modification time changes only when files are added, removed or
+   *       renamed. FPL files rewritten in place or removed and created again under the
+   *       same name between two updates are not reordered.
+   */
+  class CRaceResultsIndex : CNonCopyable {
+  public:
+    using CPathList = std::vector<bfs::path>;
+
+  private:
+    using CFilesMap = std::map<std::string, std::time_t>;           ///< @brief File modification times by name.
+    using CTimesMap = std::multimap<std::time_t, std::string>;      ///< @brief File names by modification time.
+
+    const bfs::path _dirPath;                   ///< @brief Race results directory.
+    const bfs::path _indexPath;                 ///< @brief Index file path.
+    std::time_t _dirTime;                       ///< @brief Directory modification time during the last scan.
+    std::time_t _scanTime;                      ///< @brief The time of the last scan.
+    CFilesMap _files;                           ///< @brief Indexed files.
+    CTimesMap _times;                           ///< @brief Indexed files sorted by modification time.
+
+    void Load();
+    void Save() const;
+    void Add(const std::string &name, std::time_t time);
+    void Remove(CFilesMap::iterator it);
+    bool Scan();
+
+  public:
+    CRaceResultsIndex(bfs::path dirPath, bfs::path indexPath);
+    void Update();
+    size_t Size() const { return _files.size(); }
+    CPathList Last(size_t num) const;
+  };
+
+}
+
+#endif /* __RACERESULTSINDEX_H__ */
@@ -0,0 +1,91 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file reader.cpp
+ *
+ * @brief Implements the condor2nav::CReader class hierarchy. 
+ */
+
+#include "reader.h"
+#include "exception.h"
+#include <algorithm>
+#include <cstring>
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CReaderFile class constructor that opens the file.
+ *
+ * @param path The path of the file.
+ */
+condor2nav::CReaderFile::CReaderFile(const bfs::path &path) :
+  _stream{path, std::ios_base::in | std::ios_base::binary}
+{
+  if(!_stream)
+    throw EOperationFailed{"ERROR: Couldn't open file '" + path.string() + "' for reading!!!"};
+}
+
+
+/**
+ * @brief Reads next chunk of the file.
+ *
+ * @param buffer The buffer to fill.
+ * @param size   The size of the buffer.
+ *
+ * @return The number of bytes read (0 at the end of the file).
+ */
+size_t condor2nav::CReaderFile::Read(char *buffer, size_t size)
+{
+  _stream.read(buffer, size);
+  return static_cast<size_t>(_stream.gcount());
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CReaderString class constructor.
+ *
+ * @param data Data to read.
+ */
+condor2nav::CReaderString::CReaderString(std::string data) :
+  _data{std::move(data)}, _pos{0}
+{
+}
+
+
+/**
+ * @brief Reads next chunk of the data.
+ *
+ * @param buffer The buffer to fill.
+ * @param size   The size of the buffer.
+ *
+ * @return The number of bytes read (0 at the end of the data).
+ */
+size_t condor2nav::CReaderString::Read(char *buffer, size_t size)
+{
+  const auto count = (std::min)(size, _data.size() - _pos);
+  std::memcpy(buffer, _data.data() + _pos, count);
+  _pos += count;
+  return count;
+}
@@ -0,0 +1,86 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file reader.h
+ *
+ * @brief Declares the condor2nav::CReader class hierarchy. 
+ */
+
+#ifndef __READER_H__
+#define __READER_H__
+
+#include "nonCopyable.h"
+#include "boostfwd.h"
+#include <boost/filesystem/fstream.hpp>
+#include <string>
+
+namespace condor2nav {
+
+  /**
+   * @brief Chunked data reader.
+   *
+   * condor2nav::CReader is an interface of data sources read in chunks
+   * (local files, device files, network downloads).
+   */
+  class CReader : CNonCopyable {
+  public:
+    enum { CHUNK_SIZE = 32 * 1024 };                  ///< @brief Default size of the chunk read at once.
+
+    virtual ~CReader() {}
+
+    /**
+     * @brief Reads next chunk of data.
+     *
+     * @param buffer Buffer for data.
+     * @param size   Buffer size.
+     *
+     * @return The number of bytes read (0 at the end of data).
+     */
+    virtual size_t Read(char *buffer, size_t size) = 0;
+  };
+
+
+  /**
+   * @brief Local file reader.
+   */
+  class CReaderFile : public CReader {
+    bfs::ifstream _stream;                            ///< @brief File stream.
+  public:
+    explicit CReaderFile(const bfs::path &path);
+    size_t Read(char *buffer, size_t size) override;
+  };
+
+
+  /**
+   * @brief Memory buffer reader.
+   */
+  class CReaderString : public CReader {
+    const std::string _data;                          ///< @brief Data to read.
+    size_t _pos;                                      ///< @brief Current position in data.
+  public:
+    explicit CReaderString(std::string data);
+    size_t Read(char *buffer, size_t size) override;
+  };
+
+}
+
+#endif /* __READER_H__ */
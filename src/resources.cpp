@@ -0,0 +1,122 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file resources.cpp
+ *
+ * @brief Implements the condor2nav::CResources class. 
+ */
+
+#include "resources.h"
+#include "translationCache.h"
+#include <boost/filesystem.hpp>
+
+
+/**
+ * @brief Returns cached file parser.
+ *
+ * Method returns the parser of the file from the cache. The file is parsed again
+ * if it was not cached yet or if it was modified since the last parse. Remote
+ * (ActiveSync) files are never cached.
+ *
+ * @param cache    The cache to use.
+ * @param filePath The path of the file to parse.
+ *
+ * @return File parser.
+ */
+template<class T>
+std::shared_ptr<const T> condor2nav::CResources::Parser(std::map<bfs::path, TFileEntry<T>> &cache, const bfs::path &filePath) const
+{
+  if(PathType(filePath) != TPathType::LOCAL)
+    return std::make_shared<T>(filePath);
+
+  boost::system::error_code ec;
+  const auto time = bfs::last_write_time(filePath, ec);
+  const auto size = ec ? 0 : bfs::file_size(filePath, ec);
+
+  std::shared_ptr<const T> parser;
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto &entry = cache[filePath];
+    if(!entry.parser || ec || entry.time != time || entry.size != size) {
+      entry.parser = std::make_shared<T>(filePath);
+      entry.time = time;
+      entry.size = size;
+      return entry.parser;
+    }
+    parser = entry.parser;
+  }
+
+  // file not read again so let translation cache know about it
+  CTranslationCache::CRecorder::OnFileRead(filePath);
+  return parser;
+}
+
+
+/**
+ * @brief Returns CSV file parser.
+ *
+ * Method returns parser of provided CSV file.
+ *
+ * @param filePath The path of the CSV file.
+ *
+ * @return CSV file parser.
+ */
+std::shared_ptr<const condor2nav::CFileParserCSV> condor2nav::CResources::CSVParser(const bfs::path &filePath) const
+{
+  return Parser(_csvParsers, filePath);
+}
+
+
+/**
+ * @brief Returns INI file parser.
+ *
+ * Method returns a private copy of provided INI file parser. Returned
+ * parser can be freely modified by the caller.
+ *
+ * @param filePath The path of the INI file.
+ *
+ * @return INI file parser.
+ */
+std::unique_ptr<condor2nav::CFileParserINI> condor2nav::CResources::INIParser(const bfs::path &filePath) const
+{
+  return Parser(_iniParsers, filePath)->Clone();
+}
+
+
+/**
+ * @brief Returns coordinates converter.
+ *
+ * Method returns coordinates converter for provided Condor landscape.
+ *
+ * @param condorPath The path to Condor directory
+ * @param trnName    The name of the landscape.
+ *
+ * @return Coordinates converter.
+ */
+std::shared_ptr<const condor2nav::CCondor::CCoordConverter> condor2nav::CResources::CoordConverter(const bfs::path &condorPath, const std::string &trnName) const
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  auto &converter = _coordConverters[condorPath / trnName];
+  if(!converter)
+    converter = CCondor::CCoordConverter::Create(condorPath, trnName);
+  return converter;
+}
@@ -0,0 +1,80 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file resources.h
+ *
+ * @brief Declares the condor2nav::CResources class. 
+ */
+
+#ifndef __RESOURCES_H__
+#define __RESOURCES_H__
+
+#include "nonCopyable.h"
+#include "condor.h"
+#include "fileParserCSV.h"
+#include "fileParserINI.h"
+#include "boostfwd.h"
+#include <ctime>
+#include <map>
+#include <mutex>
+
+namespace condor2nav {
+
+  /**
+   * @brief Translation resources cache.
+   *
+   * condor2nav::CResources class keeps data that do not change between translations
+   * (data CSV files, profile templates and landscape coordinates converters) so that
+   * several translations run by one process do not need to load them again. Local
+   * files are reloaded only when they were modified on disk. All methods are thread-safe.
+   */
+  class CResources : CNonCopyable {
+    /**
+     * @brief Cached file entry.
+     */
+    template<class T>
+    struct TFileEntry {
+      std::time_t time;
+      uintmax_t size;
+      std::shared_ptr<const T> parser;
+    };
+    using CCSVParsersMap = std::map<bfs::path, TFileEntry<CFileParserCSV>>;
+    using CINIParsersMap = std::map<bfs::path, TFileEntry<CFileParserINI>>;
+    using CCoordConvertersMap = std::map<bfs::path, std::shared_ptr<const CCondor::CCoordConverter>>;
+
+    mutable std::mutex _mutex;                               ///< @brief Cache access guard.
+    mutable CCSVParsersMap _csvParsers;                      ///< @brief Cached CSV files.
+    mutable CINIParsersMap _iniParsers;                      ///< @brief Cached INI files.
+    mutable CCoordConvertersMap _coordConverters;            ///< @brief Cached coordinates converters.
+
+    template<class T>
+    std::shared_ptr<const T> Parser(std::map<bfs::path, TFileEntry<T>> &cache, const bfs::path &filePath) const;
+
+  public:
+    std::shared_ptr<const CFileParserCSV> CSVParser(const bfs::path &filePath) const;
+    std::unique_ptr<CFileParserINI> INIParser(const bfs::path &filePath) const;
+    std::shared_ptr<const CCondor::CCoordConverter> CoordConverter(const bfs::path &condorPath, const std::string &trnName) const;
+  };
+
+}
+
+#endif /* __RESOURCES_H__ */
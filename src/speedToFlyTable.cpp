@@ -0,0 +1,293 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file speedToFlyTable.cpp
+ *
+ * @brief Implements the condor2nav::CSpeedToFlyTable class. 
+ */
+
+#include "speedToFlyTable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CONDOR2NAV_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+  /**
+   * @brief Converts the value to unsigned fixed point 16-bit number.
+   *
+   * @param value The value to convert.
+   * @param scale The scale of fixed point number.
+   *
+   * @return Fixed point number (saturated to 16-bit range).
+   */
+  std::uint16_t Fixed(double value, double scale)
+  {
+    const double v = std::floor(value * scale + 0.5);
+    if(!(v > 0))
+      return 0;
+    return static_cast<std::uint16_t>((std::min)(v, static_cast<double>(std::numeric_limits<std::uint16_t>::max())));
+  }
+
+}
+
+
+/**
+ * @brief Writes 16-bit integer to the image.
+ *
+ * @param offset The offset of the value in the image.
+ * @param value  The value to write.
+ */
+void condor2nav::CSpeedToFlyTable::PutShort(size_t offset, std::uint16_t value)
+{
+  _buffer[offset]     = static_cast<char>(value);
+  _buffer[offset + 1] = static_cast<char>(value >> 8);
+}
+
+
+/**
+ * @brief Writes 32-bit integer to the image.
+ *
+ * @param offset The offset of the value in the image.
+ * @param value  The value to write.
+ */
+void condor2nav::CSpeedToFlyTable::PutInt(size_t offset, std::int32_t value)
+{
+  const auto v = static_cast<std::uint32_t>(value);
+  for(unsigned i = 0; i < 4; ++i)
+    _buffer[offset + i] = static_cast<char>(v >> (8 * i));
+}
+
+
+/**
+ * @brief Reads 16-bit integer from the image.
+ *
+ * @param offset The offset of the value in the image.
+ *
+ * @return The value.
+ */
+unsigned condor2nav::CSpeedToFlyTable::GetShort(size_t offset) const
+{
+  return static_cast<unsigned char>(_buffer[offset]) | static_cast<unsigned char>(_buffer[offset + 1]) << 8;
+}
+
+
+/**
+ * @brief Returns the size of the table file.
+ *
+ * @return The size of the table file in bytes.
+ */
+size_t condor2nav::CSpeedToFlyTable::Size()
+{
+  return HEADER_SIZE + BALLAST_NUM * WIND_NUM * MC_NUM * CELL_SIZE;
+}
+
+
+/**
+ * @brief Returns polar curve equation coefficients.
+ *
+ * Method calculates XCSoar polar curve equation coefficients from 3 polar curve
+ * points and scales them for provided weights.
+ *
+ * @param speed         An array of 3 speeds from polar curve [km/h].
+ * @param sink          An array of 3 sinks from polar curve [m/s].
+ * @param weight        Glider + pilot mass.
+ * @param ballastLitres The amount of water ballast.
+ * @param coeffs        Equation coefficients (a, b, c) for the speed in m/s.
+ */
+void condor2nav::CSpeedToFlyTable::Coefficients(const double (&speed)[3], const double (&sink)[3], double weight, double ballastLitres, double (&coeffs)[3])
+{
+  const double v1 = speed[0] / 3.6, v2 = speed[1] / 3.6, v3 = speed[2] / 3.6;
+  const double w1 = sink[0], w2 = sink[1], w3 = sink[2];
+
+  double polar[3];
+  double d = v1 * v1 * (v2 - v3) + v2 * v2 * (v3 - v1) + v3 * v3 * (v1 - v2);
+  polar[0] = d == 0.0 ? 0 : ((v2 - v3) * (w1 - w3) + (v3 - v1) * (w2 - w3)) / d;
+  d = v2 - v3;
+  polar[1] = d == 0.0 ? 0 : (w2 - w3 - polar[0] * (v2 * v2 - v3 * v3)) / d;
+  polar[2] = w3 - polar[0] * v3 * v3 - polar[1] * v3;
+
+  // scale for the mass with water ballast
+  const double dry = std::sqrt(weight);
+  const double ballast = std::sqrt(ballastLitres + weight);
+  coeffs[0] = polar[0] * dry / ballast;
+  coeffs[1] = polar[1];
+  coeffs[2] = polar[2] / dry * ballast;
+}
+
+
+/**
+ * @brief XCSoar speed polar curve equation.
+ *
+ * @param a  Equation argument.
+ * @param b  Equation argument.
+ * @param c  Equation argument.
+ * @param MC MacCready value [m/s].
+ * @param HW Head wind [m/s].
+ * @param V  Speed [m/s].
+ *
+ * @return Calculated sink [m/s].
+ */
+double condor2nav::CSpeedToFlyTable::SinkRate(double a, double b, double c, double MC, double HW, double V)
+{
+  return a * (V + HW) * (V + HW) + b * (V + HW) + c - MC;
+}
+
+
+/**
+ * @brief Calculates glider performance for a number of MacCready values.
+ *
+ * Method calculates speed to fly, sink, glide ratio over the ground and average
+ * cross-country speed for provided MacCready values and the same head wind.
+ *
+ * @param coeffs   Polar curve equation coefficients (for the speed in m/s).
+ * @param headWind Head wind component [m/s] (negative for tail wind).
+ * @param mc       MacCready values [m/s].
+ * @param cells    Calculated performance.
+ * @param num      The number of MacCready values.
+ */
+void condor2nav::CSpeedToFlyTable::Solve(const double (&coeffs)[3], double headWind, const double *mc, TCell *cells, unsigned num)
+{
+  const double a = coeffs[0], b = coeffs[1], c = coeffs[2];
+  unsigned i = 0;
+
+#ifdef CONDOR2NAV_SSE2
+  const __m128d va = _mm_set1_pd(a);
+  const __m128d vb = _mm_set1_pd(b);
+  const __m128d vc = _mm_set1_pd(c);
+  const __m128d vhw = _mm_set1_pd(headWind);
+  const __m128d vhw2 = _mm_set1_pd(headWind * headWind);
+  const __m128d vbhw = _mm_set1_pd(b * headWind);
+  const __m128d vkmh = _mm_set1_pd(3.6);
+  const __m128d zero = _mm_setzero_pd();
+  for(; i + 2 <= num; i += 2) {
+    const __m128d m = _mm_loadu_pd(mc + i);
+    // V = HW + sqrt(HW^2 - (MC - c - b*HW) / a)
+    const __m128d k = _mm_sub_pd(_mm_sub_pd(m, vc), vbhw);
+    const __m128d disc = _mm_max_pd(_mm_sub_pd(vhw2, _mm_div_pd(k, va)), zero);
+    const __m128d v = _mm_add_pd(vhw, _mm_sqrt_pd(disc));
+    const __m128d w = _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(va, v), v), _mm_mul_pd(vb, v)), vc);
+    const __m128d ground = _mm_sub_pd(v, vhw);
+    const __m128d ld = _mm_div_pd(ground, _mm_sub_pd(zero, w));
+    const __m128d xc = _mm_div_pd(_mm_mul_pd(m, ground), _mm_sub_pd(m, w));
+
+    double speed[2], sink[2], groundLD[2], xcSpeed[2];
+    _mm_storeu_pd(speed, _mm_mul_pd(v, vkmh));
+    _mm_storeu_pd(sink, w);
+    _mm_storeu_pd(groundLD, ld);
+    _mm_storeu_pd(xcSpeed, _mm_mul_pd(xc, vkmh));
+    for(unsigned j = 0; j < 2; ++j)
+      cells[i + j] = TCell{speed[j], sink[j], groundLD[j], xcSpeed[j]};
+  }
+#endif
+
+  for(; i < num; ++i) {
+    const double v = headWind + std::sqrt((std::max)(headWind * headWind - (mc[i] - c - b * headWind) / a, 0.0));
+    const double ground = v - headWind;
+    const double sink = SinkRate(a, b, c, 0, 0, v);
+    const double netSink = SinkRate(a, b, c, mc[i], headWind, ground);
+    cells[i] = TCell{v * 3.6, sink, ground / -sink, mc[i] * ground / -netSink * 3.6};
+  }
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CSpeedToFlyTable class constructor. Calculates the whole table.
+ *
+ * @param speed        An array of 3 speeds from glider polar curve [km/h].
+ * @param sink         An array of 3 sinks from glider polar curve [m/s].
+ * @param massDryGross Glider mass with empty water tanks [kg].
+ * @param ballastMax   Maximum water ballast [liters].
+ */
+condor2nav::CSpeedToFlyTable::CSpeedToFlyTable(const double (&speed)[3], const double (&sink)[3], unsigned massDryGross, unsigned ballastMax) :
+  _buffer(Size(), '\0')
+{
+  _buffer.replace(HEADER_MAGIC, 4, "C2NS");
+  PutShort(HEADER_VERSION, VERSION);
+  PutShort(HEADER_CELL_SIZE, CELL_SIZE);
+  PutShort(HEADER_MC_NUM, MC_NUM);
+  PutShort(HEADER_BALLAST_NUM, BALLAST_NUM);
+  PutShort(HEADER_WIND_NUM, WIND_NUM);
+  PutInt(HEADER_MC_STEP, MC_STEP);
+  PutInt(HEADER_BALLAST_MAX, ballastMax);
+  PutInt(HEADER_WIND_MIN, WIND_MIN);
+  PutInt(HEADER_WIND_STEP, WIND_STEP);
+  PutInt(HEADER_MASS_DRY_GROSS, massDryGross);
+
+  double mc[MC_NUM];
+  for(unsigned i = 0; i < MC_NUM; ++i)
+    mc[i] = i * MC_STEP / 1000.0;
+
+  TCell cells[MC_NUM];
+  size_t offset = HEADER_SIZE;
+  for(unsigned ballast = 0; ballast < BALLAST_NUM; ++ballast) {
+    double coeffs[3];
+    Coefficients(speed, sink, massDryGross, static_cast<double>(ballastMax) * ballast / (BALLAST_NUM - 1), coeffs);
+    for(unsigned wind = 0; wind < WIND_NUM; ++wind) {
+      Solve(coeffs, (WIND_MIN + static_cast<int>(wind * WIND_STEP)) / 1000.0, mc, cells, MC_NUM);
+      for(const auto &cell : cells) {
+        PutShort(offset + CELL_SPEED, Fixed(cell.speed, 10));
+        PutShort(offset + CELL_SINK, Fixed(-cell.sink, 1000));
+        PutShort(offset + CELL_GROUND_LD, Fixed(cell.groundLD, 100));
+        PutShort(offset + CELL_XC_SPEED, Fixed(cell.xcSpeed, 10));
+        offset += CELL_SIZE;
+      }
+    }
+  }
+}
+
+
+/**
+ * @brief Returns table cell.
+ *
+ * Method decodes the cell stored in the table.
+ *
+ * @param ballast Ballast index.
+ * @param wind    Head wind index.
+ * @param mc      MacCready index.
+ *
+ * @return Table cell (with the precision of stored values).
+ */
+auto condor2nav::CSpeedToFlyTable::Cell(unsigned ballast, unsigned wind, unsigned mc) const -> TCell
+{
+  const size_t offset = HEADER_SIZE + ((ballast * WIND_NUM + wind) * MC_NUM + mc) * CELL_SIZE;
+  return TCell{GetShort(offset + CELL_SPEED) / 10.0, -(GetShort(offset + CELL_SINK) / 1000.0),
+               GetShort(offset + CELL_GROUND_LD) / 100.0, GetShort(offset + CELL_XC_SPEED) / 10.0};
+}
+
+
+/**
+ * @brief Returns table file data.
+ *
+ * @return Table file image.
+ */
+const std::string &condor2nav::CSpeedToFlyTable::Data() const
+{
+  return _buffer;
+}
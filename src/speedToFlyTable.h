@@ -0,0 +1,125 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file speedToFlyTable.h
+ *
+ * @brief Declares the condor2nav::CSpeedToFlyTable class. 
+ */
+
+#ifndef __SPEEDTOFLYTABLE_H__
+#define __SPEEDTOFLYTABLE_H__
+
+#include "nonCopyable.h"
+#include <cstdint>
+#include <string>
+
+namespace condor2nav {
+
+  /**
+   * @brief MacCready speed to fly and final glide tables.
+   *
+   * condor2nav::CSpeedToFlyTable class precomputes glider performance for a dense grid of
+   * MacCready settings, water ballast volumes and head wind components so the navigation
+   * device does not have to solve speed to fly in real time. For every grid cell the table
+   * provides the speed to fly, the sink at that speed, the glide ratio over the ground (used
+   * for final glide) and the average cross-country speed.
+   *
+   * The polar curve is described by 3 points in the same way as XCSoar does it and is scaled
+   * for the glider mass and water ballast with the XCSoar equations.
+   *
+   * The speed to fly is calculated in closed form for the quadratic polar curve (w = a*V^2 + b*V + c)
+   * as the airspeed V maximizing (V - HW) / (MC - w), that is V = HW + sqrt(HW^2 + (MC - c - b*HW) / -a).
+   * Whole MacCready rows are calculated at once with SSE2 when available.
+   *
+   * The table is stored in a compact binary file (little-endian, fixed point values) described
+   * with the layout enumerations below. Cells are ordered by ballast, head wind and MacCready.
+   */
+  class CSpeedToFlyTable : CNonCopyable {
+  public:
+    /**
+     * @brief Layout of the file header.
+     */
+    enum THeaderLayout {
+      HEADER_MAGIC                        = 0,    ///< @brief "C2NS" 
+      HEADER_VERSION                      = 4,    ///< @brief uint16 file format version
+      HEADER_CELL_SIZE                    = 6,    ///< @brief uint16 size of one cell
+      HEADER_MC_NUM                       = 8,    ///< @brief uint16 number of MacCready values
+      HEADER_BALLAST_NUM                  = 10,   ///< @brief uint16 number of ballast values
+      HEADER_WIND_NUM                     = 12,   ///< @brief uint16 number of head wind values
+      HEADER_MC_STEP                      = 16,   ///< @brief int32 MacCready step [mm/s] (starting from 0)
+      HEADER_BALLAST_MAX                  = 20,   ///< @brief int32 maximum water ballast [liters] (starting from 0)
+      HEADER_WIND_MIN                     = 24,   ///< @brief int32 the lowest head wind [mm/s] (negative for tail wind)
+      HEADER_WIND_STEP                    = 28,   ///< @brief int32 head wind step [mm/s]
+      HEADER_MASS_DRY_GROSS               = 32,   ///< @brief int32 glider mass with empty water tanks [kg]
+      HEADER_SIZE                         = 36
+    };
+
+    /**
+     * @brief Layout of one table cell.
+     */
+    enum TCellLayout {
+      CELL_SPEED                          = 0,    ///< @brief uint16 speed to fly [0.1 km/h]
+      CELL_SINK                           = 2,    ///< @brief uint16 sink at speed to fly [mm/s]
+      CELL_GROUND_LD                      = 4,    ///< @brief uint16 glide ratio over the ground [0.01]
+      CELL_XC_SPEED                       = 6,    ///< @brief uint16 average cross-country speed [0.1 km/h]
+      CELL_SIZE                           = 8
+    };
+
+    static const unsigned VERSION = 1;            ///< @brief File format version.
+    static const unsigned MC_NUM = 51;            ///< @brief MacCready values from 0 to 5 m/s.
+    static const unsigned MC_STEP = 100;          ///< @brief MacCready step [mm/s].
+    static const unsigned BALLAST_NUM = 11;       ///< @brief Water ballast values from 0 to 100%.
+    static const unsigned WIND_NUM = 21;          ///< @brief Head wind values from -20 to 20 m/s.
+    static const int WIND_MIN = -20000;           ///< @brief The lowest head wind [mm/s].
+    static const unsigned WIND_STEP = 2000;       ///< @brief Head wind step [mm/s].
+
+    /**
+     * @brief Glider performance for one grid cell.
+     */
+    struct TCell {
+      double speed;                               ///< @brief Speed to fly [km/h].
+      double sink;                                ///< @brief Sink at speed to fly [m/s] (negative value).
+      double groundLD;                            ///< @brief Glide ratio over the ground.
+      double xcSpeed;                             ///< @brief Average cross-country speed [km/h].
+    };
+
+  private:
+    std::string _buffer;                          ///< @brief Table file image.
+
+    void PutShort(size_t offset, std::uint16_t value);
+    void PutInt(size_t offset, std::int32_t value);
+    unsigned GetShort(size_t offset) const;
+
+  public:
+    static size_t Size();
+    static void Coefficients(const double (&speed)[3], const double (&sink)[3], double weight, double ballastLitres, double (&coeffs)[3]);
+    static double SinkRate(double a, double b, double c, double MC, double HW, double V);
+    static void Solve(const double (&coeffs)[3], double headWind, const double *mc, TCell *cells, unsigned num);
+
+    CSpeedToFlyTable(const double (&speed)[3], const double (&sink)[3], unsigned massDryGross, unsigned ballastMax);
+    TCell Cell(unsigned ballast, unsigned wind, unsigned mc) const;
+    const std::string &Data() const;
+  };
+
+}
+
+#endif /* __SPEEDTOFLYTABLE_H__ */
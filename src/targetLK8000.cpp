@@ -28,7 +28,8 @@
 #include "targetLK8000.h"
 #include "imports/lk8000Types.h"
 #include "ostream.h"
-#include <array>
+#include "resources.h"
+#include "taskImage.h"
 
 
 const bfs::path condor2nav::CTargetLK8000::AIRSPACES_SUBDIR    = "_Airspaces";
@@ -50,11 +51,12 @@ const bfs::path condor2nav::CTargetLK8000::OUTPUT_AIRCRAFT_PROFILE_NAME  = "Cond
  * condor2nav::CTargetLK8000 class constructor.
  *
  * @param translator Configuration INI file parser.
+ * @param outputPath Translation output directory.
  */
-condor2nav::CTargetLK8000::CTargetLK8000(const CTranslator &translator) :
-  CTargetXCSoarCommon{translator},
+condor2nav::CTargetLK8000::CTargetLK8000(const CTranslator &translator, bfs::path outputPath) :
+  CTargetXCSoarCommon{translator, std::move(outputPath)},
   _outputLK8000DataPath{OutputPath() / "LK8000"},
-  _condor2navDataPathString{ConfigParser().Value("LK8000", "LK8000Path")}
+  _condor2navDataPathString{Config().lk8000.lk8000Path}
 {
   // prepare directory names
   const bfs::path subDir{"condor2nav"};
@@ -74,7 +76,7 @@ condor2nav::CTargetLK8000::CTargetLK8000(const CTranslator &translator) :
     DirectoryCreate(outputTaskDir);
     _outputTaskFilePathList.emplace_back(outputTaskDir / TASK_FILE_NAME);
   }
-  if(Convert<unsigned>(ConfigParser().Value("LK8000", "DefaultTaskOverwrite"))) {
+  if(Config().lk8000.defaultTaskOverwrite) {
     const auto outputTaskDir = _outputLK8000DataPath / TASKS_SUBDIR;
     _outputTaskFilePathList.emplace_back(outputTaskDir / DEFAULT_TASK_FILE_NAME);
   }
@@ -85,7 +87,7 @@ condor2nav::CTargetLK8000::CTargetLK8000(const CTranslator &translator) :
     _outputSystemProfilePathList.emplace_back(outputConfigDir / OUTPUT_PROFILE_NAME);
     _outputAircraftProfilePathList.emplace_back(outputConfigDir / OUTPUT_AIRCRAFT_PROFILE_NAME);
   }
-  if(Convert<unsigned>(ConfigParser().Value("LK8000", "DefaultProfilesOverwrite"))) {
+  if(Config().lk8000.defaultProfilesOverwrite) {
     const auto outputConfigDir = _outputLK8000DataPath / CONFIG_SUBDIR;
     DirectoryCreate(outputConfigDir);
     _outputSystemProfilePathList.emplace_back(outputConfigDir / DEFAULT_SYSTEM_PROFILE_NAME);
@@ -102,7 +104,7 @@ condor2nav::CTargetLK8000::CTargetLK8000(const CTranslator &translator) :
         throw EOperationFailed{"ERROR: Please copy '" + DEFAULT_SYSTEM_PROFILE_NAME.string() + "' file to '" + CTranslator::DATA_PATH.string() + "' directory."};
     }
   }
-  _systemParser = std::make_unique<CFileParserINI>(systemPath);
+  _systemParser = Translator().App().Resources().INIParser(systemPath);
 
   auto aircraftPath = _outputLK8000DataPath / CONFIG_SUBDIR / subDir / OUTPUT_AIRCRAFT_PROFILE_NAME;
   if(!FileExists(aircraftPath)) {
@@ -113,21 +115,28 @@ condor2nav::CTargetLK8000::CTargetLK8000(const CTranslator &translator) :
         throw EOperationFailed{"ERROR: Please copy '" + DEFAULT_AIRCRAFT_PROFILE_NAME.string() + "' file to '" + CTranslator::DATA_PATH.string() + "' directory."};
     }
   }
-  _aircraftParser = std::make_unique<CFileParserINI>(aircraftPath);
+  _aircraftParser = Translator().App().Resources().INIParser(aircraftPath);
 }
 
 
 /**
  * @brief Class destructor.
  *
- * condor2nav::CTargetLK8000 class destructor.
+ * condor2nav::CTargetLK8000 class destructor that writes modified profile files.
  */
-condor2nav::CTargetLK8000::~CTargetLK8000()
+condor2nav::CTargetLK8000::~CTargetLK8000() CONDOR2NAV_DTOR_THROWS
 {
+  CFileParserINI::TPatchStats total{0, 0};
+  const auto patch = [&](const CFileParserINI &parser, const bfs::path &path) {
+    const auto stats = parser.Patch(path);
+    total.size += stats.size;
+    total.written += stats.written;
+  };
   for(const auto &path : _outputSystemProfilePathList)
-    _systemParser->Dump(path);
+    patch(*_systemParser, path);
   for(const auto &path : _outputAircraftProfilePathList)
-    _aircraftParser->Dump(path);
+    patch(*_aircraftParser, path);
+  Translator().App().Log() << Name() << " profiles: " << total.written << " of " << total.size << " bytes written" << std::endl;
 }
 
 
@@ -150,50 +159,14 @@ void condor2nav::CTargetLK8000::TaskDump(CFileParserINI &profileParser,
                                          const xcsoar::START_POINT startPointArray[],
                                          const CWaypointArray &waypointArray) const
 {
-  using namespace lk8000;
-
-  COStream tskFile(_outputTaskFilePathList);
-
-  const std::string ver{"LK" + Convert(LK_TASK_VERSION) + Convert(lk8000::MAXTASKPOINTS) + Convert(lk8000::MAXSTARTPOINTS)};
-  std::array<char, 50> version{};
-  copy(begin(ver), end(ver), begin(version));
-  tskFile.Write(version.data(), version.size());
-
-  tskFile.Write(reinterpret_cast<const char *>(taskPointArray), lk8000::MAXTASKPOINTS * sizeof(taskPointArray[0]));
-
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.AATEnabled), sizeof(settingsTask.AATEnabled));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.AATTaskLength), sizeof(settingsTask.AATTaskLength));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.FinishRadius), sizeof(settingsTask.FinishRadius));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.FinishType), sizeof(settingsTask.FinishType));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.StartRadius), sizeof(settingsTask.StartRadius));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.StartType), sizeof(settingsTask.StartType));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.SectorType), sizeof(settingsTask.SectorType));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.SectorRadius), sizeof(settingsTask.SectorRadius));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.AutoAdvance), sizeof(settingsTask.AutoAdvance));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.EnableMultipleStartPoints), sizeof(settingsTask.EnableMultipleStartPoints));
-
-  tskFile.Write(reinterpret_cast<const char *>(startPointArray), lk8000::MAXSTARTPOINTS * sizeof(startPointArray[0]));
-
-  std::array<lk8000::WAYPOINT, lk8000::MAXTASKPOINTS> taskWaypointArray;
-  std::array<lk8000::WAYPOINT, lk8000::MAXSTARTPOINTS> startWaypointArray;
-  memset(taskWaypointArray.data(), 0, taskWaypointArray.size() * sizeof(taskWaypointArray[0]));
-  memset(startWaypointArray.data(), 0, startWaypointArray.size() * sizeof(startWaypointArray[0]));
-
-  for(size_t i=0; i<waypointArray.size(); ++i) {
-    taskWaypointArray[i].Number    = waypointArray[i].number;
-    taskWaypointArray[i].Latitude  = waypointArray[i].latitude;
-    taskWaypointArray[i].Longitude = waypointArray[i].longitude;
-    taskWaypointArray[i].Altitude  = waypointArray[i].altitude;
-    taskWaypointArray[i].Flags     = waypointArray[i].flags;
-    mbstowcs(taskWaypointArray[i].Name, waypointArray[i].name.c_str(), lk8000::NAME_SIZE);
-    mbstowcs(taskWaypointArray[i].Comment, waypointArray[i].comment.c_str(), lk8000::COMMENT_SIZE);
-    taskWaypointArray[i].InTask    = true;
-    taskWaypointArray[i].Style     = 1;
-  }
-  
-  tskFile.Write(reinterpret_cast<const char *>(taskWaypointArray.data()), taskWaypointArray.size() * sizeof(taskWaypointArray[0]));
-  tskFile.Write(reinterpret_cast<const char *>(startWaypointArray.data()), startWaypointArray.size() * sizeof(startWaypointArray[0]));
-  
+  CTaskImage image{CTaskImage::TFormat::LK8000_1_24};
+  image.TaskPoints(taskPointArray);
+  image.Settings(settingsTask);
+  image.StartPoints(startPointArray);
+  image.Waypoints(waypointArray);
+
+  COStream{_outputTaskFilePathList}.Attach(image.Data().data(), image.Data().size());
+
   profileParser.Value("", "StartMaxHeight", Convert(settingsTask.StartMaxHeight * 1000));
   profileParser.Value("", "StartMaxHeightMargin", "0");
   profileParser.Value("", "FinishMinHeight", Convert(settingsTask.FinishMinHeight * 1000));
@@ -284,6 +257,7 @@ void condor2nav::CTargetLK8000::Glider(const CFileParserCSV::CStringArray &glide
     polarFile << std::endl;
     polarFile << gliderData.at(GLIDER_FLAPS) << std::endl;
   }
+  SpeedToFlyTableProcess(gliderData, _outputLK8000DataPath / _outputPolarsSubDir);
 
   const auto ballast = Convert<unsigned>(Condor().TaskParser().Value("Plane", "Water"));
   const auto maxBallast = Convert<unsigned>(gliderData.at(GLIDER_MAX_WATER_BALLAST));
@@ -308,10 +282,26 @@ void condor2nav::CTargetLK8000::Glider(const CFileParserCSV::CStringArray &glide
  */
 void condor2nav::CTargetLK8000::Task(const CFileParserINI &taskParser, const CCondor::CCoordConverter &coordConv, const CFileParserCSV::CStringArray &sceneryData, unsigned aatTime)
 {
-  const auto wpFile = Convert<unsigned>(ConfigParser().Value("LK8000", "TaskWPFileGenerate"));
   TaskProcess(*_systemParser, taskParser, coordConv, aatTime,
               lk8000::MAXTASKPOINTS, lk8000::MAXSTARTPOINTS,
-              wpFile > 0, _outputLK8000DataPath / _outputWaypointsSubDir);
+              Config().lk8000.taskWPFileGenerate, _outputLK8000DataPath / _outputWaypointsSubDir);
+
+  // limit scenery waypoints to the task corridor
+  const auto corridorWidth = Config().lk8000.wpFileCorridorWidth;
+  const auto &wpFileName = sceneryData.at(SCENERY_WAYPOINTS_FILE);
+  if(corridorWidth > 0 && !wpFileName.empty() && Config().general.setSceneryMap) {
+    auto wpFilePath = _outputLK8000DataPath / _outputWaypointsSubDir / wpFileName;
+    if(!FileExists(wpFilePath)) {
+      wpFilePath = CTranslator::DATA_PATH / "LK8000" / _outputWaypointsSubDir / wpFileName;
+      if(!FileExists(wpFilePath))
+        wpFilePath = CTranslator::DATA_PATH / "LK8000" / "Waypoints" / wpFileName;
+    }
+    if(FileExists(wpFilePath))
+      WaypointsCorridorProcess(*_systemParser, taskParser, coordConv, wpFilePath, corridorWidth,
+                               _condor2navDataPathString + "\\" + _outputWaypointsSubDir.string(), _outputLK8000DataPath / _outputWaypointsSubDir);
+    else
+      Translator().App().Warning() << "WARNING: Scenery waypoints file '" << wpFileName << "' not found. Task corridor waypoints file will not be generated." << std::endl;
+  }
 }
  
 
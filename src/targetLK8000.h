@@ -78,8 +78,8 @@ namespace condor2nav {
                   const CWaypointArray &waypointArray) const override;
 
   public:
-    explicit CTargetLK8000(const CTranslator &translator);
-    virtual ~CTargetLK8000();
+    CTargetLK8000(const CTranslator &translator, bfs::path outputPath);
+    virtual ~CTargetLK8000() CONDOR2NAV_DTOR_THROWS;
 
     const char *Name() const override { return "LK8000"; }
     void Gps() override;
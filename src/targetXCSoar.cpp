@@ -28,7 +28,8 @@
 #include "targetXCSoar.h"
 #include "imports/xcsoarTypes.h"
 #include "ostream.h"
-#include <array>
+#include "resources.h"
+#include "taskImage.h"
 
 
 const bfs::path condor2nav::CTargetXCSoar::XCSOAR_PROFILE_NAME = "xcsoar-registry.prf";
@@ -40,18 +41,19 @@ const bfs::path condor2nav::CTargetXCSoar::XCSOAR_PROFILE_NAME = "xcsoar-registr
  * condor2nav::CTargetXCSoar class constructor.
  *
  * @param translator Configuration INI file parser.
+ * @param outputPath Translation output directory.
  */
-condor2nav::CTargetXCSoar::CTargetXCSoar(const CTranslator &translator) :
-  CTargetXCSoarCommon{translator}, _outputXCSoarDataPath{OutputPath() / "XCSoarData"}
+condor2nav::CTargetXCSoar::CTargetXCSoar(const CTranslator &translator, bfs::path outputPath) :
+  CTargetXCSoarCommon{translator, std::move(outputPath)}, _outputXCSoarDataPath{OutputPath() / "XCSoarData"}
 {
-  const bfs::path subDir{ConfigParser().Value("XCSoar", "Condor2NavDataSubDir")};
+  const auto &subDir = Config().xcsoar.condor2navDataSubDir;
   _outputCondor2NavDataPath = _outputXCSoarDataPath / subDir;
-  _condor2navDataPathString = ConfigParser().Value("XCSoar", "XCSoarDataPath") + "\\" + subDir.string();
+  _condor2navDataPathString = Config().xcsoar.xcsoarDataPath + "\\" + subDir.string();
 
   DirectoryCreate(_outputCondor2NavDataPath);
 
   _outputTaskFilePathList.emplace_back(_outputCondor2NavDataPath / TASK_FILE_NAME);
-  if(Convert<unsigned>(ConfigParser().Value("XCSoar", "DefaultTaskOverwrite")))
+  if(Config().xcsoar.defaultTaskOverwrite)
     _outputTaskFilePathList.emplace_back(_outputXCSoarDataPath / DEFAULT_TASK_FILE_NAME);
 
   auto profilePath = _outputCondor2NavDataPath / OUTPUT_PROFILE_NAME;
@@ -63,18 +65,19 @@ condor2nav::CTargetXCSoar::CTargetXCSoar(const CTranslator &translator) :
         throw EOperationFailed{"ERROR: Please copy '" + XCSOAR_PROFILE_NAME.string() + "' file to '" + CTranslator::DATA_PATH.string() + "' directory."};
     }
   }
-  _profileParser = std::make_unique<CFileParserINI>(profilePath);
+  _profileParser = Translator().App().Resources().INIParser(profilePath);
 }
 
 
 /**
  * @brief Class destructor.
  *
- * condor2nav::CTargetXCSoar class destructor.
+ * condor2nav::CTargetXCSoar class destructor that writes modified profile file.
  */
-condor2nav::CTargetXCSoar::~CTargetXCSoar()
+condor2nav::CTargetXCSoar::~CTargetXCSoar() CONDOR2NAV_DTOR_THROWS
 {
-  _profileParser->Dump(_outputCondor2NavDataPath / OUTPUT_PROFILE_NAME);
+  const auto stats = _profileParser->Patch(_outputCondor2NavDataPath / OUTPUT_PROFILE_NAME);
+  Translator().App().Log() << Name() << " profile: " << stats.written << " of " << stats.size << " bytes written" << std::endl;
 }
 
 
@@ -97,43 +100,13 @@ void condor2nav::CTargetXCSoar::TaskDump(CFileParserINI &profileParser,
                                          const xcsoar::START_POINT startPointArray[],
                                          const CWaypointArray &waypointArray) const
 {
-  using namespace xcsoar;
-
-  COStream tskFile(_outputTaskFilePathList);
-
-  tskFile.Write(reinterpret_cast<const char *>(taskPointArray), MAXTASKPOINTS * sizeof(TASK_POINT));
-
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.AATEnabled), sizeof(settingsTask.AATEnabled));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.AATTaskLength), sizeof(settingsTask.AATTaskLength));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.FinishRadius), sizeof(settingsTask.FinishRadius));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.FinishType), sizeof(settingsTask.FinishType));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.StartRadius), sizeof(settingsTask.StartRadius));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.StartType), sizeof(settingsTask.StartType));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.SectorType), sizeof(settingsTask.SectorType));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.SectorRadius), sizeof(settingsTask.SectorRadius));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.AutoAdvance), sizeof(settingsTask.AutoAdvance));
-  tskFile.Write(reinterpret_cast<const char *>(&settingsTask.EnableMultipleStartPoints), sizeof(settingsTask.EnableMultipleStartPoints));
-
-  tskFile.Write(reinterpret_cast<const char *>(startPointArray), MAXSTARTPOINTS * sizeof(START_POINT));
-
-  std::array<WAYPOINT, MAXTASKPOINTS> taskWaypointArray;
-  std::array<WAYPOINT, MAXSTARTPOINTS> startWaypointArray;
-  memset(taskWaypointArray.data(), 0, taskWaypointArray.size() * sizeof(taskWaypointArray[0]));
-  memset(startWaypointArray.data(), 0, startWaypointArray.size() * sizeof(startWaypointArray[0]));
-
-  for(size_t i=0; i<waypointArray.size(); i++) {
-    taskWaypointArray[i].Number    = waypointArray[i].number;
-    taskWaypointArray[i].Latitude  = waypointArray[i].latitude;
-    taskWaypointArray[i].Longitude = waypointArray[i].longitude;
-    taskWaypointArray[i].Altitude  = waypointArray[i].altitude;
-    taskWaypointArray[i].Flags     = waypointArray[i].flags;
-    mbstowcs(taskWaypointArray[i].Name, waypointArray[i].name.c_str(), NAME_SIZE);
-    mbstowcs(taskWaypointArray[i].Comment, waypointArray[i].comment.c_str(), COMMENT_SIZE);
-    taskWaypointArray[i].InTask    = true;
-  }
-  
-  tskFile.Write(reinterpret_cast<const char *>(taskWaypointArray.data()), taskWaypointArray.size() * sizeof(taskWaypointArray[0]));
-  tskFile.Write(reinterpret_cast<const char *>(startWaypointArray.data()), startWaypointArray.size() * sizeof(startWaypointArray[0]));
+  CTaskImage image{CTaskImage::TFormat::XCSOAR_5};
+  image.TaskPoints(taskPointArray);
+  image.Settings(settingsTask);
+  image.StartPoints(startPointArray);
+  image.Waypoints(waypointArray);
+
+  COStream{_outputTaskFilePathList}.Attach(image.Data().data(), image.Data().size());
 }
 
 
@@ -147,13 +120,14 @@ void condor2nav::CTargetXCSoar::Gps()
 {
   _profileParser->Value("", "DeviceA", "\"Condor\"");
   _profileParser->Value("", "DeviceB", _profileParser->Value("", "DeviceA"));    // copy deviceA to deviceB
-  try {
-    _profileParser->Value("", "Port2Index", _profileParser->Value("", "PortIndex"));
-    _profileParser->Value("", "Speed2Index", _profileParser->Value("", "SpeedIndex"));
-  }
-  catch(const Exception &) {
+  const auto portIndex = _profileParser->TryValue("", "PortIndex");
+  const auto speedIndex = _profileParser->TryValue("", "SpeedIndex");
+  if(portIndex)
+    _profileParser->Value("", "Port2Index", *portIndex);
+  if(portIndex && speedIndex)
+    _profileParser->Value("", "Speed2Index", *speedIndex);
+  else
     Translator().App().Warning() << "WARNING: COM port for Condor communication probably not set. Please verify that in " << Name() << " System Setup." << std::endl;
-  }
 }
 
 
@@ -221,6 +195,7 @@ void condor2nav::CTargetXCSoar::Glider(const CFileParserCSV::CStringArray &glide
     polarFile << gliderData.at(i);
   }
   polarFile << std::endl;
+  SpeedToFlyTableProcess(gliderData, _outputCondor2NavDataPath);
 
   const auto ballast = Convert<unsigned>(Condor().TaskParser().Value("Plane", "Water"));
   const auto maxBallast = Convert<unsigned>(gliderData.at(GLIDER_MAX_WATER_BALLAST));
@@ -245,10 +220,23 @@ void condor2nav::CTargetXCSoar::Glider(const CFileParserCSV::CStringArray &glide
  */
 void condor2nav::CTargetXCSoar::Task(const CFileParserINI &taskParser, const CCondor::CCoordConverter &coordConv, const CFileParserCSV::CStringArray &sceneryData, unsigned aatTime)
 {
-  const auto wpFile = Convert<unsigned>(ConfigParser().Value("XCSoar", "TaskWPFileGenerate"));
   TaskProcess(*_profileParser, taskParser, coordConv, aatTime,
               xcsoar::MAXTASKPOINTS, xcsoar::MAXSTARTPOINTS,
-              wpFile > 0, _outputCondor2NavDataPath);
+              Config().xcsoar.taskWPFileGenerate, _outputCondor2NavDataPath);
+
+  // limit scenery waypoints to the task corridor
+  const auto corridorWidth = Config().xcsoar.wpFileCorridorWidth;
+  const auto &wpFileName = sceneryData.at(SCENERY_WAYPOINTS_FILE);
+  if(corridorWidth > 0 && !wpFileName.empty() && Config().general.setSceneryMap) {
+    auto wpFilePath = _outputCondor2NavDataPath / wpFileName;
+    if(!FileExists(wpFilePath))
+      wpFilePath = CTranslator::DATA_PATH / "XCSoar" / "Waypoints" / wpFileName;
+    if(FileExists(wpFilePath))
+      WaypointsCorridorProcess(*_profileParser, taskParser, coordConv, wpFilePath, corridorWidth,
+                               _condor2navDataPathString, _outputCondor2NavDataPath);
+    else
+      Translator().App().Warning() << "WARNING: Scenery waypoints file '" << wpFileName << "' not found. Task corridor waypoints file will not be generated." << std::endl;
+  }
 }
  
 
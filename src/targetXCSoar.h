@@ -60,8 +60,8 @@ namespace condor2nav {
     COStream::CPathList _outputTaskFilePathList;          ///< @brief The path where output XCSoar task file should be located
 
   public:
-    explicit CTargetXCSoar(const CTranslator &translator);
-    ~CTargetXCSoar();
+    CTargetXCSoar(const CTranslator &translator, bfs::path outputPath);
+    ~CTargetXCSoar() CONDOR2NAV_DTOR_THROWS;
 
     const char *Name() const override { return "XCSoar 5"; }
     void Gps() override;
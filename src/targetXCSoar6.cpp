@@ -28,6 +28,7 @@
 #include "targetXCSoar6.h"
 #include "imports/xcsoarTypes.h"
 #include "ostream.h"
+#include "xmlWriter.h"
 
 
 /**
@@ -36,13 +37,115 @@
  * condor2nav::CTargetXCSoar6 class constructor.
  *
  * @param translator Configuration INI file parser.
+ * @param outputPath Translation output directory.
  */
-condor2nav::CTargetXCSoar6::CTargetXCSoar6(const CTranslator &translator) :
-  CTargetXCSoar{translator}
+condor2nav::CTargetXCSoar6::CTargetXCSoar6(const CTranslator &translator, bfs::path outputPath) :
+  CTargetXCSoar{translator, std::move(outputPath)}
 {
 }
 
 
+/**
+ * @brief Calculates task points observation zones.
+ *
+ * Method calculates observation zones of all task points. Condor task
+ * parameters are read once for every task point.
+ *
+ * @param taskParser         Condor task parser. 
+ * @param waypointArray      The array of waypoints data.
+ *
+ * @return Observation zones of task points.
+ */
+condor2nav::CTargetXCSoar6::CObservationZoneArray condor2nav::CTargetXCSoar6::ObservationZones(const CFileParserINI &taskParser,
+                                                                                              const CWaypointArray &waypointArray) const
+{
+  CObservationZoneArray zoneArray;
+  zoneArray.reserve(waypointArray.size());
+  const auto bearingsArray = NeighbourBearings(waypointArray);
+  for(size_t i=0; i<waypointArray.size(); i++) {
+    const auto tpIdxStr = Convert(i + 1);
+    const auto radius = Convert<unsigned>(taskParser.Value("Task", "TPRadius" + tpIdxStr));
+    const auto angle = Convert<unsigned>(taskParser.Value("Task", "TPAngle" + tpIdxStr));
+    if(angle == 360)
+      zoneArray.push_back(TObservationZone{TObservationZone::TType::CYLINDER, radius, 0, 0});
+    else if(angle == 180 && (i == 0 || i == (waypointArray.size() - 1)))
+      zoneArray.push_back(TObservationZone{TObservationZone::TType::LINE, radius * 2, 0, 0});
+    else {
+      const auto halfAngle = HalfAngle(bearingsArray[i]);
+      const auto astart = static_cast<unsigned>(360 + halfAngle - angle / 2.0) % 360;
+      const auto aend = static_cast<unsigned>(360 + halfAngle + angle / 2.0) % 360;
+      zoneArray.push_back(TObservationZone{TObservationZone::TType::SECTOR, radius, astart, aend});
+    }
+  }
+  return zoneArray;
+}
+
+
+/**
+ * @brief Writes XCSoar v6 task. 
+ *
+ * Method writes XCSoar v6 XML task.
+ * 
+ * @param writer             XML writer to use.
+ * @param settingsTask       Task settings
+ * @param waypointArray      The array of waypoints data.
+ * @param zoneArray          Observation zones of task points.
+ */
+void condor2nav::CTargetXCSoar6::TaskWrite(CXMLWriter &writer,
+                                           const xcsoar::SETTINGS_TASK &settingsTask,
+                                           const CWaypointArray &waypointArray,
+                                           const CObservationZoneArray &zoneArray)
+{
+  const unsigned COORD_PRECISION = 6;
+
+  writer.Start("Task");
+  if(settingsTask.AATEnabled)
+    writer.Attribute("type", "AAT").Attribute("task_scored", 1).Attribute("aat_min_time", static_cast<unsigned>(settingsTask.AATTaskLength * 60));
+  else
+    writer.Attribute("type", "RT").Attribute("task_scored", 1).Attribute("aat_min_time", 0);
+  writer.Attribute("start_max_speed", 0).Attribute("start_max_height", settingsTask.StartMaxHeight)
+    .Attribute("start_max_height_ref", 1).Attribute("finish_min_height", settingsTask.FinishMinHeight)
+    .Attribute("fai_finish", 0).Attribute("min_points", static_cast<unsigned>(waypointArray.size() - 1))
+    .Attribute("max_points", 10).Attribute("homogeneous_tps", 0).Attribute("is_closed", 0);
+
+  for(size_t i=0; i<waypointArray.size(); i++) {
+    const auto &wp = waypointArray[i];
+    writer.Start("Point");
+    if(i==0)
+      writer.Attribute("type", "Start");
+    else if(i==(waypointArray.size()-1))
+      writer.Attribute("type", "Finish");
+    else if(settingsTask.AATEnabled)
+      writer.Attribute("type", "Area");
+    else
+      writer.Attribute("type", "Turn");
+
+    writer.Start("Waypoint").Attribute("name", wp.name).Attribute("id", 0).Attribute("comment", wp.comment)
+      .Attribute("altitude", Convert(wp.altitude));
+    writer.Start("Location").Attribute("longitude", wp.longitude, COORD_PRECISION).Attribute("latitude", wp.latitude, COORD_PRECISION).End();
+    writer.End();
+
+    const auto &zone = zoneArray[i];
+    writer.Start("ObservationZone");
+    switch(zone.type) {
+    case TObservationZone::TType::CYLINDER:
+      writer.Attribute("type", "Cylinder").Attribute("radius", zone.size);
+      break;
+    case TObservationZone::TType::LINE:
+      writer.Attribute("type", "Line").Attribute("length", zone.size);
+      break;
+    case TObservationZone::TType::SECTOR:
+      writer.Attribute("type", "Sector").Attribute("radius", zone.size)
+        .Attribute("start_radial", zone.startRadial).Attribute("end_radial", zone.endRadial);
+      break;
+    }
+    writer.End();
+    writer.End();
+  }
+  writer.End();
+}
+
+
 /**
  * @brief Dumps waypoints in XCSoar v6 format. 
  *
@@ -62,79 +165,8 @@ void condor2nav::CTargetXCSoar6::TaskDump(CFileParserINI &profileParser,
                                           const xcsoar::START_POINT startPointArray[],
                                           const CWaypointArray &waypointArray) const
 {
-  using namespace xcsoar;
-
+  const auto zoneArray = ObservationZones(taskParser, waypointArray);
   COStream tskFile{_outputTaskFilePathList};
-
-  if(settingsTask.AATEnabled) {
-    tskFile << "<Task type=\"AAT\" task_scored=\"1\" aat_min_time=\""
-      << (settingsTask.AATTaskLength * 60) << "\""; 
-  }
-  else {
-    tskFile << "<Task type=\"RT\" task_scored=\"1\" aat_min_time=\"0\"";
-  }
-  tskFile << " start_max_speed=\"0\" start_max_height=\"" << settingsTask.StartMaxHeight
-    << "\" start_max_height_ref=\"1\" finish_min_height=\"" << settingsTask.FinishMinHeight
-    << "\" fai_finish=\"0\" min_points=\"" << waypointArray.size() - 1
-    << "\" max_points=\"10\" homogeneous_tps=\"0\" is_closed=\"0\">" << std::endl;
-
-  for(size_t i=0; i<waypointArray.size(); i++) {
-    tskFile << "\t<Point type=\"";
-
-    if(i==0)
-      tskFile << "Start";
-    else if(i==(waypointArray.size()-1))
-      tskFile << "Finish";
-    else if(settingsTask.AATEnabled)
-      tskFile << "Area";
-    else
-      tskFile << "Turn";
-
-    tskFile << "\">" << std::endl;
-
-    tskFile << "\t\t<Waypoint name=\"" << waypointArray[i].name << "\" id=\"0\" comment=\"" << waypointArray[i].comment <<
-      "\" altitude=\"" << waypointArray[i].altitude << "\">" << std::endl;
-    tskFile << "\t\t\t<Location longitude=\"" << waypointArray[i].longitude << "\" latitude=\""<< waypointArray[i].latitude << "\"/>" << std::endl;
-    tskFile << "\t\t</Waypoint>" << std::endl;
-
-    const auto tpIdxStr = Convert(i + 1);
-    const auto radius = Convert<unsigned>(taskParser.Value("Task", "TPRadius" + tpIdxStr));
-    const auto angle = Convert<unsigned>(taskParser.Value("Task", "TPAngle" + tpIdxStr));
-    if(angle == 360)
-      tskFile << "\t\t<ObservationZone type=\"Cylinder\" radius=\"" << radius <<"\"/>" << std::endl;
-    else {
-      if (angle==180 && (i == 0 || i == (waypointArray.size() - 1))) { 
-        tskFile << "\t\t<ObservationZone type=\"Line\" length=\"" << radius * 2 <<"\"/>" << std::endl;
-      }
-      else {			
-        unsigned angle1;
-        unsigned angle2;
-        if(i == 0)
-          angle1 = WaypointBearing(TLongitude{waypointArray[i + 1].longitude}, TLatitude{waypointArray[i + 1].latitude},
-                                   TLongitude{waypointArray[i].longitude},     TLatitude{waypointArray[i].latitude});
-        else
-          angle1 = WaypointBearing(TLongitude{waypointArray[i - 1].longitude}, TLatitude{waypointArray[i - 1].latitude},
-                                   TLongitude{waypointArray[i].longitude},     TLatitude{waypointArray[i].latitude});
-        if(i < (waypointArray.size() - 1))
-          angle2 = WaypointBearing(TLongitude{waypointArray[i + 1].longitude}, TLatitude{waypointArray[i + 1].latitude},
-                                   TLongitude{waypointArray[i].longitude},     TLatitude{waypointArray[i].latitude});
-        else
-          angle2=angle1;
-
-        unsigned halfAngle;
-        if(angle1 == angle2)
-          halfAngle = angle1;
-        else {
-          halfAngle = static_cast<unsigned>((angle1 + angle2) / 2.0);
-          if((angle1 > angle2 && angle1 - angle2 > 180) || (angle1 < angle2 && angle2 - angle1 > 180))
-            halfAngle = (halfAngle + 180) % 360;
-        }
-        const double astart = static_cast<unsigned>(360 + halfAngle - angle / 2.0) % 360;
-        const double aend = static_cast<unsigned>(360 + halfAngle + angle / 2.0) % 360;
-        tskFile << "<ObservationZone type=\"Sector\" radius=\"" << radius << "\" start_radial=\""<< astart <<"\" end_radial=\""<< aend <<"\" />\r\n";
-      }
-    }
-    tskFile << "\t</Point>" << std::endl;
-  }
-  tskFile << "</Task>" << std::endl;
+  CXMLWriter writer{tskFile};
+  TaskWrite(writer, settingsTask, waypointArray, zoneArray);
 }
@@ -29,10 +29,13 @@
 #define __TARGET_XCSOAR_6_H__
 
 #include "targetXCSoar.h"
+#include <vector>
 
 
 namespace condor2nav {
 
+  class CXMLWriter;
+
   /**
    * @brief Translator to XCSoar v6 data format.
    *
@@ -40,6 +43,30 @@ namespace condor2nav {
    * to XCSoar v6 (http://www.xcsoar.org) format.
    */
   class CTargetXCSoar6 : public CTargetXCSoar {
+  public:
+    /**
+     * @brief Task point observation zone.
+     */
+    struct TObservationZone {
+      enum class TType {
+        CYLINDER,                               ///< @brief Cylinder of a given radius.
+        LINE,                                   ///< @brief Start or finish line of a given length.
+        SECTOR                                  ///< @brief Sector of a given radius between two radials.
+      };
+      TType type;
+      unsigned size;                            ///< @brief Radius of a cylinder or sector, length of a line.
+      unsigned startRadial;
+      unsigned endRadial;
+    };
+    using CObservationZoneArray = std::vector<TObservationZone>;
+
+    static void TaskWrite(CXMLWriter &writer,
+                          const xcsoar::SETTINGS_TASK &settingsTask,
+                          const CWaypointArray &waypointArray,
+                          const CObservationZoneArray &zoneArray);
+
+  private:
+    CObservationZoneArray ObservationZones(const CFileParserINI &taskParser, const CWaypointArray &waypointArray) const;
     void TaskDump(CFileParserINI &profileParser,
                   const CFileParserINI &taskParser,
                   const xcsoar::SETTINGS_TASK &settingsTask,
@@ -47,7 +74,7 @@ namespace condor2nav {
                   const xcsoar::START_POINT startPointArray[],
                   const CWaypointArray &waypointArray) const override;
   public:
-    explicit CTargetXCSoar6(const CTranslator &translator);
+    CTargetXCSoar6(const CTranslator &translator, bfs::path outputPath);
     const char *Name() const override { return "XCSoar 6"; }
   };
 
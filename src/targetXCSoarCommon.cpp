@@ -27,19 +27,76 @@
 
 #include "targetXCSoarCommon.h"
 #include "condor2nav.h"
+#include "geodesy.h"
 #include "imports/xcsoarTypes.h"
 #include "imports/lk8000Types.h"
+#include "istream.h"
 #include "ostream.h"
+#include "speedToFlyTable.h"
+#include "taskCorridor.h"
+#include "taskGeometry.h"
+#include "traitsNoCase.h"
 #include <cmath>
 #include <algorithm>
 
 
+namespace {
+
+  /**
+   * @brief Parses waypoint file coordinate.
+   *
+   * Function parses coordinate provided either in SeeYou CUP format
+   * ("DDMM.MMMN" or "DDDMM.MMME") or in XCSoar DAT format ("DD:MM.MMMN",
+   * "DDD:MM.MMME" or "DD:MM:SSN").
+   *
+   * @param str Coordinate string to parse.
+   *
+   * @exception EOperationFailed Thrown when the coordinate cannot be parsed.
+   *
+   * @return Coordinate value in degrees.
+   */
+  double WaypointCoordParse(const std::string &str)
+  {
+    using namespace condor2nav;
+    if(str.size() < 2)
+      throw EOperationFailed{"ERROR: Invalid waypoint coordinate '" + str + "'!!!"};
+
+    const auto sign = str.back();
+    const auto value = str.substr(0, str.size() - 1);
+    double coord;
+    const auto colon = value.find(':');
+    if(colon == std::string::npos) {
+      const auto ddmm = Convert<double>(value);
+      const auto deg = floor(ddmm / 100);
+      coord = deg + (ddmm - deg * 100) / 60;
+    }
+    else {
+      const auto colon2 = value.find(':', colon + 1);
+      coord = Convert<double>(value.substr(0, colon));
+      if(colon2 == std::string::npos)
+        coord += Convert<double>(value.substr(colon + 1)) / 60;
+      else
+        coord += Convert<double>(value.substr(colon + 1, colon2 - colon - 1)) / 60 + Convert<double>(value.substr(colon2 + 1)) / 3600;
+    }
+
+    if(sign == 'S' || sign == 's' || sign == 'W' || sign == 'w')
+      return -coord;
+    if(sign == 'N' || sign == 'n' || sign == 'E' || sign == 'e')
+      return coord;
+    throw EOperationFailed{"ERROR: Invalid waypoint coordinate '" + str + "'!!!"};
+  }
+
+}
+
+
 const bfs::path condor2nav::CTargetXCSoarCommon::OUTPUT_PROFILE_NAME    = "Condor.prf";
 const bfs::path condor2nav::CTargetXCSoarCommon::TASK_FILE_NAME         = "Condor.tsk";
 const bfs::path condor2nav::CTargetXCSoarCommon::DEFAULT_TASK_FILE_NAME = "Default.tsk";
 const bfs::path condor2nav::CTargetXCSoarCommon::POLAR_FILE_NAME        = "Condor.plr";
+const bfs::path condor2nav::CTargetXCSoarCommon::SPEED_TO_FLY_FILE_NAME = "Condor.stf";
 const bfs::path condor2nav::CTargetXCSoarCommon::AIRSPACES_FILE_NAME    = "Condor.txt";
 const bfs::path condor2nav::CTargetXCSoarCommon::WP_FILE_NAME           = "Condor.dat";
+const bfs::path condor2nav::CTargetXCSoarCommon::CORRIDOR_WP_FILE_NAME  = "CondorCorridor";
 
 /**
  * @brief Class constructor.
@@ -47,9 +104,10 @@ const bfs::path condor2nav::CTargetXCSoarCommon::WP_FILE_NAME           = "Condo
  * condor2nav::CTargetXCSoarCommon class constructor.
  *
  * @param translator Configuration INI file parser.
+ * @param outputPath Translation output directory.
  */
-condor2nav::CTargetXCSoarCommon::CTargetXCSoarCommon(const CTranslator &translator) :
-  CTranslator::CTarget{translator}
+condor2nav::CTargetXCSoarCommon::CTargetXCSoarCommon(const CTranslator &translator, bfs::path outputPath) :
+  CTranslator::CTarget{translator, std::move(outputPath)}
 {
 }
 
@@ -68,31 +126,90 @@ void condor2nav::CTargetXCSoarCommon::SceneryTimeProcess(CFileParserINI &profile
 
 
 /**
-* @brief Calculates the bearing between 2 locations.
+ * @brief Creates speed to fly table file.
+ *
+ * Method precomputes MacCready speed to fly and final glide table for the glider
+ * polar curve and writes it next to the glider polar file (if enabled in the
+ * configuration file).
+ *
+ * @param gliderData Information describing the glider.
+ * @param outputPath The directory of the glider polar file.
+ */
+void condor2nav::CTargetXCSoarCommon::SpeedToFlyTableProcess(const CFileParserCSV::CStringArray &gliderData, const bfs::path &outputPath) const
+{
+  if(!Config().general.speedToFlyTable)
+    return;
+
+  const double speed[] = { Convert<double>(gliderData.at(GLIDER_SPPED_1)), Convert<double>(gliderData.at(GLIDER_SPPED_2)), Convert<double>(gliderData.at(GLIDER_SPPED_3)) };
+  const double sink[] = { Convert<double>(gliderData.at(GLIDER_SINK_1)), Convert<double>(gliderData.at(GLIDER_SINK_2)), Convert<double>(gliderData.at(GLIDER_SINK_3)) };
+  const CSpeedToFlyTable table{speed, sink,
+                               Convert<unsigned>(gliderData.at(GLIDER_MASS_DRY_GROSS)),
+                               Convert<unsigned>(gliderData.at(GLIDER_MAX_WATER_BALLAST))};
+  COStream{outputPath / SPEED_TO_FLY_FILE_NAME}.Attach(table.Data().data(), table.Data().size());
+}
+
+
+/**
+* @brief Calculates the bearings to waypoints from their neighbours.
 *
-* Method calculates the bearing between 2 locations.
+* Method calculates bearings to every task waypoint from the previous and the next
+* waypoint in the task. All the bearings are calculated in one batch.
 *
-* @param lon1 First point longitude.
-* @param lat1 First point latitude.
-* @param lon2 Second point longitude.
-* @param lat2 Second point latitude.
+* @param waypointArray The array of waypoints data.
 *
-* @return The bearing between 2 locations.
+* @return Bearings rounded to full degrees.
  */
-unsigned condor2nav::CTargetXCSoarCommon::WaypointBearing(TLongitude lon1, TLatitude lat1, TLongitude lon2, TLatitude lat2) const
+condor2nav::CTargetXCSoarCommon::CNeighbourBearingsArray condor2nav::CTargetXCSoarCommon::NeighbourBearings(const CWaypointArray &waypointArray)
 {
-  const auto longitude1 = Deg2Rad(lon1.value);
-  const auto latitude1 = Deg2Rad(lat1.value);
-  const auto longitude2 = Deg2Rad(lon2.value);
-  const auto latitude2 = Deg2Rad(lat2.value);
-  
-  const double clat1 = cos(latitude1);
-  const double clat2 = cos(latitude2);
-  const double dlon = longitude2 - longitude1;
-
-  const double y = sin(dlon) * clat2;
-  const double x = clat1 * sin(latitude2) - sin(latitude1) * clat2 * cos(dlon);
-  return (x==0 && y==0) ? 0 : (static_cast<unsigned>(360 + Rad2Deg(atan2(y, x)) + 0.5) % 360);
+  const auto num = static_cast<unsigned>(waypointArray.size());
+  CNeighbourBearingsArray bearingsArray(num, TNeighbourBearings{0, 0});
+  if(num < 2)
+    return bearingsArray;
+
+  CGeodesy::CPointArray points;
+  points.reserve(num);
+  for(const auto &waypoint : waypointArray)
+    points.push_back(CGeodesy::TPoint{waypoint.latitude, waypoint.longitude});
+
+  // bearing from the previous waypoint for waypoints 1..num-1 and from the next one for 0..num-2
+  CGeodesy::CPairArray pairs;
+  pairs.reserve(2 * (num - 1));
+  for(unsigned i=1; i<num; i++)
+    pairs.push_back(CGeodesy::TPair{i - 1, i});
+  for(unsigned i=0; i<num - 1; i++)
+    pairs.push_back(CGeodesy::TPair{i + 1, i});
+  std::vector<double> bearing(pairs.size()), angle(pairs.size());
+  CGeodesy{points}.Bearings(pairs.data(), pairs.size(), bearing.data(), angle.data());
+
+  auto round = [](double value){ return static_cast<unsigned>(value + 0.5) % 360; };
+  for(unsigned i=0; i<num; i++) {
+    bearingsArray[i].previous = round(i > 0 ? bearing[i - 1] : bearing[num - 1]);
+    bearingsArray[i].next = round(i < num - 1 ? bearing[num - 1 + i] : bearing[i - 1]);
+  }
+  return bearingsArray;
+}
+
+
+/**
+* @brief Calculates the direction of the sector.
+*
+* Method calculates the direction halfway between bearings to the waypoint from
+* its neighbours.
+*
+* @param bearings Bearings to the waypoint from its neighbours.
+*
+* @return Sector direction.
+ */
+unsigned condor2nav::CTargetXCSoarCommon::HalfAngle(const TNeighbourBearings &bearings)
+{
+  const auto angle1 = bearings.previous;
+  const auto angle2 = bearings.next;
+  if(angle1 == angle2)
+    return angle1;
+  auto halfAngle = static_cast<unsigned>((angle1 + angle2) / 2.0);
+  if((angle1 > angle2 && angle1 - angle2 > 180) || (angle1 < angle2 && angle2 - angle1 > 180))
+    halfAngle = (halfAngle + 180) % 360;
+  return halfAngle;
 }
 
 
@@ -128,11 +245,14 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
   SETTINGS_TASK settingsTask{};
   settingsTask.AATEnabled       = aatTime > 0;
   settingsTask.AATTaskLength    = aatTime;
-  try {
-    settingsTask.AutoAdvance      = static_cast<AutoAdvanceMode_t>(Convert<unsigned>(profileParser.Value("", "AutoAdvance")));
-  }
-  catch(const Exception &) {
-    settingsTask.AutoAdvance    = AUTOADVANCE_ARMSTART;
+  settingsTask.AutoAdvance      = AUTOADVANCE_ARMSTART;
+  if(const auto autoAdvance = profileParser.TryValue("", "AutoAdvance")) {
+    try {
+      settingsTask.AutoAdvance    = static_cast<AutoAdvanceMode_t>(Convert<unsigned>(*autoAdvance));
+    }
+    catch(const Exception &) {
+      // keep the default for an invalid profile entry
+    }
   }
   settingsTask.EnableMultipleStartPoints = false;
 
@@ -152,6 +272,7 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
     startPointArray[i].Index = -1;
 
   bool tpsValid{true};
+  std::vector<std::pair<size_t, unsigned>> aatSectors;
 
   // skip takeoff waypoint
   for(size_t i=1; i<tpNum; i++) {
@@ -211,29 +332,7 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
         else {
           taskPointArray[i - 1].AATType = WAYPOINT_AAT_SECTOR;
           taskPointArray[i - 1].AATSectorRadius = radius;
-
-          const auto x1 = taskParser.Value("Task", "TPPosX" + Convert(i - 1));
-          const auto y1 = taskParser.Value("Task", "TPPosY" + Convert(i - 1));
-          const auto lon1 = coordConv.Longitude(x1, y1);
-          const auto lat1 = coordConv.Latitude(x1, y1);
-          const auto angle1 = WaypointBearing(lon1, lat1, longitude, latitude);
-
-          const auto x2 = taskParser.Value("Task", "TPPosX" + Convert(i + 1));
-          const auto y2 = taskParser.Value("Task", "TPPosY" + Convert(i + 1));
-          const auto lon2 = coordConv.Longitude(x2, y2);
-          const auto lat2 = coordConv.Latitude(x2, y2);
-          const auto angle2 = WaypointBearing(lon2, lat2, longitude, latitude);
-
-          unsigned halfAngle;
-          if(angle1 == angle2)
-            halfAngle = angle1;
-          else {
-            halfAngle = static_cast<unsigned>((angle1 + angle2) / 2.0);
-            if((angle1 > angle2 && angle1 - angle2 > 180) || (angle1 < angle2 && angle2 - angle1 > 180))
-              halfAngle = (halfAngle + 180) % 360;
-          }
-          taskPointArray[i - 1].AATStartRadial = static_cast<unsigned>(360 + halfAngle - angle / 2.0) % 360;
-          taskPointArray[i - 1].AATFinishRadial = static_cast<unsigned>(360 + halfAngle + angle / 2.0) % 360;
+          aatSectors.emplace_back(i - 1, angle);     // radials set when all waypoints are known
         }
       }
       else {
@@ -252,7 +351,7 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
             settingsTask.SectorType = xcsoar::AST_FAI;
             if(i > 2 && settingsTask.SectorRadius != radius) {
               Translator().App().Warning() << "WARNING: " << name << ": " << Name() << " does not support different TPs types. The smallest radius will be used for all FAI sectors. If you advance a sector in " << Name() << " you will advance it in Condor." << std::endl;
-              settingsTask.SectorRadius = min(settingsTask.SectorRadius, radius);
+              settingsTask.SectorRadius = (std::min)(settingsTask.SectorRadius, static_cast<DWORD>(radius));
             }
             else
               settingsTask.SectorRadius = radius;
@@ -290,7 +389,7 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
               settingsTask.SectorType = xcsoar::AST_CIRCLE;
               if(i > 2 && settingsTask.SectorRadius != radius) {
                 Translator().App().Warning() << "WARNING: " << name << ": " << Name() << " does not support different TPs types. The smallest radius will be used for all circle sectors. If you advance a sector in " << Name() << " you will advance it in Condor." << std::endl;
-                settingsTask.SectorRadius = min(settingsTask.SectorRadius, radius);
+                settingsTask.SectorRadius = (std::min)(settingsTask.SectorRadius, static_cast<DWORD>(radius));
               }
               else
                 settingsTask.SectorRadius = radius;
@@ -320,6 +419,29 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
       Translator().App().Error() << "ERROR: Unsupported sector type '" << sectorTypeStr << "' specified for TP '" << name << "'!!!";
   }
 
+  // set AAT sectors radials
+  if(!aatSectors.empty()) {
+    const auto bearingsArray = NeighbourBearings(waypointArray);
+    for(const auto &sector : aatSectors) {
+      const auto halfAngle = HalfAngle(bearingsArray[sector.first]);
+      taskPointArray[sector.first].AATStartRadial = static_cast<unsigned>(360 + halfAngle - sector.second / 2.0) % 360;
+      taskPointArray[sector.first].AATFinishRadial = static_cast<unsigned>(360 + halfAngle + sector.second / 2.0) % 360;
+    }
+  }
+
+  // set task geometry
+  CTaskGeometry::CPointArray points;
+  points.reserve(waypointArray.size());
+  for(const auto &waypoint : waypointArray)
+    points.push_back(CTaskGeometry::TPoint{waypoint.latitude, waypoint.longitude});
+  const CTaskGeometry geometry{std::move(points)};
+  geometry.Fill(settingsTask, taskPointArray.get());
+  if(settingsTask.AATEnabled) {
+    const auto distances = geometry.AATDistances(taskPointArray.get());
+    Translator().App().Log() << "AAT task distance: min " << std::round(distances.min / 100) / 10 << " km, nominal " <<
+      std::round(distances.nominal / 100) / 10 << " km, max " << std::round(distances.max / 100) / 10 << " km" << std::endl;
+  }
+
   if(!tpsValid)
     Translator().App().Warning() << "WARNING: " << Name() << " does not support different TPs types. FAI Sector will be used for all sectors. You may need to manualy advance a waypoint after reaching it in Condor." << std::endl;
 
@@ -347,6 +469,102 @@ void condor2nav::CTargetXCSoarCommon::TaskProcess(CFileParserINI &profileParser,
 }
 
 
+/**
+* @brief Generates scenery waypoints file limited to the task corridor.
+*
+* Method creates a copy of scenery waypoints file that contains only the airfields
+* and outlandings located within specified distance from the task legs. The profile
+* is updated to use the generated file instead of the original one. Both SeeYou CUP
+* and XCSoar DAT waypoint files are supported.
+*
+* @param profileParser XCSoar profile file parser.
+* @param taskParser Condor task parser. 
+* @param coordConv  Condor coordinates converter.
+* @param wpFilePath The path of scenery waypoints file.
+* @param width The maximum distance of the waypoint from the task legs (in km).
+* @param pathPrefix WP file subdirectory prefix (in XCSoar format).
+* @param outputPathPrefix WP file subdirectory prefix (in filesystem format).
+ */
+void condor2nav::CTargetXCSoarCommon::WaypointsCorridorProcess(CFileParserINI &profileParser,
+                                                               const CFileParserINI &taskParser,
+                                                               const CCondor::CCoordConverter &coordConv,
+                                                               const bfs::path &wpFilePath,
+                                                               double width,
+                                                               const bfs::path &pathPrefix,
+                                                               const bfs::path &outputPathPrefix) const
+{
+  // create task polyline (including takeoff)
+  CTaskCorridor corridor{width};
+  const auto tpNum = Convert<unsigned>(taskParser.Value("Task", "Count"));
+  for(size_t i=0; i<tpNum; i++) {
+    const auto tpIdxStr = Convert(i);
+    const auto x = taskParser.Value("Task", "TPPosX" + tpIdxStr);
+    const auto y = taskParser.Value("Task", "TPPosY" + tpIdxStr);
+    corridor.PointAdd(coordConv.Longitude(x, y), coordConv.Latitude(x, y));
+  }
+
+  const bool cup = wpFilePath.extension().string().c_str() == CStringNoCase{".cup"};
+  auto fileName = CORRIDOR_WP_FILE_NAME;
+  fileName.replace_extension(wpFilePath.extension());
+
+  CIStream inputStream{wpFilePath};
+  COStream outputStream{outputPathPrefix / fileName};
+  unsigned total = 0, selected = 0;
+  std::string line;
+  bool header = cup;
+  while(inputStream.GetLine(line)) {
+    if(line.empty())
+      continue;
+    if(header) {
+      // copy CUP file columns description
+      outputStream << line << std::endl;
+      header = false;
+      continue;
+    }
+    if(cup && line.find("-----Related Tasks-----") != std::string::npos)
+      // tasks section is not needed
+      break;
+
+    const auto values = CFileParserCSV::LineParse(line);
+    bool landable;
+    std::string latStr, lonStr;
+    if(cup) {
+      // name,code,country,lat,lon,elev,style,...
+      if(values.size() < 7)
+        continue;
+      latStr = values[3];
+      lonStr = values[4];
+      const auto style = values[6];
+      landable = style == "2" || style == "3" || style == "4" || style == "5";
+    }
+    else {
+      // number,lat,lon,alt,flags,name,comment
+      if(values.size() < 5)
+        continue;
+      latStr = values[1];
+      lonStr = values[2];
+      landable = values[4].find_first_of("ALal") != std::string::npos;
+    }
+    total++;
+    if(!landable)
+      continue;
+
+    try {
+      if(corridor.Inside(TLongitude{WaypointCoordParse(lonStr)}, TLatitude{WaypointCoordParse(latStr)})) {
+        outputStream << line << std::endl;
+        selected++;
+      }
+    }
+    catch(const Exception &) {
+      Translator().App().Warning() << "WARNING: Invalid waypoint '" << line << "' found in '" << wpFilePath.string() << "' file." << std::endl;
+    }
+  }
+
+  Translator().App().Log() << "Task corridor of " << width << "km contains " << selected << " of " << total << " scenery waypoints" << std::endl;
+  profileParser.Value("", "WPFile", "\"" + (pathPrefix / fileName).string() + std::string("\""));
+}
+
+
 /**
 * @brief Sets task penalty zones. 
 *
@@ -29,6 +29,7 @@
 #define __TARGET_XCSOAR_COMMON_H__
 
 #include "translator.h"
+#include "taskImage.h"
 #include "imports/xcsoarTypes.h"
 
 
@@ -44,31 +45,31 @@ namespace condor2nav {
    */
   class CTargetXCSoarCommon : public CTranslator::CTarget {
   protected:
-    /**
-     * @brief Waypoint data.
-     */
-    struct TWaypoint {
-      int number;
-      double latitude;
-      double longitude;
-      double altitude;
-      int flags;
-      std::string name;
-      std::string comment;
-      bool inTask;
-    };
-    using CWaypointArray = std::vector<TWaypoint>;
+    using TWaypoint = CTaskImage::TWaypoint;
+    using CWaypointArray = CTaskImage::CWaypointArray;
 
     // outputs
     static const bfs::path OUTPUT_PROFILE_NAME;             ///< @brief The name of XCSoar profile file to generate. 
     static const bfs::path TASK_FILE_NAME;                  ///< @brief The name of XCSoar task file to generate. 
     static const bfs::path DEFAULT_TASK_FILE_NAME;          ///< @brief The name of the default XCSoar task file. 
     static const bfs::path POLAR_FILE_NAME;                 ///< @brief The name of XCSoar glider polar file to generate.
+    static const bfs::path SPEED_TO_FLY_FILE_NAME;          ///< @brief The name of speed to fly table file to generate next to the polar file.
     static const bfs::path AIRSPACES_FILE_NAME;             ///< @brief The name of XCSoar airspaces file to generate. 
     static const bfs::path WP_FILE_NAME;                    ///< @brief The name of XCSoar WP file with task waypoints.
+    static const bfs::path CORRIDOR_WP_FILE_NAME;           ///< @brief The name of WP file with scenery waypoints near the task (without extension).
     static const unsigned WAYPOINT_INDEX_OFFSET = 100000;   ///< @brief A big value that should point behind all the waypoints
 
-    unsigned WaypointBearing(TLongitude lon1, TLatitude lat1, TLongitude lon2, TLatitude lat2) const;
+    /**
+     * @brief Bearings to the waypoint from its neighbours in the task.
+     */
+    struct TNeighbourBearings {
+      unsigned previous;                                    ///< @brief Bearing from the previous waypoint (from the next one for the first waypoint).
+      unsigned next;                                        ///< @brief Bearing from the next waypoint (from the previous one for the last waypoint).
+    };
+    using CNeighbourBearingsArray = std::vector<TNeighbourBearings>;
+
+    static CNeighbourBearingsArray NeighbourBearings(const CWaypointArray &waypointArray);
+    static unsigned HalfAngle(const TNeighbourBearings &bearings);
     virtual void TaskDump(CFileParserINI &profileParser,
                           const CFileParserINI &taskParser,
                           const xcsoar::SETTINGS_TASK &settingsTask,
@@ -76,6 +77,7 @@ namespace condor2nav {
                           const xcsoar::START_POINT startPointArray[],
                           const CWaypointArray &waypointArray) const = 0;
     void SceneryTimeProcess(CFileParserINI &profileParser) const;
+    void SpeedToFlyTableProcess(const CFileParserCSV::CStringArray &gliderData, const bfs::path &outputPath) const;
     void TaskProcess(CFileParserINI &profileParser,
                      const CFileParserINI &taskParser,
                      const CCondor::CCoordConverter &coordConv,
@@ -84,6 +86,13 @@ namespace condor2nav {
                      unsigned maxStartPoints,
                      bool generateWPFile,
                      const bfs::path &wpOutputPathPrefix) const;
+    void WaypointsCorridorProcess(CFileParserINI &profileParser,
+                                  const CFileParserINI &taskParser,
+                                  const CCondor::CCoordConverter &coordConv,
+                                  const bfs::path &wpFilePath,
+                                  double width,
+                                  const bfs::path &pathPrefix,
+                                  const bfs::path &outputPathPrefix) const;
     void PenaltyZonesProcess(CFileParserINI &profileParser,
                              const CFileParserINI &taskParser,
                              const CCondor::CCoordConverter &coordConv,
@@ -91,7 +100,7 @@ namespace condor2nav {
                              const bfs::path &outputPathPrefix) const;
 
   public:
-    explicit CTargetXCSoarCommon(const CTranslator &translator);
+    CTargetXCSoarCommon(const CTranslator &translator, bfs::path outputPath);
   };
 
 }
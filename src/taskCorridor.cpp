@@ -0,0 +1,129 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskCorridor.cpp
+ *
+ * @brief Implements the condor2nav::CTaskCorridor class. 
+ */
+
+#include "taskCorridor.h"
+#include <algorithm>
+#include <cmath>
+
+
+const double condor2nav::CTaskCorridor::EARTH_RADIUS = 6371.0;
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CTaskCorridor class constructor.
+ *
+ * @param width The maximum distance from the task legs (in km).
+ */
+condor2nav::CTaskCorridor::CTaskCorridor(double width) :
+  _width{width}, _lon0{0}, _lat0{0}, _lonScale{0}, _last{0, 0}
+{
+}
+
+
+/**
+ * @brief Projects geographic coordinates to the local plane.
+ *
+ * Method projects provided location to the equirectangular plane tangent
+ * at the first task point. Condor sceneries are small enough for that
+ * projection to be accurate for corridor queries.
+ *
+ * @param lon Longitude to project.
+ * @param lat Latitude to project.
+ *
+ * @return Projected point (in km).
+ */
+auto condor2nav::CTaskCorridor::Project(TLongitude lon, TLatitude lat) const -> TPoint
+{
+  return TPoint{(lon.value - _lon0) * _lonScale, Deg2Rad(lat.value - _lat0) * EARTH_RADIUS};
+}
+
+
+/**
+ * @brief Adds next task point.
+ *
+ * Method adds next point to the task polyline. Each point creates a new leg
+ * that ends in provided location.
+ *
+ * @param lon Task point longitude.
+ * @param lat Task point latitude.
+ */
+void condor2nav::CTaskCorridor::PointAdd(TLongitude lon, TLatitude lat)
+{
+  if(_legs.empty()) {
+    _lon0 = lon.value;
+    _lat0 = lat.value;
+    _lonScale = Deg2Rad(1) * EARTH_RADIUS * cos(Deg2Rad(_lat0));
+    _last = Project(lon, lat);
+  }
+
+  const auto point = Project(lon, lat);
+  TLeg leg;
+  leg.begin = _last;
+  leg.end = point;
+  leg.xMin = (std::min)(_last.x, point.x) - _width;
+  leg.xMax = (std::max)(_last.x, point.x) + _width;
+  leg.yMin = (std::min)(_last.y, point.y) - _width;
+  leg.yMax = (std::max)(_last.y, point.y) + _width;
+  _legs.emplace_back(leg);
+  _last = point;
+}
+
+
+/**
+ * @brief Checks if location is inside the corridor.
+ *
+ * Method verifies if provided location is within the corridor width from
+ * any of the task legs. Legs which bounding boxes do not contain the point are
+ * rejected before the exact point to segment distance is calculated.
+ *
+ * @param lon Longitude to check.
+ * @param lat Latitude to check.
+ *
+ * @return @p true if location is inside the corridor.
+ */
+bool condor2nav::CTaskCorridor::Inside(TLongitude lon, TLatitude lat) const
+{
+  const auto point = Project(lon, lat);
+  const auto width2 = _width * _width;
+  for(const auto &leg : _legs) {
+    if(point.x < leg.xMin || point.x > leg.xMax || point.y < leg.yMin || point.y > leg.yMax)
+      continue;
+
+    const auto dx = leg.end.x - leg.begin.x;
+    const auto dy = leg.end.y - leg.begin.y;
+    const auto len2 = dx * dx + dy * dy;
+    auto t = len2 > 0 ? ((point.x - leg.begin.x) * dx + (point.y - leg.begin.y) * dy) / len2 : 0.0;
+    t = (std::max)(0.0, (std::min)(1.0, t));
+    const auto px = leg.begin.x + t * dx - point.x;
+    const auto py = leg.begin.y + t * dy - point.y;
+    if(px * px + py * py <= width2)
+      return true;
+  }
+  return false;
+}
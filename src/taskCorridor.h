@@ -0,0 +1,82 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskCorridor.h
+ *
+ * @brief Declares the condor2nav::CTaskCorridor class. 
+ */
+
+#ifndef __TASKCORRIDOR_H__
+#define __TASKCORRIDOR_H__
+
+#include "tools.h"
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Task corridor.
+   *
+   * condor2nav::CTaskCorridor class describes the area within the specified
+   * distance from the task polyline. It is used to select only those scenery
+   * waypoints that are reachable during the task.
+   */
+  class CTaskCorridor {
+    /**
+     * @brief Point in a local plane projection (in km).
+     */
+    struct TPoint {
+      double x;
+      double y;
+    };
+
+    /**
+     * @brief Task leg with its bounding box already expanded by the corridor width.
+     */
+    struct TLeg {
+      TPoint begin;
+      TPoint end;
+      double xMin, xMax;
+      double yMin, yMax;
+    };
+    using CLegArray = std::vector<TLeg>;
+
+    static const double EARTH_RADIUS;       ///< @brief Mean Earth radius (in km)
+
+    const double _width;                    ///< @brief Corridor half width (in km)
+    double _lon0;                           ///< @brief Longitude of the projection origin
+    double _lat0;                           ///< @brief Latitude of the projection origin
+    double _lonScale;                       ///< @brief Longitude to km scale at the projection origin
+    CLegArray _legs;                        ///< @brief Task legs
+    TPoint _last;                           ///< @brief Last point added to the polyline
+
+    TPoint Project(TLongitude lon, TLatitude lat) const;
+
+  public:
+    explicit CTaskCorridor(double width);
+    void PointAdd(TLongitude lon, TLatitude lat);
+    bool Inside(TLongitude lon, TLatitude lat) const;
+  };
+
+}
+
+#endif /* __TASKCORRIDOR_H__ */
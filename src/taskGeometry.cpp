@@ -0,0 +1,353 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskGeometry.cpp
+ *
+ * @brief Implements the condor2nav::CTaskGeometry class. 
+ */
+
+#include "taskGeometry.h"
+#include "exception.h"
+#include "tools.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+  const double DAE_SECTOR_RADIUS = 10000;         // DAe 0.5/10 sector radius (in meters)
+
+  /**
+   * @brief Limits the angle to 0-360 degrees range.
+   *
+   * @param angle The angle to limit (in degrees).
+   *
+   * @return The angle in 0-360 degrees range.
+   */
+  double AngleLimit360(double angle)
+  {
+    angle = std::fmod(angle, 360.0);
+    return angle < 0 ? angle + 360 : angle;
+  }
+
+}
+
+
+const double condor2nav::CTaskGeometry::EARTH_RADIUS = 6371000.0;
+
+
+/**
+ * @brief Calculates great-circle distance and bearing.
+ *
+ * Method calculates the great-circle distance between 2 locations and the initial
+ * bearing of the route from the first location to the second one.
+ *
+ * @param point1   The first location.
+ * @param point2   The second location.
+ * @param distance The distance between locations (in meters).
+ * @param bearing  The initial bearing (in degrees).
+ */
+void condor2nav::CTaskGeometry::DistanceBearing(const TPoint &point1, const TPoint &point2, double &distance, double &bearing)
+{
+  const double lat1 = Deg2Rad(point1.latitude);
+  const double lat2 = Deg2Rad(point2.latitude);
+  const double dlat = lat2 - lat1;
+  const double dlon = Deg2Rad(point2.longitude - point1.longitude);
+
+  const double clat1 = std::cos(lat1);
+  const double clat2 = std::cos(lat2);
+  const double sdlat = std::sin(dlat / 2);
+  const double sdlon = std::sin(dlon / 2);
+  const double a = (std::min)(sdlat * sdlat + clat1 * clat2 * sdlon * sdlon, 1.0);
+  distance = 2 * std::asin(std::sqrt(a)) * EARTH_RADIUS;
+
+  const double y = std::sin(dlon) * clat2;
+  const double x = clat1 * std::sin(lat2) - std::sin(lat1) * clat2 * std::cos(dlon);
+  bearing = (x == 0 && y == 0) ? 0 : AngleLimit360(Rad2Deg(std::atan2(y, x)));
+}
+
+
+/**
+ * @brief Calculates destination location.
+ *
+ * Method calculates the location reached when moving from provided location
+ * along the great-circle with specified initial bearing.
+ *
+ * @param point    The initial location.
+ * @param bearing  The initial bearing (in degrees).
+ * @param distance The distance to move (in meters).
+ *
+ * @return Destination location.
+ */
+auto condor2nav::CTaskGeometry::Destination(const TPoint &point, double bearing, double distance) -> TPoint
+{
+  const double lat1 = Deg2Rad(point.latitude);
+  const double brg = Deg2Rad(bearing);
+  const double delta = distance / EARTH_RADIUS;
+
+  const double slat1 = std::sin(lat1);
+  const double clat1 = std::cos(lat1);
+  const double sdelta = std::sin(delta);
+  const double cdelta = std::cos(delta);
+  const double slat2 = (std::max)(-1.0, (std::min)(slat1 * cdelta + clat1 * sdelta * std::cos(brg), 1.0));
+  const double dlon = std::atan2(std::sin(brg) * sdelta * clat1, cdelta - slat1 * slat2);
+
+  double lon2 = point.longitude + Rad2Deg(dlon);
+  lon2 = AngleLimit360(lon2 + 180) - 180;
+  return TPoint{Rad2Deg(std::asin(slat2)), lon2};
+}
+
+
+/**
+ * @brief Calculates sector bisector.
+ *
+ * Method calculates the bisector of the angle between the reversed inbound leg
+ * and the outbound leg of a task point (the same way as XCSoar does).
+ *
+ * @param inBound  The bearing of the leg ending in the task point (in degrees).
+ * @param outBound The bearing of the leg starting in the task point (in degrees).
+ *
+ * @return Sector bisector (in degrees).
+ */
+double condor2nav::CTaskGeometry::BiSector(double inBound, double outBound)
+{
+  inBound = AngleLimit360(inBound + 180);
+  outBound = AngleLimit360(outBound);
+  const double diff = std::fabs(inBound - outBound);
+  return AngleLimit360(diff < 180 ? (inBound + outBound) / 2 : (inBound + outBound + 360) / 2);
+}
+
+
+/**
+ * @brief Samples AAT area.
+ *
+ * Method provides candidate locations of AAT area used in task distances
+ * optimization: the area center, its boundary arc and radial edges.
+ *
+ * @param taskPoint Task point data.
+ * @param center    Task point location.
+ * @param points    Sampled locations.
+ */
+void condor2nav::CTaskGeometry::AreaPoints(const xcsoar::TASK_POINT &taskPoint, const TPoint &center, CPointArray &points)
+{
+  points.clear();
+  points.push_back(center);
+
+  const bool circle = taskPoint.AATType == xcsoar::WAYPOINT_AAT_CIRCLE;
+  const double radius = circle ? taskPoint.AATCircleRadius : taskPoint.AATSectorRadius;
+  if(radius <= 0)
+    return;
+
+  double start = 0;
+  double span = 360;
+  if(!circle) {
+    start = taskPoint.AATStartRadial;
+    span = AngleLimit360(taskPoint.AATFinishRadial - start);
+    if(span == 0)
+      span = 360;
+  }
+
+  const auto steps = static_cast<unsigned>(std::ceil(span / AREA_ARC_STEP));
+  for(unsigned i=0; i<steps + (span < 360 ? 1 : 0); i++)
+    points.push_back(Destination(center, start + span * i / steps, radius));
+
+  if(span < 360) {
+    for(unsigned i=1; i<AREA_RADIAL_NUM; i++) {
+      points.push_back(Destination(center, start, radius * i / AREA_RADIAL_NUM));
+      points.push_back(Destination(center, start + span, radius * i / AREA_RADIAL_NUM));
+    }
+  }
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CTaskGeometry class constructor.
+ *
+ * @param points Task waypoints locations in the task order.
+ */
+condor2nav::CTaskGeometry::CTaskGeometry(CPointArray points) :
+  _points{std::move(points)}, _geodesy{_points}
+{
+}
+
+
+/**
+ * @brief Fills task points geometry.
+ *
+ * Method sets legs, bearings, bisectors, sectors edge points, AAT areas edge points
+ * and AAT targets of all task points. Start and finish sectors are perpendicular to
+ * the first and the last leg and other sectors are oriented with the bisector.
+ * Circle and FAI sectors use the configured sector radius while DAe sectors always
+ * extend to 10km.
+ *
+ * @param settingsTask   Task settings.
+ * @param taskPointArray Task points to fill (at least as many as task waypoints).
+ */
+void condor2nav::CTaskGeometry::Fill(const xcsoar::SETTINGS_TASK &settingsTask, xcsoar::TASK_POINT taskPointArray[]) const
+{
+  const auto num = _points.size();
+
+  // legs
+  std::vector<double> bearing(num), angle(num);
+  _geodesy.Legs(bearing.data(), angle.data());
+  for(size_t i=0; i<num; i++) {
+    auto &tp = taskPointArray[i];
+    if(i == 0) {
+      tp.Leg = 0;
+      tp.InBound = 0;
+    }
+    else {
+      tp.Leg = angle[i - 1] * EARTH_RADIUS;
+      tp.InBound = bearing[i - 1];
+      auto &prev = taskPointArray[i - 1];
+      prev.OutBound = tp.InBound;
+      prev.Bisector = BiSector(prev.InBound, prev.OutBound);
+    }
+  }
+
+  // sectors
+  for(size_t i=0; i<num; i++) {
+    auto &tp = taskPointArray[i];
+    double sectorAngle, size, sectorBearing;
+    if(i == 0) {
+      sectorAngle = 90;
+      size = settingsTask.StartRadius;
+      sectorBearing = tp.OutBound;
+    }
+    else if(i == num - 1) {
+      sectorAngle = 90;
+      size = settingsTask.FinishRadius;
+      sectorBearing = tp.InBound;
+    }
+    else {
+      sectorAngle = 45 + 90;
+      switch(settingsTask.SectorType) {
+      case xcsoar::AST_CIRCLE:
+      case xcsoar::AST_FAI:
+        size = settingsTask.SectorRadius;
+        break;
+      case xcsoar::AST_DAE:
+        // only the 500m cylinder of DAe sector is configurable
+        size = DAE_SECTOR_RADIUS;
+        break;
+      default:
+        throw EOperationFailed{"ERROR: Unknown sector type '" + Convert(static_cast<int>(settingsTask.SectorType)) + "'!!!"};
+      }
+      sectorBearing = tp.Bisector;
+    }
+
+    const auto start = Destination(_points[i], AngleLimit360(sectorBearing + sectorAngle), size);
+    const auto end = Destination(_points[i], AngleLimit360(sectorBearing - sectorAngle), size);
+    tp.SectorStartLat = start.latitude;
+    tp.SectorStartLon = start.longitude;
+    tp.SectorEndLat = end.latitude;
+    tp.SectorEndLon = end.longitude;
+
+    if(settingsTask.AATEnabled && i > 0 && i < num - 1) {
+      const double radius = tp.AATType == xcsoar::WAYPOINT_AAT_CIRCLE ? tp.AATCircleRadius : tp.AATSectorRadius;
+      const auto aatStart = Destination(_points[i], tp.AATStartRadial, radius);
+      const auto aatFinish = Destination(_points[i], tp.AATFinishRadial, radius);
+      tp.AATStartLat = aatStart.latitude;
+      tp.AATStartLon = aatStart.longitude;
+      tp.AATFinishLat = aatFinish.latitude;
+      tp.AATFinishLon = aatFinish.longitude;
+    }
+
+    // targets in the waypoints
+    tp.AATTargetOffsetRadius = 0;
+    tp.AATTargetOffsetRadial = 0;
+    tp.AATTargetLat = _points[i].latitude;
+    tp.AATTargetLon = _points[i].longitude;
+  }
+}
+
+
+/**
+ * @brief Calculates AAT task distances.
+ *
+ * Method calculates the shortest and the longest task distance that may be flown
+ * through AAT areas and the nominal distance through the waypoints. Areas boundaries
+ * are sampled and the best path is found with dynamic programming over consecutive
+ * areas.
+ *
+ * @param taskPointArray Task points with AAT areas set.
+ *
+ * @return AAT task distances.
+ */
+auto condor2nav::CTaskGeometry::AATDistances(const xcsoar::TASK_POINT taskPointArray[]) const -> TDistances
+{
+  TDistances distances{0, 0, 0};
+  const auto num = _points.size();
+  if(num == 0)
+    return distances;
+
+  // nominal distance through waypoints
+  std::vector<double> bearing(num), angle(num);
+  _geodesy.Legs(bearing.data(), angle.data());
+  for(size_t i=0; i + 1<num; i++)
+    distances.nominal += angle[i] * EARTH_RADIUS;
+
+  // candidate locations of all task points converted at once
+  CPointArray candidates{_points.front()}, points;
+  std::vector<unsigned> offsets{0, 1};
+  for(size_t i=1; i<num; i++) {
+    if(i < num - 1)
+      AreaPoints(taskPointArray[i], _points[i], points);
+    else
+      points.assign(1, _points[i]);
+    candidates.insert(candidates.end(), points.begin(), points.end());
+    offsets.push_back(static_cast<unsigned>(candidates.size()));
+  }
+  const CGeodesy geodesy{candidates};
+
+  // dynamic programming over consecutive task points
+  std::vector<double> prevMin{0}, prevMax{0}, curMin, curMax;
+  CGeodesy::CPairArray pairs;
+  for(size_t i=1; i<num; i++) {
+    const auto prevBegin = offsets[i - 1], prevEnd = offsets[i], curBegin = offsets[i], curEnd = offsets[i + 1];
+    pairs.clear();
+    for(auto j=curBegin; j<curEnd; j++)
+      for(auto k=prevBegin; k<prevEnd; k++)
+        pairs.push_back(CGeodesy::TPair{k, j});
+    bearing.resize(pairs.size());
+    angle.resize(pairs.size());
+    geodesy.Bearings(pairs.data(), pairs.size(), bearing.data(), angle.data());
+
+    curMin.assign(curEnd - curBegin, std::numeric_limits<double>::max());
+    curMax.assign(curEnd - curBegin, 0);
+    for(size_t j=0, idx=0; j<curMin.size(); j++) {
+      for(size_t k=0; k<prevMin.size(); k++, idx++) {
+        const double distance = angle[idx] * EARTH_RADIUS;
+        curMin[j] = (std::min)(curMin[j], prevMin[k] + distance);
+        curMax[j] = (std::max)(curMax[j], prevMax[k] + distance);
+      }
+    }
+    prevMin.swap(curMin);
+    prevMax.swap(curMax);
+  }
+
+  distances.min = prevMin.front();
+  distances.max = prevMax.front();
+  return distances;
+}
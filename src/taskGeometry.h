@@ -0,0 +1,84 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskGeometry.h
+ *
+ * @brief Declares the condor2nav::CTaskGeometry class. 
+ */
+
+#ifndef __TASKGEOMETRY_H__
+#define __TASKGEOMETRY_H__
+
+#include "geodesy.h"
+#include "imports/xcsoarTypes.h"
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Task geometry.
+   *
+   * condor2nav::CTaskGeometry class calculates the geometry of the task that XCSoar 5
+   * and LK8000 otherwise recalculate on task load: great-circle legs with their
+   * bearings, sectors bisectors, sectors edge points and AAT areas edge points and
+   * targets. It also provides the minimum, nominal and maximum AAT task distances.
+   *
+   * All the calculations are done on a sphere with the same Earth radius as used
+   * by XCSoar so the results match the values calculated on the device.
+   */
+  class CTaskGeometry : CNonCopyable {
+  public:
+    using TPoint = CGeodesy::TPoint;
+    using CPointArray = CGeodesy::CPointArray;
+
+    /**
+     * @brief AAT task distances (in meters).
+     */
+    struct TDistances {
+      double min;
+      double nominal;
+      double max;
+    };
+
+    static const double EARTH_RADIUS;       ///< @brief Mean Earth radius used by XCSoar (in meters)
+    static const unsigned AREA_ARC_STEP = 2;    ///< @brief Step of AAT area boundary sampling (in degrees)
+    static const unsigned AREA_RADIAL_NUM = 10; ///< @brief The number of AAT sector radial edge samples
+
+    static void DistanceBearing(const TPoint &point1, const TPoint &point2, double &distance, double &bearing);
+    static TPoint Destination(const TPoint &point, double bearing, double distance);
+    static double BiSector(double inBound, double outBound);
+
+  private:
+    const CPointArray _points;              ///< @brief Task waypoints (takeoff waypoint excluded)
+    const CGeodesy _geodesy;                ///< @brief Task waypoints converted for batch calculations
+
+    static void AreaPoints(const xcsoar::TASK_POINT &taskPoint, const TPoint &center, CPointArray &points);
+
+  public:
+    explicit CTaskGeometry(CPointArray points);
+    void Fill(const xcsoar::SETTINGS_TASK &settingsTask, xcsoar::TASK_POINT taskPointArray[]) const;
+    TDistances AATDistances(const xcsoar::TASK_POINT taskPointArray[]) const;
+  };
+
+}
+
+#endif /* __TASKGEOMETRY_H__ */
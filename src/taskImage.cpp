@@ -0,0 +1,371 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskImage.cpp
+ *
+ * @brief Implements the condor2nav::CTaskImage class. 
+ */
+
+#include "taskImage.h"
+#include "imports/lk8000Types.h"
+#include "tools.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+  using condor2nav::CTaskImage;
+
+  static_assert(std::numeric_limits<double>::is_iec559, "IEEE 754 doubles are required to encode task files");
+
+#if defined(_M_IX86) || defined(_M_ARM)
+
+  // host ABI is the same as the one of the device so layout description can be verified with imported types
+  static_assert(sizeof(xcsoar::TASK_POINT) == CTaskImage::TASK_POINT_SIZE, "xcsoar::TASK_POINT size mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, Index) == CTaskImage::TASK_POINT_INDEX, "xcsoar::TASK_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, AATType) == CTaskImage::TASK_POINT_AAT_TYPE, "xcsoar::TASK_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, AATCircleRadius) == CTaskImage::TASK_POINT_AAT_CIRCLE_RADIUS, "xcsoar::TASK_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, AATSectorRadius) == CTaskImage::TASK_POINT_AAT_SECTOR_RADIUS, "xcsoar::TASK_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, AATStartRadial) == CTaskImage::TASK_POINT_AAT_START_RADIAL, "xcsoar::TASK_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, AATFinishRadial) == CTaskImage::TASK_POINT_AAT_FINISH_RADIAL, "xcsoar::TASK_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::TASK_POINT, AATTargetLocked) == CTaskImage::TASK_POINT_AAT_TARGET_LOCKED, "xcsoar::TASK_POINT layout mismatch");
+
+  static_assert(sizeof(xcsoar::START_POINT) == CTaskImage::START_POINT_SIZE, "xcsoar::START_POINT size mismatch");
+  static_assert(offsetof(xcsoar::START_POINT, Index) == CTaskImage::START_POINT_INDEX, "xcsoar::START_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::START_POINT, Active) == CTaskImage::START_POINT_ACTIVE, "xcsoar::START_POINT layout mismatch");
+  static_assert(offsetof(xcsoar::START_POINT, InSector) == CTaskImage::START_POINT_IN_SECTOR, "xcsoar::START_POINT layout mismatch");
+
+  static_assert(sizeof(xcsoar::WAYPOINT) == CTaskImage::XCSOAR_WAYPOINT_SIZE, "xcsoar::WAYPOINT size mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Number) == CTaskImage::XCSOAR_WAYPOINT_NUMBER, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Latitude) == CTaskImage::XCSOAR_WAYPOINT_LATITUDE, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Longitude) == CTaskImage::XCSOAR_WAYPOINT_LONGITUDE, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Altitude) == CTaskImage::XCSOAR_WAYPOINT_ALTITUDE, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Flags) == CTaskImage::XCSOAR_WAYPOINT_FLAGS, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Name) == CTaskImage::XCSOAR_WAYPOINT_NAME, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, Comment) == CTaskImage::XCSOAR_WAYPOINT_COMMENT, "xcsoar::WAYPOINT layout mismatch");
+  static_assert(offsetof(xcsoar::WAYPOINT, InTask) == CTaskImage::XCSOAR_WAYPOINT_IN_TASK, "xcsoar::WAYPOINT layout mismatch");
+
+  static_assert(sizeof(lk8000::WAYPOINT) == CTaskImage::LK8000_WAYPOINT_SIZE, "lk8000::WAYPOINT size mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Number) == CTaskImage::LK8000_WAYPOINT_NUMBER, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Latitude) == CTaskImage::LK8000_WAYPOINT_LATITUDE, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Longitude) == CTaskImage::LK8000_WAYPOINT_LONGITUDE, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Altitude) == CTaskImage::LK8000_WAYPOINT_ALTITUDE, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Flags) == CTaskImage::LK8000_WAYPOINT_FLAGS, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Name) == CTaskImage::LK8000_WAYPOINT_NAME, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Comment) == CTaskImage::LK8000_WAYPOINT_COMMENT, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, InTask) == CTaskImage::LK8000_WAYPOINT_IN_TASK, "lk8000::WAYPOINT layout mismatch");
+  static_assert(offsetof(lk8000::WAYPOINT, Style) == CTaskImage::LK8000_WAYPOINT_STYLE, "lk8000::WAYPOINT layout mismatch");
+
+#endif
+
+}
+
+
+/**
+ * @brief Returns the offset of task file part.
+ *
+ * @param format Task file format.
+ * @param part   Task file part.
+ *
+ * @return The offset of task file part.
+ */
+size_t condor2nav::CTaskImage::Offset(TFormat format, TPart part)
+{
+  const bool lk8000 = format == TFormat::LK8000_1_24;
+  const size_t taskPointsNum  = lk8000 ? lk8000::MAXTASKPOINTS : xcsoar::MAXTASKPOINTS;
+  const size_t startPointsNum = lk8000 ? lk8000::MAXSTARTPOINTS : xcsoar::MAXSTARTPOINTS;
+  const size_t waypointSize   = lk8000 ? static_cast<size_t>(LK8000_WAYPOINT_SIZE) : static_cast<size_t>(XCSOAR_WAYPOINT_SIZE);
+
+  const size_t sizes[] = {
+    lk8000 ? LK8000_VERSION_SIZE : 0,         // VERSION
+    taskPointsNum * TASK_POINT_SIZE,          // TASK_POINTS
+    SETTINGS_SIZE,                            // SETTINGS
+    startPointsNum * START_POINT_SIZE,        // START_POINTS
+    taskPointsNum * waypointSize,             // TASK_WAYPOINTS
+    startPointsNum * waypointSize             // START_WAYPOINTS
+  };
+  size_t offset = 0;
+  for(size_t i = 0; i < static_cast<size_t>(part); ++i)
+    offset += sizes[i];
+  return offset;
+}
+
+
+/**
+ * @brief Returns the size of task file.
+ *
+ * @param format Task file format.
+ *
+ * @return The size of task file in bytes.
+ */
+size_t condor2nav::CTaskImage::Size(TFormat format)
+{
+  return Offset(format, TPart::END);
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CTaskImage class constructor. Allocates zero-initialized image
+ * and sets LK8000 file version header.
+ *
+ * @param format Task file format.
+ */
+condor2nav::CTaskImage::CTaskImage(TFormat format) :
+  _format{format}, _buffer(Size(format), '\0')
+{
+  if(_format == TFormat::LK8000_1_24) {
+    const std::string ver{"LK" + Convert(lk8000::LK_TASK_VERSION) + Convert(lk8000::MAXTASKPOINTS) + Convert(lk8000::MAXSTARTPOINTS)};
+    ver.copy(&_buffer[Offset(_format, TPart::VERSION)], (std::min)(ver.size(), static_cast<size_t>(LK8000_VERSION_SIZE)));
+  }
+}
+
+
+/**
+ * @brief Writes 32-bit integer to the image.
+ *
+ * @param offset The offset of the value in the image.
+ * @param value  The value to write.
+ */
+void condor2nav::CTaskImage::PutInt(size_t offset, std::int32_t value)
+{
+  const auto v = static_cast<std::uint32_t>(value);
+  for(unsigned i = 0; i < 4; ++i)
+    _buffer[offset + i] = static_cast<char>(v >> (8 * i));
+}
+
+
+/**
+ * @brief Writes 16-bit integer to the image.
+ *
+ * @param offset The offset of the value in the image.
+ * @param value  The value to write.
+ */
+void condor2nav::CTaskImage::PutShort(size_t offset, std::int16_t value)
+{
+  const auto v = static_cast<std::uint16_t>(value);
+  _buffer[offset]     = static_cast<char>(v);
+  _buffer[offset + 1] = static_cast<char>(v >> 8);
+}
+
+
+/**
+ * @brief Writes boolean value to the image.
+ *
+ * @param offset The offset of the value in the image.
+ * @param value  The value to write.
+ */
+void condor2nav::CTaskImage::PutBool(size_t offset, bool value)
+{
+  _buffer[offset] = value ? 1 : 0;
+}
+
+
+/**
+ * @brief Writes double value to the image.
+ *
+ * @param offset The offset of the value in the image.
+ * @param value  The value to write.
+ */
+void condor2nav::CTaskImage::PutDouble(size_t offset, double value)
+{
+  std::uint64_t v;
+  memcpy(&v, &value, sizeof(v));
+  for(unsigned i = 0; i < 8; ++i)
+    _buffer[offset + i] = static_cast<char>(v >> (8 * i));
+}
+
+
+/**
+ * @brief Writes screen point to the image.
+ *
+ * @param offset The offset of the point in the image.
+ * @param point  The point to write.
+ */
+void condor2nav::CTaskImage::PutPoint(size_t offset, const POINT &point)
+{
+  PutInt(offset, point.x);
+  PutInt(offset + 4, point.y);
+}
+
+
+/**
+ * @brief Writes a string to the image.
+ *
+ * String is stored as UTF-16 characters array of provided size. Characters are
+ * converted the same way as mbstowcs() does in "C" locale on the device (every byte
+ * becomes one character). The array is always terminated with '\0'.
+ *
+ * @param offset The offset of the string in the image.
+ * @param str    The string to write.
+ * @param size   The maximum number of characters to write.
+ */
+void condor2nav::CTaskImage::PutString(size_t offset, const std::string &str, unsigned size)
+{
+  const auto num = (std::min)(str.size(), static_cast<size_t>(size));
+  for(size_t i = 0; i < num; ++i)
+    PutShort(offset + 2 * i, static_cast<std::int16_t>(static_cast<unsigned char>(str[i])));
+}
+
+
+/**
+ * @brief Writes task points.
+ *
+ * @param taskPointArray Task points array.
+ */
+void condor2nav::CTaskImage::TaskPoints(const xcsoar::TASK_POINT taskPointArray[])
+{
+  auto offset = Offset(_format, TPart::TASK_POINTS);
+  for(const auto end = Offset(_format, TPart::SETTINGS); offset < end; offset += TASK_POINT_SIZE, ++taskPointArray) {
+    const auto &tp = *taskPointArray;
+    PutInt(offset + TASK_POINT_INDEX, tp.Index);
+    PutDouble(offset + TASK_POINT_IN_BOUND, tp.InBound);
+    PutDouble(offset + TASK_POINT_OUT_BOUND, tp.OutBound);
+    PutDouble(offset + TASK_POINT_BISECTOR, tp.Bisector);
+    PutDouble(offset + TASK_POINT_LEG, tp.Leg);
+    PutDouble(offset + TASK_POINT_SECTOR_START_LAT, tp.SectorStartLat);
+    PutDouble(offset + TASK_POINT_SECTOR_START_LON, tp.SectorStartLon);
+    PutDouble(offset + TASK_POINT_SECTOR_END_LAT, tp.SectorEndLat);
+    PutDouble(offset + TASK_POINT_SECTOR_END_LON, tp.SectorEndLon);
+    PutPoint(offset + TASK_POINT_START, tp.Start);
+    PutPoint(offset + TASK_POINT_END, tp.End);
+    PutInt(offset + TASK_POINT_AAT_TYPE, tp.AATType);
+    PutDouble(offset + TASK_POINT_AAT_CIRCLE_RADIUS, tp.AATCircleRadius);
+    PutDouble(offset + TASK_POINT_AAT_SECTOR_RADIUS, tp.AATSectorRadius);
+    PutDouble(offset + TASK_POINT_AAT_START_RADIAL, tp.AATStartRadial);
+    PutDouble(offset + TASK_POINT_AAT_FINISH_RADIAL, tp.AATFinishRadial);
+    PutDouble(offset + TASK_POINT_AAT_START_LAT, tp.AATStartLat);
+    PutDouble(offset + TASK_POINT_AAT_START_LON, tp.AATStartLon);
+    PutDouble(offset + TASK_POINT_AAT_FINISH_LAT, tp.AATFinishLat);
+    PutDouble(offset + TASK_POINT_AAT_FINISH_LON, tp.AATFinishLon);
+    PutPoint(offset + TASK_POINT_AAT_START, tp.AATStart);
+    PutPoint(offset + TASK_POINT_AAT_FINISH, tp.AATFinish);
+    PutDouble(offset + TASK_POINT_AAT_TARGET_OFFSET_RADIUS, tp.AATTargetOffsetRadius);
+    PutDouble(offset + TASK_POINT_AAT_TARGET_OFFSET_RADIAL, tp.AATTargetOffsetRadial);
+    PutDouble(offset + TASK_POINT_AAT_TARGET_LAT, tp.AATTargetLat);
+    PutDouble(offset + TASK_POINT_AAT_TARGET_LON, tp.AATTargetLon);
+    PutPoint(offset + TASK_POINT_TARGET, tp.Target);
+    PutBool(offset + TASK_POINT_AAT_TARGET_LOCKED, tp.AATTargetLocked);
+  }
+}
+
+
+/**
+ * @brief Writes task settings.
+ *
+ * @param settingsTask Task settings.
+ */
+void condor2nav::CTaskImage::Settings(const xcsoar::SETTINGS_TASK &settingsTask)
+{
+  const auto offset = Offset(_format, TPart::SETTINGS);
+  PutInt(offset + SETTINGS_AAT_ENABLED, settingsTask.AATEnabled);
+  PutDouble(offset + SETTINGS_AAT_TASK_LENGTH, settingsTask.AATTaskLength);
+  PutInt(offset + SETTINGS_FINISH_RADIUS, settingsTask.FinishRadius);
+  PutInt(offset + SETTINGS_FINISH_TYPE, settingsTask.FinishType);
+  PutInt(offset + SETTINGS_START_RADIUS, settingsTask.StartRadius);
+  PutInt(offset + SETTINGS_START_TYPE, settingsTask.StartType);
+  PutInt(offset + SETTINGS_SECTOR_TYPE, settingsTask.SectorType);
+  PutInt(offset + SETTINGS_SECTOR_RADIUS, settingsTask.SectorRadius);
+  PutInt(offset + SETTINGS_AUTO_ADVANCE, settingsTask.AutoAdvance);
+  PutBool(offset + SETTINGS_ENABLE_MULTIPLE_START, settingsTask.EnableMultipleStartPoints);
+}
+
+
+/**
+ * @brief Writes start points.
+ *
+ * @param startPointArray Start points array.
+ */
+void condor2nav::CTaskImage::StartPoints(const xcsoar::START_POINT startPointArray[])
+{
+  auto offset = Offset(_format, TPart::START_POINTS);
+  for(const auto end = Offset(_format, TPart::TASK_WAYPOINTS); offset < end; offset += START_POINT_SIZE, ++startPointArray) {
+    const auto &sp = *startPointArray;
+    PutInt(offset + START_POINT_INDEX, sp.Index);
+    PutDouble(offset + START_POINT_OUT_BOUND, sp.OutBound);
+    PutDouble(offset + START_POINT_SECTOR_START_LAT, sp.SectorStartLat);
+    PutDouble(offset + START_POINT_SECTOR_START_LON, sp.SectorStartLon);
+    PutDouble(offset + START_POINT_SECTOR_END_LAT, sp.SectorEndLat);
+    PutDouble(offset + START_POINT_SECTOR_END_LON, sp.SectorEndLon);
+    PutPoint(offset + START_POINT_START, sp.Start);
+    PutPoint(offset + START_POINT_END, sp.End);
+    PutBool(offset + START_POINT_ACTIVE, sp.Active);
+    PutBool(offset + START_POINT_IN_SECTOR, sp.InSector);
+  }
+}
+
+
+/**
+ * @brief Writes task waypoints.
+ *
+ * Start waypoints are not used and stay empty.
+ *
+ * @param waypointArray The array of waypoints data.
+ */
+void condor2nav::CTaskImage::Waypoints(const CWaypointArray &waypointArray)
+{
+  const bool lk8000 = _format == TFormat::LK8000_1_24;
+  const size_t waypointsNum = lk8000 ? lk8000::MAXTASKPOINTS : xcsoar::MAXTASKPOINTS;
+  if(waypointArray.size() > waypointsNum)
+    throw EOperationFailed{"ERROR: Too many task waypoints (" + Convert(waypointArray.size()) + ")!!!"};
+
+  auto offset = Offset(_format, TPart::TASK_WAYPOINTS);
+  for(const auto &waypoint : waypointArray) {
+    if(lk8000) {
+      PutInt(offset + LK8000_WAYPOINT_NUMBER, waypoint.number);
+      PutDouble(offset + LK8000_WAYPOINT_LATITUDE, waypoint.latitude);
+      PutDouble(offset + LK8000_WAYPOINT_LONGITUDE, waypoint.longitude);
+      PutDouble(offset + LK8000_WAYPOINT_ALTITUDE, waypoint.altitude);
+      PutInt(offset + LK8000_WAYPOINT_FLAGS, waypoint.flags);
+      PutString(offset + LK8000_WAYPOINT_NAME, waypoint.name, lk8000::NAME_SIZE);
+      // comment is stored by pointer in LK8000 so it cannot be provided in a file
+      PutBool(offset + LK8000_WAYPOINT_IN_TASK, true);
+      PutShort(offset + LK8000_WAYPOINT_STYLE, 1);
+      offset += LK8000_WAYPOINT_SIZE;
+    }
+    else {
+      PutInt(offset + XCSOAR_WAYPOINT_NUMBER, waypoint.number);
+      PutDouble(offset + XCSOAR_WAYPOINT_LATITUDE, waypoint.latitude);
+      PutDouble(offset + XCSOAR_WAYPOINT_LONGITUDE, waypoint.longitude);
+      PutDouble(offset + XCSOAR_WAYPOINT_ALTITUDE, waypoint.altitude);
+      PutInt(offset + XCSOAR_WAYPOINT_FLAGS, waypoint.flags);
+      PutString(offset + XCSOAR_WAYPOINT_NAME, waypoint.name, xcsoar::NAME_SIZE);
+      PutString(offset + XCSOAR_WAYPOINT_COMMENT, waypoint.comment, xcsoar::COMMENT_SIZE);
+      PutBool(offset + XCSOAR_WAYPOINT_IN_TASK, true);
+      offset += XCSOAR_WAYPOINT_SIZE;
+    }
+  }
+}
+
+
+/**
+ * @brief Returns task file image.
+ *
+ * @return Task file image.
+ */
+const std::string &condor2nav::CTaskImage::Data() const
+{
+  return _buffer;
+}
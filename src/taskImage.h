@@ -0,0 +1,216 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file taskImage.h
+ *
+ * @brief Declares the condor2nav::CTaskImage class. 
+ */
+
+#ifndef __TASKIMAGE_H__
+#define __TASKIMAGE_H__
+
+#include "nonCopyable.h"
+#include "imports/xcsoarTypes.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Binary task file image.
+   *
+   * condor2nav::CTaskImage class creates the contents of XCSoar 5 and LK8000 1.24 binary
+   * task files. Those files are memory dumps of application structures so the image follows
+   * the layout of the structures on the target device (32-bit Windows CE: little-endian,
+   * 4-byte pointers, UTF-16 strings). The layout is described by the enumerations below and
+   * every field is encoded explicitly so the image does not depend on the layout of host
+   * structures. The whole image is created in one zero-initialized buffer of exact size
+   * and every part is written directly to its place.
+   */
+  class CTaskImage : CNonCopyable {
+  public:
+    /**
+     * @brief Task file formats.
+     */
+    enum class TFormat {
+      XCSOAR_5,                                 ///< @brief XCSoar 5 task file.
+      LK8000_1_24                               ///< @brief LK8000 1.24 task file.
+    };
+
+    /**
+     * @brief Task waypoint data.
+     */
+    struct TWaypoint {
+      int number;
+      double latitude;
+      double longitude;
+      double altitude;
+      int flags;
+      std::string name;
+      std::string comment;
+      bool inTask;
+    };
+    using CWaypointArray = std::vector<TWaypoint>;
+
+    /**
+     * @brief Layout of xcsoar::TASK_POINT record.
+     */
+    enum TTaskPointLayout {
+      TASK_POINT_INDEX                    = 0,
+      TASK_POINT_IN_BOUND                 = 8,
+      TASK_POINT_OUT_BOUND                = 16,
+      TASK_POINT_BISECTOR                 = 24,
+      TASK_POINT_LEG                      = 32,
+      TASK_POINT_SECTOR_START_LAT         = 40,
+      TASK_POINT_SECTOR_START_LON         = 48,
+      TASK_POINT_SECTOR_END_LAT           = 56,
+      TASK_POINT_SECTOR_END_LON           = 64,
+      TASK_POINT_START                    = 72,
+      TASK_POINT_END                      = 80,
+      TASK_POINT_AAT_TYPE                 = 88,
+      TASK_POINT_AAT_CIRCLE_RADIUS        = 96,
+      TASK_POINT_AAT_SECTOR_RADIUS        = 104,
+      TASK_POINT_AAT_START_RADIAL         = 112,
+      TASK_POINT_AAT_FINISH_RADIAL        = 120,
+      TASK_POINT_AAT_START_LAT            = 128,
+      TASK_POINT_AAT_START_LON            = 136,
+      TASK_POINT_AAT_FINISH_LAT           = 144,
+      TASK_POINT_AAT_FINISH_LON           = 152,
+      TASK_POINT_AAT_START                = 160,
+      TASK_POINT_AAT_FINISH               = 168,
+      TASK_POINT_AAT_TARGET_OFFSET_RADIUS = 176,
+      TASK_POINT_AAT_TARGET_OFFSET_RADIAL = 184,
+      TASK_POINT_AAT_TARGET_LAT           = 192,
+      TASK_POINT_AAT_TARGET_LON           = 200,
+      TASK_POINT_TARGET                   = 208,
+      TASK_POINT_AAT_TARGET_LOCKED        = 216,
+      TASK_POINT_SIZE                     = 224
+    };
+
+    /**
+     * @brief Layout of xcsoar::START_POINT record.
+     */
+    enum TStartPointLayout {
+      START_POINT_INDEX                   = 0,
+      START_POINT_OUT_BOUND               = 8,
+      START_POINT_SECTOR_START_LAT        = 16,
+      START_POINT_SECTOR_START_LON        = 24,
+      START_POINT_SECTOR_END_LAT          = 32,
+      START_POINT_SECTOR_END_LON          = 40,
+      START_POINT_START                   = 48,
+      START_POINT_END                     = 56,
+      START_POINT_ACTIVE                  = 64,
+      START_POINT_IN_SECTOR               = 65,
+      START_POINT_SIZE                    = 72
+    };
+
+    /**
+     * @brief Layout of xcsoar::SETTINGS_TASK fields stored in the file (stored without padding).
+     */
+    enum TSettingsLayout {
+      SETTINGS_AAT_ENABLED                = 0,
+      SETTINGS_AAT_TASK_LENGTH            = 4,
+      SETTINGS_FINISH_RADIUS              = 12,
+      SETTINGS_FINISH_TYPE                = 16,
+      SETTINGS_START_RADIUS               = 20,
+      SETTINGS_START_TYPE                 = 24,
+      SETTINGS_SECTOR_TYPE                = 28,
+      SETTINGS_SECTOR_RADIUS              = 32,
+      SETTINGS_AUTO_ADVANCE               = 36,
+      SETTINGS_ENABLE_MULTIPLE_START      = 40,
+      SETTINGS_SIZE                       = 41
+    };
+
+    /**
+     * @brief Layout of xcsoar::WAYPOINT record.
+     */
+    enum TXCSoarWaypointLayout {
+      XCSOAR_WAYPOINT_NUMBER              = 0,
+      XCSOAR_WAYPOINT_LATITUDE            = 8,
+      XCSOAR_WAYPOINT_LONGITUDE           = 16,
+      XCSOAR_WAYPOINT_ALTITUDE            = 24,
+      XCSOAR_WAYPOINT_FLAGS               = 32,
+      XCSOAR_WAYPOINT_NAME                = 36,
+      XCSOAR_WAYPOINT_COMMENT             = 138,
+      XCSOAR_WAYPOINT_IN_TASK             = 268,
+      XCSOAR_WAYPOINT_SIZE                = 288
+    };
+
+    /**
+     * @brief Layout of lk8000::WAYPOINT record.
+     */
+    enum TLK8000WaypointLayout {
+      LK8000_WAYPOINT_NUMBER              = 0,
+      LK8000_WAYPOINT_LATITUDE            = 8,
+      LK8000_WAYPOINT_LONGITUDE           = 16,
+      LK8000_WAYPOINT_ALTITUDE            = 24,
+      LK8000_WAYPOINT_FLAGS               = 32,
+      LK8000_WAYPOINT_NAME                = 36,
+      LK8000_WAYPOINT_COMMENT             = 100,
+      LK8000_WAYPOINT_IN_TASK             = 132,
+      LK8000_WAYPOINT_STYLE               = 246,
+      LK8000_WAYPOINT_SIZE                = 248
+    };
+
+    static const unsigned LK8000_VERSION_SIZE = 50;     ///< @brief The size of LK8000 task file version header.
+
+  private:
+    /**
+     * @brief Task file parts in file order.
+     */
+    enum class TPart {
+      VERSION,
+      TASK_POINTS,
+      SETTINGS,
+      START_POINTS,
+      TASK_WAYPOINTS,
+      START_WAYPOINTS,
+      END
+    };
+
+    const TFormat _format;                      ///< @brief Task file format.
+    std::string _buffer;                        ///< @brief Task file image.
+
+    static size_t Offset(TFormat format, TPart part);
+
+    void PutInt(size_t offset, std::int32_t value);
+    void PutShort(size_t offset, std::int16_t value);
+    void PutBool(size_t offset, bool value);
+    void PutDouble(size_t offset, double value);
+    void PutPoint(size_t offset, const POINT &point);
+    void PutString(size_t offset, const std::string &str, unsigned size);
+
+  public:
+    static size_t Size(TFormat format);
+
+    explicit CTaskImage(TFormat format);
+    void TaskPoints(const xcsoar::TASK_POINT taskPointArray[]);
+    void Settings(const xcsoar::SETTINGS_TASK &settingsTask);
+    void StartPoints(const xcsoar::START_POINT startPointArray[]);
+    void Waypoints(const CWaypointArray &waypointArray);
+    const std::string &Data() const;
+  };
+
+}
+
+#endif /* __TASKIMAGE_H__ */
@@ -0,0 +1,84 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file threadPool.cpp
+ *
+ * @brief Thread pool.
+ */
+
+#include "threadPool.h"
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CThreadPool class constructor. Starts worker threads.
+ *
+ * @param size The number of worker threads.
+ */
+condor2nav::CThreadPool::CThreadPool(unsigned size)
+{
+  _threads.reserve(size);
+  for(unsigned i = 0; i < size; ++i)
+    _threads.emplace_back([this]{ Run(); });
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::CThreadPool class destructor. Waits for all scheduled tasks
+ * to finish and stops worker threads.
+ */
+condor2nav::CThreadPool::~CThreadPool()
+{
+  // empty task finishes a worker
+  for(size_t i = 0; i < _threads.size(); ++i)
+    _taskQueue.Push(CTask{});
+  for(auto &thread : _threads)
+    thread.join();
+}
+
+
+/**
+ * @brief Schedules a task.
+ *
+ * Task is run by the first worker thread that is not busy.
+ *
+ * @param task The task to run.
+ */
+void condor2nav::CThreadPool::Send(CTask task)
+{
+  _taskQueue.Push(std::move(task));
+}
+
+
+/**
+ * @brief Worker thread loop.
+ *
+ * Method runs tasks from the queue until an empty task is received.
+ */
+void condor2nav::CThreadPool::Run()
+{
+  while(auto task = _taskQueue.PopWait())
+    task();
+}
@@ -0,0 +1,58 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file threadPool.h
+ *
+ * @brief Thread pool.
+ */
+
+#ifndef __THREADPOOL_H__
+#define __THREADPOOL_H__
+
+#include "waitQueue.h"
+#include <functional>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Thread pool.
+   *
+   * condor2nav::CThreadPool class runs provided tasks on a number of worker
+   * threads. Destructor waits for all scheduled tasks to finish.
+   */
+  class CThreadPool : CNonCopyable {
+    using CTask = std::function<void()>;
+
+    CWaitQueue<CTask> _taskQueue;
+    std::vector<std::thread> _threads;
+
+    void Run();
+  public:
+    explicit CThreadPool(unsigned size);
+    ~CThreadPool();
+    void Send(CTask task);
+  };
+
+}
+
+#endif /* __THREADPOOL_H__ */
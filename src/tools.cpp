@@ -27,19 +27,19 @@
 
 #include "tools.h"
 #include "istream.h"
-#include "activeSync.h"
+#include "deviceTransport.h"
+#include "translationCache.h"
 #include <boost/filesystem.hpp>
 #include <boost/filesystem/fstream.hpp>
 #include <iomanip>
 #include <vector>
 #include <algorithm>
-#include <windows.h>
 
 
 
 namespace {
 
-  const double PI = 3.1415923865;
+  const double PI = 3.14159265358979323846;
 
 }
 
@@ -222,7 +222,8 @@ double condor2nav::Rad2Deg(double angle)
 /** 
  * @brief Creates specified directory
  * 
- * Function creates given directory recursively.
+ * Function creates given directory recursively. Nothing is created
+ * during dry run translation.
  * 
  * @param dirName Directory name to created.
  *
@@ -235,20 +236,20 @@ void condor2nav::DirectoryCreate(const bfs::path &dirName)
   if(str.size() > 2 && str[0] == '\\' && str[1] != '\\')
     activeSync = true;
 
-  if(!dirName.empty()) {
+  if(!dirName.empty() && !CTranslationCache::CRecorder::DryRun()) {
     if(!activeSync) {
       bfs::create_directories(dirName);
     }
     else {
-      auto path = dirName;
-      std::vector<bfs::path> dirs;
-      while(path.parent_path() != "\\") {
-        dirs.emplace_back(path);
-        path = path.parent_path();
+      // device root directory (i.e. "\My Documents") is expected to exist
+      // (backslash is not a path separator outside of Windows so split manually on both)
+      const auto transport = CDeviceTransport::Current();
+      auto pos = str.find_first_of("\\/", 1);
+      while(pos != std::string::npos) {
+        const auto next = str.find_first_of("\\/", pos + 1);
+        transport->DirectoryCreate(str.substr(0, next));
+        pos = next;
       }
-      auto &activeSync = CActiveSync::Instance();
-      std::for_each(dirs.crbegin(), dirs.crend(),
-                    [&](const bfs::path &d){ activeSync.DirectoryCreate(d); });
     }
   }
 }
@@ -270,10 +271,9 @@ bool condor2nav::FileExists(const bfs::path &fileName)
   if(str.size() > 2 && str[0] == '\\' && str[1] != '\\')
     activeSync = true;
 
-  if(activeSync)
-    return CActiveSync::Instance().FileExists(fileName);
-  else
-    return bfs::exists(fileName);
+  const bool exists = activeSync ? CDeviceTransport::Current()->FileExists(fileName) : bfs::exists(fileName);
+  CTranslationCache::CRecorder::OnFileExists(fileName, exists);
+  return exists;
 }
 
 
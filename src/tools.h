@@ -32,20 +32,10 @@
 #include "boostfwd.h"
 #include <sstream>
 #include <memory>
-#include <Windows.h>
 
 
 namespace condor2nav {
 
-  /**
-   * @brief Deleter for HModule
-   */
-  struct CLibraryDeleter {
-    typedef HMODULE pointer;
-    void operator()(HMODULE hmod) const { ::FreeLibrary(hmod); }
-  };
-  using CLibraryRes = std::unique_ptr<HMODULE, CLibraryDeleter>;
-
   // conversions
   template<class T>
   T Convert(const std::string &str);
@@ -31,12 +31,99 @@
 #include <string>
 #include <cctype>
 #include <cwctype>
+#include <istream>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define CONDOR2NAV_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace condor2nav {
 
   inline int    ToUpper(char ch)    { return std::toupper(ch); }
   inline wint_t ToUpper(wchar_t ch) { return std::towupper(ch); }
-  
+
+#ifdef CONDOR2NAV_SSE2
+
+  /**
+   * @brief Converts 16 ASCII characters to upper case.
+   *
+   * @param v Characters to convert.
+   *
+   * @return Upper case characters.
+   */
+  inline __m128i ToUpper(__m128i v)
+  {
+    const auto lower = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('z' + 1)));
+    return _mm_sub_epi8(v, _mm_and_si128(lower, _mm_set1_epi8('a' - 'A')));
+  }
+
+#endif
+
+  /**
+   * @brief Skips equal ASCII prefix of 2 strings.
+   *
+   * Function quickly skips the beginning of 2 strings that is equal in case-insensitive
+   * manner and contains only ASCII characters (processed 16 characters at a time).
+   * The rest of the strings has to be compared with ToUpper().
+   *
+   * @param s1 The first string to compare. 
+   * @param s2 The second string to compare. 
+   * @param N  Size of the string to be compared. 
+   *
+   * @return The number of characters that are known to be equal.
+   */
+  inline size_t NoCaseEqualPrefix(const char *s1, const char *s2, size_t N)
+  {
+    size_t i = 0;
+#ifdef CONDOR2NAV_SSE2
+    for(; i + 16 <= N; i += 16) {
+      const auto v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s1 + i));
+      const auto v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s2 + i));
+      if(_mm_movemask_epi8(_mm_or_si128(v1, v2)) ||                              // non-ASCII characters
+         _mm_movemask_epi8(_mm_cmpeq_epi8(ToUpper(v1), ToUpper(v2))) != 0xFFFF)  // difference found
+        break;
+    }
+#endif
+    return i;
+  }
+
+  inline size_t NoCaseEqualPrefix(const wchar_t *, const wchar_t *, size_t) { return 0; }
+
+
+  /**
+   * @brief Skips ASCII prefix of a string that does not contain given character.
+   *
+   * Function quickly skips the beginning of the string that contains only ASCII characters
+   * not equal to @p a in case-insensitive manner (processed 16 characters at a time).
+   * The rest of the string has to be searched with ToUpper().
+   *
+   * @param s The string to search in. 
+   * @param N The number of positions to search.
+   * @param a The character to find. 
+   *
+   * @return The number of characters that are known not to match.
+   */
+  inline size_t NoCaseMismatchPrefix(const char *s, size_t N, char a)
+  {
+    size_t i = 0;
+#ifdef CONDOR2NAV_SSE2
+    if(static_cast<unsigned char>(a) < 0x80) {
+      const auto upper = ToUpper(_mm_set1_epi8(a));
+      for(; i + 16 <= N; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        if(_mm_movemask_epi8(v) ||                                  // non-ASCII characters
+           _mm_movemask_epi8(_mm_cmpeq_epi8(ToUpper(v), upper)))   // character found
+          break;
+      }
+    }
+#endif
+    return i;
+  }
+
+  inline size_t NoCaseMismatchPrefix(const wchar_t *, size_t, wchar_t) { return 0; }
+
+
   /**
    * @brief Case-insensitive traits for strings. 
    *
@@ -85,11 +172,11 @@ namespace condor2nav {
      */
     static int compare(const Char *s1, const Char *s2, size_t N)
     {
-      for(size_t i = 0; i < N; ++i) {
-        if(lt(s1[i], s2[i]))
-          return -1;
-        if(lt(s2[i], s1[i]))
-          return +1;
+      for(size_t i = NoCaseEqualPrefix(s1, s2, N); i < N; ++i) {
+        const auto c1 = ToUpper(s1[i]);
+        const auto c2 = ToUpper(s2[i]);
+        if(c1 != c2)
+          return c1 < c2 ? -1 : +1;
       }
       return 0;
     }
@@ -107,9 +194,10 @@ namespace condor2nav {
      */
     static const Char *find(const Char *s, size_t N, const Char &a)
     {
-      for(size_t i=0; i<N; ++i)
-        if(ToUpper(s[i]) == ToUpper(a))
-          return s+i;
+      const auto upper = ToUpper(a);
+      for(size_t i = NoCaseMismatchPrefix(s, N, a); i < N; ++i)
+        if(ToUpper(s[i]) == upper)
+          return s + i;
       return 0;
     }
   };
@@ -122,6 +210,27 @@ namespace condor2nav {
   using CWStringNoCase = std::basic_string<wchar_t, CTraitsNoCase<wchar_t>>;
 
 
+  /**
+   * @brief Case-insensitive strings hash.
+   *
+   * Hash functor to be used with case-insensitive strings in unordered containers.
+   * Strings equal in case-insensitive manner get the same hash.
+   */
+  struct CHashNoCase {
+    template<typename Char>
+    size_t operator()(const std::basic_string<Char, CTraitsNoCase<Char>> &str) const
+    {
+      // FNV-1a
+      size_t hash = 2166136261U;
+      for(auto ch : str) {
+        hash ^= (ch >= 'a' && ch <= 'z') ? static_cast<size_t>(ch - ('a' - 'A')) : static_cast<size_t>(ToUpper(ch));
+        hash *= 16777619U;
+      }
+      return hash;
+    }
+  };
+
+
   /**
    * @brief Dumps case-insensitive string to a stream. 
    *
@@ -0,0 +1,474 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file translationCache.cpp
+ *
+ * @brief Implements the condor2nav::CTranslationCache class. 
+ */
+
+#include "translationCache.h"
+#include "istream.h"
+#include "ostream.h"
+#include "tools.h"
+#include <boost/filesystem.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+const condor2nav::CTranslationCache::THash condor2nav::CTranslationCache::HASH_SEED = 14695981039346656037ULL;
+
+namespace {
+
+  const condor2nav::CTranslationCache::THash HASH_PRIME = 1099511628211ULL;
+
+  std::mutex recordersMutex;
+  std::map<std::thread::id, condor2nav::CTranslationCache::CRecorder *> recorders;
+
+}
+
+
+
+/* ********************* T R A N S L A T I O N   C A C H E   -   R E C O R D E R ********************* */
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CTranslationCache::CRecorder class constructor. Starts recording
+ * of file operations done by the current thread.
+ *
+ * @param cache  The cache to store translation in.
+ * @param key    Translation key.
+ * @param dryRun Do not write any files (only record their contents).
+ */
+condor2nav::CTranslationCache::CRecorder::CRecorder(CTranslationCache &cache, THash key, bool dryRun /* = false */) :
+  _cache(cache), _key{key}, _cacheable{true}, _dryRun{dryRun}
+{
+  std::lock_guard<std::mutex> lock{recordersMutex};
+  recorders[std::this_thread::get_id()] = this;
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::CTranslationCache::CRecorder class destructor. Stops recording.
+ */
+condor2nav::CTranslationCache::CRecorder::~CRecorder()
+{
+  std::lock_guard<std::mutex> lock{recordersMutex};
+  recorders.erase(std::this_thread::get_id());
+}
+
+
+/**
+ * @brief Returns the recorder of the current thread.
+ *
+ * @return The recorder of the current thread or nullptr if not recording.
+ */
+condor2nav::CTranslationCache::CRecorder *condor2nav::CTranslationCache::CRecorder::Current()
+{
+  std::lock_guard<std::mutex> lock{recordersMutex};
+  const auto it = recorders.find(std::this_thread::get_id());
+  return it != recorders.end() ? it->second : nullptr;
+}
+
+
+/**
+ * @brief Checks if files should not be written.
+ *
+ * @return @p true if the current thread does a dry run translation.
+ */
+bool condor2nav::CTranslationCache::CRecorder::DryRun()
+{
+  const auto recorder = Current();
+  return recorder && recorder->_dryRun;
+}
+
+
+/**
+ * @brief Records file dependency.
+ *
+ * Method records the state of the file. Only the first state of the file is
+ * remembered (the one from before the translation modified it) unless the
+ * contents of a file known only to exist is provided. Files already written
+ * by the translation are not its dependencies.
+ *
+ * @param path The path of the file.
+ * @param type Dependency type.
+ * @param hash The hash of the file contents.
+ */
+void condor2nav::CTranslationCache::CRecorder::Dependency(const bfs::path &path, TDependencyType type, THash hash /* = 0 */)
+{
+  if(PathType(path) != TPathType::LOCAL) {
+    _cacheable = false;
+    return;
+  }
+  if(std::any_of(_outputs.begin(), _outputs.end(), [&](const std::pair<bfs::path, std::string> &output){ return output.first == path; }))
+    return;
+  auto ret = _dependencies.insert(std::make_pair(path, TDependency{type, hash, false, 0}));
+  if(!ret.second && ret.first->second.type == TDependencyType::EXISTS && type == TDependencyType::CONTENT)
+    ret.first->second = TDependency{type, hash, false, 0};
+}
+
+
+/**
+ * @brief Stores recorded translation in the cache.
+ *
+ * Method should be called after successful translation.
+ */
+void condor2nav::CTranslationCache::CRecorder::Commit()
+{
+  if(!_cacheable || _outputs.empty())
+    return;
+
+  auto entry = std::make_shared<TEntry>();
+  entry->key = _key;
+  entry->size = 0;
+  for(const auto &output : _outputs) {
+    entry->size += output.first.string().size() + output.second.size();
+
+    // previous output checked or read by the translation
+    const auto it = _dependencies.find(output.first);
+    if(it != _dependencies.end()) {
+      it->second.output = true;
+      it->second.outputHash = ContentHash(output.second);
+    }
+  }
+  entry->dependencies = std::move(_dependencies);
+  entry->outputs = std::move(_outputs);
+  _cache.Store(std::move(entry));
+}
+
+
+/**
+ * @brief Handles file existence check.
+ *
+ * @param path   The path of the file.
+ * @param exists Check result.
+ */
+void condor2nav::CTranslationCache::CRecorder::OnFileExists(const bfs::path &path, bool exists)
+{
+  if(auto recorder = Current())
+    recorder->Dependency(path, exists ? TDependencyType::EXISTS : TDependencyType::MISSING);
+}
+
+
+/**
+ * @brief Handles file read.
+ *
+ * Method handles the read of the file that was served from memory. File contents
+ * is hashed only if the current thread is recording.
+ *
+ * @param path The path of the file.
+ */
+void condor2nav::CTranslationCache::CRecorder::OnFileRead(const bfs::path &path)
+{
+  if(auto recorder = Current()) {
+    THash hash;
+    if(FileHash(path, hash))
+      recorder->Dependency(path, TDependencyType::CONTENT, hash);
+    else
+      recorder->_cacheable = false;
+  }
+}
+
+
+/**
+ * @brief Handles file read.
+ *
+ * @param path The path of the file.
+ * @param hash The hash of file contents.
+ */
+void condor2nav::CTranslationCache::CRecorder::OnFileRead(const bfs::path &path, THash hash)
+{
+  if(auto recorder = Current())
+    recorder->Dependency(path, TDependencyType::CONTENT, hash);
+}
+
+
+/**
+ * @brief Handles file write.
+ *
+ * @param path The path of the file.
+ * @param data Provides file contents (called only if the file is recorded).
+ */
+void condor2nav::CTranslationCache::CRecorder::OnFileWrite(const bfs::path &path, const std::function<const std::string &()> &data)
+{
+  if(auto recorder = Current()) {
+    if(PathType(path) != TPathType::LOCAL) {
+      recorder->_cacheable = false;
+      return;
+    }
+    auto it = std::find_if(recorder->_outputs.begin(), recorder->_outputs.end(),
+                           [&](const std::pair<bfs::path, std::string> &output){ return output.first == path; });
+    if(it != recorder->_outputs.end())
+      it->second = data();
+    else
+      recorder->_outputs.emplace_back(path, data());
+  }
+}
+
+
+
+/* ************************** T R A N S L A T I O N   C A C H E ************************** */
+
+/**
+ * @brief Calculates the hash of data.
+ *
+ * Function calculates 64-bit FNV-1a hash of provided data. Several strings
+ * can be hashed together by providing the previous result as @p hash.
+ *
+ * @param data Data to hash.
+ * @param hash Initial hash value.
+ *
+ * @return Data hash.
+ */
+auto condor2nav::CTranslationCache::Hash(const std::string &data, THash hash /* = HASH_SEED */) -> THash
+{
+  return Hash(data.data(), data.size(), hash);
+}
+
+
+/**
+ * @brief Calculates the hash of data.
+ *
+ * Function calculates 64-bit FNV-1a hash of provided data. Data read in chunks
+ * can be hashed by providing the result for previous chunks as @p hash.
+ *
+ * @param data Data to hash.
+ * @param size Data size.
+ * @param hash Initial hash value.
+ *
+ * @return Data hash.
+ */
+auto condor2nav::CTranslationCache::Hash(const char *data, size_t size, THash hash) -> THash
+{
+  for(const auto end = data + size; data != end; ++data) {
+    hash ^= static_cast<unsigned char>(*data);
+    hash *= HASH_PRIME;
+  }
+  return hash;
+}
+
+
+/**
+ * @brief Calculates the hash of file contents.
+ *
+ * File is read the same way as condor2nav::CIStream does.
+ *
+ * @param path The path of the file.
+ * @param hash Calculated hash.
+ *
+ * @return @p true if file was read successfully.
+ */
+bool condor2nav::CTranslationCache::FileHash(const bfs::path &path, THash &hash)
+{
+  boost::system::error_code ec;
+  if(!bfs::is_regular_file(path, ec))
+    return false;
+  CIStream::CBuffer buffer{std::make_unique<CReaderFile>(path)};
+  std::istream{&buffer}.ignore(std::numeric_limits<std::streamsize>::max());
+  hash = buffer.Hash();
+  return true;
+}
+
+
+/**
+ * @brief Calculates the hash of file contents.
+ *
+ * Function calculates the hash of data to be written to a file the
+ * same way as FileHash() does for the file read (CR LF translated).
+ *
+ * @param data File contents.
+ *
+ * @return Data hash.
+ */
+auto condor2nav::CTranslationCache::ContentHash(const std::string &data) -> THash
+{
+  auto hash = HASH_SEED;
+  size_t pos = 0;
+  for(auto crlf = data.find("\r\n"); crlf != std::string::npos; crlf = data.find("\r\n", pos)) {
+    hash = Hash(data.data() + pos, crlf - pos, hash);
+    pos = crlf + 1;
+  }
+  return Hash(data.data() + pos, data.size() - pos, hash);
+}
+
+
+/**
+ * @brief Checks if cached translation is still valid.
+ *
+ * Output files of the translation that were also checked or read by it
+ * may be in the state from before the translation or contain exactly
+ * what the translation wrote.
+ *
+ * @param entry Cache entry.
+ *
+ * @return @p true if none of the files used by the translation changed.
+ */
+bool condor2nav::CTranslationCache::Valid(const TEntry &entry)
+{
+  for(const auto &dependency : entry.dependencies) {
+    const auto &path = dependency.first;
+    bool valid = true;
+    THash hash;
+    switch(dependency.second.type) {
+    case TDependencyType::MISSING:
+      valid = !bfs::exists(path);
+      break;
+
+    case TDependencyType::EXISTS:
+      valid = bfs::exists(path);
+      break;
+
+    case TDependencyType::CONTENT:
+      valid = FileHash(path, hash) && hash == dependency.second.hash;
+      break;
+    }
+    if(!valid && !(dependency.second.output && FileHash(path, hash) && hash == dependency.second.outputHash))
+      return false;
+  }
+  return true;
+}
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CTranslationCache class constructor.
+ *
+ * @param sizeMax Cache size limit in bytes (0 disables the cache).
+ */
+condor2nav::CTranslationCache::CTranslationCache(size_t sizeMax) :
+  _sizeMax{sizeMax}, _stats()
+{
+}
+
+
+/**
+ * @brief Stores new entry in the cache.
+ *
+ * Method stores new entry as the most recently used one replacing
+ * the entry with the same key and evicting the least recently used
+ * entries if the size limit is exceeded.
+ *
+ * @param entry The entry to store.
+ */
+void condor2nav::CTranslationCache::Store(std::shared_ptr<const TEntry> entry)
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  auto it = _entriesMap.find(entry->key);
+  if(it != _entriesMap.end()) {
+    _stats.size -= (*it->second)->size;
+    _entries.erase(it->second);
+    _entriesMap.erase(it);
+    _stats.entries = _entries.size();
+  }
+  if(entry->size > _sizeMax)
+    return;
+
+  while(_stats.size + entry->size > _sizeMax) {
+    _stats.size -= _entries.back()->size;
+    _entriesMap.erase(_entries.back()->key);
+    _entries.pop_back();
+    ++_stats.evictions;
+  }
+
+  _stats.size += entry->size;
+  _entries.push_front(std::move(entry));
+  _entriesMap[_entries.front()->key] = _entries.begin();
+  _stats.entries = _entries.size();
+}
+
+
+/**
+ * @brief Checks if valid translation is cached.
+ *
+ * Method does not change the order of entries and cache statistics.
+ *
+ * @param key Translation key.
+ *
+ * @return @p true if the translation is cached and none of its inputs changed.
+ */
+bool condor2nav::CTranslationCache::Contains(THash key) const
+{
+  std::shared_ptr<const TEntry> entry;
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto it = _entriesMap.find(key);
+    if(it != _entriesMap.end())
+      entry = *it->second;
+  }
+  return entry && Valid(*entry);
+}
+
+
+/**
+ * @brief Replays cached translation.
+ *
+ * Method writes again all the files generated by the cached translation
+ * if none of its inputs changed.
+ *
+ * @param key Translation key.
+ *
+ * @return The number of written files (0 if translation was not found in the cache).
+ */
+unsigned condor2nav::CTranslationCache::Replay(THash key)
+{
+  std::shared_ptr<const TEntry> entry;
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto it = _entriesMap.find(key);
+    if(it != _entriesMap.end()) {
+      _entries.splice(_entries.begin(), _entries, it->second);
+      entry = _entries.front();
+    }
+  }
+
+  if(!entry || !Valid(*entry)) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    ++_stats.misses;
+    return 0;
+  }
+
+  for(const auto &output : entry->outputs) {
+    DirectoryCreate(output.first.parent_path());
+    COStream{output.first}.Attach(output.second.data(), output.second.size());
+  }
+
+  std::lock_guard<std::mutex> lock{_mutex};
+  ++_stats.hits;
+  return static_cast<unsigned>(entry->outputs.size());
+}
+
+
+/**
+ * @brief Returns cache statistics.
+ *
+ * @return Cache statistics.
+ */
+auto condor2nav::CTranslationCache::Stats() const -> TStats
+{
+  std::lock_guard<std::mutex> lock{_mutex};
+  return _stats;
+}
@@ -0,0 +1,167 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file translationCache.h
+ *
+ * @brief Declares the condor2nav::CTranslationCache class. 
+ */
+
+#ifndef __TRANSLATIONCACHE_H__
+#define __TRANSLATIONCACHE_H__
+
+#include "nonCopyable.h"
+#include "boostfwd.h"
+#include <boost/filesystem/path.hpp>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace condor2nav {
+
+  /**
+   * @brief Translation results cache.
+   *
+   * condor2nav::CTranslationCache class keeps the files generated by recent translations.
+   * Each entry is identified by a key computed from the translation inputs (FPL file contents,
+   * configuration and output directory) and remembers the state of all the files that were
+   * checked or read by the translation (data files, profile templates, previous output
+   * files). If none of them changed the translation outputs are simply written again.
+   * Output files are also valid inputs if they still have the contents written by the
+   * translation so the same task translated again to the same directory is replayed.
+   * Least recently used entries are evicted when the cache size limit is exceeded.
+   * All methods are thread-safe.
+   */
+  class CTranslationCache : CNonCopyable {
+  public:
+    using THash = std::uint64_t;
+
+    /**
+     * @brief Cache statistics.
+     */
+    struct TStats {
+      unsigned hits;                            ///< @brief Number of translations replayed from the cache.
+      unsigned misses;                          ///< @brief Number of translations not found in the cache.
+      unsigned evictions;                       ///< @brief Number of entries removed because of size limit.
+      size_t entries;                           ///< @brief Number of entries in the cache.
+      size_t size;                              ///< @brief Size of cached data in bytes.
+    };
+
+  private:
+    /**
+     * @brief Type of file dependency.
+     */
+    enum class TDependencyType {
+      MISSING,                                  ///< @brief File did not exist.
+      EXISTS,                                   ///< @brief File existed.
+      CONTENT                                   ///< @brief File with given contents was read.
+    };
+
+    /**
+     * @brief File dependency.
+     */
+    struct TDependency {
+      TDependencyType type;
+      THash hash;
+      bool output;                              ///< @brief The file is also written by the translation.
+      THash outputHash;                         ///< @brief The hash of the contents written by the translation.
+    };
+    using CDependenciesMap = std::map<bfs::path, TDependency>;
+    using COutputsList = std::vector<std::pair<bfs::path, std::string>>;
+
+    /**
+     * @brief Cache entry.
+     */
+    struct TEntry {
+      THash key;
+      CDependenciesMap dependencies;
+      COutputsList outputs;
+      size_t size;
+    };
+    using CEntriesList = std::list<std::shared_ptr<const TEntry>>;    ///< @brief Entries ordered from the most recently used.
+    using CEntriesMap = std::map<THash, CEntriesList::iterator>;
+
+    static bool FileHash(const bfs::path &path, THash &hash);
+    static THash ContentHash(const std::string &data);
+    static bool Valid(const TEntry &entry);
+
+    const size_t _sizeMax;                      ///< @brief Cache size limit in bytes.
+    mutable std::mutex _mutex;                  ///< @brief Cache access guard.
+    CEntriesList _entries;                      ///< @brief Cache entries.
+    CEntriesMap _entriesMap;                    ///< @brief Cache entries by key.
+    TStats _stats;                              ///< @brief Cache statistics.
+
+    void Store(std::shared_ptr<const TEntry> entry);
+
+  public:
+    /**
+     * @brief Translation recorder.
+     *
+     * condor2nav::CTranslationCache::CRecorder class records all files checked, read and
+     * written by the current thread for the time of its life. Recorded translation is
+     * stored in the cache by Commit(). Translations that use ActiveSync paths are never stored.
+     * Dry run recorder does not let the translation write any files so their contents is only
+     * kept in the cache and written later by CTranslationCache::Replay().
+     */
+    class CRecorder : CNonCopyable {
+      CTranslationCache &_cache;                ///< @brief The cache to use.
+      const THash _key;                         ///< @brief Translation key.
+      CDependenciesMap _dependencies;           ///< @brief Files checked or read by the translation.
+      COutputsList _outputs;                    ///< @brief Files written by the translation.
+      bool _cacheable;                          ///< @brief Set to false if translation cannot be cached.
+      const bool _dryRun;                       ///< @brief Files are not written if true.
+
+      static CRecorder *Current();
+      void Dependency(const bfs::path &path, TDependencyType type, THash hash = 0);
+
+    public:
+      CRecorder(CTranslationCache &cache, THash key, bool dryRun = false);
+      ~CRecorder();
+      void Commit();
+
+      static bool DryRun();
+
+      static void OnFileExists(const bfs::path &path, bool exists);
+      static void OnFileRead(const bfs::path &path);
+      static void OnFileRead(const bfs::path &path, THash hash);
+      static void OnFileWrite(const bfs::path &path, const std::function<const std::string &()> &data);
+    };
+
+    static const THash HASH_SEED;               ///< @brief Initial value of a hash.
+
+    static THash Hash(const std::string &data, THash hash = HASH_SEED);
+    static THash Hash(const char *data, size_t size, THash hash);
+
+    explicit CTranslationCache(size_t sizeMax);
+    bool Contains(THash key) const;
+    unsigned Replay(THash key);
+    TStats Stats() const;
+  };
+
+}
+
+#endif /* __TRANSLATIONCACHE_H__ */
@@ -28,9 +28,14 @@
 #include "translator.h"
 #include "condor2nav.h"
 #include "condor.h"
+#include "deviceSession.h"
+#include "resources.h"
+#include "istream.h"
 #include "targetXCSoar.h"
 #include "targetXCSoar6.h"
 #include "targetLK8000.h"
+#include "threadPool.h"
+#include <chrono>
 
 const bfs::path condor2nav::CTranslator::DATA_PATH                = "data";
 const bfs::path condor2nav::CTranslator::SCENERIES_DATA_FILE_NAME = "SceneryData.csv";
@@ -47,10 +52,11 @@ const bfs::path condor2nav::CTranslator::GLIDERS_DATA_FILE_NAME   = "GliderData.
  * condor2nav::CTranslator::CTarget class constructor.
  *
  * @param translator Translator class.
+ * @param outputPath Translation output directory.
  */
-condor2nav::CTranslator::CTarget::CTarget(const CTranslator &translator) :
+condor2nav::CTranslator::CTarget::CTarget(const CTranslator &translator, bfs::path outputPath) :
   _translator{translator},
-  _outputPath{_translator._configParser.Value("Condor2Nav", "OutputPath")}
+  _outputPath{std::move(outputPath)}
 {
   DirectoryCreate(_outputPath);
 }
@@ -71,17 +77,17 @@ const condor2nav::CTranslator &condor2nav::CTranslator::CTarget::Translator() co
 
 
 /**
- * @brief Returns configuration INI file parser.
+ * @brief Returns configuration.
  *
- * Method returns configuration INI file parser. Should be used by the
+ * Method returns configuration used by the translation. Should be used by the
  * translation targets if directly provided information is not enough
  * for the translation.
  *
- * @return Configuration INI file parser. 
+ * @return Configuration. 
  */
-const condor2nav::CFileParserINI &condor2nav::CTranslator::CTarget::ConfigParser() const
+const condor2nav::TConfig &condor2nav::CTranslator::CTarget::Config() const
 {
-  return _translator._configParser;
+  return *_translator._config;
 }
 
 
@@ -123,101 +129,300 @@ const bfs::path &condor2nav::CTranslator::CTarget::OutputPath() const
  * condor2nav::CTranslator class constructor. 
  *
  * @param app          The application. 
- * @param configParser Configuration file parser.
+ * @param config       Configuration snapshot.
  * @param condor       The Condor wrapper.
  * @param aatTime      Minimum time for AAT task. 
+ * @param outputPath   Translation output directory (empty means the one from configuration file).
  */
-condor2nav::CTranslator::CTranslator(const CCondor2Nav &app, const CFileParserINI &configParser, const CCondor &condor, unsigned aatTime) :
-  _app{app}, _configParser{configParser}, _condor{condor}, _aatTime{aatTime}
+condor2nav::CTranslator::CTranslator(const CCondor2Nav &app, CConfigPtr config, const CCondor &condor, unsigned aatTime,
+                                     bfs::path outputPath /* = bfs::path{} */) :
+  _app{app}, _config{std::move(config)}, _condor{condor}, _aatTime{aatTime},
+  _outputPath{outputPath.empty() ? _config->general.outputPath : std::move(outputPath)}
 {
 }
 
 
+/**
+ * @brief Returns translation targets.
+ *
+ * Method returns translation targets provided in configuration file. Several
+ * targets may be provided as a comma separated list. In such a case every target
+ * is translated to the subdirectory of the output path named after the target.
+ * XCSoar5 and XCSoar6 target names select XCSoar version explicitly.
+ * Target names are already validated by the configuration.
+ *
+ * @param config     Configuration.
+ * @param outputPath Translation output directory.
+ *
+ * @return Translation targets.
+ */
+auto condor2nav::CTranslator::Targets(const TConfig &config, const bfs::path &outputPath) -> CTargetInfoArray
+{
+  CTargetInfoArray targets;
+  for(const auto &name : config.general.targets) {
+    TTargetInfo info{name, name, "", outputPath};
+    if(name == "XCSoar5" || name == "XCSoar6") {
+      info.chapter = "XCSoar";
+      info.version = name.substr(info.chapter.size());
+    }
+    targets.emplace_back(std::move(info));
+  }
+  if(targets.size() > 1)
+    for(auto &target : targets)
+      target.outputPath /= target.name;
+  return targets;
+}
+
+
 /**
  * @brief Creates Condor data translator target. 
  *
  * Method creates Condor data translator target.
  *
+ * @param info Translation target description.
+ *
  * @return Condor data translator target.
  */
-auto condor2nav::CTranslator::Target() const -> std::unique_ptr<CTarget>
+auto condor2nav::CTranslator::Target(const TTargetInfo &info) const -> std::unique_ptr<CTarget>
 {
-  const auto &target = _configParser.Value("Condor2Nav", "Target");
-  if(target == "XCSoar") {
-    const auto &version = _configParser.Value("XCSoar", "Version");
+  if(info.chapter == "XCSoar") {
+    const auto &version = info.version.empty() ? _config->xcsoar.version : info.version;
     if(version == "5")
-      return std::make_unique<CTargetXCSoar>(*this);
+      return std::make_unique<CTargetXCSoar>(*this, info.outputPath);
     else if(version == "6")
-      return std::make_unique<CTargetXCSoar6>(*this);
+      return std::make_unique<CTargetXCSoar6>(*this, info.outputPath);
     else
       throw EOperationFailed{"ERROR: Unknown XCSoar version '" + version + "'!!!"};
   }
-  else if(target == "LK8000")
-    return std::make_unique<CTargetLK8000>(*this);
+  else if(info.chapter == "LK8000")
+    return std::make_unique<CTargetLK8000>(*this, info.outputPath);
   else
-    throw EOperationFailed{"ERROR: Unknown translation target '" + target + "'!!!"};
+    throw EOperationFailed{"ERROR: Unknown translation target '" + info.name + "'!!!"};
+}
+
+
+/**
+ * @brief Calculates translation cache key.
+ *
+ * Method calculates the key that identifies the translation in the cache. The key
+ * depends on FPL file contents, translation configuration and output directory.
+ * Data and profile files are verified by the cache itself.
+ *
+ * @param info Translation target description.
+ *
+ * @return Translation cache key.
+ */
+condor2nav::CTranslationCache::THash condor2nav::CTranslator::CacheKey(const TTargetInfo &info) const
+{
+  CIStream fplStream{_condor.TaskParser().Path()};
+  std::stringstream fpl;
+  fpl << fplStream;
+
+  auto key = CTranslationCache::Hash(fpl.str());
+  key = CTranslationCache::Hash(Convert(_aatTime), key);
+  key = CTranslationCache::Hash(info.name + "\n" + info.version + "\n" + info.outputPath.string(), key);
+  for(const auto &chapter : { std::string{"Condor2Nav"}, info.chapter })
+    for(const auto &value : _config->parser->Values(chapter))
+      key = CTranslationCache::Hash(value.first + "=" + value.second + "\n", key);
+  return key;
 }
 
 
 /**
  * @brief Runs translation.
  *
- * Method is responsible for Condor data translation. Several
- * translate actions are configured through configuration INI file.
+ * Method is responsible for Condor data translation. When several targets are
+ * configured the task data is parsed and converted only once and all the targets
+ * are translated in parallel (one after another for ActiveSync outputs).
  */
 void condor2nav::CTranslator::Run()
 {
+  using clock = std::chrono::steady_clock;
+  using milliseconds = std::chrono::milliseconds;
+
   _app.LogHigh() << "Translation START" << std::endl;
 
+  const auto targets = Targets(*_config, _outputPath);
+  if(targets.size() == 1) {
+    Run(targets.front());
+  }
+  else {
+    /**
+     * @brief Single target translation result.
+     */
+    struct TResult {
+      std::string error;
+      milliseconds::rep time;
+    };
+    std::vector<TResult> results(targets.size());
+
+    // one connection to the device
+    const unsigned jobs = PathType(_outputPath) == TPathType::ACTIVE_SYNC ? 1 : static_cast<unsigned>(targets.size());
+    const auto start = clock::now();
+    {
+      CThreadPool pool{jobs};
+      for(size_t i = 0; i < targets.size(); ++i) {
+        pool.Send([&, i]{
+          const auto targetStart = clock::now();
+          try {
+            Run(targets[i]);
+          }
+          catch(const std::exception &ex) {
+            results[i].error = ex.what();
+          }
+          results[i].time = std::chrono::duration_cast<milliseconds>(clock::now() - targetStart).count();
+        });
+      }
+    }
+    const auto total = std::chrono::duration_cast<milliseconds>(clock::now() - start).count();
+
+    unsigned failed = 0;
+    milliseconds::rep sum = 0;
+    for(size_t i = 0; i < targets.size(); ++i) {
+      sum += results[i].time;
+      if(results[i].error.empty())
+        _app.Log() << "Target '" << targets[i].name << "' translated to '" << targets[i].outputPath.string() << "' in " << results[i].time << " ms" << std::endl;
+      else {
+        ++failed;
+        _app.Error() << "Target '" << targets[i].name << "' translation failed: " << results[i].error << std::endl;
+      }
+    }
+    _app.Log() << targets.size() << " targets translated in " << total << " ms (" << sum << " ms one after another, speedup "
+               << (total ? sum / static_cast<double>(total) : 1.0) << ")" << std::endl;
+    if(failed)
+      throw EOperationFailed{"ERROR: Translation of " + Convert(failed) + " of " + Convert(targets.size()) + " targets failed!!!"};
+  }
+
+  _app.LogHigh() << "Translation FINISH" << std::endl;
+}
+
+
+/**
+ * @brief Prepares translation in advance.
+ *
+ * Method translates targets with local output directories without writing
+ * any files. Generated files are kept in the translation cache so the following
+ * Run() only writes them if none of translation inputs changed in the meantime.
+ * Targets are translated one after another on the calling thread. ActiveSync
+ * outputs cannot be cached so they are not prepared.
+ *
+ * @return The number of targets prepared.
+ */
+unsigned condor2nav::CTranslator::Prepare() const
+{
+  unsigned prepared = 0;
+  auto &cache = _app.TranslationCache();
+  for(const auto &info : Targets(*_config, _outputPath)) {
+    if(PathType(info.outputPath) != TPathType::LOCAL)
+      continue;
+
+    const auto key = CacheKey(info);
+    if(!cache.Contains(key)) {
+      CTranslationCache::CRecorder recorder{cache, key, true};
+      Translate(info);
+      recorder.Commit();
+    }
+    if(cache.Contains(key))
+      ++prepared;
+  }
+  return prepared;
+}
+
+
+/**
+ * @brief Runs translation for one target.
+ *
+ * Method is responsible for Condor data translation for one target. Files
+ * generated by the same translation done recently are taken from the
+ * translation cache. Device outputs are sent to the device as one batch
+ * after the translation is finished.
+ *
+ * @param info Translation target description.
+ */
+void condor2nav::CTranslator::Run(const TTargetInfo &info) const
+{
+  std::unique_ptr<CDeviceSession> session;
+  if(PathType(info.outputPath) == TPathType::ACTIVE_SYNC)
+    session = std::make_unique<CDeviceSession>();
+
+  auto &cache = _app.TranslationCache();
+  const auto key = CacheKey(info);
+  if(const auto files = cache.Replay(key)) {
+    _app.Log() << "Translation results for '" << info.name << "' found in cache (" << files << " files written)" << std::endl;
+  }
+  else {
+    CTranslationCache::CRecorder recorder{cache, key};
+    Translate(info);
+    recorder.Commit();
+  }
+
+  if(session) {
+    session->Commit();
+    const auto &stats = session->Stats();
+    _app.Log() << "Device synchronized: " << stats.listings << " directories listed, " << stats.reads << " files read, "
+               << stats.creates << " directories created, " << stats.writes << " files written, " << stats.patches << " files patched ("
+               << stats.bytes << " bytes sent)" << std::endl;
+  }
+}
+
+
+/**
+ * @brief Translates Condor data.
+ *
+ * Method is responsible for Condor data translation. Several
+ * translate actions are configured through configuration INI file.
+ *
+ * @param info Translation target description.
+ */
+void condor2nav::CTranslator::Translate(const TTargetInfo &info) const
+{
   // create translation target
-  auto target = Target();
+  auto target = Target(info);
   
   {
-    const CFileParserCSV sceneriesParser{DATA_PATH / _configParser.Value("Condor2Nav", "Target") / SCENERIES_DATA_FILE_NAME};
-    const auto &sceneryData = sceneriesParser.Row(_condor.TaskParser().Value("Task", "Landscape"), 0, true);
+    const auto sceneriesParser = _app.Resources().CSVParser(DATA_PATH / info.chapter / SCENERIES_DATA_FILE_NAME);
+    const auto &sceneryData = sceneriesParser->Row(_condor.TaskParser().Value("Task", "Landscape"), 0, true);
 
     // set Condor GPS data
-    if(_configParser.Value("Condor2Nav", "SetGPS") == "1") {
+    if(_config->general.setGPS) {
       _app.Log() << "Setting Condor GPS data..." << std::endl;
       target->Gps();
     }
 
     // translate scenery data
-    if(_configParser.Value("Condor2Nav", "SetSceneryMap") == "1") {
+    if(_config->general.setSceneryMap) {
       _app.Log() << "Setting scenery map data..." << std::endl;
       target->SceneryMap(sceneryData);
     }
 
-    if(_configParser.Value("Condor2Nav", "SetSceneryTime") == "1") {
+    if(_config->general.setSceneryTime) {
       _app.Log() << "Setting scenery time..." << std::endl;
       target->SceneryTime();
     }
   
     // translate task
-    if(_configParser.Value("Condor2Nav", "SetTask") == "1") {
+    if(_config->general.setTask) {
       _app.Log() << "Setting task data..." << std::endl;
       target->Task(_condor.TaskParser(), _condor.CoordConverter(), sceneryData, _aatTime);
     }
   }
   
   // translate glider data
-  if(_configParser.Value("Condor2Nav", "SetGlider") == "1") {
+  if(_config->general.setGlider) {
     _app.Log() << "Setting glider data..." << std::endl;
-    const CFileParserCSV glidersParser{DATA_PATH / GLIDERS_DATA_FILE_NAME};
-    target->Glider(glidersParser.Row(_condor.TaskParser().Value("Plane", "Name")));
+    const auto glidersParser = _app.Resources().CSVParser(DATA_PATH / GLIDERS_DATA_FILE_NAME);
+    target->Glider(glidersParser->Row(_condor.TaskParser().Value("Plane", "Name")));
   }
 
   // translate penalty zones
-  if(_configParser.Value("Condor2Nav", "SetPenaltyZones") == "1") {
+  if(_config->general.setPenaltyZones) {
     _app.Log() << "Setting penalty zones..." << std::endl;
     target->PenaltyZones(_condor.TaskParser(), _condor.CoordConverter());
   }
 
   // translate weather
-  if(_configParser.Value("Condor2Nav", "SetWeather") == "1") {
+  if(_config->general.setWeather) {
     _app.Log() << "Setting weather data..." << std::endl;
     target->Weather(_condor.TaskParser());
   }
-
-  _app.LogHigh() << "Translation FINISH" << std::endl;
 }
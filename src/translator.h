@@ -29,7 +29,10 @@
 #define __TRANSLATOR_H__
 
 #include "condor.h"
+#include "config.h"
 #include "fileParserCSV.h"
+#include "translationCache.h"
+#include <vector>
 
 
 namespace condor2nav {
@@ -44,6 +47,17 @@ namespace condor2nav {
    */
   class CTranslator : CNonCopyable {
   public:
+    /**
+     * @brief Translation target description.
+     */
+    struct TTargetInfo {
+      std::string name;                   ///< @brief Target name as provided in configuration file (e.g. XCSoar6).
+      std::string chapter;                ///< @brief Configuration file chapter and data subdirectory of the target.
+      std::string version;                ///< @brief Target version (empty means the one from configuration file).
+      bfs::path outputPath;               ///< @brief Translation output directory of the target.
+    };
+    using CTargetInfoArray = std::vector<TTargetInfo>;
+
     /**
      * @brief Translation targets hierarchy base class.
      *
@@ -86,13 +100,13 @@ namespace condor2nav {
       };
 
       const CTranslator &Translator() const;
-      const CFileParserINI &ConfigParser() const;
+      const TConfig &Config() const;
       const CCondor &Condor() const;
       const bfs::path &OutputPath() const;
 
     public:
-      explicit CTarget(const CTranslator &translator);
-      virtual ~CTarget() {}
+      CTarget(const CTranslator &translator, bfs::path outputPath);
+      virtual ~CTarget() CONDOR2NAV_DTOR_THROWS {}
 
       /**
        * @brief Returns target name.
@@ -168,11 +182,15 @@ namespace condor2nav {
 
   private:
     const CCondor2Nav &_app;
-    const CFileParserINI &_configParser;                  ///< @brief Configuration INI file parser.
+    const CConfigPtr _config;                             ///< @brief Configuration snapshot.
     const CCondor &_condor;                               ///< @brief Condor data.
     const unsigned _aatTime;                              ///< @brief Minimum time for AAT task
+    const bfs::path _outputPath;                          ///< @brief Translation output directory
 
-    std::unique_ptr<CTarget> Target() const;
+    std::unique_ptr<CTarget> Target(const TTargetInfo &info) const;
+    CTranslationCache::THash CacheKey(const TTargetInfo &info) const;
+    void Run(const TTargetInfo &info) const;
+    void Translate(const TTargetInfo &info) const;
 
   public:
     // inputs
@@ -180,8 +198,12 @@ namespace condor2nav {
     static const bfs::path SCENERIES_DATA_FILE_NAME;      ///< @brief Sceneries data CSV file name. 
     static const bfs::path GLIDERS_DATA_FILE_NAME;        ///< @brief Gliders data CSV file name.
 
-    CTranslator(const CCondor2Nav &app, const CFileParserINI &configParser, const CCondor &condor, unsigned aatTime);
+    static CTargetInfoArray Targets(const TConfig &config, const bfs::path &outputPath);
+
+    CTranslator(const CCondor2Nav &app, CConfigPtr config, const CCondor &condor, unsigned aatTime,
+                bfs::path outputPath = bfs::path{});
     void Run();
+    unsigned Prepare() const;
     const CCondor2Nav &App() const { return _app; }
   };
 
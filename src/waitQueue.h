@@ -44,14 +44,12 @@ namespace condor2nav {
     CWaitQueue() {}
     void Push(T msg)
     {
-      bool wasEmpty;
       {
         std::lock_guard<std::mutex> lock{_mutex};
-        wasEmpty = _queue.empty();
         _queue.push(std::move(msg));
       }
-      if(wasEmpty)
-        _newItemReady.notify_one();
+      // always notify as there may be more than one consumer waiting
+      _newItemReady.notify_one();
     }
     T PopWait()
     {
@@ -0,0 +1,348 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file xmlWriter.cpp
+ *
+ * @brief Implements the condor2nav::CXMLWriter class. 
+ */
+
+#include "xmlWriter.h"
+#include "ostream.h"
+#include "exception.h"
+#include "tools.h"
+#include <cmath>
+
+
+/**
+ * @brief Class constructor.
+ *
+ * condor2nav::CXMLWriter class constructor.
+ *
+ * @param stream Output stream to write XML data to.
+ */
+condor2nav::CXMLWriter::CXMLWriter(COStream &stream) :
+  _stream(stream), _elements(), _depth{0}, _startTag{false}, _text{false}, _size{0}
+{
+}
+
+
+/**
+ * @brief Class destructor.
+ *
+ * condor2nav::CXMLWriter class destructor. Passes buffered data to the stream.
+ */
+condor2nav::CXMLWriter::~CXMLWriter()
+{
+  Flush();
+}
+
+
+/**
+ * @brief Passes buffered data to the stream.
+ *
+ * Method passes buffered data to the stream. Should be called before
+ * writing to the stream directly while the writer exists.
+ */
+void condor2nav::CXMLWriter::Flush()
+{
+  if(_size) {
+    _stream.Write(_buffer, static_cast<std::streamsize>(_size));
+    _size = 0;
+  }
+}
+
+
+/**
+ * @brief Writes data to the stream without escaping.
+ *
+ * Method writes data to the stream without escaping.
+ *
+ * @param str Data to write.
+ * @param len Length of the data.
+ */
+void condor2nav::CXMLWriter::Raw(const char *str, size_t len)
+{
+  if(_size + len > BUFFER_SIZE) {
+    Flush();
+    if(len >= BUFFER_SIZE) {
+      _stream.Write(str, static_cast<std::streamsize>(len));
+      return;
+    }
+  }
+  std::memcpy(_buffer + _size, str, len);
+  _size += len;
+}
+
+
+/**
+ * @brief Writes escaped data to the stream.
+ *
+ * Method writes data to the stream replacing XML markup characters with entities.
+ * Whitespace control characters are written as character references so they
+ * survive attribute value normalization and all other control characters (not
+ * allowed in XML 1.0) are skipped. Unchanged runs of characters are written at once.
+ *
+ * @param str Data to write.
+ * @param len Length of the data.
+ */
+void condor2nav::CXMLWriter::Escaped(const char *str, size_t len)
+{
+  const char *run = str;
+  const char *end = str + len;
+  for(const char *it = str; it != end; ++it) {
+    const char *entity;
+    switch(*it) {
+    case '&':  entity = "&amp;";  break;
+    case '<':  entity = "&lt;";   break;
+    case '>':  entity = "&gt;";   break;
+    case '"':  entity = "&quot;"; break;
+    case '\'': entity = "&apos;"; break;
+    case '\t': entity = "&#9;";   break;
+    case '\n': entity = "&#10;";  break;
+    case '\r': entity = "&#13;";  break;
+    default:
+      if(static_cast<unsigned char>(*it) >= 0x20)
+        continue;
+      entity = "";
+    }
+    Raw(run, it - run);
+    Raw(entity);
+    run = it + 1;
+  }
+  Raw(run, end - run);
+}
+
+
+/**
+ * @brief Writes indentation of the current element.
+ *
+ * Method writes indentation of the current element.
+ */
+void condor2nav::CXMLWriter::Indent()
+{
+  static const char tabs[DEPTH_MAX] = { '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t', '\t' };
+  Raw(tabs, _depth);
+}
+
+
+/**
+ * @brief Terminates the start tag of the last element.
+ *
+ * Method terminates the start tag of the last element if it was not terminated yet.
+ */
+void condor2nav::CXMLWriter::StartTagEnd()
+{
+  if(_startTag) {
+    Raw(">");
+    _startTag = false;
+  }
+}
+
+
+/**
+ * @brief Starts a new element.
+ *
+ * Method starts a new element nested in the last open one.
+ *
+ * @param name The name of the element (has to stay valid until the element is closed).
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::Start(const char *name)
+{
+  if(_depth == DEPTH_MAX)
+    throw EOperationFailed{"ERROR: Too many nested XML elements (max " + Convert(static_cast<unsigned>(DEPTH_MAX)) + ")!!!"};
+  if(_startTag)
+    Raw(">\r\n");
+  _startTag = false;
+  _text = false;
+  Indent();
+  Raw("<");
+  Raw(name);
+  _elements[_depth++] = name;
+  _startTag = true;
+  return *this;
+}
+
+
+/**
+ * @brief Writes an attribute of the last element.
+ *
+ * Method writes an attribute of the last element. Attribute value is escaped.
+ *
+ * @param name The name of the attribute.
+ * @param value The value of the attribute.
+ * @param len The length of the value.
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::Attribute(const char *name, const char *value, size_t len)
+{
+  if(!_startTag)
+    throw EOperationFailed{"ERROR: XML attribute '" + std::string{name} + "' written outside of a start tag!!!"};
+  Raw(" ");
+  Raw(name);
+  Raw("=\"");
+  Escaped(value, len);
+  Raw("\"");
+  return *this;
+}
+
+
+/**
+ * @brief Writes an integer attribute of the last element.
+ *
+ * Method writes an integer attribute of the last element.
+ *
+ * @param name The name of the attribute.
+ * @param value The value of the attribute.
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::Attribute(const char *name, int value)
+{
+  if(value >= 0)
+    return Attribute(name, static_cast<unsigned>(value));
+
+  char *end = _number + sizeof(_number);
+  char *it = end;
+  unsigned magnitude = 0U - static_cast<unsigned>(value);
+  do {
+    *--it = '0' + magnitude % 10;
+    magnitude /= 10;
+  } while(magnitude);
+  *--it = '-';
+  return Attribute(name, it, end - it);
+}
+
+
+/**
+ * @brief Writes an unsigned integer attribute of the last element.
+ *
+ * Method writes an unsigned integer attribute of the last element.
+ *
+ * @param name The name of the attribute.
+ * @param value The value of the attribute.
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::Attribute(const char *name, unsigned value)
+{
+  char *end = _number + sizeof(_number);
+  char *it = end;
+  do {
+    *--it = '0' + value % 10;
+    value /= 10;
+  } while(value);
+  return Attribute(name, it, end - it);
+}
+
+
+/**
+ * @brief Writes a floating point attribute of the last element.
+ *
+ * Method writes a floating point attribute of the last element with
+ * a fixed number of fractional digits. The value is rounded half away from zero.
+ *
+ * @param name The name of the attribute.
+ * @param value The value of the attribute.
+ * @param precision The number of fractional digits.
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::Attribute(const char *name, double value, unsigned precision)
+{
+  static const double scales[PRECISION_MAX + 1] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9 };
+  if(precision > PRECISION_MAX)
+    throw EOperationFailed{"ERROR: XML number precision '" + Convert(precision) + "' too big (max " + Convert(static_cast<unsigned>(PRECISION_MAX)) + ")!!!"};
+  const double scaled = std::floor(std::fabs(value) * scales[precision] + 0.5);
+  if(!(scaled < 1e18))
+    throw EOperationFailed{"ERROR: XML number '" + Convert(value) + "' out of range!!!"};
+
+  auto digits = static_cast<unsigned long long>(scaled);
+  char *end = _number + sizeof(_number);
+  char *it = end;
+  for(unsigned i = 0; i < precision; i++) {
+    *--it = '0' + digits % 10;
+    digits /= 10;
+  }
+  if(precision)
+    *--it = '.';
+  do {
+    *--it = '0' + digits % 10;
+    digits /= 10;
+  } while(digits);
+  if(value < 0 && scaled > 0)
+    *--it = '-';
+  return Attribute(name, it, end - it);
+}
+
+
+/**
+ * @brief Writes a text of the last element.
+ *
+ * Method writes an escaped text content of the last element.
+ *
+ * @param text The text to write.
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::Text(const std::string &text)
+{
+  if(!_depth)
+    throw EOperationFailed{"ERROR: XML text written outside of an element!!!"};
+  StartTagEnd();
+  Escaped(text.c_str(), text.size());
+  _text = true;
+  return *this;
+}
+
+
+/**
+ * @brief Closes the last open element.
+ *
+ * Method closes the last open element. Elements without content are closed
+ * with an empty-element tag.
+ *
+ * @return Writer instance.
+ */
+condor2nav::CXMLWriter &condor2nav::CXMLWriter::End()
+{
+  if(!_depth)
+    throw EOperationFailed{"ERROR: No XML element to close!!!"};
+  const char *name = _elements[--_depth];
+  if(_startTag) {
+    Raw("/>\r\n");
+    _startTag = false;
+  }
+  else {
+    if(!_text)
+      Indent();
+    Raw("</");
+    Raw(name);
+    Raw(">\r\n");
+  }
+  _text = false;
+  if(!_depth)
+    Flush();
+  return *this;
+}
@@ -0,0 +1,102 @@
+//
+// This file is part of Condor2Nav file formats translator.
+//
+// Copyright (C) 2009-2012 Mateusz Pusz
+//
+// Condor2Nav is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Condor2Nav is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Condor2Nav. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file xmlWriter.h
+ *
+ * @brief Declares the condor2nav::CXMLWriter class. 
+ */
+
+#ifndef __XMLWRITER_H__
+#define __XMLWRITER_H__
+
+#include "nonCopyable.h"
+#include <cstring>
+#include <string>
+
+namespace condor2nav {
+
+  class COStream;
+
+  /**
+   * @brief Streaming XML writer.
+   *
+   * condor2nav::CXMLWriter class writes XML elements directly to an output stream.
+   * Attribute values and texts are escaped on the fly and numbers are formatted
+   * into an internal buffer so no memory is allocated during writing. Element
+   * names are not copied so they have to stay valid until the element is closed
+   * (string literals are expected). Nested elements are indented with tabs and
+   * every line is terminated with CR LF. Output is collected in an internal
+   * buffer and passed to the stream when the buffer is full, the root element
+   * is closed or the writer is destroyed.
+   */
+  class CXMLWriter : CNonCopyable {
+  public:
+    enum {
+      DEPTH_MAX          = 16,                  ///< @brief Maximum number of nested elements.
+      PRECISION_MAX      = 9,                   ///< @brief Maximum number of fractional digits.
+      BUFFER_SIZE        = 4096                 ///< @brief Size of output buffer.
+    };
+
+  private:
+    COStream &_stream;                          ///< @brief Output stream.
+    const char *_elements[DEPTH_MAX];           ///< @brief Names of open elements.
+    unsigned _depth;                            ///< @brief Number of open elements.
+    bool _startTag;                             ///< @brief Start tag of the last element is not terminated yet.
+    bool _text;                                 ///< @brief Text was written to the last element.
+    char _number[32];                           ///< @brief Number formatting buffer.
+    char _buffer[BUFFER_SIZE];                  ///< @brief Output buffer.
+    size_t _size;                               ///< @brief Number of bytes in output buffer.
+
+    void Raw(const char *str, size_t len);
+    void Raw(const char *str) { Raw(str, std::strlen(str)); }
+    void Escaped(const char *str, size_t len);
+    void Indent();
+    void StartTagEnd();
+
+  public:
+    explicit CXMLWriter(COStream &stream);
+    ~CXMLWriter();
+
+    CXMLWriter &Start(const char *name);
+    CXMLWriter &Attribute(const char *name, const char *value) { return Attribute(name, value, std::strlen(value)); }
+    CXMLWriter &Attribute(const char *name, const std::string &value) { return Attribute(name, value.c_str(), value.size()); }
+    CXMLWriter &Attribute(const char *name, const char *value, size_t len);
+    CXMLWriter &Attribute(const char *name, int value);
+    CXMLWriter &Attribute(const char *name, unsigned value);
+    CXMLWriter &Attribute(const char *name, double value, unsigned precision);
+    CXMLWriter &Text(const std::string &text);
+    CXMLWriter &End();
+    void Flush();
+
+    /**
+     * @brief Returns the number of open elements.
+     *
+     * Method returns the number of open elements.
+     *
+     * @return The number of open elements.
+     */
+    unsigned Depth() const { return _depth; }
+  };
+
+}
+
+#endif /* __XMLWRITER_H__ */
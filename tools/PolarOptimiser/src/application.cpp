@@ -26,23 +26,28 @@
 **/
 
 #include "application.h"
+#include "polarSolver.h"
 #include "tools.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <string>
 #include <cmath>
 #include <set>
+#include <stdexcept>
 
 
 /**
  * @brief Class constructor
  *
  * polarOptimiser::CApplication class constructor responsible for polar curve creation.
+ * If more than 3 polar curve points are provided the curve is fitted to all of them.
  *
  * @param fileName WinPilot polar file
+ * @param mode Polar curve fitting mode
  */
-polarOptimiser::CApplication::CApplication(const std::string &fileName)
+polarOptimiser::CApplication::CApplication(const std::string &fileName, CPolarFit::TMode mode /* = CPolarFit::MODE_LEAST_SQUARES */)
 {
   // get polar curve data
   CDataArray data;
@@ -55,55 +60,25 @@ polarOptimiser::CApplication::CApplication(const std::string &fileName)
   _massDryGross = data.at(0);
   _waterBallastLitersMax = static_cast<unsigned>(data.at(1));
 
-  double speed[3];
-  double sink[3];
-  unsigned idx0 = 2, idx1 = 4, idx2 = 6;
-  double bestError = 0xFFFF;
-  if(data.size() > 8) {
-    // look for the best 3 polar curve points
-    for(unsigned i=2; i<data.size(); i+=2) {
-      speed[0] = data.at(i);
-      sink[0] = data.at(i + 1);
-      for(unsigned j=i + 2; j<data.size(); j+=2) {
-        speed[1] = data.at(j);
-        sink[1] = data.at(j + 1);
-        for(unsigned k=j + 2; k<data.size(); k+=2) {
-          speed[2] = data.at(k);
-          sink[2] = data.at(k + 1);
-
-          _polar = std::auto_ptr<CPolarXCSoar>(new CPolarXCSoar(speed, sink));
-          double error = 0;
-          for(unsigned l=0; l<(data.size() - 2) / 2; l++)
-            error += abs(_polar->Sink(data.at(l * 2 + 2), data.at(0), 0) - data.at(l * 2 + 3));
-          if(error < bestError) {
-            bestError = error;
-            idx0 = i;
-            idx1 = j;
-            idx2 = k;
-          }
-        }
-      }
-    }
+  CPolarFit::CPointsArray points;
+  for(unsigned i=2; i<data.size(); i+=2) {
+    CPolarFit::TPoint point = { data[i], data[i + 1] };
+    points.push_back(point);
   }
 
-  // assign 3 polar curve points
-  speed[0] = data[idx0];
-  sink[0] = data[idx0 + 1];
-  speed[1] = data[idx1];
-  sink[1] = data[idx1 + 1];
-  speed[2] = data[idx2];
-  sink[2] = data[idx2 + 1];
-  _polar = std::auto_ptr<CPolarXCSoar>(new CPolarXCSoar(speed, sink));
+  CPolarFit fit(points, mode);
+  _polar.reset(new CPolarXCSoar(fit.Polar(points)));
 
-  if(data.size() > 8) {
+  if(points.size() > 3) {
     // print calculation values and errors
-    std::cout << "Best polar" << std::endl;
+    std::cout << "Best polar (" << (mode == CPolarFit::MODE_L1 ? "L1" : "least squares") << " fit)" << std::endl;
     PolarHeader(true);
-    for(unsigned l=0; l<(data.size() - 2) / 2; l++)
-      PolarLine(data.at(l * 2 + 2), _massDryGross, 0, true, data.at(l * 2 + 3));
+    for(unsigned l=0; l<points.size(); l++)
+      PolarLine(points[l].speed, _massDryGross, 0, true, points[l].sink);
     PolarFooter(true);
     std::cout << std::endl;
-    std::cout << "Gross sink error: " << bestError << "m/s" << std::endl;
+    std::cout << "Gross sink error: " << fit.Error(points) << "m/s" << std::endl;
+    std::cout << "RMS sink error: " << std::sqrt(fit.ErrorSquared(points) / points.size()) << "m/s" << std::endl;
   }
 }
 
@@ -140,13 +115,14 @@ void polarOptimiser::CApplication::PolarHeader(bool sinkError /* = false */) con
 void polarOptimiser::CApplication::PolarLine(double speed, double weight, double ballast, bool sinkError /* = false */, double expSink /* = 0 */) const
 {
   double sink = _polar->Sink(speed, weight, ballast);
+  const std::streamsize precision = std::cout.precision();
   std::cout << std::setfill(' ') << "| " << std::setw(13) << speed << " | " <<
     std::fixed << std::setprecision(3) << std::setw(13) << sink << " | " <<
     std::setprecision(2) << std::setw(13) << (speed / 3.6 / (-sink)) << " |";
   if(sinkError)
     std::cout << " " << std::setw(13) << std::setprecision(4) << sink - expSink << " |";
   std::cout.unsetf(std::ios_base::fixed);
-  std::cout.precision(0);
+  std::cout.precision(precision);
   std::cout << std::endl;
 }
 
@@ -228,23 +204,19 @@ void polarOptimiser::CApplication::SpeedPolar() const
   std::cout << std::endl;
 
   // find best LD
-  double ld = 0;
-  unsigned ldSpeed;
-  for(ldSpeed=speedMin; ldSpeed<=speedMax; ldSpeed+=1) {
-    double ldLast = ld;
-    ld = ldSpeed / 3.6 / (-_polar->Sink(ldSpeed, _massDryGross, ballast));
-    if(ld < ldLast) {
-      ldSpeed--;
-      ld = ldLast;
-      break;
-    }
-  }
-  
+  double ldSpeed = CPolarSolver(*_polar).BestLDSpeed(_massDryGross, ballast);
+  if(ldSpeed < speedMin)
+    ldSpeed = speedMin;
+  else if(ldSpeed > speedMax)
+    ldSpeed = speedMax;
+  const double ld = ldSpeed / 3.6 / (-_polar->Sink(ldSpeed, _massDryGross, ballast));
+
   // prepare speed range
   std::set<unsigned> speeds;
   for(unsigned speed=speedMin; speed<=speedMax; speed+=5)
     speeds.insert(speed);
-  for(unsigned speed=ldSpeed-5; speed<=ldSpeed+5; speed+=1)
+  const unsigned ldSpeedRounded = static_cast<unsigned>(ldSpeed + 0.5);
+  for(unsigned speed=(std::max)(ldSpeedRounded, speedMin + 5) - 5; speed<=(std::min)(ldSpeedRounded + 5, speedMax); speed+=1)
     speeds.insert(speed);
 
   PolarHeader();
@@ -306,19 +278,10 @@ double polarOptimiser::CApplication::BestWeightCalculateUsingWaterBallast() cons
     std::cin >> sinkFull[i];
   }
 
-  unsigned weight;
-  double error = 0xFFFF;
-  for(weight=10; weight<500; weight++) {
-    double errorLast = error;
-    error = 0;
-    for(unsigned i=0; i<3; i++)
-      error += abs(_polar->Sink(speedFull[i], weight, _waterBallastLitersMax) - sinkFull[i]);
-    if(error > errorLast) {
-      error = errorLast;
-      weight--;
-      break;
-    }
-  }
+  const CPolarSolver solver(*_polar);
+  double error;
+  const unsigned weight = static_cast<unsigned>(solver.BestWeight(_waterBallastLitersMax, speedFull, sinkFull, 3, error) + 0.5);
+  error = solver.SinkError(weight, _waterBallastLitersMax, speedFull, sinkFull, 3);
   std::cout << std::endl;
   std::cout << "The best weight [kg]: " << weight << std::endl;
   std::cout << "Gross sink error: " << error << "m/s" << std::endl;
@@ -28,7 +28,9 @@
 #ifndef __APPLICATION_H__
 #define __APPLICATION_H__
 
-#include "polarXCSoar.h"
+#include "polarFit.h"
+#include <memory>
+#include <string>
 #include <vector>
 
 /**
@@ -43,25 +45,27 @@ namespace polarOptimiser {
    * input and output and basic calculations.
    */
   class CApplication {
+  public:
     typedef std::vector<double> CDataArray;
 
+  private:
     double _massDryGross;                 /**< @brief Glider + pilot weight with empty water tanks. */
     unsigned _waterBallastLitersMax;      /**< @brief Maximum volume of water ballast in liters. */
-    std::auto_ptr<CPolar> _polar;         /**< @brief Glider polar equation implementation */
+    std::unique_ptr<CPolar> _polar;       /**< @brief Glider polar equation implementation */
 
     void PolarHeader(bool sinkError = false) const;
     void PolarLine(double speed, double weight, double ballast, bool sinkError = false, double expSink = 0) const;
     void PolarFooter(bool sinkError = false) const;
 
-    void PolarFileRead(const std::string &fileName, CDataArray &data);
-
     void SpeedPolar() const;
     void Sink() const;
     double BestWeightCalculateUsingWaterBallast() const;
     void WinPilotDump() const;
 
   public:
-    CApplication(const std::string &fileName);
+    static void PolarFileRead(const std::string &fileName, CDataArray &data);
+
+    CApplication(const std::string &fileName, CPolarFit::TMode mode = CPolarFit::MODE_LEAST_SQUARES);
     void Run();
   };
 
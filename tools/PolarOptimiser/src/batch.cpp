@@ -0,0 +1,322 @@
+//
+// This file is part of PolarOptimiser gliders polar files optimisation helper.
+//
+// Copyright (C) 2009 Mateusz Pusz
+//
+// PolarOptimiser is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PolarOptimiser is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PolarOptimiser. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file batch.cpp
+ *
+ * @brief Implements the polarOptimiser::CBatch class. 
+**/
+
+#include "batch.h"
+#include "application.h"
+#include "polarSolver.h"
+#include "exception.h"
+#include "fileParserCSV.h"
+#include "fileParserINI.h"
+#include "ostream.h"
+#include "threadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+
+namespace {
+
+  /**
+   * @brief Rounds the value to specified number of decimal places
+   */
+  double Round(double value, unsigned decimals)
+  {
+    const double scale = std::pow(10.0, static_cast<int>(decimals));
+    return std::floor(value * scale + 0.5) / scale;
+  }
+
+  /**
+   * @brief Gross and RMS sink errors of the polar for measured points
+   */
+  void Errors(const polarOptimiser::CPolar &polar, const polarOptimiser::CPolarFit::CPointsArray &points, double weight, double &gross, double &rms)
+  {
+    gross = rms = 0;
+    for(auto &p : points) {
+      const double error = polar.Sink(p.speed, weight, 0) - p.sink;
+      gross += std::fabs(error);
+      rms += error * error;
+    }
+    rms = std::sqrt(rms / points.size());
+  }
+
+}
+
+
+/**
+ * @brief Class constructor
+ *
+ * polarOptimiser::CBatch class constructor.
+ *
+ * @param configPath Configuration INI file path
+ */
+polarOptimiser::CBatch::CBatch(bfs::path configPath) :
+  _configPath(std::move(configPath))
+{
+}
+
+
+/**
+ * @brief Verifies glider flaps data
+ *
+ * Method verifies LK8000 flaps line from gliders data CSV file (mass, number
+ * of flaps settings and then the speed and the name of each flaps setting).
+ *
+ * @param flaps Flaps line (may be empty)
+ *
+ * @return Number of flaps settings.
+ */
+unsigned polarOptimiser::CBatch::FlapsCheck(const std::string &flaps)
+{
+  if(flaps.empty())
+    return 0;
+
+  const auto values = condor2nav::CFileParserCSV::LineParse(flaps);
+  if(values.size() < 2)
+    throw std::runtime_error("ERROR: Invalid flaps data '" + flaps + "'!!!");
+  const auto num = condor2nav::Convert<unsigned>(values[1]);
+  if(values.size() != 2 + num * 2)
+    throw std::runtime_error("ERROR: Invalid number of flaps settings in '" + flaps + "'!!!");
+  for(unsigned i=1; i<num; i++)
+    if(condor2nav::Convert<double>(values[2 + i * 2]) <= condor2nav::Convert<double>(values[i * 2]))
+      throw std::runtime_error("ERROR: Flaps speeds must increase in '" + flaps + "'!!!");
+  return num;
+}
+
+
+/**
+ * @brief Optimises the polar curve of one glider
+ *
+ * Method fits the glider polar curve to measured points and updates provided
+ * gliders data CSV row. The row is not changed if the glider could not be
+ * processed.
+ *
+ * @param row Gliders data CSV row
+ * @param glider Glider inputs
+ * @param mode Polar curve fitting mode
+ *
+ * @return Optimisation result.
+ */
+polarOptimiser::CBatch::TResult polarOptimiser::CBatch::Process(std::vector<std::string> &row, const TGlider &glider, CPolarFit::TMode mode)
+{
+  using condor2nav::Convert;
+
+  TResult result = {};
+  result.glider = row.at(GLIDER_NAME);
+  result.ballastError = -1;
+  try {
+    if(row.size() != GLIDER_FLAPS + 1)
+      throw std::runtime_error("ERROR: Invalid number of columns in gliders data!!!");
+
+    const double mass = Convert<double>(row[GLIDER_MASS_DRY_GROSS]);
+    const double ballast = Convert<double>(row[GLIDER_MAX_WATER_BALLAST]);
+    result.massOld = result.massNew = static_cast<unsigned>(mass);
+    result.flaps = FlapsCheck(row[GLIDER_FLAPS]);
+
+    if(!bfs::exists(glider.polarFile))
+      return result;
+
+    // read measured polar curve points
+    CApplication::CDataArray data;
+    CApplication::PolarFileRead(glider.polarFile.string(), data);
+    if(data.size() < 8 || data.size() % 2 != 0)
+      throw std::runtime_error("ERROR: Invalid number of data specified in POLAR file '" + glider.polarFile.string() + "'!!!");
+    CPolarFit::CPointsArray points;
+    for(unsigned i=2; i<data.size(); i+=2) {
+      CPolarFit::TPoint point = { data[i], data[i + 1] };
+      if(!points.empty() && point.speed <= points.back().speed)
+        throw std::runtime_error("ERROR: Speeds must increase in POLAR file '" + glider.polarFile.string() + "'!!!");
+      points.push_back(point);
+    }
+    result.points = static_cast<unsigned>(points.size());
+
+    // original polar curve
+    double speed[3], sink[3];
+    for(unsigned i=0; i<3; i++) {
+      speed[i] = Convert<double>(row[GLIDER_SPEED_1 + i * 2]);
+      sink[i] = Convert<double>(row[GLIDER_SINK_1 + i * 2]);
+    }
+    Errors(CPolarXCSoar(speed, sink), points, mass, result.errorOld, result.rmsOld);
+
+    // fitted polar curve with values rounded as stored in gliders data
+    CPolarFit fit(points, mode);
+    const CPolarXCSoar fitted = fit.Polar(points);
+    for(unsigned i=0; i<3; i++) {
+      speed[i] = Round(fitted.Speed(i), 0);
+      sink[i] = Round(fit.Sink(speed[i]), 3);
+    }
+    const CPolarXCSoar polar(speed, sink);
+    Errors(polar, points, mass, result.errorNew, result.rmsNew);
+
+    if(!glider.fullBallast.empty() && ballast > 0) {
+      // the best MassDryGross for full water ballast polar curve
+      const auto values = condor2nav::CFileParserCSV::LineParse(glider.fullBallast);
+      if(values.size() != 6)
+        throw std::runtime_error("ERROR: 3 speed-sink pairs expected for full water ballast polar of '" + result.glider + "'!!!");
+      double speedFull[3], sinkFull[3];
+      for(unsigned i=0; i<3; i++) {
+        speedFull[i] = Convert<double>(values[i * 2]);
+        sinkFull[i] = Convert<double>(values[i * 2 + 1]);
+      }
+      const CPolarSolver solver(polar);
+      result.massNew = static_cast<unsigned>(Round(solver.BestWeight(ballast, speedFull, sinkFull, 3, result.ballastError), 0));
+      result.ballastError = solver.SinkError(result.massNew, ballast, speedFull, sinkFull, 3);
+    }
+
+    // update gliders data
+    for(unsigned i=0; i<3; i++) {
+      row[GLIDER_SPEED_1 + i * 2] = Convert(speed[i]);
+      row[GLIDER_SINK_1 + i * 2] = Convert(sink[i]);
+    }
+    if(result.massNew != result.massOld) {
+      row[GLIDER_MASS_DRY_GROSS] = Convert(result.massNew);
+      if(result.flaps) {
+        // flaps mass is given either for empty or for full water ballast
+        auto flaps = condor2nav::CFileParserCSV::LineParse(row[GLIDER_FLAPS]);
+        const auto flapsMass = Convert<unsigned>(flaps[0]);
+        if(flapsMass == result.massOld || flapsMass == result.massOld + static_cast<unsigned>(ballast)) {
+          flaps[0] = Convert(flapsMass + result.massNew - result.massOld);
+          std::string line;
+          for(auto &value : flaps)
+            line += (line.empty() ? "" : ",") + value;
+          row[GLIDER_FLAPS] = line;
+        }
+      }
+    }
+  }
+  catch(const std::exception &ex) {
+    result.points = 0;
+    result.massNew = result.massOld;
+    result.message = ex.what();
+  }
+  return result;
+}
+
+
+/**
+ * @brief Writes optimisation report
+ *
+ * @param path Report file path
+ * @param results Optimisation results
+ * @param mode Polar curve fitting mode
+ */
+void polarOptimiser::CBatch::Report(const bfs::path &path, const CResultsArray &results, CPolarFit::TMode mode)
+{
+  std::ostringstream report;
+  report << "PolarOptimiser batch report (" << (mode == CPolarFit::MODE_L1 ? "L1" : "least squares") << " fit)" << std::endl;
+  report << std::endl;
+  report << std::left << std::setw(16) << "Glider" << std::right << std::setw(7) << "Points"
+         << std::setw(11) << "Error old" << std::setw(11) << "Error new" << std::setw(9) << "RMS old" << std::setw(9) << "RMS new"
+         << std::setw(7) << "Mass" << std::setw(9) << "Ballast" << std::setw(7) << "Flaps" << "  Notes" << std::endl;
+  report << std::setfill('-') << std::setw(102) << "" << std::setfill(' ') << std::endl;
+  report << std::fixed << std::setprecision(3);
+  for(auto &r : results) {
+    report << std::left << std::setw(16) << r.glider << std::right << std::setw(7) << r.points;
+    if(r.points)
+      report << std::setw(11) << r.errorOld << std::setw(11) << r.errorNew << std::setw(9) << r.rmsOld << std::setw(9) << r.rmsNew;
+    else
+      report << std::setw(11) << "-" << std::setw(11) << "-" << std::setw(9) << "-" << std::setw(9) << "-";
+    report << std::setw(7) << r.massNew;
+    if(r.ballastError >= 0)
+      report << std::setw(9) << r.ballastError;
+    else
+      report << std::setw(9) << "-";
+    report << std::setw(7) << r.flaps << "  ";
+    if(!r.message.empty())
+      report << r.message;
+    else if(!r.points)
+      report << "No measured polar points";
+    else if(r.massNew != r.massOld)
+      report << "MassDryGross changed from " << r.massOld << "kg";
+    report << std::endl;
+  }
+
+  condor2nav::COStream stream(path);
+  stream << report.str();
+}
+
+
+/**
+ * @brief Runs batch optimisation
+ *
+ * Method reads configuration INI file and gliders data, fits polar curves of
+ * all gliders in parallel and writes updated gliders data and the report.
+ *
+ * @return Optimisation results.
+ */
+polarOptimiser::CBatch::CResultsArray polarOptimiser::CBatch::Run() const
+{
+  const condor2nav::CFileParserINI config(_configPath);
+  const bfs::path configDir = _configPath.parent_path();
+  const std::string chapter = "PolarOptimiser";
+
+  CPolarFit::TMode mode = CPolarFit::MODE_LEAST_SQUARES;
+  if(auto value = config.TryValue(chapter, "FitMode")) {
+    if(*value == "L1")
+      mode = CPolarFit::MODE_L1;
+    else if(*value != "LeastSquares")
+      throw std::runtime_error("ERROR: Unknown FitMode '" + *value + "' in '" + _configPath.string() + "'!!!");
+  }
+  unsigned threads = std::thread::hardware_concurrency();
+  if(auto value = config.TryValue(chapter, "Threads"))
+    if(condor2nav::Convert<unsigned>(*value))
+      threads = condor2nav::Convert<unsigned>(*value);
+  const bfs::path polarsDir = bfs::absolute(config.Value(chapter, "PolarsDir"), configDir);
+
+  condor2nav::CFileParserCSV gliders(bfs::absolute(config.Value(chapter, "GliderData"), configDir));
+  auto &rows = gliders.Rows();
+  if(rows.empty())
+    throw std::runtime_error("ERROR: No gliders data header in '" + gliders.Path().string() + "'!!!");
+  CResultsArray results(rows.size() - 1);
+  {
+    // first row is a header
+    condor2nav::CThreadPool pool((std::max)(threads, 1U));
+    for(size_t i=1; i<rows.size(); i++) {
+      TGlider glider;
+      const std::string &name = rows[i].at(GLIDER_NAME);
+      glider.polarFile = polarsDir / (name + ".plr");
+      if(auto value = config.TryValue(name, "PolarFile"))
+        glider.polarFile = bfs::absolute(*value, configDir);
+      if(auto value = config.TryValue(name, "FullBallast"))
+        glider.fullBallast = *value;
+
+      auto &row = rows[i];
+      auto &result = results[i - 1];
+      pool.Send([&row, &result, glider, mode]{ result = Process(row, glider, mode); });
+    }
+  }
+
+  const bfs::path outputPath = bfs::absolute(config.Value(chapter, "OutputGliderData"), configDir);
+  const bfs::path reportPath = bfs::absolute(config.Value(chapter, "Report"), configDir);
+  for(auto &path : { outputPath, reportPath })
+    if(!path.parent_path().empty())
+      bfs::create_directories(path.parent_path());
+  gliders.Dump(outputPath);
+  Report(reportPath, results, mode);
+  return results;
+}
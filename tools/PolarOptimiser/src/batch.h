@@ -0,0 +1,110 @@
+//
+// This file is part of PolarOptimiser gliders polar files optimisation helper.
+//
+// Copyright (C) 2009 Mateusz Pusz
+//
+// PolarOptimiser is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PolarOptimiser is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PolarOptimiser. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file batch.h
+ *
+ * @brief Batch polar curves optimisation class declaration.
+**/
+
+#ifndef __BATCH_H__
+#define __BATCH_H__
+
+#include "polarFit.h"
+#include "boostfwd.h"
+#include <boost/filesystem.hpp>
+#include <string>
+#include <vector>
+
+namespace polarOptimiser {
+
+  /**
+   * @brief Batch polar curves optimisation
+   *
+   * polarOptimiser::CBatch class fits speed polar curves of all gliders from
+   * Condor2Nav gliders data CSV file to measured polar points without any user
+   * interaction. All inputs are provided in a configuration INI file. Gliders are
+   * processed in parallel on a thread pool. Updated gliders data CSV file and
+   * per glider error report are written as an output.
+   */
+  class CBatch {
+  public:
+    /**
+     * @brief Single glider optimisation result
+     */
+    struct TResult {
+      std::string glider;                 /**< @brief Condor glider name */
+      unsigned points;                    /**< @brief Number of measured polar points (0 if not provided) */
+      double errorOld;                    /**< @brief Gross sink error of the original polar [m/s] */
+      double errorNew;                    /**< @brief Gross sink error of the fitted polar [m/s] */
+      double rmsOld;                      /**< @brief RMS sink error of the original polar [m/s] */
+      double rmsNew;                      /**< @brief RMS sink error of the fitted polar [m/s] */
+      unsigned massOld;                   /**< @brief Original MassDryGross [kg] */
+      unsigned massNew;                   /**< @brief Best MassDryGross [kg] */
+      double ballastError;                /**< @brief Gross sink error of full water ballast polar [m/s] (negative if not provided) */
+      unsigned flaps;                     /**< @brief Number of flaps settings */
+      std::string message;                /**< @brief Processing error */
+    };
+    typedef std::vector<TResult> CResultsArray;
+
+  private:
+    /**
+     * @brief Gliders data CSV file column names.
+     */
+    enum TGlidersDataColumns {
+      GLIDER_NAME,
+      GLIDER_SPEED_MAX,
+      GLIDER_DAEC_INDEX,
+      GLIDER_WATER_BALLAST_EMPTY_TIME,
+      GLIDER_WING_AREA,
+      GLIDER_MASS_DRY_GROSS,
+      GLIDER_MAX_WATER_BALLAST,
+      GLIDER_SPEED_1,
+      GLIDER_SINK_1,
+      GLIDER_SPEED_2,
+      GLIDER_SINK_2,
+      GLIDER_SPEED_3,
+      GLIDER_SINK_3,
+      GLIDER_FLAPS
+    };
+
+    /**
+     * @brief Single glider inputs
+     */
+    struct TGlider {
+      bfs::path polarFile;                /**< @brief Measured polar points in WinPilot polar file format */
+      std::string fullBallast;            /**< @brief 3 speed-sink pairs of full water ballast polar (may be empty) */
+    };
+
+    const bfs::path _configPath;          /**< @brief Configuration INI file path */
+
+    static unsigned FlapsCheck(const std::string &flaps);
+    static TResult Process(std::vector<std::string> &row, const TGlider &glider, CPolarFit::TMode mode);
+    static void Report(const bfs::path &path, const CResultsArray &results, CPolarFit::TMode mode);
+
+  public:
+    explicit CBatch(bfs::path configPath);
+    CResultsArray Run() const;
+  };
+
+} // namespace polarOptimiser
+
+#endif // __BATCH_H__
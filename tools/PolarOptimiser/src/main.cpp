@@ -26,6 +26,8 @@
 **/
 
 #include "application.h"
+#include "batch.h"
+#include <cstdlib>
 #include <iostream>
 #include <string>
 
@@ -43,9 +45,12 @@ void Usage()
   std::cout << "and you are welcome to redistribute it under GNU GPL conditions." << std::endl;
   std::cout << std::endl;
   std::cout << "Usage:" << std::endl;
-  std::cout << "  polarOptimier.exe [-h|<WINPILOT_POLAR_FILE>]" << std::endl;
+  std::cout << "  polarOptimier.exe [-h|-b <CONFIG_FILE>|[-l1] <WINPILOT_POLAR_FILE>]" << std::endl;
   std::cout << std::endl;
   std::cout << "  -h                    - that help message" << std::endl;
+  std::cout << "  -b <CONFIG_FILE>      - optimise polars of all gliders from Condor2Nav gliders data" << std::endl;
+  std::cout << "                          as specified in configuration INI file" << std::endl;
+  std::cout << "  -l1                   - fit polar curve minimising gross sink error instead of least squares" << std::endl;
   std::cout << "  <WINPILOT_POLAR_FILE> - glider polar file in WinPilot like format" << std::endl;
 }
 
@@ -61,12 +66,43 @@ void Usage()
 int main(int argc, const char *argv[])
 {
   try {
-    if(argc == 1 || argc > 1 && std::string(argv[1]) == "-h") {
+    if(argc == 1 || (argc > 1 && std::string(argv[1]) == "-h")) {
       Usage();
       return EXIT_SUCCESS;
     }
 
-    polarOptimiser::CApplication app(argv[1]);
+    if(std::string(argv[1]) == "-b") {
+      if(argc != 3) {
+        Usage();
+        return EXIT_FAILURE;
+      }
+      polarOptimiser::CBatch batch(argv[2]);
+      const polarOptimiser::CBatch::CResultsArray results = batch.Run();
+      unsigned fitted = 0, failed = 0;
+      for(unsigned i=0; i<results.size(); i++) {
+        if(!results[i].message.empty()) {
+          std::cerr << results[i].glider << ": " << results[i].message << std::endl;
+          failed++;
+        }
+        else if(results[i].points)
+          fitted++;
+      }
+      std::cout << results.size() << " gliders processed, " << fitted << " polars fitted, " << failed << " failed" << std::endl;
+      return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+
+    polarOptimiser::CPolarFit::TMode mode = polarOptimiser::CPolarFit::MODE_LEAST_SQUARES;
+    int arg = 1;
+    if(std::string(argv[arg]) == "-l1") {
+      mode = polarOptimiser::CPolarFit::MODE_L1;
+      arg++;
+    }
+    if(arg >= argc) {
+      Usage();
+      return EXIT_FAILURE;
+    }
+
+    polarOptimiser::CApplication app(argv[arg], mode);
     app.Run();
     return EXIT_SUCCESS;
   }
@@ -50,3 +50,4 @@ double polarOptimiser::CPolar::Sink(double speed) const
 {
   return Sink(speed, 200, 0);  // any weight is good here
 }
+
@@ -66,6 +66,18 @@ namespace polarOptimiser {
      */
     virtual double Sink(double speed, double weight, double ballastLitres) const = 0;
     double Sink(double speed) const;
+
+    /**
+     * @brief Returns quadratic polar curve equation coefficients
+     *
+     * Method returns coefficients of the polar curve equation
+     * (sink = a * V^2 + b * V + c) for the speed V in m/s.
+     *
+     * @param weight Glider + pilot mass
+     * @param ballastLitres The amount of water ballast
+     * @param coeffs Equation coefficients (a, b, c)
+     */
+    virtual void Coefficients(double weight, double ballastLitres, double (&coeffs)[3]) const = 0;
   };
 
 } // namespace polarOptimiser
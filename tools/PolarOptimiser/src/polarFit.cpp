@@ -0,0 +1,405 @@
+//
+// This file is part of PolarOptimiser gliders polar files optimisation helper.
+//
+// Copyright (C) 2009 Mateusz Pusz
+//
+// PolarOptimiser is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PolarOptimiser is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PolarOptimiser. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file polarFit.cpp
+ *
+ * @brief Polar curve fitting class definition.
+**/
+
+#include "polarFit.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+
+namespace {
+
+  const double L1_RESIDUAL_ZERO = 1e-9;           /**< @brief Residual of points treated as lying on the curve [m/s] */
+
+  /**
+   * @brief Compares points indices by the residual
+   */
+  class CResidualLess {
+    const std::vector<double> &_residuals;
+  public:
+    explicit CResidualLess(const std::vector<double> &residuals) : _residuals(residuals) {}
+    bool operator()(size_t lhs, size_t rhs) const { return _residuals[lhs] < _residuals[rhs]; }
+  };
+
+}
+
+
+/**
+ * @brief Class constructor
+ *
+ * polarOptimiser::CPolarFit class constructor that fits the polar curve to
+ * measured points.
+ *
+ * @param points Measured polar curve points.
+ * @param mode Fitting mode.
+ */
+polarOptimiser::CPolarFit::CPolarFit(const CPointsArray &points, TMode mode /* = MODE_LEAST_SQUARES */)
+{
+  if(!LeastSquares(points, CWeightsArray(), _coeffs))
+    throw std::runtime_error("ERROR: At least 3 polar curve points with different speeds are needed!!!");
+  if(mode == MODE_L1)
+    L1(points);
+}
+
+
+/**
+ * @brief Class constructor
+ *
+ * polarOptimiser::CPolarFit class constructor that fits the polar curve to
+ * measured points with weighted least squares.
+ *
+ * @param points Measured polar curve points.
+ * @param weights Weights of measured points.
+ */
+polarOptimiser::CPolarFit::CPolarFit(const CPointsArray &points, const CWeightsArray &weights)
+{
+  if(weights.size() != points.size())
+    throw std::invalid_argument("ERROR: The number of weights does not match the number of polar curve points!!!");
+  if(!LeastSquares(points, weights, _coeffs))
+    throw std::runtime_error("ERROR: At least 3 polar curve points with different speeds are needed!!!");
+}
+
+
+/**
+ * @brief Calculates weighted least squares fit
+ *
+ * Method solves normal equations of weighted least squares quadratic fit. Speeds
+ * are centered and scaled before to keep the equations well conditioned.
+ *
+ * @param points Measured polar curve points.
+ * @param weights Weights of measured points (all equal to 1 if empty).
+ * @param coeffs Calculated polar curve coefficients.
+ *
+ * @return @p false if the polar curve cannot be fitted.
+ */
+bool polarOptimiser::CPolarFit::LeastSquares(const CPointsArray &points, const CWeightsArray &weights, double (&coeffs)[3])
+{
+  if(points.size() < 3)
+    return false;
+
+  // center and scale speeds
+  double sumW = 0, sumWV = 0;
+  for(size_t i=0; i<points.size(); i++) {
+    const double w = weights.empty() ? 1 : weights[i];
+    sumW += w;
+    sumWV += w * points[i].speed;
+  }
+  if(sumW <= 0)
+    return false;
+  const double mean = sumWV / sumW;
+  double scale = 0;
+  for(size_t i=0; i<points.size(); i++)
+    scale = std::max(scale, std::fabs(points[i].speed - mean));
+  if(scale == 0)
+    return false;
+
+  // normal equations
+  double s[5] = {0};
+  double t[3] = {0};
+  for(size_t i=0; i<points.size(); i++) {
+    const double w = weights.empty() ? 1 : weights[i];
+    const double x = (points[i].speed - mean) / scale;
+    const double x2 = x * x;
+    s[0] += w;
+    s[1] += w * x;
+    s[2] += w * x2;
+    s[3] += w * x2 * x;
+    s[4] += w * x2 * x2;
+    t[0] += w * points[i].sink;
+    t[1] += w * points[i].sink * x;
+    t[2] += w * points[i].sink * x2;
+  }
+  double m[3][4] = {
+    { s[4], s[3], s[2], t[2] },
+    { s[3], s[2], s[1], t[1] },
+    { s[2], s[1], s[0], t[0] }
+  };
+
+  // Gaussian elimination with partial pivoting
+  for(unsigned col=0; col<3; col++) {
+    unsigned pivot = col;
+    for(unsigned row=col + 1; row<3; row++)
+      if(std::fabs(m[row][col]) > std::fabs(m[pivot][col]))
+        pivot = row;
+    if(std::fabs(m[pivot][col]) <= 1e-12 * s[0])
+      return false;
+    if(pivot != col)
+      for(unsigned k=0; k<4; k++)
+        std::swap(m[col][k], m[pivot][k]);
+    for(unsigned row=col + 1; row<3; row++) {
+      const double f = m[row][col] / m[col][col];
+      for(unsigned k=col; k<4; k++)
+        m[row][k] -= f * m[col][k];
+    }
+  }
+  double abc[3];
+  for(int row=2; row>=0; row--) {
+    double value = m[row][3];
+    for(unsigned k=row + 1; k<3; k++)
+      value -= m[row][k] * abc[k];
+    abc[row] = value / m[row][row];
+  }
+
+  // back to not scaled speeds: sink = A * x^2 + B * x + C, where x = (speed - mean) / scale
+  coeffs[0] = abc[0] / (scale * scale);
+  coeffs[1] = abc[1] / scale - 2 * abc[0] * mean / (scale * scale);
+  coeffs[2] = abc[0] * mean * mean / (scale * scale) - abc[1] * mean / scale + abc[2];
+  return true;
+}
+
+
+/**
+ * @brief Calculates gross sink error
+ *
+ * @param points Measured polar curve points.
+ * @param coeffs Polar curve coefficients.
+ *
+ * @return The sum of absolute sink errors.
+ */
+double polarOptimiser::CPolarFit::Error(const CPointsArray &points, const double (&coeffs)[3])
+{
+  double error = 0;
+  for(size_t i=0; i<points.size(); i++) {
+    const double v = points[i].speed;
+    error += std::fabs((coeffs[0] * v + coeffs[1]) * v + coeffs[2] - points[i].sink);
+  }
+  return error;
+}
+
+
+/**
+ * @brief Calculates robust L1 fit
+ *
+ * Method minimises the sum of absolute sink errors. L1 optimum always passes
+ * exactly through 3 of the points (a vertex) so the points fitting best to the least
+ * squares curve are used as a starting vertex. The vertex is then improved with
+ * a descent along its 3 edges (moving the curve away from one of the vertex points
+ * while keeping it on the other two) and an exact weighted median line search.
+ * The descent stops when no edge decreases the error which proves the optimum
+ * for vertices with no more than 3 points lying on the curve.
+ *
+ * @param points Measured polar curve points.
+ */
+void polarOptimiser::CPolarFit::L1(const CPointsArray &points)
+{
+  // starting vertex defined by the best fitting points with different speeds
+  std::vector<double> residuals(points.size());
+  std::vector<size_t> indices(points.size());
+  for(size_t i=0; i<points.size(); i++) {
+    residuals[i] = std::fabs(Sink(points[i].speed) - points[i].sink);
+    indices[i] = i;
+  }
+  std::sort(indices.begin(), indices.end(), CResidualLess(residuals));
+  CPointsArray::size_type vertex[3];
+  unsigned count = 0;
+  for(size_t i=0; i<indices.size() && count<3; i++) {
+    bool unique = true;
+    for(unsigned j=0; j<count; j++)
+      unique = unique && points[vertex[j]].speed != points[indices[i]].speed;
+    if(unique)
+      vertex[count++] = indices[i];
+  }
+  double coeffs[3];
+  if(count < 3 || !Vertex(points, vertex, coeffs))
+    return;
+
+  // descent along vertex edges
+  double error = Error(points, coeffs);
+  std::vector<double> directions(points.size());
+  std::vector<std::pair<double, size_t> > breakpoints;
+  bool improved = true;
+  while(improved) {
+    improved = false;
+    for(size_t i=0; i<points.size(); i++) {
+      const double v = points[i].speed;
+      residuals[i] = (coeffs[0] * v + coeffs[1]) * v + coeffs[2] - points[i].sink;
+    }
+
+    for(unsigned m=0; m<3 && !improved; m++) {
+      // edge direction: Lagrange polynomial equal to 1 at vertex point m and 0 at the other ones
+      const double vm = points[vertex[m]].speed;
+      const double vj = points[vertex[(m + 1) % 3]].speed;
+      const double vk = points[vertex[(m + 2) % 3]].speed;
+      double slope = 0, slopeZero = 0;
+      for(size_t i=0; i<points.size(); i++) {
+        const double v = points[i].speed;
+        directions[i] = (v - vj) * (v - vk) / ((vm - vj) * (vm - vk));
+        if(std::fabs(residuals[i]) > L1_RESIDUAL_ZERO)
+          slope += residuals[i] > 0 ? directions[i] : -directions[i];
+        else
+          slopeZero += std::fabs(directions[i]);
+      }
+
+      // error derivatives in both directions along the edge
+      double sign;
+      if(slope + slopeZero < 0)
+        sign = 1;
+      else if(-slope + slopeZero < 0)
+        sign = -1;
+      else
+        continue;
+
+      // error along the edge is minimised at the weighted median of points breakpoints
+      breakpoints.clear();
+      double weightSum = 0;
+      for(size_t i=0; i<points.size(); i++) {
+        if(directions[i] == 0)
+          continue;
+        breakpoints.push_back(std::make_pair(-residuals[i] / (sign * directions[i]), i));
+        weightSum += std::fabs(directions[i]);
+      }
+      std::sort(breakpoints.begin(), breakpoints.end());
+      double weight = 0;
+      size_t median = vertex[m];
+      for(size_t i=0; i<breakpoints.size(); i++) {
+        const size_t idx = breakpoints[i].second;
+        weight += std::fabs(directions[idx]);
+        if(weight >= weightSum / 2) {
+          median = idx;
+          break;
+        }
+      }
+      if(median == vertex[m])
+        continue;
+
+      CPointsArray::size_type next[3] = { vertex[0], vertex[1], vertex[2] };
+      next[m] = median;
+      double nextCoeffs[3];
+      if(!Vertex(points, next, nextCoeffs))
+        continue;
+      const double nextError = Error(points, nextCoeffs);
+      if(nextError < error) {
+        error = nextError;
+        std::copy(next, next + 3, vertex);
+        std::copy(nextCoeffs, nextCoeffs + 3, coeffs);
+        improved = true;
+      }
+    }
+  }
+
+  if(error < Error(points, _coeffs))
+    std::copy(coeffs, coeffs + 3, _coeffs);
+}
+
+
+/**
+ * @brief Calculates the curve going through 3 points
+ *
+ * @param points Measured polar curve points.
+ * @param vertex Indices of 3 points with different speeds.
+ * @param coeffs Calculated polar curve coefficients.
+ *
+ * @return @p false if the curve cannot be calculated.
+ */
+bool polarOptimiser::CPolarFit::Vertex(const CPointsArray &points, const CPointsArray::size_type (&vertex)[3], double (&coeffs)[3])
+{
+  CPointsArray triple(3);
+  for(unsigned i=0; i<3; i++)
+    triple[i] = points[vertex[i]];
+  return LeastSquares(triple, CWeightsArray(), coeffs);
+}
+
+
+/**
+ * @brief Calculates sink for specified speed
+ *
+ * @param speed Speed [km/h].
+ *
+ * @return Sink [m/s].
+ */
+double polarOptimiser::CPolarFit::Sink(double speed) const
+{
+  return (_coeffs[0] * speed + _coeffs[1]) * speed + _coeffs[2];
+}
+
+
+/**
+ * @brief Calculates gross sink error
+ *
+ * @param points Measured polar curve points.
+ *
+ * @return The sum of absolute sink errors.
+ */
+double polarOptimiser::CPolarFit::Error(const CPointsArray &points) const
+{
+  return Error(points, _coeffs);
+}
+
+
+/**
+ * @brief Calculates squared sink error
+ *
+ * @param points Measured polar curve points.
+ *
+ * @return The sum of squared sink errors.
+ */
+double polarOptimiser::CPolarFit::ErrorSquared(const CPointsArray &points) const
+{
+  double error = 0;
+  for(size_t i=0; i<points.size(); i++) {
+    const double r = Sink(points[i].speed) - points[i].sink;
+    error += r * r;
+  }
+  return error;
+}
+
+
+/**
+ * @brief Creates XCSoar polar curve
+ *
+ * Method creates XCSoar polar curve that goes through fitted curve points
+ * for provided speeds (the curve is the same as the fitted one).
+ *
+ * @param speed Speeds of 3 polar curve points.
+ *
+ * @return XCSoar polar curve.
+ */
+polarOptimiser::CPolarXCSoar polarOptimiser::CPolarFit::Polar(const double (&speed)[3]) const
+{
+  double sink[3];
+  for(unsigned i=0; i<3; i++)
+    sink[i] = Sink(speed[i]);
+  return CPolarXCSoar(speed, sink);
+}
+
+
+/**
+ * @brief Returns XCSoar polar curve for measured points
+ *
+ * Method returns fitted polar curve described with the lowest, the middle
+ * and the highest of measured speeds.
+ *
+ * @param points Measured polar curve points (sorted by speed)
+ *
+ * @return XCSoar polar curve.
+ */
+polarOptimiser::CPolarXCSoar polarOptimiser::CPolarFit::Polar(const CPointsArray &points) const
+{
+  double speed[3] = { points.front().speed, points[points.size() / 2].speed, points.back().speed };
+  return Polar(speed);
+}
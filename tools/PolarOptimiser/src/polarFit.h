@@ -0,0 +1,87 @@
+//
+// This file is part of PolarOptimiser gliders polar files optimisation helper.
+//
+// Copyright (C) 2009 Mateusz Pusz
+//
+// PolarOptimiser is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PolarOptimiser is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PolarOptimiser. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file polarFit.h
+ *
+ * @brief Polar curve fitting class declaration.
+**/
+
+#ifndef __POLARFIT_H__
+#define __POLARFIT_H__
+
+#include "polarXCSoar.h"
+#include <vector>
+
+namespace polarOptimiser {
+
+  /**
+   * @brief Quadratic speed polar curve fitted to measured points
+   *
+   * polarOptimiser::CPolarFit class fits the quadratic polar curve
+   * (sink = a * speed^2 + b * speed + c) to any number of measured speed-sink
+   * points. Weighted least squares fit is calculated in closed form from the
+   * normal equations. Robust L1 fit minimises the sum of absolute sink errors
+   * (the same "gross sink error" that was minimised by choosing the best 3 of
+   * measured points) exactly with a descent over curves going through 3 of
+   * the points started from the least squares fit.
+   */
+  class CPolarFit {
+  public:
+    /**
+     * @brief Measured polar curve point
+     */
+    struct TPoint {
+      double speed;                       /**< @brief Speed [km/h] */
+      double sink;                        /**< @brief Sink [m/s] (negative value) */
+    };
+    typedef std::vector<TPoint> CPointsArray;
+    typedef std::vector<double> CWeightsArray;
+
+    /**
+     * @brief Fitting mode
+     */
+    enum TMode {
+      MODE_LEAST_SQUARES,                 /**< @brief Minimise the sum of squared sink errors */
+      MODE_L1                             /**< @brief Minimise the sum of absolute sink errors */
+    };
+
+  private:
+    double _coeffs[3];                    /**< @brief Polar curve coefficients (a, b, c) for speed in km/h */
+
+    static bool LeastSquares(const CPointsArray &points, const CWeightsArray &weights, double (&coeffs)[3]);
+    static double Error(const CPointsArray &points, const double (&coeffs)[3]);
+    static bool Vertex(const CPointsArray &points, const CPointsArray::size_type (&vertex)[3], double (&coeffs)[3]);
+    void L1(const CPointsArray &points);
+
+  public:
+    CPolarFit(const CPointsArray &points, TMode mode = MODE_LEAST_SQUARES);
+    CPolarFit(const CPointsArray &points, const CWeightsArray &weights);
+    double Sink(double speed) const;
+    double Error(const CPointsArray &points) const;
+    double ErrorSquared(const CPointsArray &points) const;
+    CPolarXCSoar Polar(const double (&speed)[3]) const;
+    CPolarXCSoar Polar(const CPointsArray &points) const;
+  };
+
+} // namespace polarOptimiser
+
+#endif // __POLARFIT_H__
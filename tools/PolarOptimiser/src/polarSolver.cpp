@@ -0,0 +1,181 @@
+//
+// This file is part of PolarOptimiser gliders polar files optimisation helper.
+//
+// Copyright (C) 2009 Mateusz Pusz
+//
+// PolarOptimiser is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PolarOptimiser is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PolarOptimiser. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file polarSolver.cpp
+ *
+ * @brief Implements the polarOptimiser::CPolarSolver class. 
+**/
+
+#include "polarSolver.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifdef POLAROPTIMISER_SSE2
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * @brief Class constructor
+ *
+ * polarOptimiser::CPolarSolver class constructor.
+ *
+ * @param polar Glider polar equation implementation
+ */
+polarOptimiser::CPolarSolver::CPolarSolver(const CPolar &polar) :
+  _polar(polar)
+{
+}
+
+
+/**
+ * @brief Calculates sinks for many speeds
+ *
+ * Method evaluates polar curve equation for an array of speeds. Equation
+ * coefficients are scaled for provided weights only once.
+ *
+ * @param speed Speeds [km/h]
+ * @param sink Calculated sinks [m/s]
+ * @param num Number of speeds
+ * @param weight Glider + pilot mass
+ * @param ballastLitres The amount of water ballast
+ */
+void polarOptimiser::CPolarSolver::Sink(const double *speed, double *sink, unsigned num, double weight, double ballastLitres) const
+{
+  double coeffs[3];
+  _polar.Coefficients(weight, ballastLitres, coeffs);
+
+  unsigned i = 0;
+#ifdef POLAROPTIMISER_SSE2
+  const __m128d a = _mm_set1_pd(coeffs[0]);
+  const __m128d b = _mm_set1_pd(coeffs[1]);
+  const __m128d c = _mm_set1_pd(coeffs[2]);
+  const __m128d kmh = _mm_set1_pd(3.6);
+  for(; i + 2 <= num; i += 2) {
+    const __m128d v = _mm_div_pd(_mm_loadu_pd(speed + i), kmh);
+    _mm_storeu_pd(sink + i, _mm_add_pd(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(a, v), v), _mm_mul_pd(b, v)), c));
+  }
+#endif
+  for(; i < num; i++) {
+    const double v = speed[i] / 3.6;
+    sink[i] = coeffs[0] * v * v + coeffs[1] * v + coeffs[2];
+  }
+}
+
+
+/**
+ * @brief Calculates the best LD speed
+ *
+ * Method calculates the speed of the best LD. LD = V / -(a * V^2 + b * V + c)
+ * is the highest when its derivative a * V^2 - c is equal to 0.
+ *
+ * @param weight Glider + pilot mass
+ * @param ballastLitres The amount of water ballast
+ *
+ * @exception std::runtime_error Thrown when polar curve has no best LD.
+ *
+ * @return The best LD speed [km/h].
+ */
+double polarOptimiser::CPolarSolver::BestLDSpeed(double weight, double ballastLitres) const
+{
+  double coeffs[3];
+  _polar.Coefficients(weight, ballastLitres, coeffs);
+  if(coeffs[0] >= 0 || coeffs[2] >= 0)
+    throw std::runtime_error("ERROR: Polar curve does not have the best LD!!!");
+  return std::sqrt(coeffs[2] / coeffs[0]) * 3.6;
+}
+
+
+/**
+ * @brief Calculates gross sink error
+ *
+ * Method calculates the sum of sink errors for provided polar points.
+ *
+ * @param weight Glider + pilot mass
+ * @param ballastLitres The amount of water ballast for provided polar points
+ * @param speed Speeds of polar points [km/h]
+ * @param sink Sinks of polar points [m/s]
+ * @param num Number of polar points
+ *
+ * @return Gross sink error [m/s].
+ */
+double polarOptimiser::CPolarSolver::SinkError(double weight, double ballastLitres, const double *speed, const double *sink, unsigned num) const
+{
+  const unsigned CHUNK_SIZE = 16;
+  double calculated[CHUNK_SIZE];
+  double error = 0;
+  for(unsigned i=0; i<num; i+=CHUNK_SIZE) {
+    const unsigned size = (std::min)(num - i, CHUNK_SIZE);
+    Sink(speed + i, calculated, size, weight, ballastLitres);
+    for(unsigned j=0; j<size; j++)
+      error += std::fabs(calculated[j] - sink[i + j]);
+  }
+  return error;
+}
+
+
+/**
+ * @brief Searches for the best MassDryGross value
+ *
+ * Method searches for the glider + pilot mass (in 10-500kg range) that makes
+ * the polar curve "move" with water ballast the best to match provided polar
+ * points. Golden-section search is used.
+ *
+ * @param ballastLitres The amount of water ballast for provided polar points
+ * @param speed Speeds of polar points [km/h]
+ * @param sink Sinks of polar points [m/s]
+ * @param num Number of polar points
+ * @param error Gross sink error for the best mass
+ *
+ * @return The best glider + pilot mass.
+ */
+double polarOptimiser::CPolarSolver::BestWeight(double ballastLitres, const double *speed, const double *sink, unsigned num, double &error) const
+{
+  const double ratio = (std::sqrt(5.0) - 1) / 2;
+  const double tolerance = 1e-4;
+
+  double low = 10, high = 500;
+  double x1 = high - ratio * (high - low);
+  double x2 = low + ratio * (high - low);
+  double f1 = SinkError(x1, ballastLitres, speed, sink, num);
+  double f2 = SinkError(x2, ballastLitres, speed, sink, num);
+  while(high - low > tolerance) {
+    if(f1 <= f2) {
+      high = x2;
+      x2 = x1;
+      f2 = f1;
+      x1 = high - ratio * (high - low);
+      f1 = SinkError(x1, ballastLitres, speed, sink, num);
+    }
+    else {
+      low = x1;
+      x1 = x2;
+      f1 = f2;
+      x2 = low + ratio * (high - low);
+      f2 = SinkError(x2, ballastLitres, speed, sink, num);
+    }
+  }
+
+  const double weight = (low + high) / 2;
+  error = SinkError(weight, ballastLitres, speed, sink, num);
+  return weight;
+}
@@ -0,0 +1,61 @@
+//
+// This file is part of PolarOptimiser gliders polar files optimisation helper.
+//
+// Copyright (C) 2009 Mateusz Pusz
+//
+// PolarOptimiser is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// PolarOptimiser is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with PolarOptimiser. If not, see <http://www.gnu.org/licenses/>.
+//
+// Visit the project webpage (http://sf.net/projects/condor2nav) for more info.
+//
+
+/**
+ * @file polarSolver.h
+ *
+ * @brief Polar curve solver class declaration.
+**/
+
+#ifndef __POLARSOLVER_H__
+#define __POLARSOLVER_H__
+
+#include "polar.h"
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define POLAROPTIMISER_SSE2
+#endif
+
+namespace polarOptimiser {
+
+  /**
+   * @brief Polar curve solver
+   *
+   * polarOptimiser::CPolarSolver class calculates glider performance values
+   * directly from the quadratic polar curve equation instead of stepping
+   * through speeds or weights: best LD speed is found in closed form and the
+   * best glider mass with golden-section search. Sinks for many speeds are
+   * evaluated at once (with SSE2 when available).
+   */
+  class CPolarSolver {
+    const CPolar &_polar;                 /**< @brief Glider polar equation implementation */
+
+  public:
+    explicit CPolarSolver(const CPolar &polar);
+    void Sink(const double *speed, double *sink, unsigned num, double weight, double ballastLitres) const;
+    double BestLDSpeed(double weight, double ballastLitres) const;
+    double SinkError(double weight, double ballastLitres, const double *speed, const double *sink, unsigned num) const;
+    double BestWeight(double ballastLitres, const double *speed, const double *sink, unsigned num, double &error) const;
+  };
+
+} // namespace polarOptimiser
+
+#endif // __POLARSOLVER_H__
@@ -44,6 +44,7 @@
 #include "polarXCSoar.h"
 #include <string>
 #include <cmath>
+#include <stdexcept>
 
 
 /**
@@ -133,17 +134,15 @@ double polarOptimiser::CPolarXCSoar::Speed(unsigned idx) const
 
 
 /**
-* @brief Calculates XCSoar sink polar curve value
+* @brief Returns XCSoar polar curve equation coefficients
 *
-* Method calculates XCSoar sink polar curve value.
+* Method scales XCSoar polar curve equation coefficients for provided weights.
 *
-* @param speed Speed value from polar curve to use
 * @param weight Glider + pilot mass
 * @param ballastLitres The amount of water ballast to set for calculations
-*
-* @return XCSoar polar curve sink value.
+* @param coeffs Equation coefficients (a, b, c) for the speed in m/s
 */
-double polarOptimiser::CPolarXCSoar::Sink(double speed, double weight, double ballastLitres) const
+void polarOptimiser::CPolarXCSoar::Coefficients(double weight, double ballastLitres, double (&coeffs)[3]) const
 {
   // now scale off weight
   double weights[3] = {0};
@@ -162,9 +161,26 @@ double polarOptimiser::CPolarXCSoar::Sink(double speed, double weight, double ba
 
   double ballast = sqrt(ballastLitres + weights[0] + weights[1]);
 
-  double polar_a = polar[0] / ballast;
-  double polar_b = polar[1];
-  double polar_c = polar[2] * ballast;
-  
-  return SinkRate(polar_a, polar_b, polar_c, 0, 0, speed/3.6);
+  coeffs[0] = polar[0] / ballast;
+  coeffs[1] = polar[1];
+  coeffs[2] = polar[2] * ballast;
+}
+
+
+/**
+* @brief Calculates XCSoar sink polar curve value
+*
+* Method calculates XCSoar sink polar curve value.
+*
+* @param speed Speed value from polar curve to use
+* @param weight Glider + pilot mass
+* @param ballastLitres The amount of water ballast to set for calculations
+*
+* @return XCSoar polar curve sink value.
+*/
+double polarOptimiser::CPolarXCSoar::Sink(double speed, double weight, double ballastLitres) const
+{
+  double coeffs[3];
+  Coefficients(weight, ballastLitres, coeffs);
+  return SinkRate(coeffs[0], coeffs[1], coeffs[2], 0, 0, speed/3.6);
 }
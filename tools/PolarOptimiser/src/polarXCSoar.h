@@ -46,6 +46,7 @@ namespace polarOptimiser {
     CPolarXCSoar(const double (&speed)[3], const double (&sink)[3]);
     virtual double Speed(unsigned idx) const;
     virtual double Sink(double speed, double weight, double ballastLitres) const;
+    virtual void Coefficients(double weight, double ballastLitres, double (&coeffs)[3]) const;
   };
 
 } // namespace polarOptimiser
@@ -25,8 +25,8 @@
  * @brief Common utilities. 
 **/
 
-#ifndef __TOOLS_H__
-#define __TOOLS_H__
+#ifndef __POLAROPTIMISER_TOOLS_H__
+#define __POLAROPTIMISER_TOOLS_H__
 
 #include <sstream>
 
@@ -58,4 +58,4 @@ namespace polarOptimiser {
 
 } // namespace polarOptimiser
 
-#endif // __TOOLS_H__
+#endif // __POLAROPTIMISER_TOOLS_H__